@@ -0,0 +1,305 @@
+/**
+ * PIGO: a parallel graph and matrix I/O and preprocessing library
+ * Copyright (c) 2022 GT-TDALab
+ *
+ * This file contains the benchmark harness used by pigo_bench. Each
+ * benchmark is run with warmup and repeated, timed runs for every thread
+ * count, and the results are reported as a table, JSON or CSV.
+ */
+
+#ifndef PIGO_BENCH_HPP
+#define PIGO_BENCH_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "pigo.hpp"
+
+namespace pigo_bench {
+
+    /** @brief A benchmarked operation
+     *
+     * setup and teardown run before and after every timed run, outside of
+     * the timing. bytes and edges are queried after the runs, so they can
+     * report the size of an output the benchmark created.
+     */
+    struct Benchmark {
+        /** The name, as group/operation */
+        std::string name;
+        /** The timed operation */
+        std::function<void()> run;
+        /** Prepares each run, untimed */
+        std::function<void()> setup;
+        /** Cleans up after each run, untimed */
+        std::function<void()> teardown;
+        /** The bytes read or written by one run */
+        std::function<size_t()> bytes;
+        /** The edges or non-zeros processed by one run */
+        size_t edges;
+    };
+
+    /** @brief The timings of one benchmark at one thread count */
+    struct Result {
+        std::string name;
+        int threads;
+        std::vector<double> seconds;
+        size_t bytes;
+        size_t edges;
+        /** The hardware counts of all timed runs, if measured */
+        pigo::PerfCounters counters;
+        /** The timestamp counter ticks of all timed runs, or 0 */
+        uint64_t ticks;
+        /** The most bytes PIGO held allocated during any timed run,
+         *  including what the setup allocated */
+        size_t peak_bytes;
+
+        double min() const { return *std::min_element(seconds.begin(), seconds.end()); }
+        double max() const { return *std::max_element(seconds.begin(), seconds.end()); }
+        double mean() const {
+            double sum = 0.;
+            for (double s : seconds) sum += s;
+            return sum / seconds.size();
+        }
+        double median() const {
+            std::vector<double> sorted = seconds;
+            std::sort(sorted.begin(), sorted.end());
+            size_t n = sorted.size();
+            return (n % 2 == 1) ? sorted[n/2] : (sorted[n/2-1] + sorted[n/2]) / 2.;
+        }
+        double stddev() const {
+            if (seconds.size() < 2) return 0.;
+            double m = mean();
+            double ss = 0.;
+            for (double s : seconds) ss += (s-m)*(s-m);
+            return std::sqrt(ss / (seconds.size()-1));
+        }
+        /** @brief Return the bandwidth in GB/s at the median time */
+        double gbps() const {
+            double t = median();
+            return (t > 0) ? bytes / t / 1e9 : 0.;
+        }
+        /** @brief Return the edges per second at the median time */
+        double edges_per_sec() const {
+            double t = median();
+            return (t > 0) ? edges / t : 0.;
+        }
+        /** @brief Return the cycles per byte of one run
+         *
+         * Core cycles are used when counted, otherwise the timestamp
+         * counter, which ticks at a fixed reference frequency.
+         */
+        double cycles_per_byte() const {
+            uint64_t cycles = counters.valid ? counters.cycles : ticks;
+            return (bytes > 0) ? (double)cycles / seconds.size() / bytes : 0.;
+        }
+        /** @brief Return a count per edge in one run */
+        double per_edge(uint64_t count) const {
+            return (edges > 0) ? (double)count / seconds.size() / edges : 0.;
+        }
+    };
+
+    /** @brief The settings shared by every benchmark run */
+    struct Settings {
+        /** Untimed runs before timing */
+        int warmup = 1;
+        /** Timed runs */
+        int reps = 5;
+        /** The thread counts to sweep */
+        std::vector<int> threads;
+        /** Only run benchmarks whose name contains this */
+        std::string filter;
+        /** Whether to count hardware events, see pigo::enable_perf_counters */
+        bool counters = false;
+    };
+
+    /** @brief Set the number of threads used by PIGO */
+    inline void set_threads(int threads) {
+        #ifdef _OPENMP
+        omp_set_num_threads(threads);
+        #else
+        (void)threads;
+        #endif
+    }
+
+    /** @brief Return the default number of threads */
+    inline int max_threads() {
+        #ifdef _OPENMP
+        return omp_get_max_threads();
+        #else
+        return 1;
+        #endif
+    }
+
+    /** @brief Return the timestamp counter, or 0 where there is none */
+    inline uint64_t cpu_ticks() {
+        #if defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+        #else
+        return 0;
+        #endif
+    }
+
+    /** @brief Parse a comma-separated list of thread counts */
+    inline std::vector<int> parse_threads(const std::string& list) {
+        std::vector<int> threads;
+        std::stringstream ss { list };
+        std::string item;
+        while (std::getline(ss, item, ',')) {
+            int t = std::atoi(item.c_str());
+            if (t <= 0) throw std::runtime_error("Invalid thread count " + item);
+            threads.push_back(t);
+        }
+        return threads;
+    }
+
+    /** @brief Run every matching benchmark for every thread count */
+    inline std::vector<Result> run_all(const std::vector<Benchmark>& benchmarks,
+            const Settings& settings, std::ostream& progress) {
+        std::vector<Result> results;
+        for (const Benchmark& b : benchmarks) {
+            if (!settings.filter.empty() && b.name.find(settings.filter) == std::string::npos)
+                continue;
+            for (int t : settings.threads) {
+                set_threads(t);
+                Result r;
+                r.name = b.name;
+                r.threads = t;
+                r.ticks = 0;
+                r.peak_bytes = 0;
+                for (int rep = 0; rep < settings.warmup + settings.reps; ++rep) {
+                    if (b.setup) b.setup();
+                    pigo::PerfCounters before;
+                    if (settings.counters) before = pigo::read_perf_counters();
+                    pigo::reset_memory_peaks();
+                    auto start = std::chrono::steady_clock::now();
+                    uint64_t start_ticks = cpu_ticks();
+                    b.run();
+                    uint64_t end_ticks = cpu_ticks();
+                    auto end = std::chrono::steady_clock::now();
+                    pigo::PerfCounters after;
+                    if (settings.counters) after = pigo::read_perf_counters();
+                    size_t peak = pigo::memory_usage().peak;
+                    if (b.teardown) b.teardown();
+                    if (rep >= settings.warmup) {
+                        r.peak_bytes = std::max(r.peak_bytes, peak);
+                        r.seconds.push_back(std::chrono::duration<double>(end-start).count());
+                        r.counters += after - before;
+                        r.ticks += end_ticks - start_ticks;
+                    }
+                }
+                r.bytes = b.bytes ? b.bytes() : 0;
+                r.edges = b.edges;
+                progress << std::left << std::setw(32) << r.name << std::right
+                    << " threads=" << std::setw(3) << t
+                    << std::fixed << std::setprecision(4)
+                    << "  median " << r.median() << " s"
+                    << std::setprecision(3) << "  " << r.gbps() << " GB/s"
+                    << std::setprecision(1) << "  " << r.edges_per_sec()/1e6 << " Medges/s"
+                    << "  peak " << r.peak_bytes/1048576. << " MiB";
+                if (r.counters.valid)
+                    progress << std::setprecision(2) << "  IPC " << r.counters.ipc()
+                        << std::setprecision(3)
+                        << "  cache-miss/edge " << r.per_edge(r.counters.cache_misses)
+                        << "  tlb-miss/edge " << r.per_edge(r.counters.tlb_misses)
+                        << "  branch-miss/edge " << r.per_edge(r.counters.branch_misses);
+                progress << std::endl;
+                results.push_back(r);
+            }
+        }
+        set_threads(max_threads());
+        return results;
+    }
+
+    /** @brief Escape a string for JSON output */
+    inline std::string json_str(const std::string& s) {
+        std::string out = "\"";
+        for (char c : s) {
+            if (c == '"' || c == '\\') out += '\\';
+            out += c;
+        }
+        return out + "\"";
+    }
+
+    /** @brief Write results as JSON, with key/value metadata first */
+    inline void write_json(std::ostream& out,
+            const std::vector<std::pair<std::string, std::string>>& meta,
+            const std::vector<Result>& results) {
+        out << "{\n";
+        for (const auto& kv : meta)
+            out << "  " << json_str(kv.first) << ": " << json_str(kv.second) << ",\n";
+        out << "  \"results\": [";
+        out << std::setprecision(9);
+        for (size_t i = 0; i < results.size(); ++i) {
+            const Result& r = results[i];
+            out << (i ? ",\n" : "\n") << "    {\"name\": " << json_str(r.name)
+                << ", \"threads\": " << r.threads
+                << ", \"reps\": " << r.seconds.size()
+                << ", \"min_s\": " << r.min()
+                << ", \"median_s\": " << r.median()
+                << ", \"mean_s\": " << r.mean()
+                << ", \"max_s\": " << r.max()
+                << ", \"stddev_s\": " << r.stddev()
+                << ", \"bytes\": " << r.bytes
+                << ", \"edges\": " << r.edges
+                << ", \"gbps\": " << r.gbps()
+                << ", \"edges_per_s\": " << r.edges_per_sec()
+                << ", \"cycles_per_byte\": " << r.cycles_per_byte()
+                << ", \"peak_bytes\": " << r.peak_bytes;
+            if (r.counters.valid) {
+                // Counts are per run, averaged over the timed runs
+                size_t reps = r.seconds.size();
+                out << ", \"cycles\": " << r.counters.cycles / reps
+                    << ", \"instructions\": " << r.counters.instructions / reps
+                    << ", \"ipc\": " << r.counters.ipc()
+                    << ", \"cache_misses\": " << r.counters.cache_misses / reps
+                    << ", \"tlb_misses\": " << r.counters.tlb_misses / reps
+                    << ", \"branch_misses\": " << r.counters.branch_misses / reps;
+            }
+            out << "}";
+        }
+        out << "\n  ]\n}\n";
+    }
+
+    /** @brief Write results as CSV with a header row */
+    inline void write_csv(std::ostream& out, const std::vector<Result>& results) {
+        // Count columns are only added if some result has counts
+        bool counters = false;
+        for (const Result& r : results)
+            counters = counters || r.counters.valid;
+        out << "name,threads,reps,min_s,median_s,mean_s,max_s,stddev_s,bytes,edges,gbps,edges_per_s,peak_bytes";
+        if (counters) out << ",cycles,instructions,ipc,cache_misses,tlb_misses,branch_misses";
+        out << "\n";
+        out << std::setprecision(9);
+        for (const Result& r : results) {
+            out << r.name << "," << r.threads << "," << r.seconds.size() << ","
+                << r.min() << "," << r.median() << "," << r.mean() << ","
+                << r.max() << "," << r.stddev() << "," << r.bytes << ","
+                << r.edges << "," << r.gbps() << "," << r.edges_per_sec() << ","
+                << r.peak_bytes;
+            if (counters) {
+                size_t reps = r.seconds.size();
+                out << "," << r.counters.cycles / reps << "," << r.counters.instructions / reps
+                    << "," << r.counters.ipc() << "," << r.counters.cache_misses / reps
+                    << "," << r.counters.tlb_misses / reps << "," << r.counters.branch_misses / reps;
+            }
+            out << "\n";
+        }
+    }
+
+}
+
+#endif
@@ -0,0 +1,203 @@
+/**
+ * PIGO: a parallel graph and matrix I/O and preprocessing library
+ * Copyright (c) 2022 GT-TDALab
+ *
+ * This file contains the reference graph and matrix kernels used by
+ * pigo_workloads: a parallel top-down BFS, pull and push PageRank and
+ * CSR SpMV. They access the CSR offsets and endpoints directly, so their
+ * time depends on the layout PIGO loaded.
+ */
+
+#ifndef PIGO_BENCH_KERNELS_HPP
+#define PIGO_BENCH_KERNELS_HPP
+
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "pigo.hpp"
+
+namespace pigo_bench {
+
+    /** @brief The outcome of a BFS */
+    struct BFSResult {
+        /** The vertices reached, including the source */
+        uint64_t reached;
+        /** The number of levels */
+        uint64_t levels;
+    };
+
+    /** @brief Run a level-synchronous top-down BFS
+     *
+     * Each level's frontier is expanded in parallel. Vertices are claimed
+     * with a compare-and-swap on their parent, and each thread collects
+     * its part of the next frontier locally.
+     *
+     * @param g the graph, whose rows are out-neighbors
+     * @param source the vertex to start from
+     * @return the vertices reached and levels
+     */
+    template<class G>
+    BFSResult bfs(G& g, uint64_t source) {
+        typedef typename std::remove_reference<decltype(g.endpoints()[0])>::type V;
+        int64_t n = g.n();
+        auto offsets = g.offsets();
+        auto endpoints = g.endpoints();
+        std::vector<int64_t> parent(n, -1);
+        std::vector<V> frontier { (V)source };
+        parent[source] = (int64_t)source;
+        BFSResult res { 1, 0 };
+        while (!frontier.empty()) {
+            ++res.levels;
+            std::vector<V> next;
+            #pragma omp parallel
+            {
+                std::vector<V> local;
+                #pragma omp for schedule(dynamic, 64) nowait
+                for (size_t i = 0; i < frontier.size(); ++i) {
+                    V u = frontier[i];
+                    for (auto e = offsets[u]; e < offsets[u+1]; ++e) {
+                        V v = endpoints[e];
+                        int64_t unvisited = -1;
+                        if (parent[v] == -1 &&
+                                __atomic_compare_exchange_n(&parent[v], &unvisited, (int64_t)u,
+                                    false, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+                            local.push_back(v);
+                    }
+                }
+                #pragma omp critical
+                next.insert(next.end(), local.begin(), local.end());
+            }
+            res.reached += next.size();
+            frontier.swap(next);
+        }
+        return res;
+    }
+
+    /** @brief Run pull-based PageRank
+     *
+     * Each vertex sums the contributions of its in-neighbors, so the
+     * iterations are free of atomics.
+     *
+     * @param in the graph whose rows are in-neighbors
+     * @param out the graph whose rows are out-neighbors, for degrees
+     * @param iterations the number of iterations
+     * @param damping the damping factor
+     * @return the ranks
+     */
+    template<class G>
+    std::vector<double> pagerank_pull(G& in, G& out, int iterations, double damping=0.85) {
+        int64_t n = out.n();
+        auto in_offs = in.offsets();
+        auto in_ends = in.endpoints();
+        auto out_offs = out.offsets();
+        std::vector<double> rank(n, 1./n), contrib(n), next(n);
+        for (int it = 0; it < iterations; ++it) {
+            double dangling = 0.;
+            #pragma omp parallel for reduction(+ : dangling)
+            for (int64_t u = 0; u < n; ++u) {
+                auto deg = out_offs[u+1] - out_offs[u];
+                if (deg == 0) dangling += rank[u];
+                contrib[u] = (deg == 0) ? 0. : rank[u] / deg;
+            }
+            double base = (1.-damping)/n + damping*dangling/n;
+            // Only rows in the transpose exist for vertices with in-edges
+            int64_t in_n = in.n();
+            #pragma omp parallel for schedule(dynamic, 1024)
+            for (int64_t v = 0; v < n; ++v) {
+                double sum = 0.;
+                if (v < in_n)
+                    for (auto e = in_offs[v]; e < in_offs[v+1]; ++e)
+                        sum += contrib[in_ends[e]];
+                next[v] = base + damping*sum;
+            }
+            rank.swap(next);
+        }
+        return rank;
+    }
+
+    /** @brief Run push-based PageRank
+     *
+     * Each vertex adds its contribution to its out-neighbors with atomic
+     * updates, needing only the out-edges.
+     *
+     * @param out the graph whose rows are out-neighbors
+     * @param iterations the number of iterations
+     * @param damping the damping factor
+     * @return the ranks
+     */
+    template<class G>
+    std::vector<double> pagerank_push(G& out, int iterations, double damping=0.85) {
+        int64_t n = out.n();
+        auto offs = out.offsets();
+        auto ends = out.endpoints();
+        std::vector<double> rank(n, 1./n), next(n);
+        for (int it = 0; it < iterations; ++it) {
+            double dangling = 0.;
+            #pragma omp parallel
+            {
+                #pragma omp for
+                for (int64_t v = 0; v < n; ++v)
+                    next[v] = 0.;
+                #pragma omp for schedule(dynamic, 1024) reduction(+ : dangling)
+                for (int64_t u = 0; u < n; ++u) {
+                    auto deg = offs[u+1] - offs[u];
+                    if (deg == 0) {
+                        dangling += rank[u];
+                        continue;
+                    }
+                    double c = rank[u] / deg;
+                    for (auto e = offs[u]; e < offs[u+1]; ++e) {
+                        #pragma omp atomic
+                        next[ends[e]] += c;
+                    }
+                }
+            }
+            double base = (1.-damping)/n + damping*dangling/n;
+            #pragma omp parallel for
+            for (int64_t v = 0; v < n; ++v)
+                next[v] = base + damping*next[v];
+            rank.swap(next);
+        }
+        return rank;
+    }
+
+    /** @brief Return the value of a CSR entry, 1 if unweighted */
+    template<bool wgt>
+    struct entry_value_i_ {
+        template<class WS, class O>
+        static double op_(WS&, O) { return 1.; }
+    };
+    template<>
+    struct entry_value_i_<true> {
+        template<class WS, class O>
+        static double op_(WS& w, O e) { return w[e]; }
+    };
+
+    /** @brief Multiply a CSR matrix by a vector, y = A x
+     *
+     * @param a the matrix, unweighted entries counting as 1
+     * @param x the input vector, of the number of columns
+     * @param y the output vector, of the number of rows
+     */
+    template<bool wgt, class M>
+    void spmv(M& a, const std::vector<double>& x, std::vector<double>& y) {
+        int64_t nrows = a.nrows();
+        auto offs = a.offsets();
+        auto ends = a.endpoints();
+        auto& ws = a.weights();
+        #pragma omp parallel for schedule(dynamic, 1024)
+        for (int64_t r = 0; r < nrows; ++r) {
+            double sum = 0.;
+            for (auto e = offs[r]; e < offs[r+1]; ++e)
+                sum += entry_value_i_<wgt>::op_(ws, e) * x[ends[e]];
+            y[r] = sum;
+        }
+    }
+
+}
+
+#endif
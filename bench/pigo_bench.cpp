@@ -0,0 +1,428 @@
+/**
+ * PIGO: a parallel graph and matrix I/O and preprocessing library
+ * Copyright (c) 2022 GT-TDALab
+ *
+ * This is pigo_bench, which times every PIGO reader, writer, conversion,
+ * sort and deduplication path on a generated or given graph, sweeping
+ * thread counts and reporting bandwidth and edge rates.
+ */
+
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "pigo.hpp"
+#include "bench.hpp"
+
+using namespace std;
+using namespace pigo;
+using namespace pigo_bench;
+
+typedef COO<> coo_t;
+typedef COO<uint32_t, uint32_t, uint32_t*, true> sym_coo_t;
+typedef CSR<> csr_t;
+typedef DiGraph<> digraph_t;
+typedef Tensor<uint32_t, uint64_t> tensor_t;
+
+static void usage() {
+    cerr <<
+        "Usage: pigo_bench [options]\n"
+        "\n"
+        "Times PIGO's readers, writers, conversions, sorting and\n"
+        "deduplication. Without --input, a synthetic graph is generated.\n"
+        "\n"
+        "Options:\n"
+        "  --input FILE       benchmark an edge list instead of a generated graph\n"
+        "  --graph KIND       generate a uniform or rmat graph (default: uniform)\n"
+        "  --scale S          generate 2^S vertices (default: 18)\n"
+        "  --edge-factor E    generate E edges per vertex (default: 16)\n"
+        "  --seed N           the generator seed (default: 1)\n"
+        "  --reps N           timed runs per benchmark (default: 5)\n"
+        "  --warmup N         untimed runs per benchmark (default: 1)\n"
+        "  --threads LIST     comma-separated thread counts (default: powers\n"
+        "                     of two up to the number of cores)\n"
+        "  --filter TEXT      only run benchmarks whose name contains TEXT\n"
+        "  --format FORMAT    table, json or csv (default: table)\n"
+        "  --output FILE      write the json or csv results to FILE\n"
+        "  --counters         also count cycles, instructions and cache, TLB\n"
+        "                     and branch misses with perf_event_open\n"
+        "  --dir DIR          directory for temporary files (default: .)\n"
+        "  --list             list the benchmarks and exit\n";
+}
+
+static size_t file_size(const string& fn) {
+    struct stat st;
+    if (stat(fn.c_str(), &st) != 0) return 0;
+    return st.st_size;
+}
+
+/** @brief Holds the inputs shared by the benchmarks
+ *
+ * COOs and Tensors copy on assignment, so every loaded object is held
+ * through a pointer.
+ */
+struct Inputs {
+    string dir;
+    string el, mtx, graph, coo_bin, csr_bin, csr_crc, dig_bin, tns, tns_bin;
+    unique_ptr<coo_t> coo;
+    unique_ptr<csr_t> csr;
+    unique_ptr<digraph_t> dig;
+    unique_ptr<tensor_t> tensor;
+    vector<string> temps;
+
+    string temp(const string& suffix) {
+        string fn = dir + "/.pigo_bench." + suffix;
+        temps.push_back(fn);
+        return fn;
+    }
+
+    ~Inputs() {
+        if (coo) coo->free();
+        if (csr) csr->free();
+        if (dig) dig->free();
+        if (tensor) tensor->free();
+        for (const string& fn : temps) remove(fn.c_str());
+    }
+};
+
+/** @brief Write every input format from the loaded COO */
+static void prepare(Inputs& in, const string& input) {
+    coo_t& coo = *in.coo;
+    if (input.empty()) {
+        in.el = in.temp("el");
+        coo.write(in.el);
+    } else
+        in.el = input;
+
+    in.csr.reset(new csr_t { coo });
+    in.dig.reset(new digraph_t { coo });
+    csr_t& csr = *in.csr;
+
+    // Matrix market files are one-based with a size line
+    in.mtx = in.temp("mtx");
+    {
+        ofstream out { in.mtx };
+        out << "%%MatrixMarket matrix coordinate pattern general\n";
+        out << coo.nrows() << " " << coo.ncols() << " " << coo.m() << "\n";
+        for (size_t e = 0; e < coo.m(); ++e)
+            out << coo.x()[e]+1 << " " << coo.y()[e]+1 << "\n";
+    }
+
+    // Graph files list one-based neighbors for each vertex
+    in.graph = in.temp("graph");
+    {
+        ofstream out { in.graph };
+        out << csr.n() << " " << csr.m() << "\n";
+        for (size_t v = 0; v < csr.n(); ++v) {
+            for (uint32_t e = csr.offsets()[v]; e < csr.offsets()[v+1]; ++e)
+                out << (e == csr.offsets()[v] ? "" : " ") << csr.endpoints()[e]+1;
+            out << "\n";
+        }
+    }
+
+    in.coo_bin = in.temp("coo.pigo");
+    coo.save(in.coo_bin);
+    in.csr_bin = in.temp("csr.pigo");
+    csr.save(in.csr_bin);
+    in.csr_crc = in.temp("csr.crc.pigo");
+    csr.save(in.csr_crc, MAPPED, CRC32C);
+    in.dig_bin = in.temp("dig.pigo");
+    in.dig->save(in.dig_bin);
+
+    // A third-order tensor built from the edges
+    in.tensor.reset(new tensor_t { 3, coo.m() });
+    tensor_t& tensor = *in.tensor;
+    #pragma omp parallel for
+    for (size_t e = 0; e < coo.m(); ++e) {
+        tensor.c()[3*e] = coo.x()[e];
+        tensor.c()[3*e+1] = coo.y()[e];
+        tensor.c()[3*e+2] = (coo.x()[e] + coo.y()[e]) % 64;
+        tensor.w()[e] = 1.f + (e % 7);
+    }
+    in.tns = in.temp("tns");
+    tensor.write(in.tns);
+    in.tns_bin = in.temp("tns.pigo");
+    tensor.save(in.tns_bin);
+}
+
+/** @brief Holds the result of a benchmark until its teardown */
+template<class T>
+struct Slot {
+    unique_ptr<T> obj;
+
+    void release() {
+        if (obj) obj->free();
+        obj.reset();
+    }
+};
+
+/** @brief Build a benchmark that loads an object from a file */
+template<class T>
+static Benchmark read_bench(const string& name, const string& fn, size_t edges) {
+    shared_ptr<Slot<T>> out = make_shared<Slot<T>>();
+    return Benchmark {
+        name,
+        [out, fn]() { out->obj.reset(new T { fn }); },
+        nullptr,
+        [out]() { out->release(); },
+        [fn]() { return file_size(fn); },
+        edges };
+}
+
+/** @brief Build a benchmark that writes a file, removing it afterwards */
+static Benchmark write_bench(const string& name, const string& fn,
+        function<void(const string&)> write, size_t edges) {
+    shared_ptr<size_t> size = make_shared<size_t>(0);
+    return Benchmark {
+        name,
+        [fn, write]() { write(fn); },
+        nullptr,
+        [fn, size]() { *size = file_size(fn); remove(fn.c_str()); },
+        [size]() { return *size; },
+        edges };
+}
+
+/** @brief Build a benchmark that creates an object from an input object */
+template<class T, class From>
+static Benchmark convert_bench(const string& name, From& from, size_t bytes, size_t edges) {
+    shared_ptr<Slot<T>> out = make_shared<Slot<T>>();
+    return Benchmark {
+        name,
+        [out, &from]() { out->obj.reset(new T { from }); },
+        nullptr,
+        [out]() { out->release(); },
+        [bytes]() { return bytes; },
+        edges };
+}
+
+static vector<Benchmark> benchmarks(Inputs& in) {
+    vector<Benchmark> b;
+    coo_t& coo = *in.coo;
+    csr_t& csr = *in.csr;
+    digraph_t& dig = *in.dig;
+    tensor_t& tensor = *in.tensor;
+    size_t m = coo.m();
+    size_t n = coo.n();
+    size_t coo_bytes = 2*sizeof(uint32_t)*m;
+    size_t csr_bytes = sizeof(uint32_t)*(n+1+m);
+
+    // Readers
+    b.push_back(read_bench<coo_t>("read/el_coo", in.el, m));
+    b.push_back(read_bench<csr_t>("read/el_csr", in.el, m));
+    b.push_back(read_bench<coo_t>("read/mtx_coo", in.mtx, m));
+    b.push_back(read_bench<csr_t>("read/graph_csr", in.graph, m));
+    b.push_back(read_bench<coo_t>("read/coo_bin", in.coo_bin, m));
+    b.push_back(read_bench<csr_t>("read/csr_bin", in.csr_bin, m));
+    b.push_back(read_bench<csr_t>("read/csr_bin_crc32c", in.csr_crc, m));
+    b.push_back(read_bench<digraph_t>("read/digraph_bin", in.dig_bin, m));
+    b.push_back(read_bench<tensor_t>("read/tns_tensor", in.tns, m));
+    b.push_back(read_bench<tensor_t>("read/tensor_bin", in.tns_bin, m));
+
+    // Writers
+    b.push_back(write_bench("write/el_two_pass", in.temp("out.el"),
+                [&coo](const string& fn) { coo.write(fn, TWO_PASS); }, m));
+    b.push_back(write_bench("write/el_buffered", in.temp("out.el"),
+                [&coo](const string& fn) { coo.write(fn, BUFFERED); }, m));
+    b.push_back(write_bench("write/el_stream", in.temp("out.el"),
+                [&coo](const string& fn) { coo.write(fn, STREAM); }, m));
+    #ifdef PIGO_HAVE_ZLIB
+    b.push_back(write_bench("write/el_gzip", in.temp("out.el.gz"),
+                [&coo](const string& fn) { coo.write(fn, GZIP); }, m));
+    #endif
+    #ifdef PIGO_HAVE_ZSTD
+    b.push_back(write_bench("write/el_zstd", in.temp("out.el.zst"),
+                [&coo](const string& fn) { coo.write(fn, ZSTD); }, m));
+    #endif
+    b.push_back(write_bench("write/coo_bin", in.temp("out.pigo"),
+                [&coo](const string& fn) { coo.save(fn); }, m));
+    b.push_back(write_bench("write/coo_bin_direct", in.temp("out.pigo"),
+                [&coo](const string& fn) { coo.save(fn, DIRECT); }, m));
+    b.push_back(write_bench("write/coo_bin_crc32c", in.temp("out.pigo"),
+                [&coo](const string& fn) { coo.save(fn, MAPPED, CRC32C); }, m));
+    b.push_back(write_bench("write/csr_bin", in.temp("out.pigo"),
+                [&csr](const string& fn) { csr.save(fn); }, m));
+    b.push_back(write_bench("write/digraph_bin", in.temp("out.pigo"),
+                [&dig](const string& fn) { dig.save(fn); }, m));
+    b.push_back(write_bench("write/tns", in.temp("out.tns"),
+                [&tensor](const string& fn) { tensor.write(fn); }, m));
+    b.push_back(write_bench("write/tensor_bin", in.temp("out.pigo"),
+                [&tensor](const string& fn) { tensor.save(fn); }, m));
+
+    // Conversions between the in-memory formats
+    b.push_back(convert_bench<csr_t>("convert/coo_to_csr", coo, coo_bytes, m));
+    b.push_back(convert_bench<coo_t>("convert/csr_to_coo", csr, csr_bytes, m));
+    b.push_back(convert_bench<sym_coo_t>("convert/csr_to_sym_coo", csr, csr_bytes, m));
+    b.push_back(convert_bench<digraph_t>("convert/coo_to_digraph", coo, coo_bytes, m));
+    string el = in.el;
+    b.push_back(write_bench("convert/el_to_coo_bin", in.temp("conv.pigo"),
+                [el](const string& fn) { coo_t::convert(el, fn); }, m));
+
+    // Sorting and deduplication, each on a freshly converted CSR
+    shared_ptr<Slot<csr_t>> work = make_shared<Slot<csr_t>>();
+    b.push_back(Benchmark { "sort/csr",
+            [work]() { work->obj->sort(); },
+            [&coo, work]() { work->obj.reset(new csr_t { coo }); },
+            [work]() { work->release(); },
+            [csr_bytes]() { return csr_bytes; }, m });
+    shared_ptr<Slot<csr_t>> dedup = make_shared<Slot<csr_t>>();
+    b.push_back(Benchmark { "dedup/csr",
+            [work, dedup]() { dedup->obj.reset(new csr_t { work->obj->new_csr_without_dups() }); },
+            [&coo, work]() { work->obj.reset(new csr_t { coo }); },
+            [work, dedup]() { work->release(); dedup->release(); },
+            [csr_bytes]() { return csr_bytes; }, m });
+
+    // Generators, at the size of the input
+    shared_ptr<Slot<coo_t>> gen = make_shared<Slot<coo_t>>();
+    unsigned scale = 0;
+    while (((size_t)1 << scale) < n) ++scale;
+    size_t rmat_m = (m >> scale) << scale;
+    b.push_back(Benchmark { "generate/rmat",
+            [gen, scale, rmat_m]() { gen->obj.reset(new coo_t(generate_rmat(scale, rmat_m >> scale))); },
+            nullptr, [gen]() { gen->release(); },
+            [rmat_m]() { return 2*sizeof(uint32_t)*rmat_m; }, rmat_m });
+    b.push_back(Benchmark { "generate/gnm",
+            [gen, n, m]() { gen->obj.reset(new coo_t(generate_gnm(n, m))); },
+            nullptr, [gen]() { gen->release(); },
+            [coo_bytes]() { return coo_bytes; }, m });
+
+    // Checks and estimates
+    b.push_back(Benchmark { "validate/csr",
+            [&csr]() { csr.validate(); }, nullptr, nullptr,
+            [csr_bytes]() { return csr_bytes; }, m });
+    shared_ptr<size_t> sampled = make_shared<size_t>(0);
+    b.push_back(Benchmark { "sample/el",
+            [el, sampled]() { *sampled = sample(el).bytes_sampled; }, nullptr, nullptr,
+            [sampled]() { return *sampled; }, 0 });
+
+    return b;
+}
+
+static string timestamp() {
+    char buf[64];
+    time_t now = time(nullptr);
+    strftime(buf, sizeof(buf), "%Y-%m-%dT%H:%M:%SZ", gmtime(&now));
+    return buf;
+}
+
+static string hostname() {
+    char buf[256] = {0};
+    if (gethostname(buf, sizeof(buf)-1) != 0) return "unknown";
+    return buf;
+}
+
+int main(int argc, char** argv) {
+    Settings settings;
+    string input, graph = "uniform", format = "table", output, dir = ".";
+    int scale = 18, edge_factor = 16;
+    uint64_t seed = 1;
+    bool list = false;
+    try {
+        for (int arg = 1; arg < argc; ++arg) {
+            string a { argv[arg] };
+            auto value = [&]() -> string {
+                if (arg+1 >= argc) throw Error("Missing value for " + a);
+                return argv[++arg];
+            };
+            if (a == "--input") input = value();
+            else if (a == "--graph") graph = value();
+            else if (a == "--scale") scale = stoi(value());
+            else if (a == "--edge-factor") edge_factor = stoi(value());
+            else if (a == "--seed") seed = stoull(value());
+            else if (a == "--reps") settings.reps = stoi(value());
+            else if (a == "--warmup") settings.warmup = stoi(value());
+            else if (a == "--threads") settings.threads = parse_threads(value());
+            else if (a == "--filter") settings.filter = value();
+            else if (a == "--format") format = value();
+            else if (a == "--output") output = value();
+            else if (a == "--dir") dir = value();
+            else if (a == "--list") list = true;
+            else if (a == "--counters") settings.counters = true;
+            else if (a == "-h" || a == "--help") {
+                usage();
+                return 0;
+            } else
+                throw Error("Unknown option " + a);
+        }
+        if (graph != "uniform" && graph != "rmat")
+            throw Error("Unknown graph " + graph);
+        if (format != "table" && format != "json" && format != "csv")
+            throw Error("Unknown format " + format);
+        if (settings.reps < 1 || settings.warmup < 0)
+            throw Error("Invalid repetition counts");
+        if (scale < 1 || scale > 31 || edge_factor < 1)
+            throw Error("Invalid graph size");
+    } catch (exception& e) {
+        cerr << "pigo_bench: " << e.what() << endl;
+        usage();
+        return 1;
+    }
+    if (settings.threads.empty()) {
+        int max_t = max_threads();
+        for (int t = 1; t < max_t; t *= 2) settings.threads.push_back(t);
+        settings.threads.push_back(max_t);
+    }
+
+    Inputs in;
+    in.dir = dir;
+    if (list) {
+        // Listing needs no inputs, only the benchmark names
+        in.coo.reset(new coo_t { });
+        in.csr.reset(new csr_t { });
+        in.dig.reset(new digraph_t { *in.coo });
+        in.tensor.reset(new tensor_t { });
+        for (const Benchmark& b : benchmarks(in)) cout << b.name << endl;
+        return 0;
+    }
+    try {
+        if (input.empty()) {
+            uint32_t n = 1u << scale;
+            if (graph == "rmat")
+                in.coo.reset(new coo_t(generate_rmat(scale, edge_factor, seed)));
+            else
+                in.coo.reset(new coo_t(generate_gnm(n, (uint64_t)n*edge_factor, seed)));
+        } else
+            in.coo.reset(new coo_t { input });
+        cerr << "Preparing inputs with " << in.coo->n() << " vertices and "
+            << in.coo->m() << " edges" << endl;
+        prepare(in, input);
+    } catch (exception& e) {
+        cerr << "pigo_bench: " << e.what() << endl;
+        return 1;
+    }
+
+    if (settings.counters && !enable_perf_counters()) {
+        cerr << "pigo_bench: hardware counters are unavailable, reporting times only" << endl;
+        settings.counters = false;
+    }
+
+    vector<Benchmark> all = benchmarks(in);
+
+    // Progress goes to stderr so that results can be piped
+    vector<Result> results = run_all(all, settings, format == "table" ? cout : cerr);
+
+    if (format != "table") {
+        vector<pair<string, string>> meta {
+            { "input", input.empty() ? "uniform random, scale " + to_string(scale) +
+                ", edge factor " + to_string(edge_factor) : input },
+            { "vertices", to_string(in.coo->n()) },
+            { "edges", to_string(in.coo->m()) },
+            { "max_threads", to_string(max_threads()) },
+            { "host", hostname() },
+            { "compiler", __VERSION__ },
+            { "timestamp", timestamp() },
+            { "counters", settings.counters ? "perf_event_open" : "none" },
+        };
+        ofstream file;
+        if (!output.empty()) file.open(output);
+        ostream& out = output.empty() ? cout : file;
+        if (format == "json") write_json(out, meta, results);
+        else write_csv(out, results);
+    }
+    return 0;
+}
@@ -0,0 +1,381 @@
+/**
+ * PIGO: a parallel graph and matrix I/O and preprocessing library
+ * Copyright (c) 2022 GT-TDALab
+ *
+ * This is pigo_micro, which times the single-threaded parsing and
+ * formatting primitives on generated inputs with varying digit lengths,
+ * whitespace and comment density, reporting throughput and cycles per
+ * byte.
+ */
+
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "pigo.hpp"
+#include "bench.hpp"
+
+using namespace std;
+using namespace pigo;
+using namespace pigo_bench;
+
+typedef Tensor<size_t, size_t, vector<size_t>, float, float*, false> offsets_t;
+
+/** Keeps benchmarked results alive */
+static volatile uint64_t sink;
+
+static void usage() {
+    cerr <<
+        "Usage: pigo_micro [options]\n"
+        "\n"
+        "Times FileReader parsing and ASCII formatting primitives on one\n"
+        "thread over generated inputs.\n"
+        "\n"
+        "Options:\n"
+        "  --size MB          bytes of each generated input (default: 16)\n"
+        "  --reps N           timed runs per benchmark (default: 5)\n"
+        "  --warmup N         untimed runs per benchmark (default: 1)\n"
+        "  --filter TEXT      only run benchmarks whose name contains TEXT\n"
+        "  --format FORMAT    table, json or csv (default: table)\n"
+        "  --output FILE      write the json or csv results to FILE\n"
+        "  --counters         count core cycles with perf_event_open instead\n"
+        "                     of the timestamp counter\n"
+        "  --list             list the benchmarks and exit\n";
+}
+
+/** @brief The deterministic values used to generate inputs */
+static uint64_t next_rand(uint64_t& state) {
+    state += 0x9E3779B97F4A7C15ull;
+    return detail::hash64_(state);
+}
+
+/** @brief Return a random integer with exactly the given digits */
+static uint64_t with_digits(uint64_t& state, int digits) {
+    uint64_t low = 1;
+    for (int d = 1; d < digits; ++d) low *= 10;
+    uint64_t span = (digits >= 20) ? ~0ull - low : low*9;
+    return low + next_rand(state) % span;
+}
+
+/** @brief The shape of a generated edge list */
+struct TextShape {
+    /** The digits of each integer */
+    int digits;
+    /** The separator between integers */
+    string sep;
+    /** The line ending */
+    string eol;
+    /** The percentage of lines that are comments */
+    int comment_pct;
+    /** The significant digits of a weight on every line, or 0 for none */
+    int fp_digits;
+};
+
+/** @brief Generate an edge list of about size bytes */
+static string edge_text(size_t size, const TextShape& shape) {
+    string out;
+    out.reserve(size + 64);
+    uint64_t state = 1;
+    char buf[64];
+    while (out.size() < size) {
+        if ((int)(next_rand(state) % 100) < shape.comment_pct) {
+            out += "% a comment line of moderate length, skipped by readers";
+            out += shape.eol;
+            continue;
+        }
+        out += to_string(with_digits(state, shape.digits));
+        out += shape.sep;
+        out += to_string(with_digits(state, shape.digits));
+        if (shape.fp_digits > 0) {
+            double w = (double)(next_rand(state) >> 11) / (1ull << 53) * 1000.;
+            snprintf(buf, sizeof(buf), "%.*g", shape.fp_digits, w);
+            out += shape.sep;
+            out += buf;
+        }
+        out += shape.eol;
+    }
+    return out;
+}
+
+/** @brief A generated input and a reader over it */
+struct Text {
+    string data;
+    FileReader reader() const {
+        return FileReader { data.data(), data.data() + data.size() };
+    }
+};
+
+/** @brief Build a benchmark that scans a generated input */
+static Benchmark scan_bench(const string& name, shared_ptr<Text> text, size_t items,
+        function<uint64_t(FileReader)> scan) {
+    return Benchmark {
+        name,
+        [text, scan]() { sink = scan(text->reader()); },
+        nullptr,
+        nullptr,
+        [text]() { return text->data.size(); },
+        items };
+}
+
+/** @brief Build a benchmark that formats values into a buffer */
+template<class T>
+static Benchmark format_bench(const string& name, shared_ptr<vector<T>> vals) {
+    shared_ptr<vector<char>> buf = make_shared<vector<char>>(
+            vals->size() * (max_write_size<T>()+1));
+    shared_ptr<size_t> written = make_shared<size_t>(0);
+    return Benchmark {
+        name,
+        [vals, buf, written]() {
+            FilePos fp = buf->data();
+            for (T v : *vals) {
+                write_ascii(fp, v);
+                write(fp, ' ');
+            }
+            *written = fp - buf->data();
+        },
+        nullptr,
+        nullptr,
+        [written]() { return *written; },
+        vals->size() };
+}
+
+/** @brief Build a benchmark that sizes the output of values */
+template<class T>
+static Benchmark size_bench(const string& name, shared_ptr<vector<T>> vals) {
+    size_t bytes = 0;
+    for (T v : *vals) bytes += write_size(v) + 1;
+    return Benchmark {
+        name,
+        [vals]() {
+            size_t total = 0;
+            for (T v : *vals) total += write_size(v);
+            sink = total;
+        },
+        nullptr,
+        nullptr,
+        [bytes]() { return bytes; },
+        vals->size() };
+}
+
+/** @brief Count the lines of a generated input that are not comments */
+static size_t count_entries(const Text& text) {
+    size_t lines = 0;
+    bool start = true;
+    for (char c : text.data) {
+        if (start && c != '%') ++lines;
+        start = (c == '\n');
+    }
+    return lines;
+}
+
+static vector<Benchmark> benchmarks(size_t size) {
+    vector<Benchmark> bs;
+    auto text = [size](const TextShape& shape) {
+        shared_ptr<Text> t = make_shared<Text>();
+        t->data = edge_text(size, shape);
+        return t;
+    };
+
+    auto next_int = [](FileReader r) -> uint64_t {
+        uint64_t count = 0;
+        r.move_to_first_int();
+        while (r.good()) {
+            r.move_to_next_int();
+            ++count;
+        }
+        return count;
+    };
+    auto read_ints = [](FileReader r) -> uint64_t {
+        uint64_t sum = 0;
+        r.move_to_first_int();
+        while (r.good()) {
+            sum += r.read_int<uint64_t>();
+            r.move_to_next_int();
+        }
+        return sum;
+    };
+
+    // Integer scanning and parsing over digit lengths
+    for (int digits : { 1, 3, 6, 10, 19 }) {
+        shared_ptr<Text> t = text(TextShape { digits, " ", "\n", 0, 0 });
+        size_t ints = 2*count_entries(*t);
+        string d = "/d" + to_string(digits);
+        bs.push_back(scan_bench("move_to_next_int" + d, t, ints, next_int));
+        bs.push_back(scan_bench("read_int" + d, t, ints, read_ints));
+    }
+
+    // Integer scanning over whitespace patterns and comment density
+    vector<pair<string, TextShape>> shapes {
+        { "tab", TextShape { 6, "\t", "\n", 0, 0 } },
+        { "spaces", TextShape { 6, "   \t ", "\n", 0, 0 } },
+        { "crlf", TextShape { 6, " ", "\r\n", 0, 0 } },
+        { "comments10", TextShape { 6, " ", "\n", 10, 0 } },
+        { "comments50", TextShape { 6, " ", "\n", 50, 0 } },
+    };
+    for (auto& shape : shapes) {
+        shared_ptr<Text> t = text(shape.second);
+        size_t ints = 2*count_entries(*t);
+        bs.push_back(scan_bench("move_to_next_int/" + shape.first, t, ints, next_int));
+        bs.push_back(scan_bench("read_int/" + shape.first, t, ints, read_ints));
+    }
+
+    // Floating point parsing over significant digits
+    for (int fp_digits : { 3, 9, 17 }) {
+        shared_ptr<Text> t = text(TextShape { 4, " ", "\n", 0, fp_digits });
+        bs.push_back(scan_bench("read_fp/d" + to_string(fp_digits), t, count_entries(*t),
+            [](FileReader r) -> uint64_t {
+                double sum = 0.;
+                // Skip both endpoints of each line, as the readers do
+                r.move_to_first_int();
+                while (r.good()) {
+                    r.move_to_next_int();
+                    r.move_to_non_int();
+                    r.move_to_fp();
+                    sum += r.read_fp<double>();
+                    r.move_to_non_fp();
+                    r.move_to_first_int();
+                }
+                return (uint64_t)sum;
+            }));
+    }
+
+    // Counting the columns of each line, as done to find tensor orders
+    for (auto& shape : { make_pair(string("space"), TextShape { 6, " ", "\n", 0, 0 }),
+            make_pair(string("spaces"), TextShape { 6, "   ", "\n", 0, 0 }) }) {
+        shared_ptr<Text> t = text(shape.second);
+        bs.push_back(scan_bench("count_spaces_to_eol/" + shape.first, t, count_entries(*t),
+            [](FileReader r) -> uint64_t {
+                uint64_t spaces = 0;
+                while (r.good()) {
+                    spaces += r.count_spaces_to_eol();
+                    r += 1;
+                }
+                return spaces;
+            }));
+    }
+
+    // Finding every newline
+    shared_ptr<Text> lines = text(TextShape { 6, " ", "\n", 0, 0 });
+    bs.push_back(scan_bench("find_offsets/newline", lines, count_entries(*lines),
+        [](FileReader r) -> uint64_t {
+            offsets_t offs = r.find_offsets<offsets_t>('\n');
+            return offs.m();
+        }));
+
+    // Sizing and formatting values
+    size_t num_vals = size / 8;
+    for (int digits : { 1, 3, 6, 10, 19 }) {
+        shared_ptr<vector<uint64_t>> vals = make_shared<vector<uint64_t>>(num_vals);
+        uint64_t state = digits;
+        for (auto& v : *vals) v = with_digits(state, digits);
+        string d = "/d" + to_string(digits);
+        bs.push_back(size_bench("write_size" + d, vals));
+        bs.push_back(format_bench("write_ascii" + d, vals));
+    }
+    shared_ptr<vector<double>> short_fps = make_shared<vector<double>>(num_vals);
+    shared_ptr<vector<double>> long_fps = make_shared<vector<double>>(num_vals);
+    uint64_t state = 3;
+    for (size_t i = 0; i < num_vals; ++i) {
+        (*short_fps)[i] = (double)(next_rand(state) % 100000) / 100.;
+        (*long_fps)[i] = (double)(next_rand(state) >> 11) / (1ull << 53) * 1e6;
+    }
+    bs.push_back(size_bench("write_size/fp_short", short_fps));
+    bs.push_back(format_bench("write_ascii/fp_short", short_fps));
+    bs.push_back(size_bench("write_size/fp_long", long_fps));
+    bs.push_back(format_bench("write_ascii/fp_long", long_fps));
+
+    return bs;
+}
+
+/** @brief Print the results as a table of per-byte costs */
+static void print_table(ostream& out, const vector<Result>& results, bool counters) {
+    out << left << setw(30) << "primitive" << right
+        << setw(12) << "bytes"
+        << setw(10) << "ns/byte"
+        << setw(10) << "GB/s"
+        << setw(12) << "Mitems/s"
+        << setw(14) << (counters ? "cycles/byte" : "ticks/byte") << "\n";
+    for (const Result& r : results) {
+        double ns = (r.bytes > 0) ? r.median() * 1e9 / r.bytes : 0.;
+        out << left << setw(30) << r.name << right
+            << setw(12) << r.bytes
+            << fixed << setprecision(3) << setw(10) << ns
+            << setw(10) << r.gbps()
+            << setprecision(1) << setw(12) << r.edges_per_sec()/1e6
+            << setprecision(3) << setw(14) << r.cycles_per_byte() << "\n";
+    }
+}
+
+int main(int argc, char** argv) {
+    Settings settings;
+    settings.threads = { 1 };
+    string format = "table", output;
+    size_t size_mb = 16;
+    bool list = false;
+    try {
+        for (int arg = 1; arg < argc; ++arg) {
+            string a { argv[arg] };
+            auto value = [&]() -> string {
+                if (arg+1 >= argc) throw Error("Missing value for " + a);
+                return argv[++arg];
+            };
+            if (a == "--size") size_mb = stoull(value());
+            else if (a == "--reps") settings.reps = stoi(value());
+            else if (a == "--warmup") settings.warmup = stoi(value());
+            else if (a == "--filter") settings.filter = value();
+            else if (a == "--format") format = value();
+            else if (a == "--output") output = value();
+            else if (a == "--counters") settings.counters = true;
+            else if (a == "--list") list = true;
+            else if (a == "-h" || a == "--help") {
+                usage();
+                return 0;
+            } else
+                throw Error("Unknown option " + a);
+        }
+        if (format != "table" && format != "json" && format != "csv")
+            throw Error("Unknown format " + format);
+        if (settings.reps < 1 || settings.warmup < 0 || size_mb == 0)
+            throw Error("Invalid repetition counts or size");
+    } catch (exception& e) {
+        cerr << "pigo_micro: " << e.what() << endl;
+        usage();
+        return 1;
+    }
+
+    if (list) {
+        for (const Benchmark& b : benchmarks(1024)) cout << b.name << endl;
+        return 0;
+    }
+    if (settings.counters && !enable_perf_counters()) {
+        cerr << "pigo_micro: hardware counters are unavailable, using the timestamp counter" << endl;
+        settings.counters = false;
+    }
+
+    cerr << "Generating " << size_mb << " MB inputs" << endl;
+    vector<Benchmark> all = benchmarks(size_mb << 20);
+
+    // The primitives are sequential, apart from find_offsets
+    set_threads(1);
+    ostringstream progress;
+    vector<Result> results = run_all(all, settings, progress);
+
+    if (format == "table") {
+        print_table(cout, results, settings.counters);
+        return 0;
+    }
+    vector<pair<string, string>> meta {
+        { "input_bytes", to_string(size_mb << 20) },
+        { "compiler", __VERSION__ },
+        { "counters", settings.counters ? "perf_event_open" : "tsc" },
+    };
+    ofstream file;
+    if (!output.empty()) file.open(output);
+    ostream& out = output.empty() ? cout : file;
+    if (format == "json") write_json(out, meta, results);
+    else write_csv(out, results);
+    return 0;
+}
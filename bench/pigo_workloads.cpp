@@ -0,0 +1,433 @@
+/**
+ * PIGO: a parallel graph and matrix I/O and preprocessing library
+ * Copyright (c) 2022 GT-TDALab
+ *
+ * This is pigo_workloads, which loads a graph with PIGO and then runs a
+ * reference BFS, PageRank or SpMV on it, timing the load, the compute and
+ * their total, so layout options can be judged by their end-to-end effect.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <numeric>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "pigo.hpp"
+#include "bench.hpp"
+#include "kernels.hpp"
+
+using namespace std;
+using namespace pigo;
+using namespace pigo_bench;
+
+typedef COO<> coo_t;
+typedef Graph graph_t;
+typedef DiGraph<> digraph_t;
+typedef Matrix<> matrix_t;
+
+static void usage() {
+    cerr <<
+        "Usage: pigo_workloads [options]\n"
+        "\n"
+        "Loads a graph with PIGO and runs BFS, PageRank or SpMV on it,\n"
+        "timing the load, the compute and their total. Without --input, a\n"
+        "synthetic graph is generated.\n"
+        "\n"
+        "Workloads:\n"
+        "  bfs                top-down BFS over a Graph\n"
+        "  pagerank_pull      PageRank pulling over DiGraph::in()\n"
+        "  pagerank_push      PageRank pushing over a Graph's out-edges\n"
+        "  spmv               repeated y = Ax over Matrix::csr()\n"
+        "\n"
+        "Options:\n"
+        "  --input FILE       use an edge list instead of a generated graph\n"
+        "  --graph KIND       generate a uniform or rmat graph (default: rmat)\n"
+        "  --scale S          generate 2^S vertices (default: 18)\n"
+        "  --edge-factor E    generate E edges per vertex (default: 16)\n"
+        "  --seed N           the generator seed (default: 1)\n"
+        "  --load FORMAT      load from the el edge list or from PIGO's\n"
+        "                     binary bin formats (default: el)\n"
+        "  --sort             sort the neighbor lists after loading\n"
+        "  --source V         the BFS source vertex (default: the vertex with\n"
+        "                     the most out-edges)\n"
+        "  --iterations N     PageRank and SpMV iterations (default: 20)\n"
+        "  --reps N           timed runs per workload (default: 5)\n"
+        "  --warmup N         untimed runs per workload (default: 1)\n"
+        "  --threads LIST     comma-separated thread counts (default: powers\n"
+        "                     of two up to the number of cores)\n"
+        "  --filter TEXT      only run workloads whose name contains TEXT\n"
+        "  --format FORMAT    table, json or csv (default: table)\n"
+        "  --output FILE      write the json or csv results to FILE\n"
+        "  --dir DIR          directory for temporary files (default: .)\n"
+        "  --list             list the workloads and exit\n";
+}
+
+static size_t file_size(const string& fn) {
+    struct stat st;
+    if (stat(fn.c_str(), &st) != 0) return 0;
+    return st.st_size;
+}
+
+/** @brief A workload, split into its timed load and compute steps
+ *
+ * release frees the loaded objects after each run, untimed, and checksum
+ * summarizes the last computed result so runs can be compared.
+ */
+struct Workload {
+    string name;
+    /** The file loaded */
+    string file;
+    function<void()> load;
+    function<void()> compute;
+    function<void()> release;
+    function<string()> checksum;
+    /** The edges traversed by one compute */
+    size_t edges;
+};
+
+/** @brief Holds the loaded objects and results of the workloads */
+struct State {
+    unique_ptr<graph_t> graph;
+    unique_ptr<digraph_t> dig;
+    unique_ptr<matrix_t> mat;
+    BFSResult bfs;
+    vector<double> ranks;
+    vector<double> x, y;
+
+    void release() {
+        if (graph) graph->free();
+        if (dig) dig->free();
+        if (mat) mat->free();
+        graph.reset();
+        dig.reset();
+        mat.reset();
+    }
+};
+
+/** @brief The files each object is loaded from */
+struct Files {
+    string graph, dig, mat;
+    vector<string> temps;
+
+    ~Files() {
+        for (const string& fn : temps) remove(fn.c_str());
+    }
+};
+
+static string checksum_str(double v) {
+    ostringstream out;
+    out << setprecision(9) << v;
+    return out.str();
+}
+
+static vector<Workload> workloads(const Files& files, bool sort, int64_t source,
+        int iterations, size_t m) {
+    vector<Workload> w;
+    shared_ptr<State> s = make_shared<State>();
+    // Copies of Files would remove the temporaries, so capture the names
+    string graph_fn = files.graph, dig_fn = files.dig, mat_fn = files.mat;
+    auto load_graph = [s, graph_fn, sort]() {
+        s->graph.reset(new graph_t { graph_fn });
+        if (sort) s->graph->sort();
+    };
+    auto release = [s]() { s->release(); };
+    auto rank_sum = [s]() {
+        return checksum_str(accumulate(s->ranks.begin(), s->ranks.end(), 0.));
+    };
+
+    w.push_back(Workload { "bfs", files.graph, load_graph,
+            [s, source]() {
+                if (source < 0 || (uint64_t)source >= s->graph->n())
+                    throw Error("The BFS source is not a vertex");
+                s->bfs = bfs(*s->graph, source);
+            },
+            release,
+            [s]() {
+                return to_string(s->bfs.reached) + " reached in " +
+                    to_string(s->bfs.levels) + " levels";
+            }, m });
+    w.push_back(Workload { "pagerank_pull", files.dig,
+            [s, dig_fn, sort]() {
+                s->dig.reset(new digraph_t { dig_fn });
+                if (sort) {
+                    s->dig->in().sort();
+                    s->dig->out().sort();
+                }
+            },
+            [s, iterations]() {
+                s->ranks = pagerank_pull(s->dig->in(), s->dig->out(), iterations);
+            },
+            release, rank_sum, m*iterations });
+    w.push_back(Workload { "pagerank_push", files.graph, load_graph,
+            [s, iterations]() { s->ranks = pagerank_push(*s->graph, iterations); },
+            release, rank_sum, m*iterations });
+    w.push_back(Workload { "spmv", files.mat,
+            [s, mat_fn, sort]() {
+                s->mat.reset(new matrix_t { mat_fn });
+                if (sort) {
+                    s->mat->csr().sort();
+                    s->mat->csc().sort();
+                }
+            },
+            [s, iterations]() {
+                s->x.assign(s->mat->ncols(), 1.);
+                s->y.assign(s->mat->nrows(), 0.);
+                for (int it = 0; it < iterations; ++it)
+                    spmv<false>(s->mat->csr(), s->x, s->y);
+            },
+            release,
+            [s]() { return checksum_str(accumulate(s->y.begin(), s->y.end(), 0.)); },
+            m*iterations });
+    return w;
+}
+
+/** @brief The load, compute and total timings of one workload */
+struct Timings {
+    Result load, compute, total;
+    string checksum;
+};
+
+static double seconds_since(chrono::steady_clock::time_point start) {
+    return chrono::duration<double>(chrono::steady_clock::now()-start).count();
+}
+
+/** @brief Run a workload at one thread count */
+static Timings run(const Workload& w, const Settings& settings, int threads) {
+    set_threads(threads);
+    Timings t;
+    Result* parts[] = { &t.load, &t.compute, &t.total };
+    const char* suffixes[] = { "/load", "/compute", "/total" };
+    for (int p = 0; p < 3; ++p) {
+        parts[p]->name = w.name + suffixes[p];
+        parts[p]->threads = threads;
+        parts[p]->ticks = 0;
+        parts[p]->peak_bytes = 0;
+    }
+    for (int rep = 0; rep < settings.warmup + settings.reps; ++rep) {
+        reset_memory_peaks();
+        auto start = chrono::steady_clock::now();
+        w.load();
+        double load = seconds_since(start);
+        size_t load_peak = memory_usage().peak;
+        reset_memory_peaks();
+        auto compute_start = chrono::steady_clock::now();
+        w.compute();
+        double compute = seconds_since(compute_start);
+        size_t compute_peak = memory_usage().peak;
+        if (rep == settings.warmup + settings.reps - 1)
+            t.checksum = w.checksum();
+        w.release();
+        if (rep >= settings.warmup) {
+            t.load.seconds.push_back(load);
+            t.compute.seconds.push_back(compute);
+            t.total.seconds.push_back(load + compute);
+            t.load.peak_bytes = max(t.load.peak_bytes, load_peak);
+            t.compute.peak_bytes = max(t.compute.peak_bytes, compute_peak);
+            t.total.peak_bytes = max(t.load.peak_bytes, t.compute.peak_bytes);
+        }
+    }
+    size_t bytes = file_size(w.file);
+    t.load.bytes = t.total.bytes = bytes;
+    t.compute.bytes = 0;
+    t.load.edges = t.compute.edges = t.total.edges = w.edges;
+    return t;
+}
+
+static string timestamp() {
+    char buf[64];
+    time_t now = time(nullptr);
+    strftime(buf, sizeof(buf), "%Y-%m-%dT%H:%M:%SZ", gmtime(&now));
+    return buf;
+}
+
+static string hostname() {
+    char buf[256] = {0};
+    if (gethostname(buf, sizeof(buf)-1) != 0) return "unknown";
+    return buf;
+}
+
+int main(int argc, char** argv) {
+    Settings settings;
+    string input, graph = "rmat", load = "el", format = "table", output, dir = ".";
+    int scale = 18, edge_factor = 16, iterations = 20;
+    uint64_t seed = 1;
+    int64_t source = -1;
+    bool sort = false, list = false;
+    try {
+        for (int arg = 1; arg < argc; ++arg) {
+            string a { argv[arg] };
+            auto value = [&]() -> string {
+                if (arg+1 >= argc) throw Error("Missing value for " + a);
+                return argv[++arg];
+            };
+            if (a == "--input") input = value();
+            else if (a == "--graph") graph = value();
+            else if (a == "--scale") scale = stoi(value());
+            else if (a == "--edge-factor") edge_factor = stoi(value());
+            else if (a == "--seed") seed = stoull(value());
+            else if (a == "--load") load = value();
+            else if (a == "--sort") sort = true;
+            else if (a == "--source") source = stoll(value());
+            else if (a == "--iterations") iterations = stoi(value());
+            else if (a == "--reps") settings.reps = stoi(value());
+            else if (a == "--warmup") settings.warmup = stoi(value());
+            else if (a == "--threads") settings.threads = parse_threads(value());
+            else if (a == "--filter") settings.filter = value();
+            else if (a == "--format") format = value();
+            else if (a == "--output") output = value();
+            else if (a == "--dir") dir = value();
+            else if (a == "--list") list = true;
+            else if (a == "-h" || a == "--help") {
+                usage();
+                return 0;
+            } else
+                throw Error("Unknown option " + a);
+        }
+        if (graph != "uniform" && graph != "rmat")
+            throw Error("Unknown graph " + graph);
+        if (load != "el" && load != "bin")
+            throw Error("Unknown load format " + load);
+        if (format != "table" && format != "json" && format != "csv")
+            throw Error("Unknown format " + format);
+        if (settings.reps < 1 || settings.warmup < 0 || iterations < 1)
+            throw Error("Invalid repetition counts");
+        if (scale < 1 || scale > 31 || edge_factor < 1)
+            throw Error("Invalid graph size");
+    } catch (exception& e) {
+        cerr << "pigo_workloads: " << e.what() << endl;
+        usage();
+        return 1;
+    }
+    if (settings.threads.empty()) {
+        int max_t = max_threads();
+        for (int t = 1; t < max_t; t *= 2) settings.threads.push_back(t);
+        settings.threads.push_back(max_t);
+    }
+
+    Files files;
+    if (list) {
+        for (const Workload& w : workloads(files, sort, source, iterations, 0))
+            cout << w.name << endl;
+        return 0;
+    }
+
+    size_t n, m;
+    try {
+        unique_ptr<coo_t> coo;
+        if (input.empty()) {
+            uint32_t nv = 1u << scale;
+            if (graph == "rmat")
+                coo.reset(new coo_t(generate_rmat(scale, edge_factor, seed)));
+            else
+                coo.reset(new coo_t(generate_gnm(nv, (uint64_t)nv*edge_factor, seed)));
+        } else
+            coo.reset(new coo_t { input });
+        n = coo->n();
+        m = coo->m();
+        cerr << "Preparing inputs with " << n << " vertices and " << m << " edges" << endl;
+
+        // Generated vertices are permuted, so find a well-connected source
+        if (source < 0) {
+            vector<size_t> degrees(n, 0);
+            for (size_t e = 0; e < m; ++e) ++degrees[coo->x()[e]];
+            source = max_element(degrees.begin(), degrees.end()) - degrees.begin();
+        }
+
+        auto temp = [&](const string& suffix) {
+            string fn = dir + "/.pigo_workloads." + suffix;
+            files.temps.push_back(fn);
+            return fn;
+        };
+        if (load == "el") {
+            string el = input;
+            if (el.empty()) {
+                el = temp("el");
+                coo->write(el);
+            }
+            files.graph = files.dig = files.mat = el;
+        } else {
+            // Each object loads its own binary format
+            graph_t g { *coo };
+            files.graph = temp("csr.pigo");
+            g.save(files.graph);
+            g.free();
+            digraph_t dig { *coo };
+            files.dig = temp("dig.pigo");
+            dig.save(files.dig);
+            dig.free();
+            files.mat = temp("coo.pigo");
+            coo->save(files.mat);
+        }
+        coo->free();
+    } catch (exception& e) {
+        cerr << "pigo_workloads: " << e.what() << endl;
+        return 1;
+    }
+
+    vector<Workload> all = workloads(files, sort, source, iterations, m);
+
+    // Progress goes to stderr so that results can be piped
+    ostream& progress = (format == "table") ? cout : cerr;
+    vector<Result> results;
+    vector<pair<string, string>> checksums;
+    try {
+        for (const Workload& w : all) {
+            if (!settings.filter.empty() && w.name.find(settings.filter) == string::npos)
+                continue;
+            for (int t : settings.threads) {
+                Timings r = run(w, settings, t);
+                progress << left << setw(16) << w.name << right
+                    << " threads=" << setw(3) << t
+                    << fixed << setprecision(4)
+                    << "  load " << r.load.median() << " s"
+                    << "  compute " << r.compute.median() << " s"
+                    << "  total " << r.total.median() << " s"
+                    << setprecision(1) << "  " << r.total.edges_per_sec()/1e6 << " Medges/s"
+                    << "  peak " << r.total.peak_bytes/1048576. << " MiB"
+                    << "  [" << r.checksum << "]" << endl;
+                results.push_back(r.load);
+                results.push_back(r.compute);
+                results.push_back(r.total);
+                checksums.push_back({ w.name + "_checksum_" + to_string(t), r.checksum });
+            }
+        }
+    } catch (exception& e) {
+        cerr << "pigo_workloads: " << e.what() << endl;
+        return 1;
+    }
+    set_threads(max_threads());
+
+    if (format != "table") {
+        vector<pair<string, string>> meta {
+            { "input", input.empty() ? graph + ", scale " + to_string(scale) +
+                ", edge factor " + to_string(edge_factor) : input },
+            { "vertices", to_string(n) },
+            { "edges", to_string(m) },
+            { "load", load },
+            { "sort", sort ? "true" : "false" },
+            { "source", to_string(source) },
+            { "iterations", to_string(iterations) },
+            { "max_threads", to_string(max_threads()) },
+            { "host", hostname() },
+            { "compiler", __VERSION__ },
+            { "timestamp", timestamp() },
+        };
+        meta.insert(meta.end(), checksums.begin(), checksums.end());
+        ofstream file;
+        if (!output.empty()) file.open(output);
+        ostream& out = output.empty() ? cout : file;
+        if (format == "json") write_json(out, meta, results);
+        else write_csv(out, results);
+    }
+    return 0;
+}
@@ -11,15 +11,12 @@
 
 #include <stdexcept>
 #include <memory>
+#include <mutex>
 #include <vector>
 #include <string>
 
 namespace pigo {
 
-    #ifndef _OPENMP
-    #pragma message("NOTICE: you are compiling without OpenMP support. PIGO will not be parallel!")
-    #endif
-
     /** @brief Thrown by errors detected in PIGO */
     class Error : public ::std::runtime_error {
         public:
@@ -301,6 +298,81 @@ namespace pigo {
         WRITE
     };
 
+    /** @brief The supported strategies for writing ASCII files
+     *
+     * TWO_PASS first computes the size of every value, then formats every
+     * value directly into the file. BUFFERED formats every value once into
+     * per-thread buffers and then copies the buffers into the file,
+     * halving the formatting work at the cost of holding the formatted
+     * output in memory. STREAM formats chunks of values in parallel and
+     * writes them in order through a WStream, so the output size is never
+     * needed and the file name "-" writes to standard output. GZIP and
+     * ZSTD stream in the same way, but each thread also compresses its
+     * chunks independently, as concatenated gzip members or as zstd frames
+     * followed by a seek table. These need PIGO_HAVE_ZLIB or
+     * PIGO_HAVE_ZSTD, respectively.
+     */
+    enum WriteMode {
+        /** Size every value, then format directly into the file */
+        TWO_PASS,
+        /** Format once into per-thread buffers, then copy into the file */
+        BUFFERED,
+        /** Format chunks in parallel and write them in order to a stream */
+        STREAM,
+        /** Stream chunks compressed in parallel as gzip members */
+        GZIP,
+        /** Stream chunks compressed in parallel as seekable zstd frames */
+        ZSTD
+    };
+
+    /** @brief The supported strategies for saving binary files
+     *
+     * MAPPED writes through a shared memory map of the presized file,
+     * leaving writeback to the kernel. DIRECT preallocates the file and
+     * writes aligned blocks from all threads with pwrite and O_DIRECT,
+     * bypassing the page cache. Where O_DIRECT is unavailable, writeback
+     * is started as each block is written instead.
+     */
+    enum SaveMode {
+        /** Write through a shared memory map */
+        MAPPED,
+        /** Write aligned blocks in parallel, bypassing the page cache */
+        DIRECT
+    };
+
+    /** @brief The supported checksums for binary files
+     *
+     * With CRC32C, a binary save appends a trailer with the CRC32C
+     * checksums of every block of every section of the file. Loading a
+     * file with such a trailer verifies each block as it is read, and
+     * throws an Error naming the offset of any corrupted block.
+     */
+    enum ChecksumMode {
+        /** Save without checksums */
+        NO_CHECKSUM,
+        /** Save with per-block CRC32C checksums */
+        CRC32C
+    };
+
+    /** @brief Reports the work done by a binary save */
+    struct SaveStats {
+        /** The number of bytes saved */
+        size_t bytes;
+        /** The time taken to save, in seconds */
+        double seconds;
+
+        /** @brief Return the achieved bandwidth in bytes per second */
+        double bandwidth() const {
+            return (seconds > 0) ? bytes / seconds : 0.;
+        }
+    };
+
+    class ChecksumWriter;
+
+    namespace detail {
+        class ChecksumReader_;
+    }
+
     /** @brief Manages a file opened for parallel access */
     class File {
         protected:
@@ -312,6 +384,8 @@ namespace pigo {
             FilePos fp_;
             /** The filename */
             std::string fn_;
+            /** The checksums computed while writing regions, if any */
+            ChecksumWriter* sums_;
         public:
             /** @brief Opens the given file
              *
@@ -332,7 +406,7 @@ namespace pigo {
             File& operator=(const File&) = delete;
 
             /** @brief Move constructor */
-            File(File &&o) {
+            File(File &&o) : sums_(o.sums_) {
                 data_ = o.data_;
                 size_ = o.size_;
             }
@@ -384,6 +458,13 @@ namespace pigo {
             */
             void parallel_write(char* v, size_t v_size);
 
+            /** @brief Checksum each region as it is written
+             *
+             * @param sums the ChecksumWriter holding the layout of the
+             *        save, or nullptr to stop checksumming
+             */
+            void checksum_regions(ChecksumWriter* sums) { sums_ = sums; }
+
             /** @brief Read a binary region in parallel
             *
             * @param v the region of data to save to
@@ -394,6 +475,9 @@ namespace pigo {
             /** @brief Return the size of the file */
             size_t size() { return size_; }
 
+            /** @brief Return the offset of the current file position */
+            size_t tell() { return fp_ - data_; }
+
             /** @brief Auto-detect the file type
              *
              * This will determine the file type based on a mixture of the
@@ -435,6 +519,302 @@ namespace pigo {
                 File(fn, WRITE, max_size) { }
     };
 
+    /** @brief Writes a binary file of known size with parallel pwrite
+     *
+     * This provides the writing interface of File used by the binary
+     * saves, without a memory map. The file is preallocated, and output
+     * is gathered into aligned blocks that are written by all threads
+     * with O_DIRECT when supported. Otherwise, writeback of each block is
+     * started right away and the written pages are dropped from the page
+     * cache on close.
+     */
+    class DirectWFile {
+        private:
+            /** The alignment of all writes */
+            static const size_t align_ = 4096;
+            /** The size of the blocks each thread writes at once */
+            static const size_t chunk_ = 1<<23;
+            /** The file descriptor */
+            int fd_;
+            /** Whether the file was opened with O_DIRECT */
+            bool direct_;
+            /** The final size of the file */
+            size_t size_;
+            /** The number of bytes written so far */
+            size_t pos_;
+            /** The aligned buffer holding the last partial block */
+            char* tail_;
+            /** The number of bytes used in the tail buffer */
+            size_t tail_used_;
+            /** The checksums computed while writing regions, if any */
+            ChecksumWriter* sums_;
+
+            /** @brief Write a full, aligned buffer at the given offset */
+            void pwrite_(const char* buf, size_t size, size_t offset);
+
+            /** @brief Write out the tail buffer, padding it to a block */
+            void flush_tail_();
+
+            /** @brief Append a small region through the tail buffer */
+            void append_(const char* data, size_t size);
+        public:
+            /** @brief Creates the given file
+             *
+             * @param fn the file name to create, removing any old file
+             * @param size the exact size that will be written
+             */
+            DirectWFile(std::string fn, size_t size);
+
+            /** @brief Closes the file if close() was not called */
+            ~DirectWFile() noexcept;
+
+            /** @brief Copying DirectWFile is unavailable */
+            DirectWFile(const DirectWFile&) = delete;
+
+            /** @brief Copying DirectWFile is unavailable */
+            DirectWFile& operator=(const DirectWFile&) = delete;
+
+            /** @brief Write the given value to the file
+             *
+             * @tparam T the type of object to write
+             * @param val the value to write
+             */
+            template<class T> void write(T val) {
+                append_((const char*)&val, sizeof(T));
+            }
+
+            /** @brief Write the given string to the file
+             *
+             * @param s the string to write
+             */
+            void write(const std::string& s) { append_(s.data(), s.size()); }
+
+            /** @brief Write a binary region in parallel
+            *
+            * @param v the region of data to write
+            * @param v_size the size of the region of data to write
+            */
+            void parallel_write(char* v, size_t v_size);
+
+            /** @brief Checksum each region as it is written
+             *
+             * @param sums the ChecksumWriter holding the layout of the
+             *        save, or nullptr to stop checksumming
+             */
+            void checksum_regions(ChecksumWriter* sums) { sums_ = sums; }
+
+            /** @brief Write any remaining data and close the file
+             *
+             * The data is synchronized to the device before returning.
+             * An error is thrown if the file was not entirely written.
+             */
+            void close();
+
+            /** @brief Return whether O_DIRECT is used */
+            bool direct() const { return direct_; }
+
+            /** @brief Return the size of the file */
+            size_t size() const { return size_; }
+    };
+
+    /** @brief Computes the CRC32C checksums of a binary save
+     *
+     * Objects first save into a ChecksumWriter just as they save into a
+     * file, which records the layout of the output. It is split into
+     * sections: each region written in parallel, and the values written
+     * between them. The values are checksummed right away, while the
+     * regions are only recorded. The file being saved is then given the
+     * ChecksumWriter with checksum_regions, and each of its threads
+     * checksums the blocks of a region right after copying them.
+     * trailer() returns the checksums to append to the saved file.
+     */
+    class ChecksumWriter {
+        private:
+            /** @brief The checksum of part of a block, taken by one thread */
+            struct Piece_ {
+                /** The index of the block's checksum */
+                size_t block;
+                /** The offset of the part within its section */
+                size_t offset;
+                /** The size of the part */
+                size_t size;
+                /** The checksum of the part */
+                uint32_t crc;
+            };
+
+            /** The size of each checksummed block */
+            size_t block_size_;
+            /** The values written since the last region */
+            std::string header_;
+            /** The number of bytes written so far */
+            size_t pos_;
+            /** The offset of each section */
+            std::vector<uint64_t> offsets_;
+            /** The size of each section */
+            std::vector<uint64_t> sizes_;
+            /** Whether each section was written in parallel */
+            std::vector<uint64_t> regions_;
+            /** The index of the first block checksum of each section */
+            std::vector<size_t> first_;
+            /** The checksums of every block of every section */
+            std::vector<uint32_t> crcs_;
+            /** The next section to look for a written region from */
+            size_t next_section_;
+            /** The parts of blocks split between threads */
+            std::vector<Piece_> pieces_;
+            /** Guards pieces_ */
+            std::mutex pieces_mutex_;
+
+            /** @brief Add the next section of the output
+             *
+             * @param data the section to checksum, or nullptr to leave
+             *        its checksums to be computed as it is written
+             * @param size the size of the section
+             * @param region whether the section is written in parallel
+             */
+            void add_section_(const char* data, size_t size, bool region);
+
+            /** @brief Checksum the values written since the last region */
+            void flush_header_();
+
+            /** @brief Start checksumming the next region written
+             *
+             * @param size the size of the region
+             * @return the region's section
+             */
+            size_t begin_region_(size_t size);
+
+            /** @brief Checksum part of a region, after it was copied
+             *
+             * This is called by the writing threads in parallel.
+             *
+             * @param sec the region's section
+             * @param offset the offset of the part within the region
+             * @param data the part
+             * @param size the size of the part
+             */
+            void add_region_part_(size_t sec, size_t offset, const char* data, size_t size);
+
+            /** @brief Combine the blocks split between threads */
+            void end_region_();
+
+            friend class File;
+            friend class DirectWFile;
+        public:
+            /** @brief Prepares to checksum a save
+             *
+             * @param block_size the size of each checksummed block
+             */
+            ChecksumWriter(size_t block_size=(1<<20));
+
+            /** @brief Add the given value to the output
+             *
+             * @tparam T the type of object to write
+             * @param val the value to write
+             */
+            template<class T> void write(T val) {
+                header_.append((const char*)&val, sizeof(T));
+            }
+
+            /** @brief Add the given string to the output
+             *
+             * @param s the string to write
+             */
+            void write(const std::string& s) { header_ += s; }
+
+            /** @brief Record a binary region of the output
+            *
+            * The region is not read here; it is checksummed when written.
+            *
+            * @param v the region of data
+            * @param v_size the size of the region of data
+            */
+            void parallel_write(char* v, size_t v_size);
+
+            /** @brief Return the size of the trailer */
+            size_t trailer_size();
+
+            /** @brief Return the trailer holding all checksums
+             *
+             * This is appended to the end of the saved file, once every
+             * region was written.
+             */
+            std::string trailer();
+    };
+
+    /** @brief Writes output sequentially to a file descriptor
+     *
+     * Unlike WFile, the total size does not need to be known ahead of
+     * time, so a WStream can write to standard output, pipes, or files
+     * of unknown size. Writes are gathered into a large buffer, which is
+     * passed on to the descriptor in order.
+     */
+    class WStream {
+        private:
+            /** The file descriptor written to */
+            int fd_;
+            /** Whether the file descriptor is closed by the stream */
+            bool owned_;
+            /** The buffer of pending output */
+            std::vector<char> buf_;
+            /** The number of pending bytes in the buffer */
+            size_t used_;
+            /** The number of bytes passed to the file descriptor */
+            size_t written_;
+
+            /** @brief Write out a region, retrying partial writes */
+            void write_fd_(const char* data, size_t size);
+        public:
+            /** @brief Opens the given file for streaming
+             *
+             * @param fn the file name to open, where an existing file is
+             *        removed. The name "-" uses standard output.
+             * @param buffer_size the size of the output buffer
+             */
+            WStream(std::string fn, size_t buffer_size=(1<<24));
+
+            /** @brief Streams to an already open file descriptor
+             *
+             * The file descriptor is not closed by the stream.
+             *
+             * @param fd the open file descriptor
+             * @param buffer_size the size of the output buffer
+             */
+            WStream(int fd, size_t buffer_size=(1<<24));
+
+            /** @brief Flushes the output and closes any opened file
+             *
+             * Errors cannot be reported here, so call flush() first to
+             * detect them.
+             */
+            ~WStream() noexcept;
+
+            /** @brief Copying WStream is unavailable */
+            WStream(const WStream&) = delete;
+
+            /** @brief Copying WStream is unavailable */
+            WStream& operator=(const WStream&) = delete;
+
+            /** @brief Append a region to the stream
+             *
+             * @param data the region to write
+             * @param size the size of the region
+             */
+            void write(const char* data, size_t size);
+
+            /** @brief Append a string to the stream
+             *
+             * @param s the string to write
+             */
+            void write(const std::string& s) { write(s.data(), s.size()); }
+
+            /** @brief Pass all buffered output to the file descriptor */
+            void flush();
+
+            /** @brief Return the number of bytes written so far */
+            size_t size() const { return written_ + used_; }
+    };
+
     /** @brief Read a binary value from an open file
      *
      * Reads a binary value out from the given file position. The file
@@ -497,12 +877,34 @@ namespace pigo {
         typename std::enable_if<std::is_floating_point<T>::value, bool>::type = true
         > inline void write_ascii(FilePos &fp, T obj);
 
+    /** @brief Return an upper bound on the size taken to write a type
+     *
+     * @tparam T the type of the object
+     *
+     * @return size_t the largest number of bytes write_ascii can use for
+     *         any object of type T
+     */
+    template<typename T> inline size_t max_write_size();
+
     namespace detail {
 
+        /** @brief Count bytes allocated at p towards a kind of structure
+         *
+         * See memory.hpp for the reported usage.
+         *
+         * @param p the start of the allocation
+         * @param bytes the bytes allocated
+         * @param kind the kind of structure, such as coo or temporary
+         */
+        void track_alloc_(void* p, size_t bytes, const char* kind);
+
+        /** @brief Stop counting the allocation at p, if it is counted */
+        void track_free_(void* p);
+
         /** A holder for allocation implementations */
         template<bool do_alloc, typename T, bool ptr_flag, bool vec_flag, bool sptr_flag>
         struct allocate_impl_ {
-            static void op_(T&, size_t) {
+            static void op_(T&, size_t, const char*) {
                 throw Error("Invalid allocation strategy");
             }
         };
@@ -510,54 +912,65 @@ namespace pigo {
         /** The implementation that will not allocate */
         template<typename T, bool ptr_flag, bool vec_flag, bool sptr_flag>
         struct allocate_impl_<false, T, ptr_flag, vec_flag, sptr_flag> {
-            static void op_(T&, size_t) { }
+            static void op_(T&, size_t, const char*) { }
         };
 
         /** The raw pointer allocation implementation */
         template<typename T>
         struct allocate_impl_<true, T, true, false, false> {
-            static void op_(T& it, size_t nmemb) {
-                it = static_cast<T>(malloc(sizeof(*(T){nullptr})*nmemb));
+            static void op_(T& it, size_t nmemb, const char* kind) {
+                size_t bytes = sizeof(*(T){nullptr})*nmemb;
+                it = static_cast<T>(malloc(bytes));
                 if (it == NULL)
                     throw Error("Unable to allocate");
+                track_alloc_(it, bytes, kind);
             }
         };
 
         /** The vector allocation implementation */
         template<typename T>
         struct allocate_impl_<true, T, false, true, false> {
-            static void op_(T& it, size_t nmemb) {
+            static void op_(T& it, size_t nmemb, const char* kind) {
                 it.resize(nmemb);
+                track_alloc_(it.data(), sizeof(typename T::value_type)*it.capacity(), kind);
             }
         };
 
         /** The shared_ptr allocation implementation */
         template<typename T>
         struct allocate_impl_<true, T, false, false, true> {
-            static void op_(T& it, size_t nmemb) {
-                it = std::shared_ptr<typename T::element_type>(
-                        new typename T::element_type[nmemb],
-                        std::default_delete<typename T::element_type []>()
-                        );
+            static void op_(T& it, size_t nmemb, const char* kind) {
+                typedef typename T::element_type E;
+                E* p = new E[nmemb];
+                track_alloc_(p, sizeof(E)*nmemb, kind);
+                // The count ends with the last reference
+                it = std::shared_ptr<E>(p, [](E* d) {
+                            track_free_(d);
+                            delete [] d;
+                        });
             }
         };
 
         /** @brief Allocates the given item appropriately
         *
+        * The allocation is counted towards kind in memory_usage. Callers
+        * check the limit with check_alloc_ first.
+        *
         * @tparam T the storage type
         * @tparam do_alloc whether to allocate or not
         * @param[out] it the item that will be allocated
         * @param nmemb the number of members to allocate
+        * @param kind the kind of structure the item belongs to
         */
         template<class T, bool do_alloc=true>
         inline
-        void allocate_mem_(T& it, size_t nmemb) {
+        void allocate_mem_(T& it, size_t nmemb, const char* kind="temporary") {
             // Use the appropriate allocation strategy
             allocate_impl_<do_alloc, T,
                 std::is_pointer<T>::value,
                 is_vector<T>::value,
                 is_sptr<T>::value
-            >::op_(it, nmemb);
+            >::op_(it, nmemb, kind);
         }
 
         /** A holder for freeing implementations */
@@ -570,14 +983,19 @@ namespace pigo {
         template<typename T>
         struct free_impl_<true, T, true, false, false> {
             static void op_(T& it) {
+                track_free_(it);
                 free(it);
+                it = nullptr;
             }
         };
 
         /** The vector allocation implementation */
         template<typename T>
         struct free_impl_<true, T, false, true, false> {
-            static void op_(T&) { }
+            static void op_(T& it) {
+                // The vector releases its memory when destroyed
+                track_free_(it.data());
+            }
         };
 
         /** The shared_ptr allocation implementation */
@@ -814,18 +1232,36 @@ namespace pigo {
 }
 
 // Load the rest of PIGO
+// The execution context is used by the structures' inline copies
+#include "pigo/execution.hpp"
 #include "pigo/coo.hpp"
 #include "pigo/csr.hpp"
 #include "pigo/matrix.hpp"
 #include "pigo/graph.hpp"
 #include "pigo/tensor.hpp"
+#include "pigo/sample.hpp"
+#include "pigo/generate.hpp"
+#include "pigo/instrument.hpp"
+#include "pigo/trace.hpp"
+#include "pigo/progress.hpp"
+#include "pigo/memory.hpp"
+#include "pigo/async.hpp"
 
 // Load the implementations
-#include "pigo/impl/stb.impl.hpp"
 #include "pigo/impl/pigo.impl.hpp"
+#include "pigo/impl/fp.impl.hpp"
+#include "pigo/impl/checksum.impl.hpp"
 #include "pigo/impl/coo.impl.hpp"
 #include "pigo/impl/csr.impl.hpp"
 #include "pigo/impl/graph.impl.hpp"
 #include "pigo/impl/tensor.impl.hpp"
+#include "pigo/impl/sample.impl.hpp"
+#include "pigo/impl/generate.impl.hpp"
+#include "pigo/impl/instrument.impl.hpp"
+#include "pigo/impl/trace.impl.hpp"
+#include "pigo/impl/progress.impl.hpp"
+#include "pigo/impl/memory.impl.hpp"
+#include "pigo/impl/execution.impl.hpp"
+#include "pigo/impl/async.impl.hpp"
 
 #endif /* PIGO_HPP */
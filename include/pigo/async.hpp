@@ -0,0 +1,227 @@
+/**
+ * PIGO: a parallel graph and matrix I/O and preprocessing library
+ * Copyright (c) 2022 GT-TDALab
+ *
+ * This file contains asynchronous loading and saving
+ */
+
+#ifndef PIGO_ASYNC_HPP
+#define PIGO_ASYNC_HPP
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace pigo {
+
+    namespace detail {
+
+        /** @brief The state shared by an operation running in the
+         *         background and its handles
+         */
+        class AsyncStateBase_ {
+            private:
+                mutable std::mutex mutex_;
+                mutable std::condition_variable finished_;
+                bool done_;
+                bool cancelled_;
+                std::exception_ptr error_;
+                /** The monitor of the running operation, if started */
+                ProgressMonitor* monitor_;
+                Progress progress_;
+            public:
+                AsyncStateBase_() : done_(false), cancelled_(false), monitor_(nullptr) { }
+                virtual ~AsyncStateBase_() { }
+
+                /** @brief Run the operation on the calling thread
+                 *
+                 * @param context the context of the thread that started it
+                 */
+                void run(const ExecutionContext& context);
+
+                /** @brief Perform the operation, storing its result */
+                virtual void perform() = 0;
+
+                /** @brief Return whether the operation has finished */
+                bool ready() const;
+
+                /** @brief Wait for the operation to finish */
+                void wait() const;
+
+                /** @brief Wait for the operation to finish, up to a timeout
+                 *
+                 * @return whether it has finished
+                 */
+                bool wait_for(double seconds) const;
+
+                /** @brief Wait, then rethrow any exception of the operation */
+                void wait_and_rethrow() const;
+
+                /** @brief Cancel the operation */
+                void cancel();
+
+                /** @brief Return the progress last reported */
+                Progress progress() const;
+        };
+
+        /** @brief Free a result that is a PIGO structure */
+        template<class T>
+        auto free_result_(T& result, int) -> decltype(result.free(), void()) {
+            result.free();
+        }
+
+        /** @brief Results without storage, such as SaveStats, need nothing */
+        template<class T>
+        void free_result_(T&, long) { }
+
+        /** @brief An operation running in the background with a result */
+        template<class T>
+        class AsyncState_ : public AsyncStateBase_ {
+            private:
+                std::function<void(std::unique_ptr<T>&)> op_;
+            public:
+                /** The result, once the operation has finished */
+                std::unique_ptr<T> result;
+                /** Whether get() handed the result to the caller */
+                std::atomic<bool> taken;
+
+                /** @brief Prepare an operation
+                 *
+                 * @param op creates the result in place
+                 */
+                AsyncState_(std::function<void(std::unique_ptr<T>&)> op) :
+                    op_(op), taken(false) { }
+
+                /** @brief Free a result that no handle got */
+                ~AsyncState_() {
+                    if (result && !taken) free_result_(*result, 0);
+                }
+
+                void perform() override {
+                    op_(result);
+                    // Release what the operation captured
+                    op_ = nullptr;
+                }
+        };
+
+        /** @brief Start an operation on the executor of the calling
+         *         thread's context
+         *
+         * @param state the operation to start
+         */
+        void launch_async_(std::shared_ptr<AsyncStateBase_> state);
+
+    }
+
+    /** @brief A handle to a PIGO operation running in the background
+     *
+     * Handles are returned by load_async and save_async, and work like a
+     * std::shared_future: copies share the operation, and get() can be
+     * called any number of times. Dropping every handle does not stop the
+     * operation.
+     *
+     * @tparam T the type of the operation's result
+     */
+    template<class T>
+    class Async {
+        private:
+            std::shared_ptr<detail::AsyncState_<T>> state_;
+        public:
+            /** @brief Create a handle without an operation */
+            Async() { }
+
+            /** @brief Create a handle to a started operation */
+            Async(std::shared_ptr<detail::AsyncState_<T>> state) : state_(state) { }
+
+            /** @brief Return whether the handle refers to an operation */
+            bool valid() const { return (bool)state_; }
+
+            /** @brief Return whether the operation has finished */
+            bool ready() const { return state_->ready(); }
+
+            /** @brief Wait for the operation to finish */
+            void wait() const { state_->wait(); }
+
+            /** @brief Wait for the operation to finish, up to a timeout
+             *
+             * @param timeout the longest time to wait
+             * @return whether the operation has finished
+             */
+            template<class Rep, class Period>
+            bool wait_for(const std::chrono::duration<Rep, Period>& timeout) const {
+                return state_->wait_for(
+                        std::chrono::duration<double>(timeout).count());
+            }
+
+            /** @brief Wait for the result and return it
+             *
+             * The result stays in the handle's shared state, so it is not
+             * copied. Once get() has returned it, the caller owns its
+             * storage: like any PIGO structure, a loaded structure is
+             * freed with free() once no longer needed. A result that no
+             * handle got is freed along with the last handle.
+             *
+             * @return the result of the operation
+             * @throws Cancelled if the operation was cancelled, or
+             *         whatever else the operation threw
+             */
+            T& get() const {
+                state_->wait_and_rethrow();
+                state_->taken = true;
+                return *state_->result;
+            }
+
+            /** @brief Cancel the operation
+             *
+             * A running operation stops at its next chunk boundary, and
+             * one that has not started yet does not start; get() then
+             * throws Cancelled. Operations that finished are unaffected.
+             */
+            void cancel() { state_->cancel(); }
+
+            /** @brief Return the progress the operation last reported */
+            Progress progress() const { return state_->progress(); }
+    };
+
+    /** @brief Load a file in the background
+     *
+     * The load runs as a job of the calling thread's executor (see
+     * ExecutionContext), in the calling thread's context. With a
+     * ThreadPool, each load occupies one worker and splits its steps
+     * across the free workers, so several loads proceed at once with no
+     * more threads than the pool has. Contexts without an executor run
+     * the load, and its steps, on a shared ThreadPool with one worker
+     * per OpenMP thread, so concurrent loads stay within that many
+     * threads.
+     *
+     * @tparam T the structure to load, such as CSR<> or COO<>
+     * @param fn the file name to load
+     * @param ft the FileType of the file, or AUTO to detect it
+     * @return a handle to the loading structure
+     */
+    template<class T>
+    Async<T> load_async(std::string fn, FileType ft=AUTO);
+
+    /** @brief Save a structure in the background
+     *
+     * The save runs like load_async does. The structure must neither be
+     * changed nor freed until the save has finished.
+     *
+     * @param obj the structure to save
+     * @param fn the file name to save to
+     * @param mode the SaveMode to write the file with
+     * @param checksum the ChecksumMode of the file
+     * @return a handle to the save's statistics
+     */
+    template<class T>
+    Async<SaveStats> save_async(T& obj, std::string fn, SaveMode mode=MAPPED,
+            ChecksumMode checksum=NO_CHECKSUM);
+
+}
+
+#endif
@@ -18,6 +18,43 @@ namespace pigo {
     template<class Label, class Ordinal, class LabelStorage, class OrdinalStorage, bool weighted, class Weight, class WeightStorage>
     class CSR;
 
+    /** @brief Options for exporting a COO as bulk-load CSV files
+     *
+     * The exported files follow the Gremlin CSV layout used by graph
+     * database bulk loaders (e.g., Amazon Neptune), with `~id`, `~from`,
+     * `~to` and `~label` system columns. Edges are split into files
+     * named `fn.N.csv` and, if requested, vertices into
+     * `fn.vertices.N.csv`.
+     */
+    struct CSVExportOptions {
+        /** The maximum number of entries (edges or vertices) per file */
+        size_t entries_per_file = std::numeric_limits<size_t>::max();
+
+        /** If true, write an `~id` column for every edge */
+        bool edge_ids = false;
+
+        /** The prefix prepended to edge IDs */
+        std::string edge_id_prefix = "e";
+
+        /** The prefix prepended to vertex IDs */
+        std::string vertex_id_prefix = "v";
+
+        /** The label written for every edge */
+        std::string edge_label = "con";
+
+        /** If true, also write vertex files for every used label */
+        bool vertices = false;
+
+        /** The label written for every vertex */
+        std::string vertex_label = "vertex";
+
+        /** The edge property name for weights (weighted COOs only) */
+        std::string weight_property = "weight";
+
+        /** If true, compress each file with gzip (requires zlib) */
+        bool gzip = false;
+    };
+
     /** @brief Holds coordinate-addressed matrices or graphs
      *
      * A COO is a fundamental object in PIGO. It is able to read a variety
@@ -136,6 +173,9 @@ namespace pigo {
              */
             void allocate_();
 
+            /** @brief Return the bytes allocated by allocate_ */
+            size_t alloc_size_() const;
+
             /** @brief Convert a CSR into this COO
              *
              * @tparam CL the label type of the CSR
@@ -173,8 +213,8 @@ namespace pigo {
 
             /** @brief Copies the COO values from the other COO */
             void copy_(const COO& other) {
-                #pragma omp parallel for
-                for (Ordinal pos = 0; pos < m_; ++pos) {
+                detail::ParallelTeam_ team;
+                team.for_each(0, m_, [&](size_t pos) {
                     Label x_val = detail::get_value_<
                                 Storage,
                                 Label
@@ -185,18 +225,22 @@ namespace pigo {
                                 Label
                             >((Storage&)(other.y_), pos);
                     detail::set_value_(y_, pos, y_val);
-                }
-                if (detail::if_true_<weighted>()) {
-                    #pragma omp parallel for
-                    for (Ordinal pos = 0; pos < m_; ++pos) {
+                    if (detail::if_true_<weighted>()) {
                         Weight w_val = detail::get_value_<
                                     WeightStorage,
                                     Weight
                                 >((WeightStorage&)(other.w_), pos);
                         detail::set_value_(w_, pos, w_val);
                     }
-                }
+                });
             }
+
+            /** @brief Write the binary save to an open file
+             *
+             * @tparam OutFile the type of file, File, DirectWFile or ChecksumWriter
+             * @param w the open file to write to
+             */
+            template<class OutFile> void save_to_(OutFile& w);
         public:
             /** @brief Initialize a COO from a file
              *
@@ -290,11 +334,111 @@ namespace pigo {
              */
             Label ncols() const { return ncols_; }
 
-            /** @brief Saves the COO to a binary PIGO file */
-            void save(std::string fn);
+            /** @brief Check the structure of the COO
+             *
+             * In one parallel sweep, this checks that every row and column
+             * label is within nrows and ncols. An Error naming the first
+             * offending index is thrown if any check fails.
+             *
+             * @param sorted whether to also check that the entries are
+             *        sorted by row and then column
+             */
+            void validate(bool sorted=false) const;
 
-            /** @brief Write the COO out to an ASCII file */
-            void write(std::string fn);
+            /** @brief Saves the COO to a binary PIGO file
+             *
+             * @param fn the filename to save as
+             * @param mode the SaveMode to use. DIRECT bypasses the page
+             *        cache and synchronizes the file before returning.
+             * @param checksum the ChecksumMode to use. CRC32C appends
+             *        checksums that are verified when loading.
+             * @return the bytes saved and the time taken
+             */
+            SaveStats save(std::string fn, SaveMode mode=MAPPED,
+                    ChecksumMode checksum=NO_CHECKSUM);
+
+            /** @brief Save the loaded COO as a PIGO binary file
+             *
+             * This saves the current COO to an open file
+             *
+             * @param w the File to save to
+             */
+            void save(File& w) { save_to_(w); }
+
+            /** @brief Save the loaded COO as a PIGO binary file
+             *
+             * This saves the current COO to an open DirectWFile
+             *
+             * @param w the DirectWFile to save to
+             */
+            void save(DirectWFile& w) { save_to_(w); }
+
+            /** @brief Checksum the binary sections of the COO
+             *
+             * @param w the ChecksumWriter to save to
+             */
+            void save(ChecksumWriter& w) { save_to_(w); }
+
+            /** @brief Convert an edge list into a binary PIGO COO file
+             *
+             * The edge list is parsed in parallel windows, and each
+             * window's entries are written straight to their place in the
+             * binary file, so memory use is bounded by the window size
+             * rather than by the size of the COO. The counts and label
+             * ranges in the header are written once all windows are
+             * parsed. The result matches loading the edge list into this
+             * COO type and saving it.
+             *
+             * @param fn the edge list file to convert
+             * @param out_fn the binary file to create
+             * @param window_size the number of bytes of text each thread
+             *        parses at a time
+             * @return the bytes saved and the time taken
+             */
+            static SaveStats convert(std::string fn, std::string out_fn,
+                    size_t window_size=(1<<24));
+
+            /** @brief Write the COO out to an ASCII file
+             *
+             * @param fn the filename to write
+             * @param mode the WriteMode to use. BUFFERED formats each
+             *        value only once but holds the output in memory.
+             *        STREAM never sizes the output, and with fn "-"
+             *        writes to standard output. GZIP and ZSTD stream
+             *        compressed output.
+             */
+            void write(std::string fn, WriteMode mode=TWO_PASS);
+
+            /** @brief Write the COO out in ASCII to a stream
+             *
+             * Lines are formatted in parallel chunks and written in
+             * order, so the stream may be a pipe or standard output.
+             *
+             * @param out the stream to write to
+             * @param mode the WriteMode, one of STREAM, GZIP or ZSTD.
+             *        GZIP and ZSTD compress the chunks in parallel.
+             */
+            void write(WStream& out, WriteMode mode=STREAM);
+
+            /** @brief Export the COO as bulk-load CSV files
+             *
+             * All files are sized and written concurrently. Weighted COOs
+             * include their weights as an edge property column.
+             *
+             * @param fn the base filename of the exported files
+             * @param opts the CSVExportOptions controlling the export
+             */
+            void csv_export(std::string fn, const CSVExportOptions& opts=CSVExportOptions());
+
+            /** @brief Write the COO out to split edge CSV files
+             *
+             * This is a shorthand for csv_export with the given number of
+             * edges per file and edge IDs.
+             *
+             * @param fn the base filename of the CSV files
+             * @param edge_per_file the maximum number of edges per file
+             * @param edgeIDs if true, include the edge ID column
+             */
             void split_cvs_write(std::string fn, Ordinal edge_per_file=std::numeric_limits<Ordinal>::max(), bool edgeIDs=false);
 
             /** @brief Utility to free consumed memory
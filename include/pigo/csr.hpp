@@ -10,6 +10,38 @@
 
 namespace pigo {
 
+    /** @brief Statistics of a CSR's rows, gathered while it is built
+     *
+     * Pass a LoadStats to a CSR constructor or to new_csr_without_dups
+     * to have it filled during the existing construction passes, instead
+     * of sweeping over the CSR afterwards.
+     */
+    struct LoadStats {
+        /** The number of rows */
+        size_t rows = 0;
+        /** The number of entries */
+        size_t entries = 0;
+        /** The largest row degree */
+        size_t max_degree = 0;
+        /** The first row with the largest degree */
+        size_t max_degree_row = 0;
+        /** The number of rows without entries */
+        size_t empty_rows = 0;
+        /** The number of entries on the diagonal */
+        size_t self_loops = 0;
+        /** The number of duplicate entries removed, which is only known
+         *  when deduplicating with new_csr_without_dups */
+        size_t duplicates = 0;
+        /** A log2 histogram of the non-zero row degrees: entry i counts
+         *  rows with degree in [2^i, 2^(i+1)) */
+        std::vector<size_t> degree_histogram;
+
+        /** @brief Return the average row degree */
+        double avg_degree() const {
+            return (rows > 0) ? (double)entries / rows : 0.;
+        }
+    };
+
     /** @brief Holds compressed sparse row matrices or graphs
      *
      * This is a fundamental object in PIGO. It is used to represent
@@ -82,8 +114,11 @@ namespace pigo {
              *
              * @param f the File to read from
              * @param ft the FileFormat to use to read
+             * @param stats if not null, the LoadStats to fill
+             * @param sums if not null, the loaded checksums of the file
              */
-            void read_(File& f, FileType ft);
+            void read_(File& f, FileType ft, LoadStats* stats,
+                    detail::ChecksumReader_* sums=nullptr);
 
             /** @brief Read a binary CSR from disk
              *
@@ -91,8 +126,10 @@ namespace pigo {
              * from a binary PIGO file.
              *
              * @param f the File to read from
+             * @param sums if not null, the loaded checksums of the file,
+             *        which are otherwise loaded here
              */
-            void read_bin_(File& f);
+            void read_bin_(File& f, detail::ChecksumReader_* sums=nullptr);
 
             /** @brief Read a GRAPH file format
              *
@@ -100,12 +137,24 @@ namespace pigo {
              * to build the CSR.
              *
              * @param r the FileReader to load from
+             * @param stats if not null, the LoadStats to fill
              */
-            void read_graph_(FileReader& r);
+            void read_graph_(FileReader& r, LoadStats* stats);
+
+            /** @brief Fill LoadStats from the loaded offsets
+             *
+             * @param stats the LoadStats to fill
+             * @param count_self_loops whether to also sweep the endpoints
+             *        for self loops
+             */
+            void row_stats_(LoadStats& stats, bool count_self_loops);
 
             /** @brief Allocate the storage for the CSR */
             void allocate_();
 
+            /** @brief Return the bytes allocated by allocate_ */
+            size_t alloc_size_() const;
+
             /** @brief Convert a COO into this CSR
              *
              * @tparam COOLabel the label for the COO format
@@ -117,16 +166,24 @@ namespace pigo {
              * @tparam COOW the weight type of the COO
              * @tparam COOWS the weight storage type of the COO
              * @param coo the COO to load from
+             * @param stats if not null, the LoadStats to fill
              */
             template <class COOLabel, class COOOrdinal, class COOStorage,
                      bool COOsym, bool COOut, bool COOsl,
                      class COOW, class COOWS>
             void convert_coo_(COO<COOLabel, COOOrdinal, COOStorage,
                     COOsym, COOut, COOsl, weighted, COOW, COOWS>&
-                    coo);
+                    coo, LoadStats* stats);
+
+            /** @brief Write the binary save to an open file
+             *
+             * @tparam OutFile the type of file, File, DirectWFile or ChecksumWriter
+             * @param w the open file to write to
+             */
+            template<class OutFile> void save_to_(OutFile& w);
         public:
             /** @brief Initialize an empty CSR */
-            CSR() : n_(0), m_(0), nrows_(0), ncols_(0) { }
+            CSR() : endpoints_(), offsets_(), weights_(), n_(0), m_(0), nrows_(0), ncols_(0) { }
 
             /** @brief Allocate a CSR for the given size */
             CSR(Label n, Ordinal m, Label nrows, Label ncols) :
@@ -150,12 +207,14 @@ namespace pigo {
              * @tparam COOW the weight type of the COO
              * @tparam COOWS the weight storage type of the COO
              * @param coo the COO object to load the CSR from
+             * @param stats if not null, the LoadStats to fill while
+             *        building the CSR
              */
             template <class COOLabel, class COOOrdinal, class COOStorage,
                      bool COOsym, bool COOut, bool COOsl,
                      class COOW, class COOWS>
             CSR(COO<COOLabel, COOOrdinal, COOStorage, COOsym, COOut,
-                    COOsl, weighted, COOW, COOWS>& coo);
+                    COOsl, weighted, COOW, COOWS>& coo, LoadStats* stats=nullptr);
 
             /** @brief Initialize from a file
              *
@@ -169,15 +228,31 @@ namespace pigo {
              *
              * @param fn the filename to open
              * @param ft the FileType to use
+             * @param stats if not null, the LoadStats to fill while
+             *        loading. Binary loads fill it with one sweep over
+             *        the loaded CSR.
              */
-            CSR(std::string fn, FileType ft);
+            CSR(std::string fn, FileType ft, LoadStats* stats=nullptr);
 
             /** @brief Initialize from an open file with a specific type
              *
              * @param f the open File
              * @param ft the FileType to use
+             * @param stats if not null, the LoadStats to fill while
+             *        loading. Binary loads fill it with one sweep over
+             *        the loaded CSR.
+             */
+            CSR(File& f, FileType ft, LoadStats* stats=nullptr);
+
+            /** @brief Initialize from a binary CSR within an open file
+             *
+             * This is used by structures holding several CSRs, which load
+             * the checksums of the file once for all of them.
+             *
+             * @param f the open File, positioned at the CSR
+             * @param sums the loaded checksums of the file
              */
-            CSR(File& f, FileType ft);
+            CSR(File& f, detail::ChecksumReader_& sums);
 
             /** @brief Return the endpoints
              *
@@ -232,9 +307,26 @@ namespace pigo {
             /** @brief Sort all row adjacencies in the CSR */
             void sort();
 
-            /** @brief Return a new CSR without duplicate entries */
+            /** @brief Check the structure of the CSR
+             *
+             * In one parallel sweep, this checks that the offsets start at
+             * zero, never decrease, and stay within m, and that every
+             * endpoint is a valid column. An Error naming the first offending index
+             * is thrown if any check fails, and an Error is thrown if the
+             * CSR holds no offsets, such as a default or freed one.
+             *
+             * @param sorted whether to also check that each row's
+             *        endpoints are sorted
+             */
+            void validate(bool sorted=false) const;
+
+            /** @brief Return a new CSR without duplicate entries
+             *
+             * @param stats if not null, the LoadStats of the new CSR to
+             *        fill, including the number of duplicates removed
+             */
             template<class nL=Label, class nO=Ordinal, class nLS=LabelStorage, class nOS=OrdinalStorage, bool nw=weighted, class nW=Weight, class nWS=WeightStorage>
-            CSR<nL, nO, nLS, nOS, nw, nW, nWS> new_csr_without_dups();
+            CSR<nL, nO, nLS, nOS, nw, nW, nWS> new_csr_without_dups(LoadStats* stats=nullptr);
 
             /** @brief Utility to free consumed memory
              *
@@ -260,8 +352,14 @@ namespace pigo {
              * This saves the current CSR to disk
              *
              * @param fn the filename to save as
+             * @param mode the SaveMode to use. DIRECT bypasses the page
+             *        cache and synchronizes the file before returning.
+             * @param checksum the ChecksumMode to use. CRC32C appends
+             *        checksums that are verified when loading.
+             * @return the bytes saved and the time taken
              */
-            void save(std::string fn);
+            SaveStats save(std::string fn, SaveMode mode=MAPPED,
+                    ChecksumMode checksum=NO_CHECKSUM);
 
             /** @brief Save the loaded CSR as a PIGO binary file
              *
@@ -269,7 +367,21 @@ namespace pigo {
              *
              * @param w the File to save to
              */
-            void save(File& w);
+            void save(File& w) { save_to_(w); }
+
+            /** @brief Save the loaded CSR as a PIGO binary file
+             *
+             * This saves the current CSR to an open DirectWFile
+             *
+             * @param w the DirectWFile to save to
+             */
+            void save(DirectWFile& w) { save_to_(w); }
+
+            /** @brief Checksum the binary sections of the CSR
+             *
+             * @param w the ChecksumWriter to save to
+             */
+            void save(ChecksumWriter& w) { save_to_(w); }
 
             /** The output file header for reading/writing */
             static constexpr const char* csr_file_header = "PIGO-CSR-v2";
@@ -0,0 +1,389 @@
+/**
+ * PIGO: a parallel graph and matrix I/O and preprocessing library
+ * Copyright (c) 2022 GT-TDALab
+ *
+ * This file contains the execution context of parallel operations
+ */
+
+#ifndef PIGO_EXECUTION_HPP
+#define PIGO_EXECUTION_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+namespace pigo {
+
+    /** @brief Runs the tasks of PIGO's parallel steps
+     *
+     * Each parallel step of an operation is split into tasks that never
+     * wait for each other, so an executor may run them in any order and
+     * on any number of threads, including the calling one. Derive from
+     * this to run PIGO on another scheduler, or adapt one with
+     * ExternalExecutor.
+     */
+    class Executor {
+        public:
+            virtual ~Executor() { }
+
+            /** @brief Return how many tasks the executor runs at once,
+             *         which is how many tasks each step is split into
+             *         unless the context sets threads */
+            virtual size_t concurrency() const = 0;
+
+            /** @brief Run task(i) for every i in [0, count), returning once
+             *         all have completed
+             *
+             * If tasks throw, the first exception is rethrown once all
+             * tasks have completed.
+             *
+             * @param count the number of tasks
+             * @param task the task to run
+             */
+            virtual void run(size_t count, const std::function<void(size_t)>& task) = 0;
+
+            /** @brief Start a job without waiting for it, such as an
+             *         operation of load_async
+             *
+             * By default, the job is queued on the shared ThreadPool of
+             * background jobs (see load_async), which is started on first
+             * use and finishes its jobs before the program exits.
+             *
+             * @param job the job to run
+             */
+            virtual void submit(std::function<void()> job);
+    };
+
+    /** @brief Runs each step as an OpenMP parallel region
+     *
+     * This is the default executor when PIGO is compiled with OpenMP. A
+     * step of n tasks asks for n threads; if OpenMP provides fewer, such
+     * as with dynamic adjustment or in nested regions, each thread runs
+     * several tasks. Without OpenMP, tasks run serially.
+     */
+    class OpenMPExecutor : public Executor {
+        public:
+            size_t concurrency() const override;
+            void run(size_t count, const std::function<void(size_t)>& task) override;
+    };
+
+    namespace detail { struct PoolState_; }
+
+    /** @brief A work-stealing pool of std::threads
+     *
+     * This is the default executor when PIGO is compiled without OpenMP.
+     * Each worker keeps its own queue of jobs, taking its newest job
+     * first and stealing the oldest jobs of other workers once its queue
+     * is empty. The tasks of a step are claimed in order by whichever
+     * threads are free, including the thread waiting for the step, so
+     * steps nest without deadlock.
+     */
+    class ThreadPool : public Executor {
+        public:
+            /** @brief Start the workers
+             *
+             * @param threads the number of workers, or 0 for one per
+             *        hardware thread
+             * @param cpus the CPUs to bind the workers to, worker i to
+             *        cpus[i % size], or empty to leave them unbound
+             */
+            ThreadPool(size_t threads=0, std::vector<int> cpus=std::vector<int>());
+
+            /** @brief Finish the queued jobs and stop the workers
+             *
+             * If called from a worker, such as by a job that held the
+             * last reference to the pool, that worker is detached and
+             * exits once the queued jobs are finished.
+             */
+            ~ThreadPool();
+
+            ThreadPool(const ThreadPool&) = delete;
+            ThreadPool& operator=(const ThreadPool&) = delete;
+
+            size_t concurrency() const override;
+            void run(size_t count, const std::function<void(size_t)>& task) override;
+
+            /** @brief Queue a job on a worker without waiting for it */
+            void submit(std::function<void()> job) override;
+
+        private:
+            std::shared_ptr<detail::PoolState_> state_;
+            std::vector<std::thread> workers_;
+    };
+
+    /** @brief Runs tasks on an external thread pool or scheduler
+     *
+     * Each step submits up to concurrency-1 jobs, such as to a TBB
+     * task_arena, and the calling thread claims tasks alongside them.
+     * Tasks are claimed as jobs start, so a step completes even if the
+     * pool is busy and runs none of its jobs in time; late jobs find no
+     * tasks left and return at once.
+     */
+    class ExternalExecutor : public Executor {
+        public:
+            /** @brief Queues a job on the external pool */
+            typedef std::function<void(std::function<void()>)> Submit;
+
+            /** @brief Adapt an external pool
+             *
+             * @param submit queues a job on the pool, and may be called
+             *        from any thread
+             * @param concurrency the number of threads of the pool
+             */
+            ExternalExecutor(Submit submit, size_t concurrency);
+
+            size_t concurrency() const override;
+            void run(size_t count, const std::function<void(size_t)>& task) override;
+
+            /** @brief Queue a job on the external pool */
+            void submit(std::function<void()> job) override;
+
+        private:
+            Submit submit_;
+            size_t concurrency_;
+    };
+
+    /** @brief Return the executor of contexts that do not set one
+     *
+     * This is an OpenMPExecutor when compiled with OpenMP, and otherwise
+     * a ThreadPool with one worker per hardware thread, started on first
+     * use.
+     */
+    std::shared_ptr<Executor> default_executor();
+
+    /** @brief What a PIGO operation does when called from inside an
+     *         active parallel region or a task of another step */
+    enum NestedMode {
+        /** Run on the calling thread alone */
+        NESTED_SERIAL,
+        /** Split its steps into tasks as usual. With OpenMP, the nested
+         *  regions only get more threads if the runtime allows another
+         *  active level (see omp_set_max_active_levels); a ThreadPool
+         *  runs them on its free workers. */
+        NESTED_PARALLEL
+    };
+
+    /** @brief How the parallel steps of PIGO operations run
+     *
+     * PIGO never changes OpenMP's global settings. Each parallel step is
+     * split into exactly the context's number of tasks and run by its
+     * executor, and the threads running the tasks are bound to the
+     * context's CPUs only while they run them.
+     */
+    struct ExecutionContext {
+        /** The tasks of each parallel step, or 0 for one per CPU in cpus
+         *  if given, and otherwise the executor's concurrency */
+        size_t threads = 0;
+        /** The CPUs to bind the threads to, task i to cpus[i % size],
+         *  or empty to leave them unbound */
+        std::vector<int> cpus;
+        /** What to do when called from inside an active parallel region
+         *  or a task of another step */
+        NestedMode nested = NESTED_SERIAL;
+        /** The executor running the tasks, or nullptr for
+         *  default_executor() */
+        std::shared_ptr<Executor> executor;
+    };
+
+    /** @brief Runs the calling thread's PIGO operations in a context
+     *
+     * While a scope exists, the readers, conversions, sorts and writers
+     * run by the thread that created it use its context. Scopes nest; the
+     * innermost one of a thread is used. Separate threads may hold scopes
+     * with disjoint CPUs to run several operations side by side.
+     */
+    class ExecutionScope {
+        public:
+            /** @brief Use context for the calling thread's operations
+             *
+             * @param context the context to use
+             */
+            ExecutionScope(const ExecutionContext& context);
+
+            /** @brief Restore the context the scope replaced */
+            ~ExecutionScope();
+
+            ExecutionScope(const ExecutionScope&) = delete;
+            ExecutionScope& operator=(const ExecutionScope&) = delete;
+
+        private:
+            ExecutionContext context_;
+            /** The scope this one replaced */
+            ExecutionScope* outer_;
+            friend ExecutionContext execution_context();
+    };
+
+    /** @brief Return the calling thread's context
+     *
+     * Without a scope, this is the default context: one task per thread
+     * of the default executor, unbound, running serially when nested.
+     * The tasks of a step run in the context of the operation that
+     * started it.
+     */
+    ExecutionContext execution_context();
+
+    namespace detail {
+
+        /** @brief The team of one parallel operation on the calling thread
+         *
+         * The team is created outside of parallel steps and fixes the
+         * operation's executor and number of tasks. Each step is started
+         * with run(), and steps that need a barrier are split into
+         * several runs, so tasks never wait for each other.
+         */
+        class ParallelTeam_ {
+            private:
+                ExecutionContext context_;
+                std::shared_ptr<Executor> executor_;
+                size_t size_;
+            public:
+                ParallelTeam_();
+
+                ParallelTeam_(const ParallelTeam_&) = delete;
+                ParallelTeam_& operator=(const ParallelTeam_&) = delete;
+
+                /** @brief Return the tasks of each step */
+                int size() const { return (int)size_; }
+
+                /** @brief Run f(tid) for every tid in [0, size())
+                 *
+                 * The tasks run in the calling thread's context, and
+                 * task_id_() returns their tid.
+                 *
+                 * @param f the task
+                 * @param wait if tracing, the name of the events recording
+                 *        how long each task waits for the step to finish
+                 */
+                template<class F>
+                void run(F f, const char* wait=nullptr);
+
+                /** @brief Run f(i) for every i in [begin, end), handing out
+                 *         chunks of grain iterations as tasks free up
+                 */
+                template<class F>
+                void for_each(size_t begin, size_t end, size_t grain, F f);
+
+                /** @brief Run f(i) for every i in [begin, end), in one
+                 *         contiguous chunk per task
+                 */
+                template<class F>
+                void for_each(size_t begin, size_t end, F f);
+        };
+
+        /** @brief Hands out the chunks of a loop, in order, to whichever
+         *         tasks ask first
+         */
+        class LoopChunks_ {
+            private:
+                std::atomic<size_t> next_;
+                size_t end_;
+                size_t grain_;
+            public:
+                LoopChunks_(size_t begin, size_t end, size_t grain) :
+                    next_(begin), end_(end), grain_(grain > 0 ? grain : 1) { }
+
+                /** @brief Claim the next chunk
+                 *
+                 * @param start set to the first iteration of the chunk
+                 * @param stop set to one past its last iteration
+                 * @return false once all chunks have been claimed
+                 */
+                bool next(size_t& start, size_t& stop);
+        };
+
+        /** @brief Lets the chunks of a loop take turns in order
+         *
+         * Chunks must be claimed in order by running tasks, such as with
+         * LoopChunks_, so a task waiting for its turn only waits for
+         * tasks that are running.
+         */
+        class OrderedTurns_ {
+            private:
+                std::mutex mutex_;
+                std::condition_variable turn_;
+                size_t next_;
+            public:
+                OrderedTurns_() : next_(0) { }
+
+                /** @brief Wait until every chunk before chunk had its turn */
+                void wait(size_t chunk);
+
+                /** @brief End the turn of the chunk that waited last */
+                void done();
+        };
+
+        /** @brief Binds the calling thread to its task's CPU
+         *
+         * Each task of a bound team creates one at its start; the
+         * thread's previous affinity is restored when it is destroyed.
+         * Unbound teams make no system calls.
+         */
+        class ThreadBinding_ {
+            private:
+                bool bound_;
+                #ifdef __linux__
+                cpu_set_t saved_;
+                #endif
+            public:
+                /** @brief Bind to cpus[tid % cpus.size()], if any */
+                ThreadBinding_(const std::vector<int>& cpus, size_t tid);
+                ~ThreadBinding_();
+
+                ThreadBinding_(const ThreadBinding_&) = delete;
+                ThreadBinding_& operator=(const ThreadBinding_&) = delete;
+        };
+
+        /** @brief Marks the calling thread as running a task of a step */
+        class TaskScope_ {
+            private:
+                size_t tid_;
+                TaskScope_* outer_;
+            public:
+                TaskScope_(size_t tid);
+                ~TaskScope_();
+
+                TaskScope_(const TaskScope_&) = delete;
+                TaskScope_& operator=(const TaskScope_&) = delete;
+
+                friend size_t task_id_();
+        };
+
+        /** @brief Return the calling thread's task id within its step, or
+         *         0 outside of steps */
+        size_t task_id_();
+
+        /** @brief Return whether the calling thread is running a task */
+        bool in_task_();
+
+        /** @brief Return the most tasks the calling thread's context
+         *         splits a step into, for sizing per-task state */
+        size_t context_threads_();
+
+        /** @brief Atomically add to a value shared by tasks
+         *
+         * @return the value before the addition
+         */
+        template<class T>
+        T fetch_add_(T& val, T inc) {
+            return __atomic_fetch_add(&val, inc, __ATOMIC_RELAXED);
+        }
+
+        /** @brief Atomically set a value shared by tasks */
+        template<class T>
+        void atomic_store_(T& val, T new_val) {
+            __atomic_store_n(&val, new_val, __ATOMIC_RELAXED);
+        }
+
+    }
+
+}
+
+#endif
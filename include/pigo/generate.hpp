@@ -0,0 +1,115 @@
+/**
+ * PIGO: a parallel graph and matrix I/O and preprocessing library
+ * Copyright (c) 2022 GT-TDALab
+ *
+ * This file contains parallel synthetic graph generators
+ */
+
+#ifndef PIGO_GENERATE_HPP
+#define PIGO_GENERATE_HPP
+
+#include <cstdint>
+
+namespace pigo {
+
+    /** @brief Generate an R-MAT (Graph500 Kronecker) graph
+     *
+     * Every edge picks one quadrant of the adjacency matrix per level
+     * with probabilities a, b, c and 1-a-b-c. The defaults are the
+     * Graph500 parameters. Each edge depends only on the seed and its
+     * index, so the result does not depend on the number of threads.
+     *
+     * @tparam Label the label type of the COO
+     * @tparam Ordinal the ordinal type of the COO
+     * @tparam Storage the storage type of the COO
+     * @tparam weighted whether the COO is weighted. Weights are all one.
+     * @tparam Weight the weight type
+     * @tparam WeightStorage the weight storage type
+     * @param scale the graph has 2^scale vertices
+     * @param edge_factor the graph has edge_factor*2^scale edges
+     * @param seed the random seed
+     * @param a the probability of the top left quadrant
+     * @param b the probability of the top right quadrant
+     * @param c the probability of the bottom left quadrant
+     * @param permute whether to scramble the vertex labels, so that high
+     *        degree vertices are not clustered at low labels
+     * @return a COO holding the edges
+     */
+    template<class Label=uint32_t, class Ordinal=Label, class Storage=Label*,
+        bool weighted=false, class Weight=float, class WeightStorage=Weight*>
+    COO<Label, Ordinal, Storage, false, false, false, weighted, Weight, WeightStorage>
+    generate_rmat(unsigned scale, uint64_t edge_factor=16, uint64_t seed=1,
+            double a=0.57, double b=0.19, double c=0.19, bool permute=true);
+
+    /** @brief Generate a uniform random graph with m edges
+     *
+     * Both endpoints are drawn uniformly without self loops. Edges are
+     * drawn independently, so a few may repeat; new_csr_without_dups
+     * removes them. For template parameters, see generate_rmat.
+     *
+     * @param n the number of vertices
+     * @param m the number of edges
+     * @param seed the random seed
+     * @return a COO holding the edges
+     */
+    template<class Label=uint32_t, class Ordinal=Label, class Storage=Label*,
+        bool weighted=false, class Weight=float, class WeightStorage=Weight*>
+    COO<Label, Ordinal, Storage, false, false, false, weighted, Weight, WeightStorage>
+    generate_gnm(uint64_t n, uint64_t m, uint64_t seed=1);
+
+    /** @brief Generate a G(n,p) graph
+     *
+     * Every ordered pair of distinct vertices is an edge with probability
+     * p. Rows are generated in parallel by skipping geometrically between
+     * edges, taking time proportional to the number of edges. For template
+     * parameters, see generate_rmat.
+     *
+     * @param n the number of vertices
+     * @param p the edge probability
+     * @param seed the random seed
+     * @return a COO holding the edges, sorted by row and column
+     */
+    template<class Label=uint32_t, class Ordinal=Label, class Storage=Label*,
+        bool weighted=false, class Weight=float, class WeightStorage=Weight*>
+    COO<Label, Ordinal, Storage, false, false, false, weighted, Weight, WeightStorage>
+    generate_gnp(uint64_t n, double p, uint64_t seed=1);
+
+    /** @brief Generate a Barabási–Albert preferential attachment graph
+     *
+     * Every vertex after the first adds k edges to earlier vertices,
+     * chosen proportionally to their degree by copying a random earlier
+     * endpoint (Batagelj and Brandes). Copies are resolved by following
+     * them back to a fixed endpoint, so all edges are generated in
+     * parallel. Multiple edges between two vertices are possible. Edges
+     * point from the newer vertex. For template parameters, see
+     * generate_rmat.
+     *
+     * @param n the number of vertices
+     * @param k the number of edges added by each vertex
+     * @param seed the random seed
+     * @return a COO holding the (n-1)*k edges
+     */
+    template<class Label=uint32_t, class Ordinal=Label, class Storage=Label*,
+        bool weighted=false, class Weight=float, class WeightStorage=Weight*>
+    COO<Label, Ordinal, Storage, false, false, false, weighted, Weight, WeightStorage>
+    generate_ba(uint64_t n, uint64_t k, uint64_t seed=1);
+
+    /** @brief Generate a 2D or 3D grid graph
+     *
+     * Vertex (x, y, z) has label x + nx*(y + ny*z) and an edge to each of
+     * its up to six axis neighbors, so every edge appears in both
+     * directions. For template parameters, see generate_rmat.
+     *
+     * @param nx the number of vertices along x
+     * @param ny the number of vertices along y
+     * @param nz the number of vertices along z, 1 for a 2D grid
+     * @return a COO holding the edges, sorted by row and column
+     */
+    template<class Label=uint32_t, class Ordinal=Label, class Storage=Label*,
+        bool weighted=false, class Weight=float, class WeightStorage=Weight*>
+    COO<Label, Ordinal, Storage, false, false, false, weighted, Weight, WeightStorage>
+    generate_grid(uint64_t nx, uint64_t ny, uint64_t nz=1);
+
+}
+
+#endif
@@ -214,28 +214,46 @@ namespace pigo {
                 auto coo_copy = coo;
                 coo_copy.transpose();
 
-                in_ = BaseGraph<
-                            vertex_t,
-                            edge_ctr_t,
-                            edge_storage,
-                            edge_ctr_storage,
-                            weighted,
-                            Weight,
-                            WeightStorage
-                        > { coo_copy };
+                // Conversions free what they built if cancelled, so only
+                // the copy and the first conversion remain to free
+                try {
+                    in_ = BaseGraph<
+                                vertex_t,
+                                edge_ctr_t,
+                                edge_storage,
+                                edge_ctr_storage,
+                                weighted,
+                                Weight,
+                                WeightStorage
+                            > { coo_copy };
+                } catch (...) {
+                    coo_copy.free();
+                    throw;
+                }
                 coo_copy.free();
 
-                out_ = BaseGraph<
-                            vertex_t,
-                            edge_ctr_t,
-                            edge_storage,
-                            edge_ctr_storage,
-                            weighted,
-                            Weight,
-                            WeightStorage
-                        > { coo };
+                try {
+                    out_ = BaseGraph<
+                                vertex_t,
+                                edge_ctr_t,
+                                edge_storage,
+                                edge_ctr_storage,
+                                weighted,
+                                Weight,
+                                WeightStorage
+                            > { coo };
+                } catch (...) {
+                    in_.free();
+                    throw;
+                }
             }
 
+            /** @brief Write the binary save to an open file
+             *
+             * @tparam OutFile the type of file, File, DirectWFile or ChecksumWriter
+             * @param w the open file to write to
+             */
+            template<class OutFile> void save_to_(OutFile& w);
 
         public:
             /** @brief Initialize from a COO
@@ -292,6 +310,17 @@ namespace pigo {
                 out_.free();
             }
 
+            /** @brief Check the structure of the DiGraph
+             *
+             * This validates both the in-edge and out-edge CSRs, see
+             * CSR::validate, and checks that they hold the same number of
+             * vertices and edges.
+             *
+             * @param sorted whether to also check that each vertex's
+             *        neighbors are sorted
+             */
+            void validate(bool sorted=false) const;
+
             /** @brief Return the number of non-zeros or edges */
             edge_ctr_t m() { return out_.m(); }
 
@@ -331,8 +360,36 @@ namespace pigo {
              * This saves the current DiGraph to disk
              *
              * @param fn the filename to save as
+             * @param mode the SaveMode to use. DIRECT bypasses the page
+             *        cache and synchronizes the file before returning.
+             * @param checksum the ChecksumMode to use. CRC32C appends
+             *        checksums that are verified when loading.
+             * @return the bytes saved and the time taken
+             */
+            SaveStats save(std::string fn, SaveMode mode=MAPPED,
+                    ChecksumMode checksum=NO_CHECKSUM);
+
+            /** @brief Save the loaded DiGraph as a PIGO binary file
+             *
+             * This saves the current DiGraph to an open file
+             *
+             * @param w the File to save to
+             */
+            void save(File& w) { save_to_(w); }
+
+            /** @brief Save the loaded DiGraph as a PIGO binary file
+             *
+             * This saves the current DiGraph to an open DirectWFile
+             *
+             * @param w the DirectWFile to save to
+             */
+            void save(DirectWFile& w) { save_to_(w); }
+
+            /** @brief Checksum the binary sections of the DiGraph
+             *
+             * @param w the ChecksumWriter to save to
              */
-            void save(std::string fn);
+            void save(ChecksumWriter& w) { save_to_(w); }
 
             /** The output file header for reading/writing */
             static constexpr const char* digraph_file_header = "PIGO-DiGraph-v1";
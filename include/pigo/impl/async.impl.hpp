@@ -0,0 +1,116 @@
+/**
+ * PIGO: a parallel graph and matrix I/O and preprocessing library
+ * Copyright (c) 2022 GT-TDALab
+ *
+ * This file contains the implementation of asynchronous loading and saving
+ */
+
+namespace pigo {
+
+    namespace detail {
+
+        inline
+        void AsyncStateBase_::run(const ExecutionContext& context) {
+            std::exception_ptr error;
+            {
+                ExecutionScope scope { context };
+                ProgressMonitor monitor { [this](const Progress& p) {
+                    std::lock_guard<std::mutex> lock { mutex_ };
+                    progress_ = p;
+                    return true;
+                } };
+                bool cancelled;
+                {
+                    std::lock_guard<std::mutex> lock { mutex_ };
+                    monitor_ = &monitor;
+                    cancelled = cancelled_;
+                }
+                try {
+                    if (cancelled)
+                        throw Cancelled("PIGO: the operation was cancelled before it started");
+                    perform();
+                } catch (...) {
+                    error = std::current_exception();
+                }
+                std::lock_guard<std::mutex> lock { mutex_ };
+                monitor_ = nullptr;
+            }
+            std::lock_guard<std::mutex> lock { mutex_ };
+            error_ = error;
+            done_ = true;
+            finished_.notify_all();
+        }
+
+        inline
+        bool AsyncStateBase_::ready() const {
+            std::lock_guard<std::mutex> lock { mutex_ };
+            return done_;
+        }
+
+        inline
+        void AsyncStateBase_::wait() const {
+            std::unique_lock<std::mutex> lock { mutex_ };
+            finished_.wait(lock, [this]() { return done_; });
+        }
+
+        inline
+        bool AsyncStateBase_::wait_for(double seconds) const {
+            std::unique_lock<std::mutex> lock { mutex_ };
+            return finished_.wait_for(lock, std::chrono::duration<double>(seconds),
+                    [this]() { return done_; });
+        }
+
+        inline
+        void AsyncStateBase_::wait_and_rethrow() const {
+            wait();
+            std::lock_guard<std::mutex> lock { mutex_ };
+            if (error_) std::rethrow_exception(error_);
+        }
+
+        inline
+        void AsyncStateBase_::cancel() {
+            std::lock_guard<std::mutex> lock { mutex_ };
+            if (done_) return;
+            cancelled_ = true;
+            if (monitor_) monitor_->cancel();
+        }
+
+        inline
+        Progress AsyncStateBase_::progress() const {
+            std::lock_guard<std::mutex> lock { mutex_ };
+            return progress_;
+        }
+
+        inline
+        void launch_async_(std::shared_ptr<AsyncStateBase_> state) {
+            ExecutionContext context = execution_context();
+            // Without an executor, the job and its steps share the
+            // workers of all background jobs
+            if (!context.executor) context.executor = job_executor_();
+            // The job keeps the state alive until the operation finishes
+            context.executor->submit([state, context]() { state->run(context); });
+        }
+
+    }
+
+    template<class T>
+    Async<T> load_async(std::string fn, FileType ft) {
+        std::shared_ptr<detail::AsyncState_<T>> state = std::make_shared<detail::AsyncState_<T>>(
+                [fn, ft](std::unique_ptr<T>& result) { result.reset(new T(fn, ft)); });
+        detail::launch_async_(state);
+        return Async<T>(state);
+    }
+
+    template<class T>
+    Async<SaveStats> save_async(T& obj, std::string fn, SaveMode mode,
+            ChecksumMode checksum) {
+        T* target = &obj;
+        std::shared_ptr<detail::AsyncState_<SaveStats>> state = std::make_shared<detail::AsyncState_<SaveStats>>(
+                [target, fn, mode, checksum](std::unique_ptr<SaveStats>& result) {
+                    result.reset(new SaveStats(target->save(fn, mode, checksum)));
+                });
+        detail::launch_async_(state);
+        return Async<SaveStats>(state);
+    }
+
+}
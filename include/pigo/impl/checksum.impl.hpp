@@ -0,0 +1,445 @@
+/**
+ * PIGO: a parallel graph and matrix I/O and preprocessing library
+ * Copyright (c) 2022 GT-TDALab
+ *
+ * This file contains the CRC32C checksums of binary files, computed while
+ * saving and verified while loading
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <vector>
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <nmmintrin.h>
+#endif
+
+namespace pigo {
+
+    namespace detail {
+        /** The magic string beginning and ending a checksum trailer */
+        constexpr const char* checksum_trailer_header_ = "PIGO-CRC32C-v1";
+
+        /** @brief The lookup tables for slicing-by-8 CRC32C */
+        struct Crc32cTables_ {
+            /** The tables, where table s advances a byte by s more bytes */
+            uint32_t t[8][256];
+
+            /** @brief Compute the tables for the Castagnoli polynomial */
+            Crc32cTables_() {
+                for (uint32_t i = 0; i < 256; ++i) {
+                    uint32_t c = i;
+                    for (int bit = 0; bit < 8; ++bit)
+                        c = (c >> 1) ^ (0x82F63B78 & (0u - (c & 1)));
+                    t[0][i] = c;
+                }
+                for (uint32_t i = 0; i < 256; ++i)
+                    for (int s = 1; s < 8; ++s)
+                        t[s][i] = (t[s-1][i] >> 8) ^ t[0][t[s-1][i] & 0xFF];
+            }
+        };
+
+        /** @brief Return the shared CRC32C lookup tables */
+        inline
+        const Crc32cTables_& crc32c_tables_() {
+            static const Crc32cTables_ tables;
+            return tables;
+        }
+
+        /** @brief Continue a raw CRC32C in software, eight bytes at a time */
+        inline
+        uint32_t crc32c_sw_(uint32_t crc, const char* data, size_t size) {
+            const Crc32cTables_& tb = crc32c_tables_();
+            const unsigned char* p = (const unsigned char*)data;
+            #if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+            while (size >= 8) {
+                uint32_t lo, hi;
+                memcpy(&lo, p, 4);
+                memcpy(&hi, p+4, 4);
+                lo ^= crc;
+                crc = tb.t[7][lo & 0xFF] ^ tb.t[6][(lo >> 8) & 0xFF] ^
+                        tb.t[5][(lo >> 16) & 0xFF] ^ tb.t[4][lo >> 24] ^
+                        tb.t[3][hi & 0xFF] ^ tb.t[2][(hi >> 8) & 0xFF] ^
+                        tb.t[1][(hi >> 16) & 0xFF] ^ tb.t[0][hi >> 24];
+                p += 8;
+                size -= 8;
+            }
+            #endif
+            while (size-- > 0)
+                crc = (crc >> 8) ^ tb.t[0][(crc ^ *p++) & 0xFF];
+            return crc;
+        }
+
+        #if defined(__x86_64__) && defined(__GNUC__)
+        /** @brief Continue a raw CRC32C with the SSE4.2 crc32 instruction */
+        __attribute__((target("sse4.2")))
+        inline
+        uint32_t crc32c_hw_(uint32_t crc, const char* data, size_t size) {
+            uint64_t crc64 = crc;
+            while (size >= 8) {
+                uint64_t word;
+                memcpy(&word, data, 8);
+                crc64 = _mm_crc32_u64(crc64, word);
+                data += 8;
+                size -= 8;
+            }
+            crc = (uint32_t)crc64;
+            while (size-- > 0)
+                crc = _mm_crc32_u8(crc, (unsigned char)*data++);
+            return crc;
+        }
+        #endif
+
+        /** @brief Compute the CRC32C of a region
+         *
+         * The SSE4.2 crc32 instruction is used when the processor supports
+         * it, and slicing-by-8 tables otherwise.
+         *
+         * @param data the region to checksum
+         * @param size the size of the region
+         * @param crc the CRC32C of preceding data to continue from
+         * @return the CRC32C of the preceding data followed by the region
+         */
+        inline
+        uint32_t crc32c_(const char* data, size_t size, uint32_t crc=0) {
+            crc = ~crc;
+            #if defined(__x86_64__) && defined(__GNUC__)
+            static const bool have_sse42 = __builtin_cpu_supports("sse4.2");
+            if (have_sse42)
+                return ~crc32c_hw_(crc, data, size);
+            #endif
+            return ~crc32c_sw_(crc, data, size);
+        }
+
+        /** @brief Multiply a vector by a 32x32 matrix over GF(2) */
+        inline
+        uint32_t gf2_times_(const uint32_t* mat, uint32_t vec) {
+            uint32_t sum = 0;
+            for (; vec != 0; vec >>= 1, ++mat)
+                if (vec & 1) sum ^= *mat;
+            return sum;
+        }
+
+        /** @brief Square a 32x32 matrix over GF(2) */
+        inline
+        void gf2_square_(uint32_t* square, const uint32_t* mat) {
+            for (int n = 0; n < 32; ++n)
+                square[n] = gf2_times_(mat, mat[n]);
+        }
+
+        /** @brief Return the CRC32C of two concatenated regions
+         *
+         * This applies the operator appending len2 zero bytes to crc1,
+         * built by repeated squaring, as done by zlib's crc32_combine.
+         *
+         * @param crc1 the CRC32C of the first region
+         * @param crc2 the CRC32C of the second region
+         * @param len2 the size of the second region
+         * @return the CRC32C of the first region followed by the second
+         */
+        inline
+        uint32_t crc32c_combine_(uint32_t crc1, uint32_t crc2, size_t len2) {
+            if (len2 == 0) return crc1;
+            uint32_t even[32], odd[32];
+            // The operator for a single zero bit
+            odd[0] = 0x82F63B78;
+            for (int n = 1; n < 32; ++n)
+                odd[n] = 1u << (n - 1);
+            // Then for two and four zero bits
+            gf2_square_(even, odd);
+            gf2_square_(odd, even);
+            // Apply the operators of the bits of len2, from a byte up
+            while (true) {
+                gf2_square_(even, odd);
+                if (len2 & 1) crc1 = gf2_times_(even, crc1);
+                len2 >>= 1;
+                if (len2 == 0) break;
+                gf2_square_(odd, even);
+                if (len2 & 1) crc1 = gf2_times_(odd, crc1);
+                len2 >>= 1;
+                if (len2 == 0) break;
+            }
+            return crc1 ^ crc2;
+        }
+
+        /** @brief Append a raw value to a string */
+        template<class T>
+        inline
+        void append_raw_(std::string& s, T val) {
+            s.append((const char*)&val, sizeof(T));
+        }
+
+        /** @brief Read a raw value from a position, advancing it */
+        template<class T>
+        inline
+        T read_raw_(const char*& p) {
+            T val;
+            memcpy(&val, p, sizeof(T));
+            p += sizeof(T);
+            return val;
+        }
+
+        /** @brief Loads and verifies the checksum trailer of a binary file
+         *
+         * Files saved without checksums have no trailer, and are read
+         * without verification.
+         */
+        class ChecksumReader_ {
+            private:
+                /** The start of the file */
+                const char* data_;
+                /** The size of each checksummed block */
+                uint64_t block_size_;
+                /** The offset of each section */
+                std::vector<uint64_t> offsets_;
+                /** The size of each section */
+                std::vector<uint64_t> sizes_;
+                /** Whether each section was written in parallel */
+                std::vector<uint64_t> regions_;
+                /** The index of the first block checksum of each section */
+                std::vector<size_t> first_;
+                /** The checksums of every block of every section */
+                std::vector<uint32_t> crcs_;
+
+                /** @brief Throw an error for the block at the offset */
+                static void mismatch_(size_t offset) {
+                    throw Error("PIGO: Checksum mismatch in the block at offset " +
+                            std::to_string(offset));
+                }
+
+                /** @brief Verify a section by block, optionally copying it
+                 *
+                 * @param sec the section to verify
+                 * @param out if not nullptr, where to copy the section
+                 */
+                void verify_(size_t sec, char* out) {
+                    size_t size = sizes_[sec];
+                    size_t num_blocks = (size + block_size_ - 1) / block_size_;
+                    const char* in = data_ + offsets_[sec];
+                    bool failed = false;
+                    size_t failed_block = 0;
+                    std::mutex failed_mutex;
+                    ParallelTeam_ team;
+                    team.for_each(0, num_blocks, [&](size_t block) {
+                        size_t start = block*block_size_;
+                        size_t len = std::min((size_t)block_size_, size - start);
+                        // Checksum the copy, which is now in cache
+                        const char* check = in + start;
+                        if (out != nullptr) {
+                            memcpy(out + start, in + start, len);
+                            check = out + start;
+                        }
+                        if (crc32c_(check, len) != crcs_[first_[sec] + block]) {
+                            std::lock_guard<std::mutex> lock { failed_mutex };
+                            if (!failed || block < failed_block)
+                                failed_block = block;
+                            failed = true;
+                        }
+                    });
+                    if (failed) mismatch_(offsets_[sec] + failed_block*block_size_);
+                }
+            public:
+                /** @brief Load the trailer of a file, if it has one
+                 *
+                 * The sections written between parallel regions, such as
+                 * headers and sizes, are verified right away.
+                 *
+                 * @param f the open file
+                 */
+                ChecksumReader_(File& f) : data_(f.fp() - f.tell()), block_size_(0) {
+                    std::string magic { checksum_trailer_header_ };
+                    size_t f_size = f.size();
+                    size_t footer = sizeof(uint64_t) + magic.size();
+                    if (f_size < footer ||
+                            memcmp(data_ + f_size - magic.size(), magic.data(), magic.size()) != 0)
+                        return;
+
+                    // Find and check the trailer itself
+                    const char* p = data_ + f_size - footer;
+                    uint64_t t_size = read_raw_<uint64_t>(p);
+                    size_t fixed = 2*magic.size() + 4*sizeof(uint64_t) + sizeof(uint32_t);
+                    if (t_size < fixed || t_size > f_size)
+                        throw Error("PIGO: Invalid checksum trailer");
+                    const char* t_start = data_ + f_size - t_size;
+                    size_t body = t_size - footer - sizeof(uint32_t);
+                    p = t_start + body;
+                    if (crc32c_(t_start, body) != read_raw_<uint32_t>(p))
+                        throw Error("PIGO: Checksum mismatch in the checksum trailer");
+                    if (memcmp(t_start, magic.data(), magic.size()) != 0)
+                        throw Error("PIGO: Invalid checksum trailer");
+
+                    // Load the sections and their block checksums
+                    p = t_start + magic.size();
+                    block_size_ = read_raw_<uint64_t>(p);
+                    uint64_t num_sections = read_raw_<uint64_t>(p);
+                    if (block_size_ == 0 || num_sections*3*sizeof(uint64_t) > body)
+                        throw Error("PIGO: Invalid checksum trailer");
+                    size_t num_blocks = 0;
+                    for (uint64_t sec = 0; sec < num_sections; ++sec) {
+                        offsets_.push_back(read_raw_<uint64_t>(p));
+                        sizes_.push_back(read_raw_<uint64_t>(p));
+                        regions_.push_back(read_raw_<uint64_t>(p));
+                        if (offsets_[sec] + sizes_[sec] > f_size - t_size)
+                            throw Error("PIGO: Invalid checksum trailer");
+                        first_.push_back(num_blocks);
+                        num_blocks += (sizes_[sec] + block_size_ - 1) / block_size_;
+                    }
+                    uint64_t num_crcs = read_raw_<uint64_t>(p);
+                    if (num_crcs != num_blocks ||
+                            (size_t)(p - t_start) + num_crcs*sizeof(uint32_t) != body)
+                        throw Error("PIGO: Invalid checksum trailer");
+                    crcs_.resize(num_crcs);
+                    memcpy(crcs_.data(), p, num_crcs*sizeof(uint32_t));
+
+                    for (size_t sec = 0; sec < offsets_.size(); ++sec)
+                        if (!regions_[sec]) verify_(sec, nullptr);
+                }
+
+                /** @brief Return whether the file has checksums */
+                bool present() const { return block_size_ > 0; }
+
+                /** @brief Read a binary region in parallel, verifying it
+                 *
+                 * Each thread verifies the blocks it copies while they are
+                 * still in cache. Regions without checksums are read as
+                 * with File::parallel_read.
+                 *
+                 * @param f the open file, positioned at the region
+                 * @param v the region of data to save to
+                 * @param v_size the size of the region of data to read
+                 */
+                void parallel_read(File& f, char* v, size_t v_size) {
+                    size_t offset = f.tell();
+                    for (size_t sec = 0; sec < offsets_.size(); ++sec) {
+                        if (regions_[sec] && offsets_[sec] == offset &&
+                                sizes_[sec] == v_size) {
+                            verify_(sec, v);
+                            f.seek(offset + v_size);
+                            return;
+                        }
+                    }
+                    f.parallel_read(v, v_size);
+                }
+        };
+    }
+
+    inline
+    ChecksumWriter::ChecksumWriter(size_t block_size) :
+            block_size_(block_size), pos_(0), next_section_(0) {
+        if (block_size_ == 0) throw Error("PIGO: The checksum block size must be positive");
+    }
+
+    inline
+    void ChecksumWriter::add_section_(const char* data, size_t size, bool region) {
+        size_t num_blocks = (size + block_size_ - 1) / block_size_;
+        size_t first = crcs_.size();
+        offsets_.push_back(pos_);
+        sizes_.push_back(size);
+        regions_.push_back(region);
+        first_.push_back(first);
+        crcs_.resize(first + num_blocks);
+        pos_ += size;
+        if (data == nullptr) return;
+
+        for (size_t block = 0; block < num_blocks; ++block) {
+            size_t start = block*block_size_;
+            size_t len = std::min(block_size_, size - start);
+            crcs_[first + block] = detail::crc32c_(data + start, len);
+        }
+    }
+
+    inline
+    void ChecksumWriter::flush_header_() {
+        if (header_.empty()) return;
+        add_section_(header_.data(), header_.size(), false);
+        header_.clear();
+    }
+
+    inline
+    void ChecksumWriter::parallel_write(char*, size_t v_size) {
+        flush_header_();
+        if (v_size > 0) add_section_(nullptr, v_size, true);
+    }
+
+    inline
+    size_t ChecksumWriter::begin_region_(size_t size) {
+        for (size_t sec = next_section_; sec < offsets_.size(); ++sec) {
+            if (!regions_[sec]) continue;
+            if (sizes_[sec] != size)
+                throw Error("PIGO: The written region does not match the checksummed layout");
+            next_section_ = sec + 1;
+            return sec;
+        }
+        throw Error("PIGO: The written region does not match the checksummed layout");
+    }
+
+    inline
+    void ChecksumWriter::add_region_part_(size_t sec, size_t offset, const char* data, size_t size) {
+        size_t sec_size = sizes_[sec];
+        while (size > 0) {
+            size_t block = offset / block_size_;
+            size_t block_start = block*block_size_;
+            size_t block_end = std::min(block_start + block_size_, sec_size);
+            size_t len = std::min(size, block_end - offset);
+            uint32_t crc = detail::crc32c_(data, len);
+            if (offset == block_start && len == block_end - block_start)
+                crcs_[first_[sec] + block] = crc;
+            else {
+                std::lock_guard<std::mutex> lock { pieces_mutex_ };
+                pieces_.push_back(Piece_ { first_[sec] + block, offset, len, crc });
+            }
+            offset += len;
+            data += len;
+            size -= len;
+        }
+    }
+
+    inline
+    void ChecksumWriter::end_region_() {
+        std::sort(pieces_.begin(), pieces_.end(), [](const Piece_& a, const Piece_& b) {
+            return (a.block != b.block) ? a.block < b.block : a.offset < b.offset;
+        });
+        for (size_t i = 0; i < pieces_.size(); ) {
+            uint32_t crc = pieces_[i].crc;
+            size_t j = i + 1;
+            for (; j < pieces_.size() && pieces_[j].block == pieces_[i].block; ++j)
+                crc = detail::crc32c_combine_(crc, pieces_[j].crc, pieces_[j].size);
+            crcs_[pieces_[i].block] = crc;
+            i = j;
+        }
+        pieces_.clear();
+    }
+
+    inline
+    size_t ChecksumWriter::trailer_size() {
+        flush_header_();
+        size_t magic_size = std::string { detail::checksum_trailer_header_ }.size();
+        return 2*magic_size + 2*sizeof(uint64_t) + offsets_.size()*3*sizeof(uint64_t) +
+                sizeof(uint64_t) + crcs_.size()*sizeof(uint32_t) + sizeof(uint32_t) +
+                sizeof(uint64_t);
+    }
+
+    inline
+    std::string ChecksumWriter::trailer() {
+        flush_header_();
+        std::string magic { detail::checksum_trailer_header_ };
+        std::string t { magic };
+        detail::append_raw_<uint64_t>(t, block_size_);
+        detail::append_raw_<uint64_t>(t, offsets_.size());
+        for (size_t sec = 0; sec < offsets_.size(); ++sec) {
+            detail::append_raw_<uint64_t>(t, offsets_[sec]);
+            detail::append_raw_<uint64_t>(t, sizes_[sec]);
+            detail::append_raw_<uint64_t>(t, regions_[sec]);
+        }
+        detail::append_raw_<uint64_t>(t, crcs_.size());
+        t.append((const char*)crcs_.data(), crcs_.size()*sizeof(uint32_t));
+        // Protect the trailer itself, then allow it to be found from the end
+        detail::append_raw_<uint32_t>(t, detail::crc32c_(t.data(), t.size()));
+        detail::append_raw_<uint64_t>(t, t.size() + sizeof(uint64_t) + magic.size());
+        t += magic;
+        return t;
+    }
+
+}
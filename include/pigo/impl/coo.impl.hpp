@@ -3,9 +3,6 @@
  * Copyright (c) 2022 GT-TDALab
  */
 
-#ifdef _OPENMP
-#include <omp.h>
-#endif
 #include <algorithm>
 #include <atomic>
 #include <vector>
@@ -31,6 +28,10 @@ namespace pigo {
 
     template<class L, class O, class S, bool sym, bool ut, bool sl, bool wgt, class W, class WS>
     void COO<L,O,S,sym,ut,sl,wgt,W,WS>::read_(File& f, FileType ft) {
+        detail::PhaseTimer_ phase { "coo.read" };
+        phase.add_bytes(f.size());
+        detail::ProgressTracker_ progress { "coo.read", f.size() };
+        progress.throw_if_cancelled();
         FileType ft_used = ft;
         // If the file type is AUTO, then try to detect it
         if (ft_used == AUTO) {
@@ -49,12 +50,25 @@ namespace pigo {
                 ft_used == GRAPH) {
             // First build a CSR, then convert to a COO
             CSR<L,O,S,S,wgt,W,WS> csr {f, ft_used};
-            convert_csr_(csr);
+            try {
+                convert_csr_(csr);
+            } catch (...) {
+                csr.free();
+                throw;
+            }
             csr.free();
         } else {
             // We need to first build a CSR, then move back to a COO
             throw NotYetImplemented("Coming in v0.6");
         }
+        // The parallel steps stop early once cancelled
+        if (progress.cancelled()) {
+            free();
+            progress.throw_if_cancelled();
+        }
+        progress.finish();
+        phase.add_items(m_);
+        phase.add_alloc(alloc_size_());
     }
 
     template<class L, class O, class S, bool sym, bool ut, bool sl, bool wgt, class W, class WS>
@@ -66,9 +80,19 @@ namespace pigo {
     template<class L, class O, class S, bool sym, bool ut, bool sl, bool wgt, class W, class WS>
     template <class CL, class CO, class LS, class OS, class CW, class CWS>
     void COO<L,O,S,sym,ut,sl,wgt,W,WS>::convert_csr_(CSR<CL,CO,LS,OS,wgt,CW,CWS>& csr) {
+        detail::PhaseTimer_ phase { "coo.convert" };
+        detail::ProgressTracker_ progress { "coo.convert", 0, (size_t)csr.m() };
+        progress.throw_if_cancelled();
         // First, set our sizes and allocate space
         n_ = csr.n();
         m_ = csr.m();
+        nrows_ = csr.nrows();
+        ncols_ = csr.ncols();
+        if (detail::if_true_<sym>()) {
+            // Symmetric entries can appear on either side
+            if (nrows_ < ncols_) nrows_ = ncols_;
+            else ncols_ = nrows_;
+        }
 
         if (detail::if_true_<sym>() && !detail::if_true_<ut>())
             m_ *= 2;
@@ -78,6 +102,8 @@ namespace pigo {
             throw NotYetImplemented("Removing self loops from CSR not yet implemented");
 
         allocate_();
+        phase.add_alloc(alloc_size_());
+        phase.add_items(m_);
 
         auto storage_offsets = csr.offsets();
         auto storage_endpoints = csr.endpoints();
@@ -90,50 +116,76 @@ namespace pigo {
             weights = (CW*)detail::get_raw_data_(storage_weights);
         }
 
-        #pragma omp parallel for schedule(dynamic, 10240)
-        for (L v = 0; v < n_; ++v) {
-            auto start = endpoints + offsets[v];
-            auto end = endpoints + offsets[v+1];
-            size_t coo_cur = offsets[v];
-
-            if (detail::if_true_<sym>() && !detail::if_true_<ut>())
-                coo_cur *= 2;
+        detail::ParallelTeam_ team;
+        detail::LoopChunks_ chunks { 0, (size_t)n_, 10240 };
+        team.run([&](size_t) {
+            // Progress is counted in edges, and checked between vertices
+            size_t since = 0;
+            bool stopped = false;
+            size_t chunk_start, chunk_stop;
+            while (!stopped && chunks.next(chunk_start, chunk_stop)) {
+                for (L v = (L)chunk_start; v < (L)chunk_stop; ++v) {
+                    if (stopped) break;
+                    auto start = endpoints + offsets[v];
+                    auto end = endpoints + offsets[v+1];
+                    size_t coo_cur = offsets[v];
+                    since += end - start;
+                    if (since >= detail::progress_chunk_) {
+                        stopped = progress.update(0, since);
+                        since = 0;
+                    }
 
-            CW* cur_weight = nullptr;
-            if (detail::if_true_<wgt>()) {
-                cur_weight = weights + offsets[v];
-            }
-            for (auto cur = start; cur < end; ++cur, ++coo_cur) {
-                L new_x = v;
-                L new_y = *cur;
-                if (detail::if_true_<sym>() && detail::if_true_<ut>()) {
-                    // Only the upper triangle should be saved
-                    if (new_x > new_y)
-                        std::swap(new_x, new_y);
-                } else if (detail::if_true_<sym>() && !detail::if_true_<ut>()) {
-                    // We need to duplicate each edge, to point both ways
-                    detail::set_value_(x_, coo_cur, new_y);
-                    detail::set_value_(y_, coo_cur, new_x);
-                    if (detail::if_true_<wgt>())
-                        detail::set_value_(w_, coo_cur, *cur_weight);
-                    ++coo_cur;
-                }
-                detail::set_value_(x_, coo_cur, new_x);
-                detail::set_value_(y_, coo_cur, new_y);
+                    if (detail::if_true_<sym>() && !detail::if_true_<ut>())
+                        coo_cur *= 2;
 
-                if (detail::if_true_<wgt>()) {
-                    detail::set_value_(w_, coo_cur, *cur_weight);
-                    ++cur_weight;
+                    CW* cur_weight = nullptr;
+                    if (detail::if_true_<wgt>()) {
+                        cur_weight = weights + offsets[v];
+                    }
+                    for (auto cur = start; cur < end; ++cur, ++coo_cur) {
+                        L new_x = v;
+                        L new_y = *cur;
+                        if (detail::if_true_<sym>() && detail::if_true_<ut>()) {
+                            // Only the upper triangle should be saved
+                            if (new_x > new_y)
+                                std::swap(new_x, new_y);
+                        } else if (detail::if_true_<sym>() && !detail::if_true_<ut>()) {
+                            // We need to duplicate each edge, to point both ways
+                            detail::set_value_(x_, coo_cur, new_y);
+                            detail::set_value_(y_, coo_cur, new_x);
+                            if (detail::if_true_<wgt>())
+                                detail::set_value_(w_, coo_cur, *cur_weight);
+                            ++coo_cur;
+                        }
+                        detail::set_value_(x_, coo_cur, new_x);
+                        detail::set_value_(y_, coo_cur, new_y);
+
+                        if (detail::if_true_<wgt>()) {
+                            detail::set_value_(w_, coo_cur, *cur_weight);
+                            ++cur_weight;
+                        }
+                    }
                 }
             }
+        });
+        if (progress.cancelled()) {
+            free();
+            progress.throw_if_cancelled();
         }
+        progress.finish();
     }
 
     template<class L, class O, class S, bool sym, bool ut, bool sl, bool wgt, class W, class WS>
     void COO<L,O,S,sym,ut,sl,wgt,W,WS>::allocate_() {
-        detail::allocate_mem_<S>(x_, m_);
-        detail::allocate_mem_<S>(y_, m_);
-        detail::allocate_mem_<WS,wgt>(w_, m_);
+        detail::check_alloc_(alloc_size_(), "coo");
+        detail::allocate_mem_<S>(x_, m_, "coo");
+        detail::allocate_mem_<S>(y_, m_, "coo");
+        detail::allocate_mem_<WS,wgt>(w_, m_, "coo");
+    }
+
+    template<class L, class O, class S, bool sym, bool ut, bool sl, bool wgt, class W, class WS>
+    size_t COO<L,O,S,sym,ut,sl,wgt,W,WS>::alloc_size_() const {
+        return sizeof(L)*m_*2 + detail::weight_size_<wgt, W, O>(m_);
     }
 
     namespace detail {
@@ -369,6 +421,9 @@ namespace pigo {
 
         // Now, read out the actual contents
         read_el_(r);
+        // A cancelled read is partial, and is freed by read_
+        detail::ProgressTracker_* progress = detail::current_progress_();
+        if (progress && progress->cancelled()) return;
 
         // Finally, sanity check the file
         if (nrows >= nrows_)
@@ -408,17 +463,8 @@ namespace pigo {
     template<class L, class O, class S, bool sym, bool ut, bool sl, bool wgt, class W, class WS>
     void COO<L,O,S,sym,ut,sl,wgt,W,WS>::read_el_(FileReader& r) {
         // Get the number of threads
-        size_t num_threads = 1;
-        #ifdef _OPENMP
-        omp_set_dynamic(0);
-        #pragma omp parallel shared(num_threads)
-        {
-            #pragma omp single
-            {
-                num_threads = omp_get_num_threads();
-            }
-        }
-        #endif
+        detail::ParallelTeam_ team;
+        size_t num_threads = team.size();
 
         // This takes two passes:
         // first, count the number of newlines to determine how to
@@ -427,26 +473,24 @@ namespace pigo {
 
         std::vector<size_t> nl_offsets(num_threads);
 
-        L max_row = 0;
-        L max_col = 0;
-        #pragma omp parallel reduction(max : max_row) \
-                reduction(max : max_col)
-        {
-            #ifdef _OPENMP
-            size_t tid = omp_get_thread_num();
-            #else
-            size_t tid = 0;
-            #endif
+        // Both passes read the whole input
+        detail::ProgressTracker_* progress = detail::current_progress_();
+        if (progress) progress->add_totals(r.size(), 0);
 
-            // Find our offsets in the file
+        detail::PhaseTimer_ count_phase { "coo.read", "count", false };
+        detail::PhaseTimer_ parse_phase { "coo.read", "parse", false };
+        count_phase.add_bytes(r.size());
+        parse_phase.add_bytes(r.size());
+
+        // Each task reads its own part of the file, moved off of
+        // overlapping entries
+        auto task_reader = [&](size_t tid) {
             size_t size = r.size();
             size_t tid_start_i = (tid*size)/num_threads;
             size_t tid_end_i = ((tid+1)*size)/num_threads;
             FileReader rs = r + tid_start_i;
             FileReader re = r + tid_end_i;
 
-            // Now, move to the appropriate starting point to move off of
-            // overlapping entries
             re.move_to_eol();
             re.move_to_next_int();
             if (tid != 0) {
@@ -458,45 +502,88 @@ namespace pigo {
             // Set our file reader to end either at the full end or at
             // the thread id local end
             rs.smaller_end(re);
+            return rs;
+        };
 
-            // Pass 1
-            // Iterate through, counting the number of newlines
-            FileReader rs_p1 = rs;
+        // Pass 1
+        // Iterate through, counting the number of newlines
+        team.run([&](size_t tid) {
+            count_phase.thread_start();
+            FileReader rs_p1 = task_reader(tid);
             L max_unused;
             size_t tid_nls = 0;
+            size_t since = 0;
+            FilePos last = rs_p1.d;
             while (rs_p1.good()) {
                 read_coord_entry_<true>(tid_nls, rs_p1, max_unused, max_unused);
+                if (++since == detail::progress_chunk_) {
+                    since = 0;
+                    if (detail::update_read_progress_(progress, last, rs_p1.d, 0)) break;
+                }
             }
+            detail::update_read_progress_(progress, last, rs_p1.d, 0);
 
             nl_offsets[tid] = tid_nls;
-
-            // Compute a prefix sum on the newline offsets
-            #pragma omp barrier
-            #pragma omp single
-            {
-                size_t sum_nl = 0;
-                for (size_t tid = 0; tid < num_threads; ++tid) {
-                    sum_nl += nl_offsets[tid];
-                    nl_offsets[tid] = sum_nl;
-                }
-
-                // Now, allocate the space appropriately
-                m_ = nl_offsets[num_threads-1];
+            count_phase.thread_stop();
+        }, "coo.read.wait");
+
+        // Compute a prefix sum on the newline offsets
+        size_t sum_nl = 0;
+        for (size_t tid = 0; tid < num_threads; ++tid) {
+            sum_nl += nl_offsets[tid];
+            nl_offsets[tid] = sum_nl;
+        }
+        count_phase.add_items(sum_nl);
+        count_phase.stop();
+
+        // Counts are incomplete once cancelled, so nothing is allocated
+        // or parsed
+        m_ = 0;
+        bool stop = progress && progress->cancelled();
+        if (!stop) {
+            // Now, allocate the space appropriately
+            detail::PhaseTimer_ alloc_phase { "coo.read", "allocate" };
+            m_ = nl_offsets[num_threads-1];
+            try {
                 allocate_();
+            } catch (...) {
+                m_ = 0;
+                throw;
             }
-            #pragma omp barrier
+            alloc_phase.add_alloc(alloc_size_());
+            if (progress) progress->add_totals(0, m_);
+        }
 
-            // Pass 2
-            // Iterate through again, but now copying out the integers
-            FileReader rs_p2 = rs;
+        // Pass 2
+        // Iterate through again, but now copying out the integers
+        std::vector<L> max_rows(num_threads, 0);
+        std::vector<L> max_cols(num_threads, 0);
+        if (!stop) team.run([&](size_t tid) {
+            parse_phase.thread_start();
+            FileReader rs_p2 = task_reader(tid);
             size_t coord_pos = 0;
             if (tid > 0)
                 coord_pos = nl_offsets[tid-1];
 
+            L my_max_row = 0;
+            L my_max_col = 0;
+            size_t since = 0;
+            FilePos last = rs_p2.d;
             while (rs_p2.good()) {
-                read_coord_entry_<false>(coord_pos, rs_p2, max_row, max_col);
+                read_coord_entry_<false>(coord_pos, rs_p2, my_max_row, my_max_col);
+                if (++since == detail::progress_chunk_) {
+                    if (detail::update_read_progress_(progress, last, rs_p2.d, since)) break;
+                    since = 0;
+                }
             }
-        }
+            max_rows[tid] = my_max_row;
+            max_cols[tid] = my_max_col;
+            parse_phase.thread_stop();
+        });
+        parse_phase.add_items(m_);
+        parse_phase.stop();
+        L max_row = *std::max_element(max_rows.begin(), max_rows.end());
+        L max_col = *std::max_element(max_cols.begin(), max_cols.end());
 
         // Set the number of labels in the matrix represented by the COO
         nrows_ = max_row + 1;
@@ -506,7 +593,7 @@ namespace pigo {
     }
 
     template<class L, class O, class S, bool sym, bool ut, bool sl, bool wgt, class W, class WS>
-    void COO<L,O,S,sym,ut,sl,wgt,W,WS>::save(std::string fn) {
+    SaveStats COO<L,O,S,sym,ut,sl,wgt,W,WS>::save(std::string fn, SaveMode mode, ChecksumMode checksum) {
         // Before creating the file, we need to find the size
         size_t out_size = 0;
         std::string cfh { coo_file_header };
@@ -520,10 +607,14 @@ namespace pigo {
         size_t w_size = detail::weight_size_<wgt, W, O>(m_);
         out_size += w_size;
 
-        // Create the output file
-        WFile w {fn, out_size};
+        return detail::save_file_(*this, fn, out_size, mode, checksum, "coo.save");
+    }
 
+    template<class L, class O, class S, bool sym, bool ut, bool sl, bool wgt, class W, class WS>
+    template<class OutFile>
+    void COO<L,O,S,sym,ut,sl,wgt,W,WS>::save_to_(OutFile& w) {
         // Output the PIGO COO file header
+        std::string cfh { coo_file_header };
         w.write(cfh);
 
         // Output the template sizes
@@ -547,14 +638,170 @@ namespace pigo {
         size_t vy_size = sizeof(L)*m_;
         w.parallel_write(vy, vy_size);
 
+        size_t w_size = detail::weight_size_<wgt, W, O>(m_);
         if (w_size > 0) {
             char* vw = detail::get_raw_data_<WS>(w_);
             w.parallel_write(vw, w_size);
         }
     }
 
+    namespace detail {
+        /** @brief Return a FileReader over the entries of one window
+         *
+         * Entries that cross the window's start belong to the previous
+         * window, and the entry crossing its end belongs to this one.
+         *
+         * @param r the FileReader over the whole file
+         * @param win the window
+         * @param window_size the size of each window in bytes
+         * @return a FileReader over the entries starting in the window
+         */
+        inline
+        FileReader window_reader_(FileReader r, size_t win, size_t window_size) {
+            size_t size = r.size();
+            size_t start = std::min(win*window_size, size);
+            size_t end = std::min(start + window_size, size);
+            FileReader rs = r + start;
+            FileReader re = r + end;
+            re.move_to_eol();
+            re.move_to_next_int();
+            if (win != 0) {
+                rs.move_to_eol();
+                rs.move_to_next_int();
+            } else
+                rs.move_to_first_int();
+            rs.smaller_end(re);
+            return rs;
+        }
+    }
+
+    template<class L, class O, class S, bool sym, bool ut, bool sl, bool wgt, class W, class WS>
+    SaveStats COO<L,O,S,sym,ut,sl,wgt,W,WS>::convert(std::string fn, std::string out_fn,
+            size_t window_size) {
+        auto start_time = std::chrono::steady_clock::now();
+        if (window_size == 0) throw Error("PIGO: The window size must be positive");
+
+        ROFile f { fn };
+        if (f.guess_file_type() != EDGE_LIST)
+            throw NotYetImplemented("PIGO: Only edge lists can be converted while streaming");
+        FileReader r = f.reader();
+        size_t num_windows = (r.size() + window_size - 1) / window_size;
+
+        // Each window is parsed into buffers of its own
+        typedef std::vector<L> LBuf;
+        typedef std::vector<W> WBuf;
+        typedef detail::read_coord_entry_i_<L,O,LBuf,sym,ut,sl,wgt,W,WBuf,true> counter;
+        typedef detail::read_coord_entry_i_<L,O,LBuf,sym,ut,sl,wgt,W,WBuf,false> reader;
+
+        // Pass 1: count the entries in every window
+        detail::ParallelTeam_ team;
+        std::vector<size_t> win_offsets(num_windows+1, 0);
+        detail::LoopChunks_ count_chunks { 0, num_windows, 1 };
+        team.run([&](size_t) {
+            LBuf x_unused, y_unused;
+            WBuf w_unused;
+            L max_unused;
+            size_t win, win_end;
+            while (count_chunks.next(win, win_end)) {
+                FileReader rs = detail::window_reader_(r, win, window_size);
+                size_t count = 0;
+                while (rs.good())
+                    counter::op_(x_unused, y_unused, w_unused, count, rs, max_unused, max_unused);
+                win_offsets[win+1] = count;
+            }
+        });
+        for (size_t win = 0; win < num_windows; ++win)
+            win_offsets[win+1] += win_offsets[win];
+        O m = win_offsets[num_windows];
+
+        // Create the file, leaving the header until the ranges are known
+        std::string cfh { coo_file_header };
+        size_t header_size = cfh.size() + sizeof(uint8_t)*2 + sizeof(L)*3 + sizeof(O);
+        size_t x_start = header_size;
+        size_t y_start = x_start + sizeof(L)*m;
+        size_t w_start = y_start + sizeof(L)*m;
+        size_t out_size = w_start + detail::weight_size_<wgt, W, O>(m);
+
+        int fd = open(out_fn.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666);
+        if (fd < 0) throw Error("PIGO: Unable to open file for writing");
+        if (ftruncate(fd, out_size) != 0) {
+            ::close(fd);
+            throw Error("PIGO: Unable to set the file size");
+        }
+
+        // Pass 2: parse each window and write its entries in place
+        std::vector<L> max_rows(team.size(), 0);
+        std::vector<L> max_cols(team.size(), 0);
+        std::atomic<bool> failed { false };
+        detail::LoopChunks_ parse_chunks { 0, num_windows, 1 };
+        team.run([&](size_t tid) {
+            LBuf x_buf, y_buf;
+            WBuf w_buf;
+            L max_row = 0;
+            L max_col = 0;
+            size_t win, win_end;
+            while (parse_chunks.next(win, win_end)) {
+                size_t count = win_offsets[win+1] - win_offsets[win];
+                x_buf.resize(count);
+                y_buf.resize(count);
+                if (detail::if_true_<wgt>()) w_buf.resize(count);
+
+                FileReader rs = detail::window_reader_(r, win, window_size);
+                size_t pos = 0;
+                while (rs.good())
+                    reader::op_(x_buf, y_buf, w_buf, pos, rs, max_row, max_col);
+
+                size_t first = win_offsets[win];
+                try {
+                    detail::pwrite_all_(fd, (const char*)x_buf.data(),
+                            sizeof(L)*count, x_start + sizeof(L)*first);
+                    detail::pwrite_all_(fd, (const char*)y_buf.data(),
+                            sizeof(L)*count, y_start + sizeof(L)*first);
+                    if (detail::if_true_<wgt>())
+                        detail::pwrite_all_(fd, (const char*)w_buf.data(),
+                                sizeof(W)*count, w_start + sizeof(W)*first);
+                } catch (...) {
+                    failed = true;
+                }
+            }
+            max_rows[tid] = max_row;
+            max_cols[tid] = max_col;
+        });
+        if (failed) {
+            ::close(fd);
+            throw Error("PIGO: Unable to write to file");
+        }
+
+        // Finally, write the header with the counts and label ranges
+        L max_row = *std::max_element(max_rows.begin(), max_rows.end());
+        L max_col = *std::max_element(max_cols.begin(), max_cols.end());
+        L nrows = max_row + 1;
+        L ncols = max_col + 1;
+        L n = (nrows > ncols) ? nrows : ncols;
+        std::string header { cfh };
+        header += (char)sizeof(L);
+        header += (char)sizeof(O);
+        header.append((const char*)&nrows, sizeof(L));
+        header.append((const char*)&ncols, sizeof(L));
+        header.append((const char*)&n, sizeof(L));
+        header.append((const char*)&m, sizeof(O));
+        try {
+            detail::pwrite_all_(fd, header.data(), header.size(), 0);
+        } catch (...) {
+            ::close(fd);
+            throw;
+        }
+        if (::close(fd) != 0) throw Error("PIGO: Unable to close the file");
+
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start_time;
+        return SaveStats { out_size, elapsed.count() };
+    }
+
     template<class L, class O, class S, bool sym, bool ut, bool sl, bool wgt, class W, class WS>
     void COO<L,O,S,sym,ut,sl,wgt,W,WS>::read_bin_(File& f) {
+        // Load any checksums, verifying the header and sizes
+        detail::ChecksumReader_ sums { f };
+
         // Read and confirm the header
         f.read(coo_file_header);
 
@@ -573,218 +820,300 @@ namespace pigo {
         m_ = f.read<O>();
 
         // Allocate space
-        allocate_();
+        {
+            detail::PhaseTimer_ alloc_phase { "coo.read", "allocate" };
+            allocate_();
+            alloc_phase.add_alloc(alloc_size_());
+        }
 
         // Read out the vectors
+        detail::PhaseTimer_ copy_phase { "coo.read", "copy" };
+        copy_phase.add_bytes(alloc_size_());
+        copy_phase.add_items(m_);
         char* vx = detail::get_raw_data_<S>(x_);
         size_t vx_size = sizeof(L)*m_;
-        f.parallel_read(vx, vx_size);
+        sums.parallel_read(f, vx, vx_size);
 
         char* vy = detail::get_raw_data_<S>(y_);
         size_t vy_size = sizeof(L)*m_;
-        f.parallel_read(vy, vy_size);
+        sums.parallel_read(f, vy, vy_size);
 
         size_t w_size = detail::weight_size_<wgt, W, O>(m_);
         if (w_size > 0) {
             char* vw = detail::get_raw_data_<WS>(w_);
-            f.parallel_read(vw, w_size);
+            sums.parallel_read(f, vw, w_size);
         }
     }
 
     template<class L, class O, class S, bool sym, bool ut, bool sl, bool wgt, class W, class WS>
-    void COO<L,O,S,sym,ut,sl,wgt,W,WS>::write(std::string fn) {
-        // Writing occurs in two passes
-        // First, each thread will simulate writing and compute how the
-        // space taken
-        // After the first pass, the output file is allocated
-        // Second, each thread actually writes
-
-        // Get the number of threads
-        size_t num_threads = 1;
-        #ifdef _OPENMP
-        omp_set_dynamic(0);
-        #pragma omp parallel shared(num_threads)
-        {
-            #pragma omp single
-            {
-                num_threads = omp_get_num_threads();
-            }
+    void COO<L,O,S,sym,ut,sl,wgt,W,WS>::validate(bool sorted) const {
+        const L* x = (const L*)detail::get_const_data_<S>(x_);
+        const L* y = (const L*)detail::get_const_data_<S>(y_);
+        size_t m = m_;
+        L nrows = nrows_;
+        L ncols = ncols_;
+
+        size_t e = detail::first_invalid_(m, [&](size_t e) {
+                return detail::in_range_(x[e], nrows) & detail::in_range_(y[e], ncols);
+            });
+        if (e < m) detail::invalid_("COO entry is outside of the matrix", e);
+
+        if (sorted) {
+            e = detail::first_invalid_(m, [&](size_t e) {
+                    return e == 0 || x[e-1] < x[e] ||
+                        (x[e-1] == x[e] && y[e-1] <= y[e]);
+                });
+            if (e < m) detail::invalid_("COO entry is not sorted", e);
         }
-        #endif
-
-        std::vector<size_t> pos_offsets(num_threads+1);
-        std::shared_ptr<File> f;
-        #pragma omp parallel shared(f) shared(pos_offsets)
-        {
-            #ifdef _OPENMP
-            size_t tid = omp_get_thread_num();
-            #else
-            size_t tid = 0;
-            #endif
-            size_t my_size = 0;
-
-            #pragma omp for
-            for (O e = 0; e < m_; ++e) {
-                auto x = detail::get_value_<S, L>(x_, e);
-                my_size += write_size(x);
-
-                // Account for the separating space
-                my_size += 1;
-
-                auto y = detail::get_value_<S, L>(y_, e);
-                my_size += write_size(y);
+    }
 
-                if (detail::if_true_<wgt>()) {
+    namespace detail {
+        /** @brief Formats COO entries as ASCII edge list lines */
+        template<class L, class S, bool wgt, class W, class WS>
+        struct coo_line_fmt_ {
+            /** The X coordinates */
+            S& x;
+            /** The Y coordinates */
+            S& y;
+            /** The weights */
+            WS& w;
+
+            size_t size(size_t e) {
+                // Account for the separating space and the newline
+                size_t res = 2;
+                res += write_size(get_value_<S, L>(x, e));
+                res += write_size(get_value_<S, L>(y, e));
+                if (if_true_<wgt>()) {
                     // Account for the separating space
-                    my_size += 1;
-
-                    auto w = detail::get_value_<WS, W>(w_, e);
-                    my_size += write_size(w);
+                    res += 1 + write_size(get_value_<WS, W>(w, e));
                 }
-                // Account for the file newline
-                my_size += 1;
+                return res;
             }
 
-            pos_offsets[tid+1] = my_size;
-            #pragma omp barrier
-
-            #pragma omp single
-            {
-                // Compute the total size and perform a prefix sum
-                pos_offsets[0] = 0;
-                for (size_t thread = 1; thread <= num_threads; ++thread)
-                    pos_offsets[thread] = pos_offsets[thread-1] + pos_offsets[thread];
-
-                // Allocate the file
-                f = std::make_shared<File>(fn, WRITE, pos_offsets[num_threads]);
+            void write(FilePos& fp, size_t e) {
+                write_ascii(fp, get_value_<S, L>(x, e));
+                pigo::write(fp, ' ');
+                write_ascii(fp, get_value_<S, L>(y, e));
+                if (if_true_<wgt>()) {
+                    pigo::write(fp, ' ');
+                    write_ascii(fp, get_value_<WS, W>(w, e));
+                }
+                pigo::write(fp, '\n');
             }
 
-            #pragma omp barrier
-
-            FilePos my_fp = f->fp()+pos_offsets[tid];
-
-            // Perform the second pass, actually writing out to the file
-            #pragma omp for
-            for (O e = 0; e < m_; ++e) {
-                auto x = detail::get_value_<S, L>(x_, e);
-                write_ascii(my_fp, x);
-                pigo::write(my_fp, ' ');
-                auto y = detail::get_value_<S, L>(y_, e);
-                write_ascii(my_fp, y);
-                if (detail::if_true_<wgt>()) {
-                    pigo::write(my_fp, ' ');
-                    auto w = detail::get_value_<WS, W>(w_, e);
-                    write_ascii(my_fp, w);
-                }
-                pigo::write(my_fp, '\n');
+            size_t max_size() {
+                size_t res = 2*max_write_size<L>() + 2;
+                if (if_true_<wgt>())
+                    res += max_write_size<W>() + 1;
+                return res;
             }
-        }
+        };
     }
 
+    template<class L, class O, class S, bool sym, bool ut, bool sl, bool wgt, class W, class WS>
+    void COO<L,O,S,sym,ut,sl,wgt,W,WS>::write(std::string fn, WriteMode mode) {
+        detail::coo_line_fmt_<L,S,wgt,W,WS> fmt { x_, y_, w_ };
+        detail::write_ascii_file_(fn, m_, fmt, mode, "coo.write");
+    }
 
     template<class L, class O, class S, bool sym, bool ut, bool sl, bool wgt, class W, class WS>
-    void COO<L,O,S,sym,ut,sl,wgt,W,WS>::split_cvs_write(std::string fn, O edge_per_file, bool edgeIDs) {
-        int fcnt=0;
+    void COO<L,O,S,sym,ut,sl,wgt,W,WS>::write(WStream& out, WriteMode mode) {
+        detail::coo_line_fmt_<L,S,wgt,W,WS> fmt { x_, y_, w_ };
+        detail::PhaseTimer_ phase { "coo.write" };
+        phase.add_items(m_);
+        detail::ProgressTracker_ progress { "coo.write", 0, (size_t)m_ };
+        progress.throw_if_cancelled();
+        detail::write_ascii_stream_(out, m_, fmt, mode);
+        // What was written before cancelling stays in the stream
+        progress.throw_if_cancelled();
+        progress.finish();
+    }
 
-        // Get the number of threads
-        omp_set_dynamic(0);
-        size_t num_threads = 0;
-        #pragma omp parallel shared(num_threads)
-        {
-            #pragma omp single
-            {
-                num_threads = omp_get_num_threads();
-            }
+    namespace detail {
+        /** @brief Return the CSV type name of a weight type */
+        template<class W>
+        inline
+        std::string csv_type_name_() {
+            if (std::is_floating_point<W>::value)
+                return (sizeof(W) > 4) ? "Double" : "Float";
+            if (sizeof(W) <= 1) return "Byte";
+            if (sizeof(W) <= 2) return "Short";
+            if (sizeof(W) <= 4) return "Int";
+            return "Long";
         }
 
-        std::string header;
-        if (edgeIDs)
-            header =  "~id,~from,~to,~label\n";
-        else
-            header = "~from,~to,~label\n";
-
-            const std::string line_end {",con\n"};
-            int ell=line_end.length();
-
-        // account for
-        //   + e at the beginning of edge ID (if any) + comma
-        //   + v at the beginning v id and a comma between them
-        //   last comma included in line_end
-        ell += ((edgeIDs) ? 2 : 0) + 3;
-
-        for (O start=0; start<=m_; start += edge_per_file) {
-                O end = std::min(m_, start+edge_per_file);
-                std::string ofname = fn + "." + std::to_string(fcnt) + ".csv";
-                ++fcnt;
-
-            // Writing occurs in two passes
-            // First, each thread will simulate writing and compute how the
-            // space taken
-            // After the first pass, the output file is allocated
-            // Second, each thread actually writes
-            std::vector<size_t> pos_offsets(num_threads+1);
-            std::shared_ptr<File> f;
-            #pragma omp parallel shared(f) shared(pos_offsets)
-            {
-                size_t tid = omp_get_thread_num();
-                size_t my_size = 0;
-
-                #pragma omp for
-                for (O e = start; e < end; ++e) {
-                    my_size += ell;
-                    if (edgeIDs)
-                        my_size += write_size(e);
-                    auto x = detail::get_value_<S, L>(x_, e);
-                    my_size += write_size(x);
-
-                    auto y = detail::get_value_<S, L>(y_, e);
-                    my_size += write_size(y);
-                }
-
-                pos_offsets[tid+1] = my_size;
-                #pragma omp barrier
-
-                #pragma omp single
-                {
-                    // Compute the total size and perform a prefix sum
-                    pos_offsets[0] = 0;
-                    for (size_t thread = 1; thread <= num_threads; ++thread)
-                        pos_offsets[thread] = pos_offsets[thread-1] + pos_offsets[thread];
-
-                    // Allocate the file
-                    f = std::make_shared<File>(ofname, WRITE, header.length()+pos_offsets[num_threads]);
+        /** @brief Formats COO entries as CSV edge lines */
+        template<class L, class S, bool wgt, class W, class WS>
+        struct csv_edge_fmt_ {
+            /** The X coordinates */
+            S& x;
+            /** The Y coordinates */
+            S& y;
+            /** The weights */
+            WS& w;
+            /** The export options */
+            const CSVExportOptions& opts;
+            /** The line ending, starting with the separator and label */
+            std::string line_end;
+            /** Whether the weight property is written */
+            bool with_weight;
+
+            size_t size(size_t e) {
+                size_t res = 2*opts.vertex_id_prefix.size() + 1;
+                if (opts.edge_ids)
+                    res += opts.edge_id_prefix.size() + write_size(e) + 1;
+                res += write_size(get_value_<S, L>(x, e));
+                res += write_size(get_value_<S, L>(y, e));
+                if (with_weight)
+                    res += write_size(get_value_<WS, W>(w, e)) + 1;
+                return res + line_end.size() + 1;
+            }
 
-                    // write header
-                    f->write(header);
+            void write(FilePos& fp, size_t e) {
+                if (opts.edge_ids) {
+                    pigo::write(fp, opts.edge_id_prefix);
+                    write_ascii(fp, e);
+                    pigo::write(fp, ',');
+                }
+                pigo::write(fp, opts.vertex_id_prefix);
+                write_ascii(fp, get_value_<S, L>(x, e));
+                pigo::write(fp, ',');
+                pigo::write(fp, opts.vertex_id_prefix);
+                write_ascii(fp, get_value_<S, L>(y, e));
+                pigo::write(fp, line_end);
+                if (with_weight) {
+                    pigo::write(fp, ',');
+                    write_ascii(fp, get_value_<WS, W>(w, e));
                 }
+                pigo::write(fp, '\n');
+            }
+        };
 
-                #pragma omp barrier
+        /** @brief Formats labels as CSV vertex lines */
+        template<class L>
+        struct csv_vertex_fmt_ {
+            /** The labels to write */
+            const std::vector<L>& verts;
+            /** The export options */
+            const CSVExportOptions& opts;
+
+            size_t size(size_t i) {
+                return opts.vertex_id_prefix.size() + write_size(verts[i]) +
+                    opts.vertex_label.size() + 2;
+            }
 
-                FilePos my_fp = f->fp()+pos_offsets[tid];
+            void write(FilePos& fp, size_t i) {
+                pigo::write(fp, opts.vertex_id_prefix);
+                write_ascii(fp, verts[i]);
+                pigo::write(fp, ',');
+                pigo::write(fp, opts.vertex_label);
+                pigo::write(fp, '\n');
+            }
+        };
 
-                // Perform the second pass, actually writing out to the file
-                #pragma omp for
-                for (O e = start; e < end; ++e) {
-                    if (edgeIDs) {
-                    pigo::write(my_fp, 'e');
-                    write_ascii(my_fp, e);
+        /** @brief Split [0, count) into the bounds of the output files
+         *
+         * There is always at least one file, even if it will be empty.
+         */
+        inline
+        std::vector<size_t> csv_bounds_(size_t count, size_t per_file) {
+            if (per_file == 0) throw Error("Need at least one entry per file");
+            size_t num_files = count/per_file + ((count%per_file != 0) ? 1 : 0);
+            if (num_files == 0) num_files = 1;
+            std::vector<size_t> bounds(num_files+1);
+            for (size_t file = 0; file < num_files; ++file)
+                bounds[file] = file*per_file;
+            bounds[num_files] = count;
+            return bounds;
+        }
+    }
 
-                    pigo::write(my_fp, ',');
-                    }
-                    auto x = detail::get_value_<S, L>(x_, e);
-                    pigo::write(my_fp, 'v');
-                    write_ascii(my_fp, x);
+    template<class L, class O, class S, bool sym, bool ut, bool sl, bool wgt, class W, class WS>
+    void COO<L,O,S,sym,ut,sl,wgt,W,WS>::csv_export(std::string fn, const CSVExportOptions& opts) {
+        std::string ext = opts.gzip ? ".csv.gz" : ".csv";
+        detail::PhaseTimer_ phase { "coo.csv_export" };
+        phase.add_items(m_);
 
-                    pigo::write(my_fp, ',');
+        // First, write out the edges
+        bool with_weight = detail::if_true_<wgt>() && !opts.weight_property.empty();
+        std::string header;
+        if (opts.edge_ids)
+            header = "~id,";
+        header += "~from,~to,~label";
+        if (with_weight)
+            header += "," + opts.weight_property + ":" + detail::csv_type_name_<W>();
+        header += "\n";
+
+        std::vector<size_t> bounds = detail::csv_bounds_(m_, opts.entries_per_file);
+        std::vector<std::string> fns(bounds.size()-1);
+        for (size_t file = 0; file < fns.size(); ++file)
+            fns[file] = fn + "." + std::to_string(file) + ext;
+
+        detail::csv_edge_fmt_<L,S,wgt,W,WS> edge_fmt { x_, y_, w_, opts,
+            "," + opts.edge_label, with_weight };
+        {
+            detail::PhaseTimer_ edge_phase { "coo.csv_export", "edges" };
+            edge_phase.add_items(m_);
+            detail::write_shards_(fns, header, bounds, edge_fmt, opts.gzip);
+        }
 
-                    auto y = detail::get_value_<S, L>(y_, e);
-                    pigo::write(my_fp, 'v');
-                    write_ascii(my_fp, y);
+        if (!opts.vertices) return;
+
+        detail::ParallelTeam_ team;
+        size_t num_threads = team.size();
+
+        // Find the labels that are used by an edge
+        detail::TempVector_<char> used(n_, 0);
+        team.for_each(0, m_, [&](size_t e) {
+            L x = detail::get_value_<S, L>(x_, e);
+            L y = detail::get_value_<S, L>(y_, e);
+            detail::atomic_store_(used[x], (char)1);
+            detail::atomic_store_(used[y], (char)1);
+        });
+
+        // Compact the used labels, keeping them in order
+        std::vector<size_t> v_offsets(num_threads+1);
+        std::vector<L> verts;
+        team.run([&](size_t tid) {
+            L v_start = (tid*n_)/num_threads;
+            L v_end = ((tid+1)*n_)/num_threads;
+            size_t my_count = 0;
+            for (L v = v_start; v < v_end; ++v)
+                if (used[v]) ++my_count;
+            v_offsets[tid+1] = my_count;
+        });
+
+        v_offsets[0] = 0;
+        for (size_t thread = 1; thread <= num_threads; ++thread)
+            v_offsets[thread] += v_offsets[thread-1];
+        verts.resize(v_offsets[num_threads]);
+
+        team.run([&](size_t tid) {
+            L v_start = (tid*n_)/num_threads;
+            L v_end = ((tid+1)*n_)/num_threads;
+            size_t pos = v_offsets[tid];
+            for (L v = v_start; v < v_end; ++v)
+                if (used[v]) verts[pos++] = v;
+        });
+
+        bounds = detail::csv_bounds_(verts.size(), opts.entries_per_file);
+        fns.resize(bounds.size()-1);
+        for (size_t file = 0; file < fns.size(); ++file)
+            fns[file] = fn + ".vertices." + std::to_string(file) + ext;
+
+        detail::csv_vertex_fmt_<L> vertex_fmt { verts, opts };
+        detail::PhaseTimer_ vertex_phase { "coo.csv_export", "vertices" };
+        vertex_phase.add_items(verts.size());
+        detail::write_shards_(fns, "~id,~label\n", bounds, vertex_fmt, opts.gzip);
+    }
 
-                    pigo::write(my_fp, line_end);
-                }
-            }
-        }
+    template<class L, class O, class S, bool sym, bool ut, bool sl, bool wgt, class W, class WS>
+    void COO<L,O,S,sym,ut,sl,wgt,W,WS>::split_cvs_write(std::string fn, O edge_per_file, bool edgeIDs) {
+        CSVExportOptions opts;
+        opts.entries_per_file = edge_per_file;
+        opts.edge_ids = edgeIDs;
+        opts.weight_property = "";
+        csv_export(fn, opts);
     }
 
 }
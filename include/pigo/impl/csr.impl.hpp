@@ -7,24 +7,26 @@
 #include <atomic>
 #include <vector>
 #include <string>
-#ifdef _OPENMP
-#include <omp.h>
-#endif
 
 namespace pigo {
     template<class L, class O, class LS, class OS, bool wgt, class W, class WS>
     CSR<L,O,LS,OS,wgt,W,WS>::CSR(std::string fn) : CSR(fn, AUTO) { }
 
     template<class L, class O, class LS, class OS, bool wgt, class W, class WS>
-    CSR<L,O,LS,OS,wgt,W,WS>::CSR(std::string fn, FileType ft) {
+    CSR<L,O,LS,OS,wgt,W,WS>::CSR(std::string fn, FileType ft, LoadStats* stats) {
         // Open the file for reading
         ROFile f {fn};
-        read_(f, ft);
+        read_(f, ft, stats);
     }
 
     template<class L, class O, class LS, class OS, bool wgt, class W, class WS>
-    CSR<L,O,LS,OS,wgt,W,WS>::CSR(File& f, FileType ft) {
-        read_(f, ft);
+    CSR<L,O,LS,OS,wgt,W,WS>::CSR(File& f, FileType ft, LoadStats* stats) {
+        read_(f, ft, stats);
+    }
+
+    template<class L, class O, class LS, class OS, bool wgt, class W, class WS>
+    CSR<L,O,LS,OS,wgt,W,WS>::CSR(File& f, detail::ChecksumReader_& sums) {
+        read_(f, PIGO_CSR_BIN, nullptr, &sums);
     }
 
     namespace detail {
@@ -40,10 +42,60 @@ namespace pigo {
         void fail_if_weighted() {
             fail_if_weighted_i_<wgt>::op_();
         }
+
+        /** @brief Account for one row in a thread's LoadStats
+         *
+         * @param s the LoadStats to update
+         * @param row the row
+         * @param deg the degree of the row
+         */
+        inline
+        void add_row_stats_(LoadStats& s, size_t row, size_t deg) {
+            ++s.rows;
+            s.entries += deg;
+            if (deg == 0) {
+                ++s.empty_rows;
+                return;
+            }
+            if (deg > s.max_degree || (deg == s.max_degree && row < s.max_degree_row)) {
+                s.max_degree = deg;
+                s.max_degree_row = row;
+            }
+            size_t bucket = 0;
+            while ((deg >> (bucket+1)) != 0) ++bucket;
+            if (s.degree_histogram.size() <= bucket)
+                s.degree_histogram.resize(bucket+1, 0);
+            ++s.degree_histogram[bucket];
+        }
+
+        /** @brief Merge a thread's LoadStats into the total */
+        inline
+        void merge_load_stats_(LoadStats& into, const LoadStats& from) {
+            into.rows += from.rows;
+            into.entries += from.entries;
+            into.empty_rows += from.empty_rows;
+            into.self_loops += from.self_loops;
+            into.duplicates += from.duplicates;
+            if (from.max_degree > into.max_degree ||
+                    (from.max_degree == into.max_degree && from.max_degree > 0 &&
+                     from.max_degree_row < into.max_degree_row)) {
+                into.max_degree = from.max_degree;
+                into.max_degree_row = from.max_degree_row;
+            }
+            if (into.degree_histogram.size() < from.degree_histogram.size())
+                into.degree_histogram.resize(from.degree_histogram.size(), 0);
+            for (size_t b = 0; b < from.degree_histogram.size(); ++b)
+                into.degree_histogram[b] += from.degree_histogram[b];
+        }
     }
 
     template<class L, class O, class LS, class OS, bool wgt, class W, class WS>
-    void CSR<L,O,LS,OS,wgt,W,WS>::read_(File& f, FileType ft) {
+    void CSR<L,O,LS,OS,wgt,W,WS>::read_(File& f, FileType ft, LoadStats* stats,
+            detail::ChecksumReader_* sums) {
+        detail::PhaseTimer_ phase { "csr.read" };
+        phase.add_bytes(f.size());
+        detail::ProgressTracker_ progress { "csr.read", f.size() };
+        progress.throw_if_cancelled();
         FileType ft_used = ft;
         // If the file type is AUTO, then try to detect it
         if (ft_used == AUTO) {
@@ -54,24 +106,45 @@ namespace pigo {
                 ft_used == PIGO_COO_BIN) {
             // First build a COO, then load here
             COO<L,O,L*, false, false, false, wgt, W, WS> coo { f, ft_used };
-            convert_coo_(coo);
+            try {
+                convert_coo_(coo, stats);
+            } catch (...) {
+                coo.free();
+                throw;
+            }
             coo.free();
         } else if (ft_used == PIGO_CSR_BIN) {
-            read_bin_(f);
+            read_bin_(f, sums);
+            if (stats) row_stats_(*stats, true);
         } else if (ft_used == GRAPH) {
             detail::fail_if_weighted<wgt>();
             FileReader r = f.reader();
-            read_graph_(r);
+            read_graph_(r, stats);
         } else
             throw NotYetImplemented("This file type is not yet supported");
+        // The parallel steps stop early once cancelled
+        if (progress.cancelled()) {
+            free();
+            progress.throw_if_cancelled();
+        }
+        progress.finish();
+        phase.add_items(m_);
+        phase.add_alloc(alloc_size_());
     }
 
     template<class L, class O, class LS, class OS, bool wgt, class W, class WS>
     void CSR<L,O,LS,OS,wgt,W,WS>::allocate_() {
-        detail::allocate_mem_<LS>(endpoints_, m_);
-        detail::allocate_mem_<WS,wgt>(weights_, m_);
-        detail::allocate_mem_<OS>(offsets_, n_+1);
+        detail::check_alloc_(alloc_size_(), "csr");
+        detail::allocate_mem_<LS>(endpoints_, m_, "csr");
+        detail::allocate_mem_<WS,wgt>(weights_, m_, "csr");
+        detail::allocate_mem_<OS>(offsets_, n_+1, "csr");
+    }
+
+    template<class L, class O, class LS, class OS, bool wgt, class W, class WS>
+    size_t CSR<L,O,LS,OS,wgt,W,WS>::alloc_size_() const {
+        return sizeof(L)*m_ + detail::weight_size_<wgt, W, O>(m_) + sizeof(O)*(n_+1);
     }
+
     namespace detail {
         template<bool wgt, class W, class WS, class COOW, class COOWS, class O>
         struct copy_weight_i_ {
@@ -99,8 +172,8 @@ namespace pigo {
             COOWS>
     CSR<L,O,LS,OS,wgt,W,WS>::CSR(COO<COOL,COOO,COOStorage,COOsym,
             COOut,COOsl,wgt,COOW,COOWS>
-            &coo) {
-        convert_coo_(coo);
+            &coo, LoadStats* stats) {
+        convert_coo_(coo, stats);
     }
 
     template<class L, class O, class LS, class OS, bool wgt, class W,
@@ -109,14 +182,19 @@ namespace pigo {
         class COOW, class COOWS>
     void CSR<L,O,LS,OS,wgt,W,WS>::convert_coo_(COO<
             COOL,COOO,COOStorage,COOsym,COOut,COOsl,wgt,COOW,COOWS>&
-            coo) {
+            coo, LoadStats* stats) {
+        detail::PhaseTimer_ phase { "csr.convert" };
+        detail::ProgressTracker_ progress { "csr.convert", 0, 2*(size_t)coo.m() };
+        progress.throw_if_cancelled();
         // Set the sizes first
         n_ = coo.n();
         m_ = coo.m();
         nrows_ = coo.nrows();
         ncols_ = coo.ncols();
+        phase.add_items(m_);
 
         // Allocate the offsets and endpoints
+        detail::PhaseTimer_ alloc_phase { "csr.convert", "allocate" };
         allocate_();
 
         // This is a multi pass algorithm.
@@ -126,82 +204,104 @@ namespace pigo {
         // Finally, we need to go through the COO and copy memory
 
         // Get the number of threads
-        size_t num_threads = 1;
-        #ifdef _OPENMP
-        omp_set_dynamic(0);
-        #pragma omp parallel shared(num_threads)
-        {
-            #pragma omp single
-            {
-                num_threads = omp_get_num_threads();
-            }
+        detail::ParallelTeam_ team;
+        size_t num_threads = team.size();
+
+        size_t temp_bytes = sizeof(O)*(2*(size_t)n_ + num_threads);
+        try {
+            detail::check_alloc_(temp_bytes, "temporary");
+        } catch (...) {
+            free();
+            throw;
         }
-        #endif
 
         // Temporarily keep track of the degree for each label (this can
         // easily be computed later)
-        O* label_degs = new O[n_];
+        O* label_degs;
+        detail::allocate_mem_(label_degs, n_);
 
         // Keep track of the starting offsets for each thread
-        O* start_offsets = new O[num_threads];
+        O* start_offsets;
+        detail::allocate_mem_(start_offsets, num_threads);
 
         // Each thread will compute the degrees for each label on its own.
         // This is then used to reduce them all
-        O* all_degs = new O[n_];
-        #pragma omp parallel shared(all_degs) shared(label_degs) shared(start_offsets)
-        {
-            #ifdef _OPENMP
-            size_t tid = omp_get_thread_num();
-            #else
-            size_t tid = 0;
-            #endif
-
+        O* all_degs;
+        detail::allocate_mem_(all_degs, n_);
+        size_t alloc_bytes = alloc_size_() + temp_bytes;
+        alloc_phase.add_alloc(alloc_bytes);
+        alloc_phase.stop();
+        phase.add_alloc(alloc_bytes);
+
+        detail::PhaseTimer_ deg_phase { "csr.convert", "degrees", false };
+        detail::PhaseTimer_ offset_phase { "csr.convert", "offsets", false };
+        detail::PhaseTimer_ scatter_phase { "csr.convert", "scatter", false };
+        deg_phase.add_items(m_);
+        offset_phase.add_items(n_);
+        scatter_phase.add_items(m_);
+        if (stats) *stats = LoadStats();
+        // Statistics are gathered per task in the existing passes, and
+        // only when asked for
+        const bool want_stats = stats != nullptr;
+        std::vector<LoadStats> task_stats(want_stats ? num_threads : 0);
+        auto coo_x = coo.x();
+        auto coo_y = coo.y();
+        auto coo_w = coo.w();
+
+        // We need to initialize degrees to count for zero-degree vertices
+        team.run([&](size_t tid) {
+            deg_phase.thread_start();
             L v_start = (tid*n_)/num_threads;
             L v_end = ((tid+1)*n_)/num_threads;
-            // We need to initialize degrees to count for zero-degree
-            // vertices
-            #pragma omp for
-            for (L v = 0; v < n_; ++v)
+            for (L v = v_start; v < v_end; ++v)
                 all_degs[v] = 0;
-
-            auto coo_x = coo.x();
-            auto coo_y = coo.y();
-            auto coo_w = coo.w();
-
-            #pragma omp for
-            for (O x_id = 0; x_id < m_; ++x_id) {
+        }, "csr.convert.wait");
+
+        // Progress counts each edge in the degree and scatter passes
+        team.run([&](size_t tid) {
+            O e_start = (tid*m_)/num_threads;
+            O e_end = ((tid+1)*m_)/num_threads;
+            size_t since = 0;
+            for (O x_id = e_start; x_id < e_end; ++x_id) {
                 size_t deg_inc = detail::get_value_<COOStorage, L>(coo_x, x_id);
-                #pragma omp atomic
-                ++all_degs[deg_inc];
+                detail::fetch_add_(all_degs[deg_inc], (O)1);
+                if (++since == detail::progress_chunk_) {
+                    bool stopped = progress.update(0, since);
+                    since = 0;
+                    if (stopped) break;
+                }
             }
+            progress.update(0, since);
+            deg_phase.thread_stop();
+        }, "csr.convert.wait");
 
-            // Reduce the degree vectors
-            #pragma omp barrier
-            // Now all degs (via all_degs) have been computed
-
+        // Now all degs (via all_degs) have been computed
+        team.run([&](size_t tid) {
+            offset_phase.thread_start();
+            L v_start = (tid*n_)/num_threads;
+            L v_end = ((tid+1)*n_)/num_threads;
             O my_degs = 0;
             for (L c = v_start; c < v_end; ++c) {
                 O this_deg = all_degs[c];
                 label_degs[c] = this_deg;
                 my_degs += this_deg;
+                if (want_stats) detail::add_row_stats_(task_stats[tid], c, this_deg);
             }
 
             // Save our local degree count to do a prefix sum on
             start_offsets[tid] = my_degs;
+        }, "csr.convert.wait");
 
-            // Get a memory allocation
-            // Do a prefix sum to keep everything compact by row
-            #pragma omp barrier
-            #pragma omp single
-            {
-                O total_degs = 0;
-                for (size_t cur_tid = 0; cur_tid < num_threads; ++cur_tid) {
-                    total_degs += start_offsets[cur_tid];
-                    start_offsets[cur_tid] = total_degs;
-                }
-            }
-            #pragma omp barrier
+        // Do a prefix sum to keep everything compact by row
+        O total_degs = 0;
+        for (size_t cur_tid = 0; cur_tid < num_threads; ++cur_tid) {
+            total_degs += start_offsets[cur_tid];
+            start_offsets[cur_tid] = total_degs;
+        }
 
+        team.run([&](size_t tid) {
+            L v_start = (tid*n_)/num_threads;
+            L v_end = ((tid+1)*n_)/num_threads;
             // Get the starting offset
             // The prefix sum array is off by one, so the start is at zero
             O cur_offset = 0;
@@ -213,59 +313,67 @@ namespace pigo {
                 detail::set_value_(offsets_, c, cur_offset);
                 cur_offset += label_degs[c];
             }
-            #pragma omp single
-            {
-                // Patch the last offset to the end, making for easier
-                // degree computation and iteration
-                detail::set_value_(offsets_, n_, m_);
-            }
-
-            #pragma omp barrier
-            // Now, all offsets_ have been assigned
-
-            // Here, we use the degrees computed earlier and treat them
-            // instead as the remaining vertices, showing the current copy
-            // position
-
-            // Finally, copy over the actual endpoints
-            #pragma omp for
-            for (O coo_pos = 0; coo_pos < m_; ++coo_pos) {
+            offset_phase.thread_stop();
+        }, "csr.convert.wait");
+
+        // Patch the last offset to the end, making for easier degree
+        // computation and iteration
+        detail::set_value_(offsets_, n_, m_);
+
+        // Here, we use the degrees computed earlier and treat them
+        // instead as the remaining vertices, showing the current copy
+        // position
+
+        // Finally, copy over the actual endpoints. Degrees are incomplete
+        // once cancelled, so nothing is scattered
+        if (!progress.cancelled()) team.run([&](size_t tid) {
+            scatter_phase.thread_start();
+            O e_start = (tid*m_)/num_threads;
+            O e_end = ((tid+1)*m_)/num_threads;
+            size_t since = 0;
+            LoadStats* my_stats = want_stats ? &task_stats[tid] : nullptr;
+            for (O coo_pos = e_start; coo_pos < e_end; ++coo_pos) {
+                if (++since == detail::progress_chunk_) {
+                    if (progress.update(0, since)) break;
+                    since = 0;
+                }
                 L src = detail::get_value_<COOStorage, L>(coo_x, coo_pos);
                 L dst = detail::get_value_<COOStorage, L>(coo_y, coo_pos);
 
-                O this_offset_pos;
-                #pragma omp atomic capture
-                {
-                    this_offset_pos = label_degs[src];
-                    label_degs[src]--;
-                }
+                O this_offset_pos = detail::fetch_add_(label_degs[src], (O)-1);
                 O this_offset = detail::get_value_<OS, O>(offsets_, src+1) - this_offset_pos;
                 detail::set_value_(endpoints_, this_offset, dst);
                 detail::copy_weight<wgt,W,WS,COOW,COOWS>(weights_, this_offset, coo_w, coo_pos);
+                if (want_stats && src == dst) ++my_stats->self_loops;
             }
+            scatter_phase.thread_stop();
+        });
 
+        if (want_stats) {
+            for (const LoadStats& my_stats : task_stats)
+                detail::merge_load_stats_(*stats, my_stats);
         }
 
-        delete [] label_degs;
-        delete [] start_offsets;
-        delete [] all_degs;
+        deg_phase.stop();
+        offset_phase.stop();
+        scatter_phase.stop();
+
+        detail::free_mem_(label_degs);
+        detail::free_mem_(start_offsets);
+        detail::free_mem_(all_degs);
 
+        if (progress.cancelled()) {
+            free();
+            progress.throw_if_cancelled();
+        }
+        progress.finish();
     }
 
     template<class L, class O, class LS, class OS, bool wgt, class W, class WS>
-    void CSR<L,O,LS,OS,wgt,W,WS>::read_graph_(FileReader &r) {
+    void CSR<L,O,LS,OS,wgt,W,WS>::read_graph_(FileReader &r, LoadStats* stats) {
         // Get the number of threads
-        size_t num_threads = 1;
-        #ifdef _OPENMP
-        omp_set_dynamic(0);
-        #pragma omp parallel shared(num_threads)
-        {
-            #pragma omp single
-            {
-                num_threads = omp_get_num_threads();
-            }
-        }
-        #endif
+        detail::ParallelTeam_ team;
+        size_t num_threads = team.size();
 
         // We have a header containing the number of vertices and edges.
         // This is used to verify and check correctness
@@ -284,17 +392,23 @@ namespace pigo {
         std::vector<size_t> nl_offsets(num_threads);
         std::vector<size_t> int_offsets(num_threads);
         std::vector<L> max_labels(num_threads);
-        std::vector<bool> have_zeros(num_threads, false);
+        std::vector<char> have_zeros(num_threads, false);
+        // Self loops are only counted when statistics are asked for
+        const bool want_stats = stats != nullptr;
+        std::vector<size_t> self_loops(want_stats ? num_threads : 0, 0);
         bool have_zero;
-        #pragma omp parallel shared(have_zero) shared(have_zeros)
-        {
-            #ifdef _OPENMP
-            size_t tid = omp_get_thread_num();
-            #else
-            size_t tid = 0;
-            #endif
 
-            // Find our offsets in the file
+        // Both passes read the whole input
+        detail::ProgressTracker_* progress = detail::current_progress_();
+        if (progress) progress->add_totals(r.size(), 0);
+
+        detail::PhaseTimer_ count_phase { "csr.read", "count", false };
+        detail::PhaseTimer_ parse_phase { "csr.read", "parse", false };
+        count_phase.add_bytes(r.size());
+        parse_phase.add_bytes(r.size());
+
+        // Each task reads its own part of the file, starting at an integer
+        auto task_reader = [&](size_t tid) {
             size_t size = r.size();
             size_t tid_start_i = (tid*size)/num_threads;
             size_t tid_end_i = ((tid+1)*size)/num_threads;
@@ -311,12 +425,18 @@ namespace pigo {
             // Set our file reader to end either at the full end or at
             // the thread id local end
             rs.smaller_end(re);
+            return rs;
+        };
 
-            // Now, perform the first pass and count
-            FileReader rs_p1 = rs;
+        // Now, perform the first pass and count
+        team.run([&](size_t tid) {
+            count_phase.thread_start();
+            FileReader rs_p1 = task_reader(tid);
             size_t tid_nls = 0;
             size_t tid_ints = 0;
             bool my_have_zero = false;
+            size_t since = 0;
+            FilePos last = rs_p1.d;
             while (rs_p1.good()) {
                 if (rs_p1.at_nl_or_eol())
                     ++tid_nls;
@@ -327,59 +447,67 @@ namespace pigo {
                     my_have_zero = true;
 
                 rs_p1.move_to_next_int_or_nl();
+                if (++since == detail::progress_chunk_) {
+                    since = 0;
+                    if (detail::update_read_progress_(progress, last, rs_p1.d, 0)) break;
+                }
             }
+            detail::update_read_progress_(progress, last, rs_p1.d, 0);
             if (my_have_zero) {
                 have_zeros[tid] = true;
             }
-
-            #pragma omp barrier
-            #pragma omp single
-            {
-                bool found_zero = false;
-                for (size_t tid = 0; tid < num_threads; ++tid) {
-                    if (have_zeros[tid]) {
-                        found_zero = true;
-                        break;
-                    }
-                }
-                if (found_zero) have_zero = true;
-                else have_zero = false;
-            }
-            #pragma omp barrier
-
             nl_offsets[tid] = tid_nls;
             int_offsets[tid] = tid_ints;
+            count_phase.thread_stop();
+        }, "csr.read.wait");
+
+        have_zero = false;
+        for (size_t tid = 0; tid < num_threads; ++tid) {
+            if (have_zeros[tid]) {
+                have_zero = true;
+                break;
+            }
+        }
 
-            // Compute a prefix sum on the offsets
-            #pragma omp barrier
-            #pragma omp single
-            {
-                size_t sum_nl = (have_zero) ? 0 : 1;
-                size_t sum_ints = 0;
-                for (size_t tid = 0; tid < num_threads; ++tid) {
-                    sum_nl += nl_offsets[tid];
-                    nl_offsets[tid] = sum_nl;
-
-                    sum_ints += int_offsets[tid];
-                    int_offsets[tid] = sum_ints;
-                }
+        // Compute a prefix sum on the offsets
+        size_t sum_nl = (have_zero) ? 0 : 1;
+        size_t sum_ints = 0;
+        for (size_t tid = 0; tid < num_threads; ++tid) {
+            sum_nl += nl_offsets[tid];
+            nl_offsets[tid] = sum_nl;
 
-                // Now, allocate the space appropriately
-                m_ = int_offsets[num_threads-1];
-                n_ = nl_offsets[num_threads-1];
-                nrows_ = n_;
-                allocate_();
-                detail::set_value_(offsets_, 0, 0);
-                if (!have_zero)
-                    detail::set_value_(offsets_, 1, 0);
-                detail::set_value_(offsets_, n_, m_);
-            }
-            #pragma omp barrier
+            sum_ints += int_offsets[tid];
+            int_offsets[tid] = sum_ints;
+        }
+        count_phase.add_items(sum_ints);
+        count_phase.stop();
 
-            // Pass 2: iterate through again, but now copy out the values
-            // to the appropriate position in the endpoints / offsets
+        // Counts are incomplete once cancelled, so the space is only
+        // allocated to be freed, and nothing is parsed
+        bool stop = progress && progress->cancelled();
+        if (progress) progress->add_totals(0, sum_ints);
+
+        // Now, allocate the space appropriately
+        {
+            detail::PhaseTimer_ alloc_phase { "csr.read", "allocate" };
+            m_ = int_offsets[num_threads-1];
+            n_ = nl_offsets[num_threads-1];
+            nrows_ = n_;
+            allocate_();
+            alloc_phase.add_alloc(alloc_size_());
+            detail::set_value_(offsets_, 0, 0);
+            if (!have_zero)
+                detail::set_value_(offsets_, 1, 0);
+            detail::set_value_(offsets_, n_, m_);
+        }
+
+        // Pass 2: iterate through again, but now copy out the values
+        // to the appropriate position in the endpoints / offsets
+        if (!stop) team.run([&](size_t tid) {
+            parse_phase.thread_start();
             L my_max = 0;
-            FileReader rs_p2 = rs;
+            size_t my_self_loops = 0;
+            FileReader rs_p2 = task_reader(tid);
             O endpoint_pos = 0;
             L offset_pos = 0;
             if (tid > 0) {
@@ -388,9 +516,15 @@ namespace pigo {
             } else if (!have_zero)
                 offset_pos = 1;
 
+            size_t since = 0;
+            FilePos last = rs_p2.d;
             while (rs_p2.good()) {
                 // Ignore any trailing data in the file
                 if (offset_pos >= n_) break;
+                if (++since == detail::progress_chunk_) {
+                    if (detail::update_read_progress_(progress, last, rs_p2.d, since)) break;
+                    since = 0;
+                }
 
                 // Copy and set the endpoint
                 if (rs_p2.at_nl_or_eol()) {
@@ -402,13 +536,20 @@ namespace pigo {
                     L endpoint = rs_p2.read_int<L>();
                     if (endpoint > my_max)
                         my_max = endpoint;
+                    if (want_stats && endpoint == offset_pos) ++my_self_loops;
                     detail::set_value_(endpoints_, endpoint_pos++, endpoint);
                     if (!rs_p2.at_nl_or_eol())
                         rs_p2.move_to_next_int_or_nl();
                 }
             }
             max_labels[tid] = my_max;
-        }
+            if (want_stats) self_loops[tid] = my_self_loops;
+            parse_phase.thread_stop();
+        });
+        parse_phase.add_items(m_);
+        parse_phase.stop();
+        // A cancelled read is partial, and is freed by read_
+        if (progress && progress->cancelled()) return;
 
         if (m_ == 2*read_m) {}
         else if (m_ != read_m) throw Error("Mismatch in CSR nonzeros and header");
@@ -421,6 +562,39 @@ namespace pigo {
                 col_max = max_labels[thread];
         }
         ncols_ = col_max+1;
+
+        // Self loops were counted while copying, so only the degrees remain
+        if (want_stats) {
+            row_stats_(*stats, false);
+            for (size_t thread = 0; thread < num_threads; ++thread)
+                stats->self_loops += self_loops[thread];
+        }
+    }
+
+    template<class L, class O, class LS, class OS, bool wgt, class W, class WS>
+    void CSR<L,O,LS,OS,wgt,W,WS>::row_stats_(LoadStats& stats, bool count_self_loops) {
+        stats = LoadStats();
+        detail::ParallelTeam_ team;
+        std::vector<LoadStats> task_stats(team.size());
+        detail::LoopChunks_ chunks { 0, (size_t)n_, 10240 };
+        team.run([&](size_t tid) {
+            LoadStats& my_stats = task_stats[tid];
+            size_t start_v, stop_v;
+            while (chunks.next(start_v, stop_v)) {
+                for (L v = (L)start_v; v < (L)stop_v; ++v) {
+                    O start = detail::get_value_<OS, O>(offsets_, v);
+                    O end = detail::get_value_<OS, O>(offsets_, v+1);
+                    detail::add_row_stats_(my_stats, v, end-start);
+                    if (count_self_loops) {
+                        for (O e = start; e < end; ++e)
+                            if (detail::get_value_<LS, L>(endpoints_, e) == v)
+                                ++my_stats.self_loops;
+                    }
+                }
+            }
+        });
+        for (const LoadStats& my_stats : task_stats)
+            detail::merge_load_stats_(stats, my_stats);
     }
 
     template<class L, class O, class LS, class OS, bool wgt, class W, class WS>
@@ -442,19 +616,14 @@ namespace pigo {
     }
 
     template<class L, class O, class LS, class OS, bool wgt, class W, class WS>
-    void CSR<L,O,LS,OS,wgt,W,WS>::save(std::string fn) {
+    SaveStats CSR<L,O,LS,OS,wgt,W,WS>::save(std::string fn, SaveMode mode, ChecksumMode checksum) {
         // Before creating the file, we need to find the size
-        size_t out_size = save_size();
-
-        // Create the output file
-        WFile w {fn, out_size};
-
-        // Now, perform the actual save
-        save(w);
+        return detail::save_file_(*this, fn, save_size(), mode, checksum, "csr.save");
     }
 
     template<class L, class O, class LS, class OS, bool wgt, class W, class WS>
-    void CSR<L,O,LS,OS,wgt,W,WS>::save(File& w) {
+    template<class OutFile>
+    void CSR<L,O,LS,OS,wgt,W,WS>::save_to_(OutFile& w) {
         // Output the file header
         std::string cfh { csr_file_header };
         w.write(cfh);
@@ -489,7 +658,14 @@ namespace pigo {
     }
 
     template<class L, class O, class LS, class OS, bool wgt, class W, class WS>
-    void CSR<L,O,LS,OS,wgt,W,WS>::read_bin_(File& f) {
+    void CSR<L,O,LS,OS,wgt,W,WS>::read_bin_(File& f, detail::ChecksumReader_* sums) {
+        // Load any checksums, verifying the header and sizes
+        std::unique_ptr<detail::ChecksumReader_> own_sums;
+        if (sums == nullptr) {
+            own_sums.reset(new detail::ChecksumReader_ { f });
+            sums = own_sums.get();
+        }
+
         // Read and confirm the header
         f.read(csr_file_header);
 
@@ -508,105 +684,202 @@ namespace pigo {
         ncols_ = f.read<L>();
 
         // Allocate space
-        allocate_();
+        {
+            detail::PhaseTimer_ alloc_phase { "csr.read", "allocate" };
+            allocate_();
+            alloc_phase.add_alloc(alloc_size_());
+        }
 
         size_t voff_size = sizeof(O)*(n_+1);
         size_t vend_size = sizeof(L)*m_;
 
         // Read out the vectors
+        detail::PhaseTimer_ copy_phase { "csr.read", "copy" };
+        copy_phase.add_bytes(alloc_size_());
+        copy_phase.add_items(m_);
         char* voff = detail::get_raw_data_<OS>(offsets_);
-        f.parallel_read(voff, voff_size);
+        sums->parallel_read(f, voff, voff_size);
 
         char* vend = detail::get_raw_data_<LS>(endpoints_);
-        f.parallel_read(vend, vend_size);
+        sums->parallel_read(f, vend, vend_size);
 
         size_t w_size = detail::weight_size_<wgt, W, O>(m_);
         if (w_size > 0) {
             char* wend = detail::get_raw_data_<WS>(weights_);
-            f.parallel_read(wend, w_size);
+            sums->parallel_read(f, wend, w_size);
         }
     }
 
     template<class L, class O, class LS, class OS, bool wgt, class W, class WS>
     void CSR<L,O,LS,OS,wgt,W,WS>::sort() {
-        #pragma omp parallel for schedule(dynamic, 10240)
-        for (L v = 0; v < n_; ++v) {
-            // Get the start and end range
-            O start = detail::get_value_<OS, O>(offsets_, v);
-            O end = detail::get_value_<OS, O>(offsets_, v+1);
-
-            // Sort the range from the start to the end
-            if (detail::if_true_<wgt>()) {
-                // This should be improved, e.g., without replicating
-                // everything. For now, make a joint array, sort that, and
-                // then pull out the resulting data
-                std::vector<std::pair<L, W>> vec;
-                vec.reserve(end-start);
-                for (O cur = start; cur < end; ++cur) {
-                    L l = detail::get_value_<LS, L>(endpoints_, cur);
-                    W w = detail::get_value_<WS, W>(weights_, cur);
-                    std::pair<L, W> val = {l, w};
-                    vec.emplace_back(val);
-                }
-                std::sort(vec.begin(), vec.end());
-                O cur = start;
-                for (auto& pair : vec) {
-                    L l = std::get<0>(pair);
-                    W w = std::get<1>(pair);
-                    detail::set_value_(endpoints_, cur, l);
-                    detail::set_value_(weights_, cur, w);
-                    ++cur;
+        detail::PhaseTimer_ phase { "csr.sort" };
+        phase.add_items(m_);
+        detail::ParallelTeam_ team;
+        detail::LoopChunks_ chunks { 0, (size_t)n_, 10240 };
+        team.run([&](size_t) {
+            phase.thread_start();
+            size_t chunk_start, chunk_stop;
+            while (chunks.next(chunk_start, chunk_stop)) {
+                for (L v = (L)chunk_start; v < (L)chunk_stop; ++v) {
+                    // Get the start and end range
+                    O start = detail::get_value_<OS, O>(offsets_, v);
+                    O end = detail::get_value_<OS, O>(offsets_, v+1);
+
+                    // Sort the range from the start to the end
+                    if (detail::if_true_<wgt>()) {
+                        // This should be improved, e.g., without replicating
+                        // everything. For now, make a joint array, sort that, and
+                        // then pull out the resulting data
+                        std::vector<std::pair<L, W>> vec;
+                        vec.reserve(end-start);
+                        for (O cur = start; cur < end; ++cur) {
+                            L l = detail::get_value_<LS, L>(endpoints_, cur);
+                            W w = detail::get_value_<WS, W>(weights_, cur);
+                            std::pair<L, W> val = {l, w};
+                            vec.emplace_back(val);
+                        }
+                        std::sort(vec.begin(), vec.end());
+                        O cur = start;
+                        for (auto& pair : vec) {
+                            L l = std::get<0>(pair);
+                            W w = std::get<1>(pair);
+                            detail::set_value_(endpoints_, cur, l);
+                            detail::set_value_(weights_, cur, w);
+                            ++cur;
+                        }
+                    } else {
+                        L* endpoints = (L*)detail::get_raw_data_(endpoints_);
+
+                        L* range_start = endpoints+start;
+                        L* range_end = endpoints+end;
+
+                        std::sort(range_start, range_end);
+                    }
                 }
-            } else {
-                L* endpoints = (L*)detail::get_raw_data_(endpoints_);
-
-                L* range_start = endpoints+start;
-                L* range_end = endpoints+end;
-
-                std::sort(range_start, range_end);
             }
+            phase.thread_stop();
+        });
+    }
+
+    template<class L, class O, class LS, class OS, bool wgt, class W, class WS>
+    void CSR<L,O,LS,OS,wgt,W,WS>::validate(bool sorted) const {
+        const O* offsets = (const O*)detail::get_const_data_<OS>(offsets_);
+        const L* endpoints = (const L*)detail::get_const_data_<LS>(endpoints_);
+        size_t n = n_;
+        size_t m = m_;
+
+        if (offsets == nullptr)
+            throw Error("PIGO: CSR has no offsets");
+        if (endpoints == nullptr && m > 0)
+            throw Error("PIGO: CSR has no endpoints");
+        if (offsets[0] != 0)
+            detail::invalid_("CSR offsets do not start at zero", 0);
+
+        size_t v = detail::first_invalid_(n, [&](size_t v) {
+                return offsets[v] <= offsets[v+1];
+            });
+        if (v < n) detail::invalid_("CSR offsets decrease", v);
+
+        // One-based files keep a trailing row beyond n, so the offsets
+        // may end before m
+        if (offsets[n] > m_)
+            detail::invalid_("CSR offsets exceed the number of non-zeros", n);
+
+        L ncols = ncols_;
+        size_t e = detail::first_invalid_(m, [&](size_t e) {
+                return detail::in_range_(endpoints[e], ncols);
+            });
+        if (e < m) detail::invalid_("CSR endpoint is not a valid column", e);
+
+        if (sorted) {
+            v = detail::first_invalid_(n, [&](size_t v) {
+                    return std::is_sorted(endpoints + offsets[v], endpoints + offsets[v+1]);
+                });
+            if (v < n) detail::invalid_("CSR row is not sorted", v);
         }
     }
 
     template<class L, class O, class LS, class OS, bool wgt, class W, class WS>
     template<class nL, class nO, class nLS, class nOS, bool nw, class nW, class nWS>
-    CSR<nL, nO, nLS, nOS, nw, nW, nWS> CSR<L,O,LS,OS,wgt,W,WS>::new_csr_without_dups() {
+    CSR<nL, nO, nLS, nOS, nw, nW, nWS> CSR<L,O,LS,OS,wgt,W,WS>::new_csr_without_dups(LoadStats* stats) {
+        detail::PhaseTimer_ phase { "csr.dedup" };
+        phase.add_items(m_);
+
         // First, sort ourselves
         sort();
 
+        detail::ParallelTeam_ team;
+
         // Next, count the degrees for each vertex, excluding duplicates
         std::shared_ptr<L> degs_storage;
+        detail::check_alloc_(sizeof(L)*n_, "temporary");
         detail::allocate_mem_(degs_storage, n_);
         L* degs = degs_storage.get();
 
-        nO new_m = 0;
-
-        #pragma omp parallel for schedule(dynamic, 10240) shared(degs) reduction(+ : new_m)
-        for (L v = 0; v < n_; ++v) {
-            O start = detail::get_value_<OS, O>(offsets_, v);
-            O end = detail::get_value_<OS, O>(offsets_, v+1);
-            if (end-start == 0) {
-                degs[v] = 0;
-                continue;
-            }
+        detail::PhaseTimer_ count_phase { "csr.dedup", "count", false };
+        count_phase.add_items(m_);
+        if (stats) *stats = LoadStats();
+        // Statistics of the new CSR are gathered while counting, and only
+        // when asked for
+        const bool want_stats = stats != nullptr;
+        std::vector<LoadStats> task_stats(want_stats ? team.size() : 0);
+        std::vector<nO> task_m(team.size(), 0);
+        detail::LoopChunks_ count_chunks { 0, (size_t)n_, 10240 };
+        team.run([&](size_t tid) {
+            LoadStats* my_stats = want_stats ? &task_stats[tid] : nullptr;
+            nO my_m = 0;
+            count_phase.thread_start();
+
+            size_t chunk_start, chunk_stop;
+            while (count_chunks.next(chunk_start, chunk_stop)) {
+                for (L v = (L)chunk_start; v < (L)chunk_stop; ++v) {
+                    O start = detail::get_value_<OS, O>(offsets_, v);
+                    O end = detail::get_value_<OS, O>(offsets_, v+1);
+                    if (end-start == 0) {
+                        degs[v] = 0;
+                        if (want_stats) detail::add_row_stats_(*my_stats, v, 0);
+                        continue;
+                    }
 
-            L prev_val = detail::get_value_<LS, L>(endpoints_, start++);
-            L new_deg = 1;
+                    L prev_val = detail::get_value_<LS, L>(endpoints_, start++);
+                    L new_deg = 1;
+                    if (want_stats && prev_val == v) ++my_stats->self_loops;
+
+                    while (start != end) {
+                        L cur_val = detail::get_value_<LS, L>(endpoints_, start++);
+                        if (cur_val != prev_val) {
+                            prev_val = cur_val;
+                            ++new_deg;
+                            if (want_stats && cur_val == v) ++my_stats->self_loops;
+                        }
+                    }
 
-            while (start != end) {
-                L cur_val = detail::get_value_<LS, L>(endpoints_, start++);
-                if (cur_val != prev_val) {
-                    prev_val = cur_val;
-                    ++new_deg;
+                    degs[v] = new_deg;
+                    my_m += new_deg;
+                    if (want_stats) detail::add_row_stats_(*my_stats, v, new_deg);
                 }
             }
-
-            degs[v] = new_deg;
-            new_m += new_deg;
+            task_m[tid] = my_m;
+            count_phase.thread_stop();
+        });
+        nO new_m = 0;
+        for (size_t tid = 0; tid < task_m.size(); ++tid) {
+            new_m += task_m[tid];
+            if (want_stats) detail::merge_load_stats_(*stats, task_stats[tid]);
         }
+        count_phase.stop();
+        if (stats) stats->duplicates = m_ - new_m;
 
         // Allocate the new CSR
+        detail::PhaseTimer_ alloc_phase { "csr.dedup", "allocate" };
         CSR<nL, nO, nLS, nOS, nw, nW, nWS> ret { (nL)n_, new_m, (nL)nrows_, (nL)ncols_ };
+        size_t alloc_bytes = sizeof(nL)*new_m + detail::weight_size_<nw, nW, nO>(new_m) +
+                sizeof(nO)*(n_+1);
+        alloc_phase.add_alloc(alloc_bytes);
+        alloc_phase.stop();
+        phase.add_alloc(alloc_bytes);
+        detail::PhaseTimer_ offset_phase { "csr.dedup", "offsets" };
+        offset_phase.add_items(n_);
 
         auto& new_endpoints = ret.endpoints();
         auto& new_offsets = ret.offsets();
@@ -615,31 +888,14 @@ namespace pigo {
         // Set the offsets by doing a prefix sum on the degrees
 
         // Get the number of threads
-        size_t num_threads = 1;
-        #ifdef _OPENMP
-        omp_set_dynamic(0);
-        #pragma omp parallel shared(num_threads)
-        {
-            #pragma omp single
-            {
-                num_threads = omp_get_num_threads();
-            }
-        }
-        #endif
+        size_t num_threads = team.size();
 
         // Keep track of the starting offsets for each thread
         std::shared_ptr<O> so_storage;
         detail::allocate_mem_(so_storage, num_threads);
         O* start_offsets = so_storage.get();
 
-        #pragma omp parallel shared(start_offsets)
-        {
-            #ifdef _OPENMP
-            size_t tid = omp_get_thread_num();
-            #else
-            size_t tid = 0;
-            #endif
-
+        team.run([&](size_t tid) {
             L v_start = (tid*n_)/num_threads;
             L v_end = ((tid+1)*n_)/num_threads;
 
@@ -652,17 +908,17 @@ namespace pigo {
 
             // Save our local degree count to do a prefix sum on
             start_offsets[tid] = my_degs;
+        });
 
-            #pragma omp barrier
-            #pragma omp single
-            {
-                O total_degs = 0;
-                for (size_t cur_tid = 0; cur_tid < num_threads; ++cur_tid) {
-                    total_degs += start_offsets[cur_tid];
-                    start_offsets[cur_tid] = total_degs;
-                }
-            }
-            #pragma omp barrier
+        O total_degs = 0;
+        for (size_t cur_tid = 0; cur_tid < num_threads; ++cur_tid) {
+            total_degs += start_offsets[cur_tid];
+            start_offsets[cur_tid] = total_degs;
+        }
+
+        team.run([&](size_t tid) {
+            L v_start = (tid*n_)/num_threads;
+            L v_end = ((tid+1)*n_)/num_threads;
 
             // Get the starting offset
             // The prefix sum array is off by one, so the start is at zero
@@ -675,44 +931,52 @@ namespace pigo {
                 detail::set_value_(new_offsets, c, cur_offset);
                 cur_offset += degs[c];
             }
-            #pragma omp single
-            {
-                // Patch the last offset to the end, making for easier
-                // degree computation and iteration
-                detail::set_value_(new_offsets, (nL)n_, new_m);
-            }
+        });
 
-            // Now, all new offsets have been assigned
-        }
+        // Patch the last offset to the end, making for easier degree
+        // computation and iteration
+        detail::set_value_(new_offsets, (nL)n_, new_m);
+        // Now, all new offsets have been assigned
 
-        // Repeat going through the edges, copying out the endpoints
-        #pragma omp parallel for schedule(dynamic, 10240)
-        for (L v = 0; v < n_; ++v) {
-            O o_start = detail::get_value_<OS, O>(offsets_, v);
-            O o_end = detail::get_value_<OS, O>(offsets_, v+1);
-            if (o_end-o_start == 0) continue;
-
-            nO n_cur = detail::get_value_<nOS, nO>(new_offsets, (nL)v);
-
-            L prev_val = detail::get_value_<LS, L>(endpoints_, o_start++);
-            detail::set_value_(new_endpoints, n_cur++, prev_val);
-            if (detail::if_true_<nw>()) {
-                W w = detail::get_value_<WS, W>(weights_, o_start-1);
-                detail::set_value_(new_weights, n_cur-1, (nW)w);
-            }
+        offset_phase.stop();
 
-            while (o_start != o_end) {
-                L cur_val = detail::get_value_<LS, L>(endpoints_, o_start++);
-                if (prev_val != cur_val) {
-                    prev_val = cur_val;
-                    detail::set_value_(new_endpoints, n_cur++, (nL)prev_val);
+        // Repeat going through the edges, copying out the endpoints
+        detail::PhaseTimer_ copy_phase { "csr.dedup", "copy", false };
+        copy_phase.add_items(new_m);
+        detail::LoopChunks_ copy_chunks { 0, (size_t)n_, 10240 };
+        team.run([&](size_t) {
+            copy_phase.thread_start();
+            size_t chunk_start, chunk_stop;
+            while (copy_chunks.next(chunk_start, chunk_stop)) {
+                for (L v = (L)chunk_start; v < (L)chunk_stop; ++v) {
+                    O o_start = detail::get_value_<OS, O>(offsets_, v);
+                    O o_end = detail::get_value_<OS, O>(offsets_, v+1);
+                    if (o_end-o_start == 0) continue;
+
+                    nO n_cur = detail::get_value_<nOS, nO>(new_offsets, (nL)v);
+
+                    L prev_val = detail::get_value_<LS, L>(endpoints_, o_start++);
+                    detail::set_value_(new_endpoints, n_cur++, prev_val);
                     if (detail::if_true_<nw>()) {
                         W w = detail::get_value_<WS, W>(weights_, o_start-1);
                         detail::set_value_(new_weights, n_cur-1, (nW)w);
                     }
+
+                    while (o_start != o_end) {
+                        L cur_val = detail::get_value_<LS, L>(endpoints_, o_start++);
+                        if (prev_val != cur_val) {
+                            prev_val = cur_val;
+                            detail::set_value_(new_endpoints, n_cur++, (nL)prev_val);
+                            if (detail::if_true_<nw>()) {
+                                W w = detail::get_value_<WS, W>(weights_, o_start-1);
+                                detail::set_value_(new_weights, n_cur-1, (nW)w);
+                            }
+                        }
+                    }
                 }
             }
-        }
+            copy_phase.thread_stop();
+        });
 
         return ret;
     }
@@ -0,0 +1,530 @@
+/**
+ * PIGO: a parallel graph and matrix I/O and preprocessing library
+ * Copyright (c) 2022 GT-TDALab
+ *
+ * This file contains the implementation of the execution context and
+ * executors
+ */
+
+#include <algorithm>
+#include <deque>
+#include <exception>
+#include <utility>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#ifdef __linux__
+#include <pthread.h>
+#endif
+
+namespace pigo {
+
+    namespace detail {
+
+        /** @brief Return the calling thread's innermost scope */
+        inline
+        ExecutionScope*& current_scope_() {
+            thread_local ExecutionScope* scope = nullptr;
+            return scope;
+        }
+
+        /** @brief Return the task the calling thread is running */
+        inline
+        TaskScope_*& current_task_() {
+            thread_local TaskScope_* task = nullptr;
+            return task;
+        }
+
+        /** @brief Return the executor a context uses */
+        inline
+        std::shared_ptr<Executor> context_executor_(const ExecutionContext& context) {
+            if (context.executor) return context.executor;
+            return default_executor();
+        }
+
+        /** @brief Return the tasks a context asks for, ignoring nesting */
+        inline
+        size_t requested_threads_(const ExecutionContext& context) {
+            if (context.threads > 0) return context.threads;
+            if (!context.cpus.empty()) return context.cpus.size();
+            return std::max(context_executor_(context)->concurrency(), (size_t)1);
+        }
+
+        inline
+        size_t context_threads_() {
+            return requested_threads_(execution_context());
+        }
+
+        inline
+        TaskScope_::TaskScope_(size_t tid) : tid_(tid), outer_(current_task_()) {
+            current_task_() = this;
+        }
+
+        inline
+        TaskScope_::~TaskScope_() {
+            current_task_() = outer_;
+        }
+
+        inline
+        size_t task_id_() {
+            TaskScope_* task = current_task_();
+            return task ? task->tid_ : 0;
+        }
+
+        inline
+        bool in_task_() {
+            return current_task_() != nullptr;
+        }
+
+        /** @brief Bind the calling thread to one CPU
+         *
+         * @param cpu the CPU to bind to
+         * @param saved if not nullptr, set to the previous affinity
+         * @return whether the thread was bound
+         */
+        inline
+        bool bind_thread_(int cpu, void* saved) {
+            #ifdef __linux__
+            if (cpu < 0 || cpu >= CPU_SETSIZE) return false;
+            if (saved && pthread_getaffinity_np(pthread_self(), sizeof(cpu_set_t),
+                        (cpu_set_t*)saved) != 0)
+                return false;
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            CPU_SET(cpu, &set);
+            // Binding is a hint; a CPU outside the allowed set is skipped
+            return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+            #else
+            (void)cpu;
+            (void)saved;
+            return false;
+            #endif
+        }
+
+        inline
+        ThreadBinding_::ThreadBinding_(const std::vector<int>& cpus, size_t tid) : bound_(false) {
+            if (cpus.empty()) return;
+            #ifdef __linux__
+            bound_ = bind_thread_(cpus[tid % cpus.size()], &saved_);
+            #else
+            (void)tid;
+            #endif
+        }
+
+        inline
+        ThreadBinding_::~ThreadBinding_() {
+            #ifdef __linux__
+            if (bound_) pthread_setaffinity_np(pthread_self(), sizeof(saved_), &saved_);
+            #endif
+        }
+
+        inline
+        bool LoopChunks_::next(size_t& start, size_t& stop) {
+            start = next_.fetch_add(grain_, std::memory_order_relaxed);
+            if (start >= end_) return false;
+            stop = std::min(start + grain_, end_);
+            return true;
+        }
+
+        inline
+        void OrderedTurns_::wait(size_t chunk) {
+            std::unique_lock<std::mutex> lock { mutex_ };
+            turn_.wait(lock, [&]() { return next_ == chunk; });
+        }
+
+        inline
+        void OrderedTurns_::done() {
+            {
+                std::lock_guard<std::mutex> lock { mutex_ };
+                ++next_;
+            }
+            turn_.notify_all();
+        }
+
+        /** @brief The tasks of one step on a ThreadPool or external pool
+         *
+         * Tasks are claimed in order by the waiting thread and by helper
+         * jobs. Helpers keep the batch alive, but only use the task after
+         * claiming one, which can only happen before the step returns.
+         */
+        struct TaskBatch_ {
+            const std::function<void(size_t)>* task;
+            size_t count;
+            std::atomic<size_t> next;
+            std::mutex mutex;
+            std::condition_variable finished;
+            size_t done;
+            std::exception_ptr error;
+
+            TaskBatch_(const std::function<void(size_t)>* task, size_t count) :
+                task(task), count(count), next(0), done(0) { }
+
+            /** @brief Run tasks until all have been claimed */
+            void work() {
+                size_t i;
+                while ((i = next.fetch_add(1)) < count) {
+                    std::exception_ptr e;
+                    try {
+                        (*task)(i);
+                    } catch (...) {
+                        e = std::current_exception();
+                    }
+                    std::lock_guard<std::mutex> lock { mutex };
+                    if (e && !error) error = e;
+                    if (++done == count) finished.notify_all();
+                }
+            }
+
+            /** @brief Wait for all tasks, rethrowing the first exception */
+            void wait() {
+                std::unique_lock<std::mutex> lock { mutex };
+                finished.wait(lock, [&]() { return done == count; });
+                if (error) std::rethrow_exception(error);
+            }
+        };
+
+        /** @brief One worker's jobs */
+        struct PoolQueue_ {
+            std::mutex mutex;
+            std::deque<std::function<void()>> jobs;
+        };
+
+        /** @brief The queues and workers' sleeping state of a ThreadPool */
+        struct PoolState_ {
+            std::vector<std::unique_ptr<PoolQueue_>> queues;
+            /** The queue the next job from outside the pool goes to */
+            std::atomic<size_t> next_queue { 0 };
+            /** The jobs queued and not yet taken */
+            std::atomic<size_t> pending { 0 };
+            std::mutex sleep_mutex;
+            std::condition_variable wake;
+            bool stopping = false;
+
+            /** @brief Return the calling thread's pool and worker index */
+            static std::pair<PoolState_*, size_t>& current() {
+                thread_local std::pair<PoolState_*, size_t> worker { nullptr, 0 };
+                return worker;
+            }
+
+            /** @brief Queue a job, on the calling worker's queue if any */
+            void push(std::function<void()> job) {
+                std::pair<PoolState_*, size_t>& me = current();
+                size_t q = (me.first == this) ? me.second :
+                    next_queue.fetch_add(1, std::memory_order_relaxed) % queues.size();
+                {
+                    std::lock_guard<std::mutex> lock { queues[q]->mutex };
+                    queues[q]->jobs.push_back(std::move(job));
+                }
+                {
+                    std::lock_guard<std::mutex> lock { sleep_mutex };
+                    ++pending;
+                }
+                wake.notify_one();
+            }
+
+            /** @brief Take the newest job of worker self, or else steal
+             *         the oldest job of another worker
+             */
+            bool pop(size_t self, std::function<void()>& job) {
+                size_t n = queues.size();
+                if (self < n) {
+                    PoolQueue_& q = *queues[self];
+                    std::lock_guard<std::mutex> lock { q.mutex };
+                    if (!q.jobs.empty()) {
+                        job = std::move(q.jobs.back());
+                        q.jobs.pop_back();
+                        --pending;
+                        return true;
+                    }
+                }
+                for (size_t k = 1; k <= n; ++k) {
+                    PoolQueue_& q = *queues[(self + k) % n];
+                    std::lock_guard<std::mutex> lock { q.mutex };
+                    if (!q.jobs.empty()) {
+                        job = std::move(q.jobs.front());
+                        q.jobs.pop_front();
+                        --pending;
+                        return true;
+                    }
+                }
+                return false;
+            }
+
+            /** @brief Run jobs until stopped with none pending */
+            void work(size_t self) {
+                current() = std::make_pair(this, self);
+                std::function<void()> job;
+                while (true) {
+                    if (pop(self, job)) {
+                        job();
+                        job = nullptr;
+                        continue;
+                    }
+                    std::unique_lock<std::mutex> lock { sleep_mutex };
+                    wake.wait(lock, [&]() { return pending > 0 || stopping; });
+                    if (stopping && pending == 0) return;
+                }
+            }
+        };
+
+    }
+
+    namespace detail {
+
+        /** @brief Return the executor of background jobs of contexts
+         *         that do not set one
+         *
+         * With OpenMP, this is a ThreadPool with one worker per OpenMP
+         * thread, started on first use. The jobs also run their steps on
+         * it, so any number of them share its workers rather than each
+         * opening a team of its own. It is destroyed at exit, which
+         * finishes the queued jobs and joins the workers.
+         */
+        inline
+        std::shared_ptr<Executor> job_executor_() {
+            #ifdef _OPENMP
+            static std::shared_ptr<Executor> pool = std::make_shared<ThreadPool>(
+                    (size_t)omp_get_max_threads());
+            return pool;
+            #else
+            return default_executor();
+            #endif
+        }
+
+    }
+
+    inline
+    void Executor::submit(std::function<void()> job) {
+        detail::job_executor_()->submit(std::move(job));
+    }
+
+    inline
+    size_t OpenMPExecutor::concurrency() const {
+        #ifdef _OPENMP
+        return omp_get_max_threads();
+        #else
+        return 1;
+        #endif
+    }
+
+    inline
+    void OpenMPExecutor::run(size_t count, const std::function<void(size_t)>& task) {
+        if (count == 0) return;
+        if (count == 1) {
+            task(0);
+            return;
+        }
+        std::exception_ptr error;
+        #ifdef _OPENMP
+        #pragma omp parallel num_threads(count)
+        {
+            size_t num_threads = omp_get_num_threads();
+            for (size_t i = omp_get_thread_num(); i < count; i += num_threads) {
+                try {
+                    task(i);
+                } catch (...) {
+                    #pragma omp critical (pigo_executor)
+                    if (!error) error = std::current_exception();
+                }
+            }
+        }
+        #else
+        for (size_t i = 0; i < count; ++i) {
+            try {
+                task(i);
+            } catch (...) {
+                if (!error) error = std::current_exception();
+            }
+        }
+        #endif
+        if (error) std::rethrow_exception(error);
+    }
+
+    inline
+    ThreadPool::ThreadPool(size_t threads, std::vector<int> cpus) :
+            state_(std::make_shared<detail::PoolState_>()) {
+        if (threads == 0) threads = std::max(std::thread::hardware_concurrency(), 1u);
+        for (size_t i = 0; i < threads; ++i)
+            state_->queues.emplace_back(new detail::PoolQueue_);
+        for (size_t i = 0; i < threads; ++i) {
+            int cpu = cpus.empty() ? -1 : cpus[i % cpus.size()];
+            std::shared_ptr<detail::PoolState_> state = state_;
+            workers_.emplace_back([state, i, cpu]() {
+                if (cpu >= 0) detail::bind_thread_(cpu, nullptr);
+                state->work(i);
+            });
+        }
+    }
+
+    inline
+    ThreadPool::~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock { state_->sleep_mutex };
+            state_->stopping = true;
+        }
+        state_->wake.notify_all();
+        for (std::thread& worker : workers_) {
+            // A job may drop the last reference to its own pool; that
+            // worker finishes the remaining jobs and exits on its own
+            if (worker.get_id() == std::this_thread::get_id())
+                worker.detach();
+            else
+                worker.join();
+        }
+    }
+
+    inline
+    size_t ThreadPool::concurrency() const {
+        return workers_.size();
+    }
+
+    inline
+    void ThreadPool::submit(std::function<void()> job) {
+        state_->push(std::move(job));
+    }
+
+    inline
+    void ThreadPool::run(size_t count, const std::function<void(size_t)>& task) {
+        if (count == 0) return;
+        if (count == 1) {
+            task(0);
+            return;
+        }
+        auto batch = std::make_shared<detail::TaskBatch_>(&task, count);
+        size_t helpers = std::min(count-1, workers_.size());
+        for (size_t h = 0; h < helpers; ++h)
+            state_->push([batch]() { batch->work(); });
+        batch->work();
+        batch->wait();
+    }
+
+    inline
+    ExternalExecutor::ExternalExecutor(Submit submit, size_t concurrency) :
+        submit_(submit), concurrency_(std::max(concurrency, (size_t)1)) { }
+
+    inline
+    size_t ExternalExecutor::concurrency() const {
+        return concurrency_;
+    }
+
+    inline
+    void ExternalExecutor::run(size_t count, const std::function<void(size_t)>& task) {
+        if (count == 0) return;
+        if (count == 1) {
+            task(0);
+            return;
+        }
+        auto batch = std::make_shared<detail::TaskBatch_>(&task, count);
+        size_t helpers = std::min(count, concurrency_) - 1;
+        try {
+            for (size_t h = 0; h < helpers; ++h)
+                submit_([batch]() { batch->work(); });
+        } catch (...) {
+            // Tasks that no job was submitted for are run here instead
+        }
+        batch->work();
+        batch->wait();
+    }
+
+    inline
+    void ExternalExecutor::submit(std::function<void()> job) {
+        submit_(std::move(job));
+    }
+
+    inline
+    std::shared_ptr<Executor> default_executor() {
+        // The executor is never destroyed, so it outlives static objects
+        // that use PIGO as they are destroyed
+        static std::shared_ptr<Executor>* executor = new std::shared_ptr<Executor>(
+            #ifdef _OPENMP
+            std::make_shared<OpenMPExecutor>()
+            #else
+            std::make_shared<ThreadPool>()
+            #endif
+        );
+        return *executor;
+    }
+
+    namespace detail {
+
+        inline
+        ParallelTeam_::ParallelTeam_() : context_(execution_context()),
+                executor_(context_executor_(context_)),
+                size_(requested_threads_(context_)) {
+            bool nested = in_task_();
+            #ifdef _OPENMP
+            nested = nested || omp_in_parallel();
+            #endif
+            if (nested && context_.nested == NESTED_SERIAL) size_ = 1;
+        }
+
+        template<class F>
+        void ParallelTeam_::run(F f, const char* wait) {
+            // Each task's waiting is traced once the step has finished
+            bool trace = wait && tracing_enabled();
+            if (size_ == 1) {
+                TaskScope_ task { 0 };
+                f((size_t)0);
+                // A lone task never waits, but its wait is traced alike
+                if (trace) {
+                    double now = instrument_now_();
+                    TraceBuffer_* track = trace_track_();
+                    if (track) trace_event_on_(track, wait, now, now);
+                }
+                return;
+            }
+            std::vector<std::pair<TraceBuffer_*, double>> ends(trace ? size_ : 0);
+            const ExecutionContext& context = context_;
+            executor_->run(size_, [&](size_t tid) {
+                ExecutionScope scope { context };
+                ThreadBinding_ binding { context.cpus, tid };
+                TaskScope_ task { tid };
+                f(tid);
+                if (trace) ends[tid] = std::make_pair(trace_track_(), instrument_now_());
+            });
+            if (trace) {
+                double now = instrument_now_();
+                for (auto& end : ends)
+                    if (end.first) trace_event_on_(end.first, wait, end.second, now);
+            }
+        }
+
+        template<class F>
+        void ParallelTeam_::for_each(size_t begin, size_t end, size_t grain, F f) {
+            if (begin >= end) return;
+            LoopChunks_ chunks { begin, end, grain };
+            run([&](size_t) {
+                size_t start, stop;
+                while (chunks.next(start, stop))
+                    for (size_t i = start; i < stop; ++i)
+                        f(i);
+            });
+        }
+
+        template<class F>
+        void ParallelTeam_::for_each(size_t begin, size_t end, F f) {
+            if (begin >= end) return;
+            for_each(begin, end, (end - begin + size_ - 1) / size_, f);
+        }
+
+    }
+
+    inline
+    ExecutionScope::ExecutionScope(const ExecutionContext& context) :
+            context_(context), outer_(detail::current_scope_()) {
+        detail::current_scope_() = this;
+    }
+
+    inline
+    ExecutionScope::~ExecutionScope() {
+        detail::current_scope_() = outer_;
+    }
+
+    inline
+    ExecutionContext execution_context() {
+        ExecutionScope* scope = detail::current_scope_();
+        if (scope) return scope->context_;
+        return ExecutionContext();
+    }
+
+}
@@ -0,0 +1,664 @@
+/**
+ * PIGO: a parallel graph and matrix I/O and preprocessing library
+ * Copyright (c) 2022 GT-TDALab
+ *
+ * This file contains the shortest round-trip floating point formatting and
+ * the matching floating point parsing
+ */
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+namespace pigo {
+
+    namespace detail {
+        #ifdef __SIZEOF_INT128__
+        /** An unsigned 128-bit integer, marked as an extension for
+         *  pedantic builds */
+        __extension__ typedef unsigned __int128 uint128_;
+
+        /** @brief Return the full 128-bit product of two 64-bit values */
+        inline
+        uint128_ mul_64x64_(uint64_t a, uint64_t b) {
+            return (uint128_)a * b;
+        }
+        #else
+        /** @brief An unsigned 128-bit integer, as two 64-bit halves
+         *
+         * This provides the operations used here where the compiler has
+         * no 128-bit integer type.
+         */
+        struct uint128_ {
+            /** The high half */
+            uint64_t hi;
+            /** The low half */
+            uint64_t lo;
+
+            uint128_(uint64_t v=0) : hi(0), lo(v) { }
+            uint128_(uint64_t h, uint64_t l) : hi(h), lo(l) { }
+
+            /** @brief Return the low half */
+            explicit operator uint64_t() const { return lo; }
+
+            uint128_ operator<<(int s) const {
+                if (s == 0) return *this;
+                if (s >= 64) return uint128_ { lo << (s-64), 0 };
+                return uint128_ { (hi << s) | (lo >> (64-s)), lo << s };
+            }
+            uint128_ operator>>(int s) const {
+                if (s == 0) return *this;
+                if (s >= 64) return uint128_ { 0, hi >> (s-64) };
+                return uint128_ { hi >> s, (lo >> s) | (hi << (64-s)) };
+            }
+            uint128_& operator<<=(int s) { return *this = *this << s; }
+            uint128_& operator|=(const uint128_& o) {
+                hi |= o.hi;
+                lo |= o.lo;
+                return *this;
+            }
+        };
+
+        inline
+        uint128_ operator+(const uint128_& a, const uint128_& b) {
+            uint64_t lo = a.lo + b.lo;
+            return uint128_ { a.hi + b.hi + (lo < a.lo), lo };
+        }
+
+        inline
+        uint128_ operator-(const uint128_& a, const uint128_& b) {
+            return uint128_ { a.hi - b.hi - (a.lo < b.lo), a.lo - b.lo };
+        }
+
+        inline
+        uint128_ operator&(const uint128_& a, const uint128_& b) {
+            return uint128_ { a.hi & b.hi, a.lo & b.lo };
+        }
+
+        inline
+        bool operator==(const uint128_& a, const uint128_& b) {
+            return a.hi == b.hi && a.lo == b.lo;
+        }
+
+        inline
+        bool operator<(const uint128_& a, const uint128_& b) {
+            return (a.hi != b.hi) ? a.hi < b.hi : a.lo < b.lo;
+        }
+
+        inline
+        bool operator>(const uint128_& a, const uint128_& b) { return b < a; }
+
+        inline
+        bool operator<=(const uint128_& a, const uint128_& b) { return !(b < a); }
+
+        inline
+        bool operator>=(const uint128_& a, const uint128_& b) { return !(a < b); }
+
+        /** @brief Return the full 128-bit product of two 64-bit values
+         *
+         * The product is assembled from the four products of the 32-bit
+         * halves.
+         */
+        inline
+        uint128_ mul_64x64_(uint64_t a, uint64_t b) {
+            uint64_t a_lo = (uint32_t)a, a_hi = a >> 32;
+            uint64_t b_lo = (uint32_t)b, b_hi = b >> 32;
+            uint64_t ll = a_lo*b_lo;
+            uint64_t lh = a_lo*b_hi;
+            uint64_t hl = a_hi*b_lo;
+            uint64_t hh = a_hi*b_hi;
+            uint64_t mid = (ll >> 32) + (uint32_t)lh + (uint32_t)hl;
+            return uint128_ { hh + (lh >> 32) + (hl >> 32) + (mid >> 32),
+                (mid << 32) | (uint32_t)ll };
+        }
+        #endif
+
+        /** @brief Holds the 128-bit significands of powers of ten
+         *
+         * For each e, this holds g(e) = floor(10^e / 2^r) + 1, where r is
+         * chosen such that 2^127 <= 10^e / 2^r < 2^128. The values are
+         * computed exactly with a small big integer, so no large constant
+         * table needs to be carried in the source.
+         */
+        class Pow10Table_ {
+            private:
+                /** The smallest power held */
+                static const int min_e = -350;
+                /** The largest power held */
+                static const int max_e = 330;
+                /** The significands, starting at min_e */
+                uint128_ g_[max_e-min_e+1];
+
+                /** A big integer, with little-endian 32-bit limbs */
+                typedef std::vector<uint32_t> big_;
+
+                static size_t bit_length_(const big_& v) {
+                    for (size_t limb = v.size(); limb > 0; --limb) {
+                        uint32_t top = v[limb-1];
+                        if (top != 0)
+                            return (limb-1)*32 + 32 - __builtin_clz(top);
+                    }
+                    return 0;
+                }
+
+                static bool bit_(const big_& v, size_t pos) {
+                    if (pos/32 >= v.size()) return false;
+                    return (v[pos/32] >> (pos%32)) & 1;
+                }
+
+                static void mul_10_(big_& v) {
+                    uint64_t carry = 0;
+                    for (auto& limb : v) {
+                        uint64_t cur = (uint64_t)limb*10 + carry;
+                        limb = (uint32_t)cur;
+                        carry = cur >> 32;
+                    }
+                    if (carry) v.push_back((uint32_t)carry);
+                }
+
+                static void shl_1_(big_& v) {
+                    uint32_t carry = 0;
+                    for (auto& limb : v) {
+                        uint32_t next = limb >> 31;
+                        limb = (limb << 1) | carry;
+                        carry = next;
+                    }
+                    if (carry) v.push_back(carry);
+                }
+
+                static bool geq_(const big_& a, const big_& b) {
+                    size_t limbs = std::max(a.size(), b.size());
+                    for (size_t limb = limbs; limb > 0; --limb) {
+                        uint32_t av = (limb-1 < a.size()) ? a[limb-1] : 0;
+                        uint32_t bv = (limb-1 < b.size()) ? b[limb-1] : 0;
+                        if (av != bv) return av > bv;
+                    }
+                    return true;
+                }
+
+                static void sub_(big_& a, const big_& b) {
+                    int64_t borrow = 0;
+                    for (size_t limb = 0; limb < a.size(); ++limb) {
+                        int64_t cur = (int64_t)a[limb] - borrow -
+                            ((limb < b.size()) ? (int64_t)b[limb] : 0);
+                        borrow = (cur < 0) ? 1 : 0;
+                        a[limb] = (uint32_t)(cur + (borrow << 32));
+                    }
+                }
+            public:
+                Pow10Table_() {
+                    big_ p { 1 };
+                    for (int e = 0; e <= max_e || -e >= min_e; ++e) {
+                        size_t b = bit_length_(p);
+
+                        // Positive powers: take the top 128 bits of 10^e
+                        if (e <= max_e) {
+                            uint128_ g = 0;
+                            for (size_t bit = 0; bit < 128; ++bit) {
+                                g <<= 1;
+                                if (bit < b) g |= bit_(p, b-1-bit);
+                            }
+                            g_[e-min_e] = g + 1;
+                        }
+
+                        // Negative powers: long division of 2^(b-1+128)
+                        // by 10^e, where the remainder starts below 10^e
+                        if (e > 0 && -e >= min_e) {
+                            big_ rem (p.size()+1, 0);
+                            rem[(b-1)/32] = 1u << ((b-1)%32);
+                            uint128_ q = 0;
+                            for (size_t bit = 0; bit < 128; ++bit) {
+                                shl_1_(rem);
+                                q <<= 1;
+                                if (geq_(rem, p)) {
+                                    sub_(rem, p);
+                                    q |= 1;
+                                }
+                            }
+                            g_[-e-min_e] = q + 1;
+                        }
+
+                        mul_10_(p);
+                    }
+                }
+
+                /** @brief Return g(e) */
+                uint128_ get(int e) const { return g_[e-min_e]; }
+        };
+
+        /** @brief Return the table of power of ten significands */
+        inline
+        const Pow10Table_& pow10_table_() {
+            static const Pow10Table_ table;
+            return table;
+        }
+
+        /** @brief Return floor(log10(2^e)) */
+        inline
+        int32_t floor_log10_pow2_(int32_t e) {
+            return (e * 1262611) >> 22;
+        }
+
+        /** @brief Return floor(log10(3/4 * 2^e)) */
+        inline
+        int32_t floor_log10_three_quarters_pow2_(int32_t e) {
+            return (e * 1262611 - 524031) >> 22;
+        }
+
+        /** @brief Return floor(log2(10^e)) */
+        inline
+        int32_t floor_log2_pow10_(int32_t e) {
+            return (e * 1741647) >> 19;
+        }
+
+        /** @brief Return floor(g * cp / 2^128), rounded to odd */
+        inline
+        uint64_t round_to_odd_(uint128_ g, uint64_t cp) {
+            uint128_ x = mul_64x64_((uint64_t)g, cp);
+            uint128_ y = mul_64x64_((uint64_t)(g >> 64), cp) + (x >> 64);
+            return (uint64_t)(y >> 64) | ((uint64_t)y > 1);
+        }
+
+        /** @brief A decimal value, digits * 10^exponent */
+        struct decimal_fp_ {
+            /** The decimal significand */
+            uint64_t digits;
+            /** The decimal exponent */
+            int32_t exponent;
+        };
+
+        /** @brief Convert a binary floating point to its shortest decimal
+         *
+         * This implements the Schubfach algorithm (R. Giulietti, "The
+         * Schubfach way to render doubles"). The result is the shortest
+         * decimal that rounds back to the same binary value, and when
+         * several exist, the closest one.
+         *
+         * @tparam sig_bits the number of explicit significand bits
+         * @tparam exp_bits the number of exponent bits
+         * @param ieee_sig the explicit significand bits
+         * @param ieee_exp the biased exponent bits, which must not
+         *        indicate infinity or NaN, with a non-zero value
+         */
+        template<int sig_bits, int exp_bits>
+        inline
+        decimal_fp_ to_shortest_decimal_(uint64_t ieee_sig, uint32_t ieee_exp) {
+            const int32_t bias = (1 << (exp_bits-1)) - 1 + sig_bits;
+
+            uint64_t c;
+            int32_t q;
+            if (ieee_exp != 0) {
+                c = (1ULL << sig_bits) | ieee_sig;
+                q = (int32_t)ieee_exp - bias;
+                // Small integers are their own shortest representation
+                if (q <= 0 && -q <= sig_bits && (c & ((1ULL << -q) - 1)) == 0)
+                    return decimal_fp_ { c >> -q, 0 };
+            } else {
+                c = ieee_sig;
+                q = 1 - bias;
+            }
+
+            bool is_even = (c % 2 == 0);
+            bool lower_closer = (ieee_sig == 0 && ieee_exp > 1);
+
+            // Scale the boundaries of the rounding interval by 10^-k
+            uint64_t cbl = 4*c - 2 + lower_closer;
+            uint64_t cb = 4*c;
+            uint64_t cbr = 4*c + 2;
+            int32_t k = lower_closer ? floor_log10_three_quarters_pow2_(q) :
+                floor_log10_pow2_(q);
+            int32_t h = q + floor_log2_pow10_(-k) + 1;
+            uint128_ g = pow10_table_().get(-k);
+
+            uint64_t vbl = round_to_odd_(g, cbl << h);
+            uint64_t vb = round_to_odd_(g, cb << h);
+            uint64_t vbr = round_to_odd_(g, cbr << h);
+
+            uint64_t lower = vbl + !is_even;
+            uint64_t upper = vbr - !is_even;
+
+            // First try one digit less
+            uint64_t s = vb / 4;
+            if (s >= 10) {
+                uint64_t sp = s / 10;
+                bool up_inside = lower <= 40*sp;
+                bool wp_inside = 40*sp + 40 <= upper;
+                if (up_inside != wp_inside)
+                    return decimal_fp_ { sp + wp_inside, k + 1 };
+            }
+
+            // Then pick between the two closest values
+            bool u_inside = lower <= 4*s;
+            bool w_inside = 4*s + 4 <= upper;
+            if (u_inside != w_inside)
+                return decimal_fp_ { s + w_inside, k };
+
+            uint64_t mid = 4*s + 2;
+            bool round_up = vb > mid || (vb == mid && (s & 1) != 0);
+            return decimal_fp_ { s + round_up, k };
+        }
+
+        /** @brief Holds the characters of a formatted floating point */
+        struct fp_chars_ {
+            /** The characters, which are not terminated */
+            char buf[32];
+            /** The number of characters used */
+            size_t size;
+        };
+
+        /** @brief Render a decimal value, choosing the shorter notation
+         *
+         * Between plain (e.g., 0.0125) and scientific (e.g., 1.25e-2)
+         * notation, the shorter one is used, preferring plain notation.
+         */
+        inline
+        void render_decimal_(fp_chars_& out, bool negative, decimal_fp_ dec) {
+            // Remove any trailing zeros
+            while (dec.digits >= 10 && dec.digits % 10 == 0) {
+                dec.digits /= 10;
+                ++dec.exponent;
+            }
+            char digits[20];
+            int32_t nd = (int32_t)num_digits_(dec.digits);
+            write_digits_(digits, dec.digits, nd);
+
+            // The position of the decimal point relative to the digits
+            int32_t pt = nd + dec.exponent;
+            int32_t sci_exp = pt - 1;
+            int32_t sci_exp_abs = (sci_exp < 0) ? -sci_exp : sci_exp;
+            size_t sci_size = nd + (nd > 1) + 1 + (sci_exp < 0) +
+                num_digits_((uint64_t)sci_exp_abs);
+            size_t plain_size;
+            if (dec.exponent >= 0) plain_size = nd + dec.exponent;
+            else if (pt > 0) plain_size = nd + 1;
+            else plain_size = 2 - pt + nd;
+
+            char* pos = out.buf;
+            if (negative) *pos++ = '-';
+            if (plain_size <= sci_size) {
+                if (dec.exponent >= 0) {
+                    memcpy(pos, digits, nd);
+                    pos += nd;
+                    memset(pos, '0', dec.exponent);
+                    pos += dec.exponent;
+                } else if (pt > 0) {
+                    memcpy(pos, digits, pt);
+                    pos += pt;
+                    *pos++ = '.';
+                    memcpy(pos, digits+pt, nd-pt);
+                    pos += nd-pt;
+                } else {
+                    *pos++ = '0';
+                    *pos++ = '.';
+                    memset(pos, '0', -pt);
+                    pos += -pt;
+                    memcpy(pos, digits, nd);
+                    pos += nd;
+                }
+            } else {
+                *pos++ = digits[0];
+                if (nd > 1) {
+                    *pos++ = '.';
+                    memcpy(pos, digits+1, nd-1);
+                    pos += nd-1;
+                }
+                *pos++ = 'e';
+                if (sci_exp < 0) *pos++ = '-';
+                size_t exp_digits = num_digits_((uint64_t)sci_exp_abs);
+                write_digits_(pos, (uint64_t)sci_exp_abs, exp_digits);
+                pos += exp_digits;
+            }
+            out.size = pos - out.buf;
+        }
+
+        /** @brief Render special values (zero, infinity and NaN)
+         *
+         * @return true if the value was special and has been rendered
+         */
+        inline
+        bool render_special_(fp_chars_& out, bool negative, bool max_exp,
+                uint64_t ieee_sig, uint32_t ieee_exp) {
+            const char* str;
+            if (max_exp)
+                str = (ieee_sig != 0) ? "nan" : (negative ? "-inf" : "inf");
+            else if (ieee_exp == 0 && ieee_sig == 0)
+                str = negative ? "-0" : "0";
+            else
+                return false;
+            out.size = strlen(str);
+            memcpy(out.buf, str, out.size);
+            return true;
+        }
+
+        /** @brief Format a double as its shortest round-trip string */
+        inline
+        void format_shortest_(fp_chars_& out, double v) {
+            uint64_t bits;
+            memcpy(&bits, &v, sizeof(bits));
+            bool negative = (bits >> 63) != 0;
+            uint64_t ieee_sig = bits & ((1ULL << 52) - 1);
+            uint32_t ieee_exp = (uint32_t)((bits >> 52) & 0x7FF);
+            if (render_special_(out, negative, ieee_exp == 0x7FF, ieee_sig, ieee_exp))
+                return;
+            render_decimal_(out, negative, to_shortest_decimal_<52, 11>(ieee_sig, ieee_exp));
+        }
+
+        /** @brief Format a float as its shortest round-trip string */
+        inline
+        void format_shortest_(fp_chars_& out, float v) {
+            uint32_t bits;
+            memcpy(&bits, &v, sizeof(bits));
+            bool negative = (bits >> 31) != 0;
+            uint64_t ieee_sig = bits & ((1u << 23) - 1);
+            uint32_t ieee_exp = (bits >> 23) & 0xFF;
+            if (render_special_(out, negative, ieee_exp == 0xFF, ieee_sig, ieee_exp))
+                return;
+            render_decimal_(out, negative, to_shortest_decimal_<23, 8>(ieee_sig, ieee_exp));
+        }
+
+        /** @brief Format other floating point types through double */
+        template<typename T>
+        inline
+        void format_shortest_(fp_chars_& out, T v) {
+            format_shortest_(out, (double)v);
+        }
+
+        /** @brief Return the powers of ten that are exact as doubles */
+        inline
+        const double* exact_pow10_() {
+            static const double pows[] = {
+                1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+                1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+            };
+            return pows;
+        }
+
+        /** @brief Round m * 10^e10 to a binary floating point
+         *
+         * The decimal is scaled by the 128-bit power of ten significands.
+         * Powers up to 10^38 are exact, and otherwise the product is within
+         * one unit of the truncated 128 bits, which is enough to round
+         * correctly unless the value is within that unit of a halfway
+         * point.
+         *
+         * @tparam mant_bits the number of significand bits, with the
+         *         implicit bit
+         * @tparam min_exp the binary exponent of the smallest subnormal
+         * @param m the non-zero decimal significand
+         * @param e10 the decimal exponent, within the power table
+         * @param[out] res the rounded value
+         * @return false if the rounding could not be decided
+         */
+        template<int mant_bits, int min_exp>
+        inline
+        bool scale_pow10_(uint64_t m, int64_t e10, double& res) {
+            bool exact = (e10 >= 0 && e10 <= 38);
+            uint128_ g = pow10_table_().get((int)e10) - exact;
+            int32_t lz = __builtin_clzll(m);
+            uint64_t mn = m << lz;
+            uint128_ lo = mul_64x64_(mn, (uint64_t)g);
+            uint128_ hi = mul_64x64_(mn, (uint64_t)(g >> 64));
+            uint128_ t = hi + (lo >> 64);
+            bool sticky = (uint64_t)lo != 0;
+
+            // The value is t * 2^e2, with t holding 127 or 128 bits
+            int32_t e2 = floor_log2_pow10_((int32_t)e10) - 127 - lz + 64;
+            int32_t bl = 127 + (int32_t)(uint64_t)(t >> 127);
+            int32_t shift = std::max(bl - mant_bits, min_exp - e2);
+            if (shift > 128) {
+                res = 0.;
+                return true;
+            }
+            uint128_ rem = (shift == 128) ? t : t & (((uint128_)1 << shift) - 1);
+            uint128_ half = (uint128_)1 << (shift - 1);
+            uint64_t mant = (shift == 128) ? 0 : (uint64_t)(t >> shift);
+            if (!exact && rem + 1 >= half && rem <= half + 1)
+                return false;
+            bool round_up = rem > half ||
+                (rem == half && (sticky || (mant & 1) != 0));
+            res = std::ldexp((double)(mant + round_up), e2 + shift);
+            return true;
+        }
+
+        /** @brief Convert a decimal value to the nearest binary floating point
+         *
+         * Values with exact operands are computed directly, and others are
+         * rounded with scale_pow10_. When digits were dropped, the value
+         * lies between m and m+1, and is only accepted if both round the
+         * same. Anything left undecided is computed in extended precision.
+         *
+         * @tparam mant_bits the number of significand bits, with the
+         *         implicit bit
+         * @tparam min_exp the binary exponent of the smallest subnormal
+         * @param m the decimal significand
+         * @param e10 the decimal exponent
+         * @param truncated whether digits were dropped from m
+         * @return the value as a double, which is exactly representable in
+         *         the target type unless it overflows
+         */
+        template<int mant_bits, int min_exp>
+        inline
+        double decimal_to_binary_(uint64_t m, int64_t e10, bool truncated) {
+            if (m == 0 || e10 < -345) return 0.;
+            if (e10 > 310) return HUGE_VAL;
+
+            // Values with exact operands need a single rounding
+            if (!truncated && m <= (1ULL << mant_bits) &&
+                    e10 >= -22 && e10 <= 22 && (mant_bits == 53 || e10 >= -10)) {
+                if (mant_bits == 53) {
+                    if (e10 < 0) return (double)m / exact_pow10_()[-e10];
+                    return (double)m * exact_pow10_()[e10];
+                }
+                if (e10 <= 10) {
+                    float res = (float)m;
+                    if (e10 < 0) res /= (float)exact_pow10_()[-e10];
+                    else res *= (float)exact_pow10_()[e10];
+                    return res;
+                }
+            }
+
+            double res;
+            if (scale_pow10_<mant_bits, min_exp>(m, e10, res)) {
+                if (!truncated) return res;
+                double upper;
+                if (scale_pow10_<mant_bits, min_exp>(m+1, e10, upper) && upper == res)
+                    return res;
+            }
+
+            return (double)((long double)m * std::pow(10.L, (long double)e10));
+        }
+    }
+
+    template<typename T,
+        typename std::enable_if<!std::is_integral<T>::value, bool>::type,
+        typename std::enable_if<std::is_floating_point<T>::value, bool>::type
+        >
+    inline
+    size_t write_size(T obj) {
+        detail::fp_chars_ chars;
+        detail::format_shortest_(chars, obj);
+        return chars.size;
+    }
+
+    template<typename T,
+        typename std::enable_if<!std::is_integral<T>::value, bool>::type,
+        typename std::enable_if<std::is_floating_point<T>::value, bool>::type
+        >
+    inline
+    void write_ascii(FilePos &fp, T obj) {
+        detail::fp_chars_ chars;
+        detail::format_shortest_(chars, obj);
+        memcpy((char*)fp, chars.buf, chars.size);
+        fp += chars.size;
+    }
+
+    template<typename T>
+    inline
+    T FileReader::read_fp() {
+        move_to_fp();
+        // Read the size
+        bool positive = true;
+        if (d < end && *d == '-') {
+            positive = false;
+            ++d;
+        } else if (d < end && *d == '+') ++d;
+
+        // Read infinity and NaN, as written by write_ascii
+        size_t nonfinite = detail::nonfinite_size_(d, end);
+        if (nonfinite > 0) {
+            T res = ((*d | 0x20) == 'n') ? std::numeric_limits<T>::quiet_NaN() :
+                std::numeric_limits<T>::infinity();
+            d += nonfinite;
+            return positive ? res : -res;
+        }
+
+        // Read (+-)AAA.BBB(eE)(+-)ZZ, keeping up to 19 significant digits
+        // exactly and tracking the decimal exponent separately
+        uint64_t mant = 0;
+        int digits = 0;
+        int64_t exp10 = 0;
+        bool truncated = false;
+        bool in_fraction = false;
+        for (; d < end; ++d) {
+            if (*d == '.' && !in_fraction) {
+                in_fraction = true;
+                continue;
+            }
+            if (*d < '0' || *d > '9') break;
+            if (digits < 19) {
+                mant = mant*10 + (*d-'0');
+                if (mant != 0) ++digits;
+                if (in_fraction) --exp10;
+            } else {
+                if (*d != '0') truncated = true;
+                if (!in_fraction) ++exp10;
+            }
+        }
+        if (d < end && (*d == 'e' || *d == 'E')) {
+            ++d;
+            bool exp_positive = true;
+            if (d < end && *d == '-') {
+                exp_positive = false;
+                ++d;
+            } else if (d < end && *d == '+') ++d;
+            int64_t exp = 0;
+            while (d < end && (*d >= '0' && *d <= '9')) {
+                if (exp < 100000) exp = exp*10 + (*d-'0');
+                ++d;
+            }
+            exp10 += exp_positive ? exp : -exp;
+        }
+
+        T res;
+        if (sizeof(T) <= sizeof(float))
+            res = (T)detail::decimal_to_binary_<24, -149>(mant, exp10, truncated);
+        else
+            res = (T)detail::decimal_to_binary_<53, -1074>(mant, exp10, truncated);
+        if (!positive) res = -res;
+        return res;
+    }
+
+}
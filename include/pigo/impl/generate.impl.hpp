@@ -0,0 +1,290 @@
+/**
+ * PIGO: a parallel graph and matrix I/O and preprocessing library
+ * Copyright (c) 2022 GT-TDALab
+ *
+ * This file contains the implementation of the synthetic graph
+ * generators
+ */
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+namespace pigo {
+
+    namespace detail {
+
+        /** @brief Mix a 64-bit value (the splitmix64 finalizer) */
+        inline
+        uint64_t hash64_(uint64_t x) {
+            x += 0x9E3779B97F4A7C15ull;
+            x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+            x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+            return x ^ (x >> 31);
+        }
+
+        /** @brief Return the i-th random value of a stream
+         *
+         * Values depend only on the seed, stream and index, so they can be
+         * drawn in any order by any thread.
+         */
+        inline
+        uint64_t rand64_(uint64_t seed, uint64_t stream, uint64_t i) {
+            return hash64_(hash64_(seed ^ hash64_(stream)) + i);
+        }
+
+        /** @brief Convert a random value to a double in [0, 1) */
+        inline
+        double unit_(uint64_t r) {
+            return (r >> 11) * (1.0 / 9007199254740992.0);
+        }
+
+        /** @brief A bijection scrambling the labels in [0, 2^bits) */
+        class LabelPermutation_ {
+            private:
+                uint64_t mask_;
+                unsigned shift_;
+                uint64_t keys_[3];
+            public:
+                LabelPermutation_(unsigned bits, uint64_t seed) :
+                        mask_((bits >= 64) ? ~0ull : ((1ull << bits) - 1)),
+                        shift_(bits/2 + 1) {
+                    for (int round = 0; round < 3; ++round)
+                        keys_[round] = hash64_(seed + round);
+                }
+                uint64_t operator()(uint64_t x) const {
+                    // Odd multiplication, addition and xorshifts are each
+                    // invertible modulo 2^bits
+                    for (int round = 0; round < 3; ++round) {
+                        x = (x * 0x9E3779B97F4A7C15ull + keys_[round]) & mask_;
+                        x ^= x >> shift_;
+                    }
+                    return x;
+                }
+        };
+
+        /** @brief Check that a generated size fits in a label or ordinal */
+        template<class T>
+        T fit_size_(uint64_t val) {
+            if (val != (uint64_t)(T)val)
+                throw Error("PIGO: The generated graph does not fit in the label or ordinal type");
+            return (T)val;
+        }
+
+        /** @brief Set the weight of a generated edge, if weighted */
+        template<bool wgt, class W, class WS>
+        struct set_unit_weight_i_ {
+            static void op_(WS&, size_t) { }
+        };
+        template<class W, class WS>
+        struct set_unit_weight_i_<true, W, WS> {
+            static void op_(WS& w, size_t pos) { set_value_(w, pos, (W)1); }
+        };
+
+        /** @brief Emit the columns of one G(n,p) row
+         *
+         * Each row draws its own stream and skips geometrically over the
+         * n-1 candidate columns, so rows are generated independently.
+         */
+        template<class L, class F>
+        void gnp_row_(L u, L n, double p, double log_q, uint64_t seed, F emit) {
+            if (p == 0 || n < 2) return;
+            uint64_t num_cand = (uint64_t)n - 1;
+            uint64_t cand = 0, draw = 0;
+            while (true) {
+                if (p < 1) {
+                    double r = unit_(rand64_(seed, u, draw++));
+                    double skip = std::floor(std::log1p(-r) / log_q);
+                    if (skip >= (double)(num_cand - cand)) break;
+                    cand += (uint64_t)skip;
+                }
+                if (cand >= num_cand) break;
+                emit((L)(cand < (uint64_t)u ? cand : cand+1));
+                ++cand;
+            }
+        }
+
+        /** @brief Fill a COO from a function computing each edge
+         *
+         * @param coo the allocated COO to fill
+         * @param edge called as edge(e, x, y) to set the endpoints of edge e
+         */
+        template<class L, class O, class S, bool wgt, class W, class WS, class F>
+        void fill_edges_(COO<L,O,S,false,false,false,wgt,W,WS>& coo, F edge) {
+            auto& xs = coo.x();
+            auto& ys = coo.y();
+            auto& ws = coo.w();
+            O m = coo.m();
+            ParallelTeam_ team;
+            team.for_each(0, m, [&](O e) {
+                L x, y;
+                edge(e, x, y);
+                set_value_(xs, e, x);
+                set_value_(ys, e, y);
+                set_unit_weight_i_<wgt, W, WS>::op_(ws, e);
+            });
+        }
+
+    }
+
+    template<class L, class O, class S, bool wgt, class W, class WS>
+    COO<L,O,S,false,false,false,wgt,W,WS> generate_rmat(unsigned scale, uint64_t edge_factor,
+            uint64_t seed, double a, double b, double c, bool permute) {
+        if (scale >= sizeof(L)*8)
+            throw Error("PIGO: The R-MAT scale does not fit in the label type");
+        if (a < 0 || b < 0 || c < 0 || a+b+c > 1)
+            throw Error("PIGO: Invalid R-MAT probabilities");
+        L n = (L)1 << scale;
+        O m = detail::fit_size_<O>(edge_factor << scale);
+        COO<L,O,S,false,false,false,wgt,W,WS> coo { n, n, n, m };
+        detail::LabelPermutation_ perm { scale, seed };
+        // Quadrants are chosen by comparing 32-bit draws to fixed-point
+        // thresholds, without branches that would mispredict every level
+        const double fixed = 4294967296.0;
+        uint64_t ta = (uint64_t)(a * fixed);
+        uint64_t tab = (uint64_t)((a+b) * fixed);
+        uint64_t tabc = (uint64_t)((a+b+c) * fixed);
+        detail::fill_edges_(coo, [&](O e, L& x, L& y) {
+            // Each 64-bit draw gives two levels
+            uint64_t base = detail::rand64_(seed, 0, e);
+            uint64_t row = 0, col = 0, bits = 0;
+            for (unsigned level = 0; level < scale; ++level) {
+                if (level % 2 == 0) bits = detail::hash64_(base + level);
+                else bits <<= 32;
+                uint64_t u = bits >> 32;
+                uint64_t right = ((u >= ta) & (u < tab)) | (u >= tabc);
+                row = (row << 1) | (u >= tab);
+                col = (col << 1) | right;
+            }
+            if (permute) {
+                row = perm(row);
+                col = perm(col);
+            }
+            x = (L)row;
+            y = (L)col;
+        });
+        return coo;
+    }
+
+    template<class L, class O, class S, bool wgt, class W, class WS>
+    COO<L,O,S,false,false,false,wgt,W,WS> generate_gnm(uint64_t n, uint64_t m, uint64_t seed) {
+        if (n < 2 && m > 0)
+            throw Error("PIGO: G(n,m) needs two vertices for an edge");
+        L nl = detail::fit_size_<L>(n);
+        COO<L,O,S,false,false,false,wgt,W,WS> coo { nl, nl, nl, detail::fit_size_<O>(m) };
+        detail::fill_edges_(coo, [&](O e, L& x, L& y) {
+            x = (L)(detail::rand64_(seed, 0, e) % n);
+            y = (L)(detail::rand64_(seed, 1, e) % (n-1));
+            if (y >= x) ++y;
+        });
+        return coo;
+    }
+
+    template<class L, class O, class S, bool wgt, class W, class WS>
+    COO<L,O,S,false,false,false,wgt,W,WS> generate_gnp(uint64_t num_vertices, double p, uint64_t seed) {
+        if (p < 0 || p > 1)
+            throw Error("PIGO: The G(n,p) probability must be in [0, 1]");
+        L n = detail::fit_size_<L>(num_vertices);
+        double log_q = std::log1p(-p);
+
+        // The first pass counts each row's edges, the second fills them
+        detail::TempVector_<O> offsets((size_t)n+1, 0);
+        detail::ParallelTeam_ team;
+        team.for_each(0, n, 1024, [&](L u) {
+            O count = 0;
+            detail::gnp_row_(u, n, p, log_q, seed, [&count](L) { ++count; });
+            offsets[(size_t)u+1] = count;
+        });
+        for (size_t u = 0; u < (size_t)n; ++u)
+            offsets[u+1] += offsets[u];
+
+        COO<L,O,S,false,false,false,wgt,W,WS> coo { n, n, n, offsets[(size_t)n] };
+        auto& xs = coo.x();
+        auto& ys = coo.y();
+        auto& ws = coo.w();
+        team.for_each(0, n, 1024, [&](L u) {
+            O pos = offsets[u];
+            detail::gnp_row_(u, n, p, log_q, seed, [&](L v) {
+                detail::set_value_(xs, pos, u);
+                detail::set_value_(ys, pos, v);
+                detail::set_unit_weight_i_<wgt, W, WS>::op_(ws, pos);
+                ++pos;
+            });
+        });
+        return coo;
+    }
+
+    template<class L, class O, class S, bool wgt, class W, class WS>
+    COO<L,O,S,false,false,false,wgt,W,WS> generate_ba(uint64_t n, uint64_t k, uint64_t seed) {
+        L nl = detail::fit_size_<L>(n);
+        O m = detail::fit_size_<O>((n > 0) ? (n-1) * k : 0);
+        COO<L,O,S,false,false,false,wgt,W,WS> coo { nl, nl, nl, m };
+        detail::fill_edges_(coo, [&](O e, L& x, L& y) {
+            x = (L)(e / k + 1);
+            // Pick a random endpoint of an earlier vertex's edges; sources
+            // are fixed, while targets are followed back to their choice
+            uint64_t cur = e;
+            while (true) {
+                uint64_t v = cur / k + 1;
+                if (v == 1) {
+                    y = 0;
+                    break;
+                }
+                uint64_t r = detail::rand64_(seed, 0, cur) % (2*(v-1)*k);
+                if (r % 2 == 0) {
+                    y = (L)(r/2 / k + 1);
+                    break;
+                }
+                cur = r/2;
+            }
+        });
+        return coo;
+    }
+
+    template<class L, class O, class S, bool wgt, class W, class WS>
+    COO<L,O,S,false,false,false,wgt,W,WS> generate_grid(uint64_t nx, uint64_t ny, uint64_t nz) {
+        size_t num_rows = ny * nz;
+        L n = detail::fit_size_<L>(nx * ny * nz);
+
+        // Every row of x values has a closed-form number of edges
+        detail::TempVector_<O> offsets(num_rows+1, 0);
+        for (size_t row = 0; row < num_rows; ++row) {
+            uint64_t y = row % ny;
+            uint64_t z = row / ny;
+            O outside = (y > 0) + (y+1 < ny) + (z > 0) + (z+1 < nz);
+            offsets[row+1] = offsets[row] + 2*(O)(nx-1) + (O)nx * outside;
+        }
+        if (nx == 0) offsets.assign(num_rows+1, 0);
+
+        COO<L,O,S,false,false,false,wgt,W,WS> coo { n, n, n, offsets[num_rows] };
+        auto& xs = coo.x();
+        auto& ys = coo.y();
+        auto& ws = coo.w();
+        uint64_t plane = nx * ny;
+        detail::ParallelTeam_ team;
+        team.for_each(0, num_rows, 64, [&](size_t row) {
+            uint64_t y = row % ny;
+            uint64_t z = row / ny;
+            O pos = offsets[row];
+            for (uint64_t x = 0; x < nx; ++x) {
+                uint64_t v = x + nx * row;
+                // Neighbors are emitted in increasing label order
+                uint64_t nbrs[6];
+                int count = 0;
+                if (z > 0) nbrs[count++] = v - plane;
+                if (y > 0) nbrs[count++] = v - nx;
+                if (x > 0) nbrs[count++] = v - 1;
+                if (x+1 < nx) nbrs[count++] = v + 1;
+                if (y+1 < ny) nbrs[count++] = v + nx;
+                if (z+1 < nz) nbrs[count++] = v + plane;
+                for (int i = 0; i < count; ++i, ++pos) {
+                    detail::set_value_(xs, pos, (L)v);
+                    detail::set_value_(ys, pos, (L)nbrs[i]);
+                    detail::set_unit_weight_i_<wgt, W, WS>::op_(ws, pos);
+                }
+            }
+        });
+        return coo;
+    }
+
+}
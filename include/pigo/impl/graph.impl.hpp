@@ -21,12 +21,20 @@ namespace pigo {
 
     template<class vertex_t, class edge_ctr_t, class edge_storage, class edge_ctr_storage, bool weighted, class Weight, class WeightStorage>
     void DiGraph<vertex_t, edge_ctr_t, edge_storage, edge_ctr_storage, weighted, Weight, WeightStorage>::read_(File& f, FileType ft) {
+        detail::PhaseTimer_ phase { "digraph.read" };
+        phase.add_bytes(f.size());
+        detail::ProgressTracker_ progress { "digraph.read", f.size() };
+        progress.throw_if_cancelled();
         FileType ft_used = ft;
         // If the file type is AUTO, then try to detect it
         if (ft_used == AUTO) {
             ft_used = f.guess_file_type();
         }
         if (ft_used == PIGO_DIGRAPH_BIN) {
+            // Load any checksums once for both CSRs, verifying the
+            // headers and sizes
+            detail::ChecksumReader_ sums { f };
+
             // First load the in, then the out
             // Read out the header
             f.read(digraph_file_header);
@@ -38,16 +46,21 @@ namespace pigo {
                         weighted,
                         Weight,
                         WeightStorage
-                    > { f, AUTO };
-            out_ = BaseGraph<
-                        vertex_t,
-                        edge_ctr_t,
-                        edge_storage,
-                        edge_ctr_storage,
-                        weighted,
-                        Weight,
-                        WeightStorage
-                    > { f, AUTO };
+                    > { f, sums };
+            try {
+                out_ = BaseGraph<
+                            vertex_t,
+                            edge_ctr_t,
+                            edge_storage,
+                            edge_ctr_storage,
+                            weighted,
+                            Weight,
+                            WeightStorage
+                        > { f, sums };
+            } catch (...) {
+                in_.free();
+                throw;
+            }
         } else {
             // Build a COO, then load ourselves from it
             COO<
@@ -55,13 +68,20 @@ namespace pigo {
                     false, false, false,
                     weighted, Weight, WeightStorage
                 > coo { f, ft };
-            from_coo_(coo);
+            try {
+                from_coo_(coo);
+            } catch (...) {
+                coo.free();
+                throw;
+            }
             coo.free();
         }
+        progress.finish();
+        phase.add_items(out_.m());
     }
 
     template<class vertex_t, class edge_ctr_t, class edge_storage, class edge_ctr_storage, bool weighted, class Weight, class WeightStorage>
-    void DiGraph<vertex_t, edge_ctr_t, edge_storage, edge_ctr_storage, weighted, Weight, WeightStorage>::save(std::string fn) {
+    SaveStats DiGraph<vertex_t, edge_ctr_t, edge_storage, edge_ctr_storage, weighted, Weight, WeightStorage>::save(std::string fn, SaveMode mode, ChecksumMode checksum) {
         // Find the total size to save
         size_t out_size = 0;
 
@@ -72,14 +92,29 @@ namespace pigo {
         out_size += out_.save_size();
 
         // Now, create the file and output everything
-        WFile w {fn, out_size};
+        return detail::save_file_(*this, fn, out_size, mode, checksum, "digraph.save");
+    }
 
+    template<class vertex_t, class edge_ctr_t, class edge_storage, class edge_ctr_storage, bool weighted, class Weight, class WeightStorage>
+    template<class OutFile>
+    void DiGraph<vertex_t, edge_ctr_t, edge_storage, edge_ctr_storage, weighted, Weight, WeightStorage>::save_to_(OutFile& w) {
+        std::string dfh { digraph_file_header };
         w.write(dfh);
 
         in_.save(w);
         out_.save(w);
     }
 
+    template<class vertex_t, class edge_ctr_t, class edge_storage, class edge_ctr_storage, bool weighted, class Weight, class WeightStorage>
+    void DiGraph<vertex_t, edge_ctr_t, edge_storage, edge_ctr_storage, weighted, Weight, WeightStorage>::validate(bool sorted) const {
+        if (in_.n() != out_.n())
+            throw Error("PIGO: DiGraph in-edges and out-edges have different numbers of vertices");
+        if (in_.m() != out_.m())
+            throw Error("PIGO: DiGraph in-edges and out-edges have different numbers of edges");
+        in_.validate(sorted);
+        out_.validate(sorted);
+    }
+
     template<class V, class O, class S>
     V& EdgeItT<V,O,S>::operator*() { return detail::get_value_<S, V&>(s, pos); }
 
@@ -0,0 +1,556 @@
+/**
+ * PIGO: a parallel graph and matrix I/O and preprocessing library
+ * Copyright (c) 2022 GT-TDALab
+ *
+ * This file contains the implementation of the per-phase performance
+ * instrumentation
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <mutex>
+#include <utility>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace pigo {
+
+    namespace detail {
+
+        /** @brief The recorded phases and settings, shared by all threads */
+        struct InstrumentState_ {
+            std::atomic<bool> enabled { false };
+            std::atomic<bool> perf { false };
+            std::mutex mutex;
+            std::vector<Phase> phases;
+            std::function<void(const Phase&)> callback;
+            std::chrono::steady_clock::time_point epoch { std::chrono::steady_clock::now() };
+        };
+
+        /** @brief Return the instrumentation state */
+        inline
+        InstrumentState_& instrument_state_() {
+            static InstrumentState_ state;
+            return state;
+        }
+
+        /** @brief Return the seconds since the instrumentation epoch */
+        inline
+        double instrument_now_() {
+            std::chrono::duration<double> since =
+                std::chrono::steady_clock::now() - instrument_state_().epoch;
+            return since.count();
+        }
+
+        /** @brief Return the calling thread's task within its step */
+        inline
+        size_t instrument_tid_() {
+            return task_id_();
+        }
+
+        /** @brief Store a completed phase and pass it to the callback */
+        inline
+        void record_phase_(Phase& phase) {
+            InstrumentState_& state = instrument_state_();
+            std::function<void(const Phase&)> callback;
+            {
+                std::lock_guard<std::mutex> lock { state.mutex };
+                state.phases.push_back(phase);
+                callback = state.callback;
+            }
+            if (callback) {
+                // Callbacks are serialized, but not under the state lock,
+                // so they may query the recorded phases
+                static std::mutex callback_mutex;
+                std::lock_guard<std::mutex> lock { callback_mutex };
+                callback(phase);
+            }
+        }
+
+        class PerfGroup_;
+
+        /** @brief The counter groups of every thread that opened them */
+        struct PerfRegistry_ {
+            std::mutex mutex;
+            std::vector<PerfGroup_*> groups;
+            /** The final counts of the threads that have exited */
+            PerfCounters retired;
+        };
+
+        /** @brief Return the counter registry, which is never destroyed so
+         *         threads may exit during static destruction */
+        inline
+        PerfRegistry_& perf_registry_() {
+            static PerfRegistry_* registry = new PerfRegistry_;
+            return *registry;
+        }
+
+        /** @brief The calling thread's group of hardware counters
+         *
+         * The group is opened on the first read and counts the thread
+         * until it exits.
+         */
+        class PerfGroup_ {
+            private:
+                static const int num_events_ = 5;
+                /** The file descriptors, led by the cycles counter */
+                int fds_[num_events_];
+                /** The kernel's id of each event */
+                uint64_t ids_[num_events_];
+                /** Whether opening has been attempted */
+                bool tried_;
+
+                /** @brief Open the counters, returning if the leader opened */
+                bool open_() {
+                    tried_ = true;
+                    #ifdef __linux__
+                    const uint32_t types[num_events_] = {
+                        PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE,
+                        PERF_TYPE_HW_CACHE, PERF_TYPE_HARDWARE
+                    };
+                    const uint64_t configs[num_events_] = {
+                        PERF_COUNT_HW_CPU_CYCLES,
+                        PERF_COUNT_HW_INSTRUCTIONS,
+                        PERF_COUNT_HW_CACHE_MISSES,
+                        PERF_COUNT_HW_CACHE_DTLB |
+                            (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                            (PERF_COUNT_HW_CACHE_RESULT_MISS << 16),
+                        PERF_COUNT_HW_BRANCH_MISSES
+                    };
+                    for (int e = 0; e < num_events_; ++e) {
+                        perf_event_attr attr;
+                        memset(&attr, 0, sizeof(attr));
+                        attr.size = sizeof(attr);
+                        attr.type = types[e];
+                        attr.config = configs[e];
+                        attr.exclude_kernel = 1;
+                        attr.exclude_hv = 1;
+                        attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_ID |
+                            PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+                        int leader = (e == 0) ? -1 : fds_[0];
+                        fds_[e] = (int)syscall(SYS_perf_event_open, &attr, 0, -1, leader, 0);
+                        if (fds_[e] < 0) {
+                            // Without the leader there is no group
+                            if (e == 0) return false;
+                            continue;
+                        }
+                        if (ioctl(fds_[e], PERF_EVENT_IOC_ID, &ids_[e]) != 0) {
+                            close(fds_[e]);
+                            fds_[e] = -1;
+                            if (e == 0) return false;
+                        }
+                    }
+                    // Other threads may now read the group's totals
+                    PerfRegistry_& registry = perf_registry_();
+                    std::lock_guard<std::mutex> lock { registry.mutex };
+                    registry.groups.push_back(this);
+                    return true;
+                    #else
+                    return false;
+                    #endif
+                }
+            public:
+                PerfGroup_() : tried_(false) {
+                    for (int e = 0; e < num_events_; ++e) {
+                        fds_[e] = -1;
+                        ids_[e] = 0;
+                    }
+                }
+                ~PerfGroup_() {
+                    #ifdef __linux__
+                    if (fds_[0] >= 0) {
+                        // Keep the counts of the exiting thread in the totals
+                        PerfRegistry_& registry = perf_registry_();
+                        std::lock_guard<std::mutex> lock { registry.mutex };
+                        PerfCounters counts;
+                        if (read_opened(counts)) registry.retired += counts;
+                        registry.groups.erase(std::find(registry.groups.begin(),
+                                    registry.groups.end(), this));
+                    }
+                    for (int e = 0; e < num_events_; ++e)
+                        if (fds_[e] >= 0) close(fds_[e]);
+                    #endif
+                }
+                PerfGroup_(const PerfGroup_&) = delete;
+                PerfGroup_& operator=(const PerfGroup_&) = delete;
+
+                /** @brief Open the counters if not yet tried, then read the
+                 *         counts so far
+                 *
+                 * Only the thread owning the group may call this.
+                 *
+                 * @param counts the counts to fill in
+                 * @return whether the counters are available
+                 */
+                bool read(PerfCounters& counts) {
+                    if (!tried_) open_();
+                    return read_opened(counts);
+                }
+
+                /** @brief Read the counts so far of opened counters, from
+                 *         any thread
+                 *
+                 * @param counts the counts to fill in
+                 * @return whether the counters are available
+                 */
+                bool read_opened(PerfCounters& counts) const {
+                    if (fds_[0] < 0) return false;
+                    #ifdef __linux__
+                    // The group format is the count, the enabled and running
+                    // times, then each value with its id
+                    uint64_t buf[3 + 2*num_events_];
+                    ssize_t got = ::read(fds_[0], buf, sizeof(buf));
+                    if (got < (ssize_t)(3*sizeof(uint64_t))) return false;
+                    uint64_t nr = buf[0];
+                    double scale = 1.;
+                    // Scale up counts that were multiplexed
+                    if (buf[2] > 0 && buf[2] < buf[1]) scale = (double)buf[1] / buf[2];
+                    else if (buf[2] == 0 && buf[1] > 0) return false;
+                    uint64_t* fields[num_events_] = {
+                        &counts.cycles, &counts.instructions, &counts.cache_misses,
+                        &counts.tlb_misses, &counts.branch_misses
+                    };
+                    for (uint64_t v = 0; v < nr && v < (uint64_t)num_events_; ++v) {
+                        uint64_t value = buf[3 + 2*v];
+                        uint64_t id = buf[4 + 2*v];
+                        for (int e = 0; e < num_events_; ++e)
+                            if (fds_[e] >= 0 && ids_[e] == id)
+                                *fields[e] = (uint64_t)(value * scale);
+                    }
+                    counts.valid = true;
+                    return true;
+                    #else
+                    (void)counts;
+                    return false;
+                    #endif
+                }
+        };
+
+        /** @brief Return the calling thread's counts so far */
+        inline
+        PerfCounters thread_perf_counters_() {
+            thread_local PerfGroup_ group;
+            PerfCounters counts;
+            group.read(counts);
+            return counts;
+        }
+
+        /** @brief Return the counts of every thread so far */
+        inline
+        PerfCounters all_perf_counters_() {
+            PerfRegistry_& registry = perf_registry_();
+            std::lock_guard<std::mutex> lock { registry.mutex };
+            PerfCounters total = registry.retired;
+            bool all_valid = true;
+            for (PerfGroup_* group : registry.groups) {
+                PerfCounters counts;
+                all_valid = group->read_opened(counts) && all_valid;
+                total += counts;
+            }
+            total.valid = total.valid && all_valid;
+            return total;
+        }
+
+        struct PhaseTimer_::State_ {
+            /** The phase being filled in */
+            Phase phase;
+            /** The start of the phase, or negative if not yet started */
+            double start;
+            /** Each thread's start, or negative if not marked */
+            std::vector<double> thread_starts;
+            /** Each thread's stop, or negative if not marked */
+            std::vector<double> thread_stops;
+            /** Whether to record the phase */
+            bool record;
+            /** Whether to trace the phase and its threads */
+            bool trace;
+            /** Whether to count hardware events */
+            bool count;
+            /** The counts at the start of the phase */
+            PerfCounters start_counts;
+            /** Each thread's counts at its start, then during its work */
+            std::vector<PerfCounters> thread_counts;
+        };
+
+        inline
+        PhaseTimer_::PhaseTimer_(const char* name, const char* step, bool start_now) :
+                state_(nullptr) {
+            bool record = instrumentation_enabled();
+            bool trace = tracing_enabled();
+            if (!record && !trace) return;
+            state_ = new State_;
+            state_->record = record;
+            state_->trace = trace;
+            state_->count = record && perf_counters_enabled();
+            state_->phase.name = name;
+            if (step) {
+                state_->phase.name += '.';
+                state_->phase.name += step;
+            }
+            size_t num_threads = context_threads_();
+            state_->thread_starts.assign(num_threads, -1.);
+            state_->thread_stops.assign(num_threads, -1.);
+            if (state_->count) state_->thread_counts.resize(num_threads);
+            state_->start = -1.;
+            if (record) watch_memory_(&state_->phase.peak_bytes);
+            if (start_now) start();
+        }
+
+        inline
+        PhaseTimer_::~PhaseTimer_() {
+            stop();
+        }
+
+        inline
+        void PhaseTimer_::start() {
+            if (!state_) return;
+            if (state_->count) state_->start_counts = read_perf_counters();
+            state_->start = instrument_now_();
+        }
+
+        inline
+        void PhaseTimer_::thread_start() {
+            if (!state_) return;
+            size_t tid = instrument_tid_();
+            if (tid >= state_->thread_starts.size()) return;
+            if (state_->count) state_->thread_counts[tid] = thread_perf_counters_();
+            state_->thread_starts[tid] = instrument_now_();
+        }
+
+        inline
+        void PhaseTimer_::thread_stop() {
+            if (!state_) return;
+            size_t tid = instrument_tid_();
+            if (tid >= state_->thread_stops.size()) return;
+            double now = instrument_now_();
+            state_->thread_stops[tid] = now;
+            if (state_->count)
+                state_->thread_counts[tid] = thread_perf_counters_() - state_->thread_counts[tid];
+            if (state_->trace) {
+                double t_start = state_->thread_starts[tid];
+                if (t_start < 0) t_start = (state_->start < 0) ? now : state_->start;
+                trace_event_(state_->phase.name, t_start, now);
+            }
+        }
+
+        inline
+        void PhaseTimer_::add_bytes(size_t bytes) {
+            if (state_) state_->phase.bytes += bytes;
+        }
+
+        inline
+        void PhaseTimer_::add_items(size_t items) {
+            if (state_) state_->phase.items += items;
+        }
+
+        inline
+        void PhaseTimer_::add_alloc(size_t bytes) {
+            if (state_) state_->phase.alloc_bytes += bytes;
+        }
+
+        inline
+        void PhaseTimer_::stop() {
+            if (!state_) return;
+            double end = instrument_now_();
+            if (state_->record) unwatch_memory_(&state_->phase.peak_bytes);
+            double start = state_->start;
+            Phase& phase = state_->phase;
+
+            // With per-thread marks, the phase spans the threads' work
+            size_t num_marked = 0;
+            double first = end, last = 0.;
+            for (size_t tid = 0; tid < state_->thread_stops.size(); ++tid) {
+                double t_stop = state_->thread_stops[tid];
+                if (t_stop < 0) continue;
+                double t_start = state_->thread_starts[tid];
+                if (t_start < 0) t_start = (start < 0) ? t_stop : start;
+                phase.thread_seconds.resize(tid+1, 0.);
+                phase.thread_seconds[tid] = t_stop - t_start;
+                first = std::min(first, t_start);
+                last = std::max(last, t_stop);
+                if (state_->count) phase.counters += state_->thread_counts[tid];
+                ++num_marked;
+            }
+            if (num_marked == 0) {
+                first = (start < 0) ? end : start;
+                last = end;
+                if (state_->count && start >= 0)
+                    phase.counters = read_perf_counters() - state_->start_counts;
+            }
+            phase.start = first;
+            phase.seconds = last - first;
+
+            // Per-thread events were traced as each thread stopped
+            if (state_->trace && num_marked == 0)
+                trace_event_(phase.name, phase.start, last, phase.bytes, phase.items);
+            if (state_->record) record_phase_(phase);
+            delete state_;
+            state_ = nullptr;
+        }
+
+    }
+
+    inline
+    double Phase::imbalance() const {
+        double sum = 0., max = 0.;
+        for (double t : thread_seconds) {
+            sum += t;
+            max = std::max(max, t);
+        }
+        if (sum <= 0.) return 1.;
+        return max / (sum / thread_seconds.size());
+    }
+
+    inline
+    double PerfCounters::ipc() const {
+        return (cycles > 0) ? (double)instructions / cycles : 0.;
+    }
+
+    inline
+    PerfCounters& PerfCounters::operator+=(const PerfCounters& other) {
+        valid = valid || other.valid;
+        cycles += other.cycles;
+        instructions += other.instructions;
+        cache_misses += other.cache_misses;
+        tlb_misses += other.tlb_misses;
+        branch_misses += other.branch_misses;
+        return *this;
+    }
+
+    inline
+    PerfCounters PerfCounters::operator-(const PerfCounters& before) const {
+        // Scaled, multiplexed counts may step back slightly
+        auto diff = [](uint64_t a, uint64_t b) -> uint64_t { return (a > b) ? a-b : 0; };
+        PerfCounters ret;
+        ret.valid = valid && before.valid;
+        ret.cycles = diff(cycles, before.cycles);
+        ret.instructions = diff(instructions, before.instructions);
+        ret.cache_misses = diff(cache_misses, before.cache_misses);
+        ret.tlb_misses = diff(tlb_misses, before.tlb_misses);
+        ret.branch_misses = diff(branch_misses, before.branch_misses);
+        return ret;
+    }
+
+    inline
+    void enable_instrumentation(bool enabled) {
+        #ifdef PIGO_NO_INSTRUMENTATION
+        if (enabled)
+            throw Error("PIGO: compiled without instrumentation (PIGO_NO_INSTRUMENTATION is defined)");
+        #else
+        detail::instrument_state_().enabled.store(enabled);
+        #endif
+    }
+
+    inline
+    bool instrumentation_enabled() {
+        #ifdef PIGO_NO_INSTRUMENTATION
+        return false;
+        #else
+        return detail::instrument_state_().enabled.load(std::memory_order_relaxed);
+        #endif
+    }
+
+    inline
+    bool enable_perf_counters(bool enabled) {
+        detail::InstrumentState_& state = detail::instrument_state_();
+        #ifdef PIGO_NO_INSTRUMENTATION
+        enabled = false;
+        #endif
+        // Counters are only enabled if the calling thread can open them
+        if (enabled && !detail::thread_perf_counters_().valid)
+            enabled = false;
+        state.perf.store(enabled);
+        return enabled;
+    }
+
+    inline
+    bool perf_counters_enabled() {
+        return detail::instrument_state_().perf.load(std::memory_order_relaxed);
+    }
+
+    inline
+    PerfCounters read_perf_counters() {
+        if (!perf_counters_enabled()) return PerfCounters();
+        bool in_parallel = detail::in_task_();
+        #ifdef _OPENMP
+        in_parallel = in_parallel || omp_in_parallel();
+        #endif
+        PerfCounters mine = detail::thread_perf_counters_();
+        if (in_parallel) return mine;
+        PerfCounters total = detail::all_perf_counters_();
+        total.valid = total.valid && mine.valid;
+        return total;
+    }
+
+    inline
+    std::vector<Phase> recorded_phases() {
+        detail::InstrumentState_& state = detail::instrument_state_();
+        std::lock_guard<std::mutex> lock { state.mutex };
+        return state.phases;
+    }
+
+    inline
+    void clear_phases() {
+        detail::InstrumentState_& state = detail::instrument_state_();
+        std::lock_guard<std::mutex> lock { state.mutex };
+        state.phases.clear();
+    }
+
+    inline
+    void set_phase_callback(std::function<void(const Phase&)> callback) {
+        detail::InstrumentState_& state = detail::instrument_state_();
+        std::lock_guard<std::mutex> lock { state.mutex };
+        state.callback = callback;
+    }
+
+    inline
+    void print_phases(std::ostream& out, const std::vector<Phase>& phases) {
+        std::ios::fmtflags flags = out.flags();
+        std::streamsize precision = out.precision();
+        // Hardware counts are only shown if some phase has them
+        bool counters = false;
+        for (const Phase& p : phases)
+            counters = counters || p.counters.valid;
+        out << std::left << std::setw(28) << "phase" << std::right
+            << std::setw(11) << "seconds"
+            << std::setw(10) << "imbal"
+            << std::setw(14) << "bytes"
+            << std::setw(14) << "items"
+            << std::setw(14) << "alloc"
+            << std::setw(14) << "peak";
+        if (counters)
+            out << std::setw(8) << "ipc"
+                << std::setw(14) << "cache-miss"
+                << std::setw(14) << "tlb-miss"
+                << std::setw(14) << "branch-miss";
+        out << "\n";
+        for (const Phase& p : phases) {
+            out << std::left << std::setw(28) << p.name << std::right
+                << std::fixed << std::setprecision(6) << std::setw(11) << p.seconds
+                << std::setprecision(2) << std::setw(10) << p.imbalance()
+                << std::setw(14) << p.bytes
+                << std::setw(14) << p.items
+                << std::setw(14) << p.alloc_bytes
+                << std::setw(14) << p.peak_bytes;
+            if (counters)
+                out << std::setw(8) << p.counters.ipc()
+                    << std::setw(14) << p.counters.cache_misses
+                    << std::setw(14) << p.counters.tlb_misses
+                    << std::setw(14) << p.counters.branch_misses;
+            out << "\n";
+        }
+        out.flags(flags);
+        out.precision(precision);
+    }
+
+}
@@ -0,0 +1,224 @@
+/**
+ * PIGO: a parallel graph and matrix I/O and preprocessing library
+ * Copyright (c) 2022 GT-TDALab
+ *
+ * This file contains the implementation of the memory accounting
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <iomanip>
+#include <mutex>
+#include <new>
+#include <unordered_map>
+
+namespace pigo {
+
+    namespace detail {
+
+        /** @brief The counted allocations and limits, shared by all threads */
+        struct MemoryState_ {
+            std::mutex mutex;
+            MemoryUsage total;
+            /** The usage of each kind, whose nodes never move */
+            std::map<std::string, MemoryUsage> kinds;
+            /** The size and kind of each live allocation */
+            std::unordered_map<const void*, std::pair<size_t, MemoryUsage*>> live;
+            /** The peaks of the phases being measured */
+            std::vector<size_t*> watches;
+            size_t limit = 0;
+            std::function<bool(const AllocationRequest&)> callback;
+            /** Whether a limit or callback is set, checked without locking */
+            std::atomic<bool> checking { false };
+            /** Serializes the callback */
+            std::mutex callback_mutex;
+        };
+
+        /** @brief Return the memory accounting state
+         *
+         * The state is never destroyed, so storage freed by static
+         * destructors is still counted safely.
+         */
+        inline
+        MemoryState_& memory_state_() {
+            static MemoryState_* state = new MemoryState_;
+            return *state;
+        }
+
+        /** @brief Remove a live allocation from its counts, under the lock */
+        inline
+        void untrack_locked_(MemoryState_& state,
+                std::unordered_map<const void*, std::pair<size_t, MemoryUsage*>>::iterator it) {
+            size_t bytes = it->second.first;
+            state.total.current -= bytes;
+            it->second.second->current -= bytes;
+            state.live.erase(it);
+        }
+
+        inline
+        void track_alloc_(void* p, size_t bytes, const char* kind) {
+            if (p == nullptr || bytes == 0) return;
+            MemoryState_& state = memory_state_();
+            std::lock_guard<std::mutex> lock { state.mutex };
+            // An address may be reused by storage that was never freed
+            auto old = state.live.find(p);
+            if (old != state.live.end()) untrack_locked_(state, old);
+
+            MemoryUsage& k = state.kinds[kind];
+            state.live[p] = std::make_pair(bytes, &k);
+            k.current += bytes;
+            k.peak = std::max(k.peak, k.current);
+            ++k.allocations;
+            state.total.current += bytes;
+            state.total.peak = std::max(state.total.peak, state.total.current);
+            ++state.total.allocations;
+            for (size_t* peak : state.watches)
+                *peak = std::max(*peak, state.total.current);
+        }
+
+        inline
+        void track_free_(void* p) {
+            if (p == nullptr) return;
+            MemoryState_& state = memory_state_();
+            std::lock_guard<std::mutex> lock { state.mutex };
+            auto it = state.live.find(p);
+            if (it != state.live.end()) untrack_locked_(state, it);
+        }
+
+        inline
+        void check_alloc_(size_t bytes, const char* kind) {
+            MemoryState_& state = memory_state_();
+            if (!state.checking.load(std::memory_order_relaxed)) return;
+            AllocationRequest req;
+            std::function<bool(const AllocationRequest&)> callback;
+            size_t limit;
+            {
+                std::lock_guard<std::mutex> lock { state.mutex };
+                req.usage = state.total;
+                callback = state.callback;
+                limit = state.limit;
+            }
+            req.kind = kind;
+            req.bytes = bytes;
+            if (limit > 0 && req.usage.current + bytes > limit)
+                throw MemoryLimitExceeded("PIGO: allocating " + std::to_string(bytes) +
+                        " bytes of " + req.kind + " would exceed the memory limit of " +
+                        std::to_string(limit) + " bytes");
+            if (callback) {
+                std::lock_guard<std::mutex> lock { state.callback_mutex };
+                if (!callback(req))
+                    throw MemoryLimitExceeded("PIGO: allocating " + std::to_string(bytes) +
+                            " bytes of " + req.kind + " was refused");
+            }
+        }
+
+        inline
+        void watch_memory_(size_t* peak) {
+            MemoryState_& state = memory_state_();
+            std::lock_guard<std::mutex> lock { state.mutex };
+            *peak = state.total.current;
+            state.watches.push_back(peak);
+        }
+
+        inline
+        void unwatch_memory_(size_t* peak) {
+            MemoryState_& state = memory_state_();
+            std::lock_guard<std::mutex> lock { state.mutex };
+            auto it = std::find(state.watches.begin(), state.watches.end(), peak);
+            if (it != state.watches.end()) state.watches.erase(it);
+        }
+
+        template<class T>
+        T* TrackedAllocator_<T>::allocate(size_t n) {
+            check_alloc_(sizeof(T)*n, "temporary");
+            T* p = static_cast<T*>(::operator new(sizeof(T)*n));
+            track_alloc_(p, sizeof(T)*n, "temporary");
+            return p;
+        }
+
+        template<class T>
+        void TrackedAllocator_<T>::deallocate(T* p, size_t) {
+            track_free_(p);
+            ::operator delete(p);
+        }
+
+    }
+
+    inline
+    MemoryUsage memory_usage() {
+        detail::MemoryState_& state = detail::memory_state_();
+        std::lock_guard<std::mutex> lock { state.mutex };
+        return state.total;
+    }
+
+    inline
+    MemoryUsage memory_usage(const std::string& kind) {
+        detail::MemoryState_& state = detail::memory_state_();
+        std::lock_guard<std::mutex> lock { state.mutex };
+        auto it = state.kinds.find(kind);
+        if (it == state.kinds.end()) return MemoryUsage();
+        return it->second;
+    }
+
+    inline
+    std::map<std::string, MemoryUsage> memory_usage_by_kind() {
+        detail::MemoryState_& state = detail::memory_state_();
+        std::lock_guard<std::mutex> lock { state.mutex };
+        return state.kinds;
+    }
+
+    inline
+    void reset_memory_peaks() {
+        detail::MemoryState_& state = detail::memory_state_();
+        std::lock_guard<std::mutex> lock { state.mutex };
+        state.total.peak = state.total.current;
+        state.total.allocations = 0;
+        for (auto& kv : state.kinds) {
+            kv.second.peak = kv.second.current;
+            kv.second.allocations = 0;
+        }
+    }
+
+    inline
+    void set_memory_limit(size_t bytes) {
+        detail::MemoryState_& state = detail::memory_state_();
+        std::lock_guard<std::mutex> lock { state.mutex };
+        state.limit = bytes;
+        state.checking.store(state.limit > 0 || (bool)state.callback);
+    }
+
+    inline
+    size_t memory_limit() {
+        detail::MemoryState_& state = detail::memory_state_();
+        std::lock_guard<std::mutex> lock { state.mutex };
+        return state.limit;
+    }
+
+    inline
+    void set_allocation_callback(std::function<bool(const AllocationRequest&)> callback) {
+        detail::MemoryState_& state = detail::memory_state_();
+        std::lock_guard<std::mutex> lock { state.mutex };
+        state.callback = callback;
+        state.checking.store(state.limit > 0 || (bool)state.callback);
+    }
+
+    inline
+    void print_memory_usage(std::ostream& out) {
+        std::ios::fmtflags flags = out.flags();
+        out << std::left << std::setw(16) << "kind" << std::right
+            << std::setw(16) << "current"
+            << std::setw(16) << "peak"
+            << std::setw(14) << "allocations" << "\n";
+        auto row = [&out](const std::string& name, const MemoryUsage& u) {
+            out << std::left << std::setw(16) << name << std::right
+                << std::setw(16) << u.current
+                << std::setw(16) << u.peak
+                << std::setw(14) << u.allocations << "\n";
+        };
+        for (const auto& kv : memory_usage_by_kind())
+            row(kv.first, kv.second);
+        row("total", memory_usage());
+        out.flags(flags);
+    }
+
+}
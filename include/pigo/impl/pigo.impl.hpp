@@ -12,15 +12,26 @@
 #include <unistd.h>
 #include <fcntl.h>
 
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
 #include <cstring>
-#ifdef _OPENMP
-#include <omp.h>
+#include <limits>
+#include <type_traits>
+#ifdef PIGO_HAVE_ZLIB
+#include <zlib.h>
+#endif
+#ifdef PIGO_HAVE_ZSTD
+#include <zstd.h>
 #endif
 
 namespace pigo {
     inline
     File::File(std::string fn, OpenMode mode, size_t max_size) :
-                fn_(fn) {
+                fn_(fn), sums_(nullptr) {
         int open_mode = O_RDONLY;
         int prot = PROT_READ;
         char fopen_mode[] = "rb";
@@ -91,11 +102,250 @@ namespace pigo {
                 munmap(data_, size_);
             data_ = o.data_;
             size_ = o.size_;
+            sums_ = o.sums_;
             o.data_ = nullptr;
         }
         return *this;
     }
 
+    inline
+    WStream::WStream(std::string fn, size_t buffer_size) :
+            owned_(fn != "-"), buf_(std::max(buffer_size, (size_t)1)),
+            used_(0), written_(0) {
+        if (owned_) {
+            fd_ = open(fn.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666);
+            if (fd_ < 0) throw Error("PIGO: Unable to open stream for writing");
+        } else
+            fd_ = STDOUT_FILENO;
+    }
+
+    inline
+    WStream::WStream(int fd, size_t buffer_size) :
+            fd_(fd), owned_(false), buf_(std::max(buffer_size, (size_t)1)),
+            used_(0), written_(0) {
+        if (fd_ < 0) throw Error("PIGO: Invalid stream file descriptor");
+    }
+
+    inline
+    WStream::~WStream() noexcept {
+        try {
+            flush();
+        } catch (...) { }
+        if (owned_) close(fd_);
+    }
+
+    inline
+    void WStream::write_fd_(const char* data, size_t size) {
+        while (size > 0) {
+            ssize_t res = ::write(fd_, data, size);
+            if (res < 0) {
+                if (errno == EINTR) continue;
+                throw Error("PIGO: Unable to write to stream");
+            }
+            data += res;
+            size -= res;
+            written_ += res;
+        }
+    }
+
+    inline
+    void WStream::write(const char* data, size_t size) {
+        if (used_ + size > buf_.size()) {
+            flush();
+            // Large regions skip the buffer entirely
+            if (size >= buf_.size()) {
+                write_fd_(data, size);
+                return;
+            }
+        }
+        memcpy(buf_.data() + used_, data, size);
+        used_ += size;
+    }
+
+    inline
+    void WStream::flush() {
+        size_t pending = used_;
+        used_ = 0;
+        write_fd_(buf_.data(), pending);
+    }
+
+    inline
+    DirectWFile::DirectWFile(std::string fn, size_t size) :
+            direct_(false), size_(size), pos_(0), tail_(nullptr),
+            tail_used_(0), sums_(nullptr) {
+        int flags = O_WRONLY | O_CREAT | O_TRUNC;
+        #ifdef __linux__
+        // Not every file system supports O_DIRECT, so fall back without it
+        fd_ = open(fn.c_str(), flags | O_DIRECT, 0666);
+        direct_ = (fd_ >= 0);
+        if (!direct_)
+        #endif
+            fd_ = open(fn.c_str(), flags, 0666);
+        if (fd_ < 0) throw Error("PIGO: Unable to open file for writing");
+        #ifdef __APPLE__
+        fcntl(fd_, F_NOCACHE, 1);
+        #endif
+
+        // Reserve the space up front, when the file system supports it
+        size_t alloc_size = (size_ + align_ - 1) / align_ * align_;
+        #ifdef __linux__
+        if (alloc_size > 0)
+            fallocate(fd_, 0, 0, alloc_size);
+        #endif
+
+        if (posix_memalign((void**)&tail_, align_, align_) != 0) {
+            ::close(fd_);
+            throw Error("PIGO: Unable to allocate aligned buffer");
+        }
+        memset(tail_, 0, align_);
+    }
+
+    inline
+    DirectWFile::~DirectWFile() noexcept {
+        if (fd_ >= 0) ::close(fd_);
+        ::free(tail_);
+    }
+
+    namespace detail {
+        /** @brief Write an entire buffer at the given file offset
+         *
+         * @param fd the file descriptor to write to
+         * @param buf the data to write
+         * @param size the size of the data
+         * @param offset the offset in the file to write at
+         */
+        inline
+        void pwrite_all_(int fd, const char* buf, size_t size, size_t offset) {
+            while (size > 0) {
+                ssize_t res = pwrite(fd, buf, size, offset);
+                if (res < 0) {
+                    if (errno == EINTR) continue;
+                    throw Error("PIGO: Unable to write to file");
+                }
+                buf += res;
+                size -= res;
+                offset += res;
+            }
+        }
+    }
+
+    inline
+    void DirectWFile::pwrite_(const char* buf, size_t size, size_t offset) {
+        detail::pwrite_all_(fd_, buf, size, offset);
+    }
+
+    inline
+    void DirectWFile::flush_tail_() {
+        pwrite_(tail_, align_, pos_ - tail_used_);
+        memset(tail_, 0, align_);
+        tail_used_ = 0;
+    }
+
+    inline
+    void DirectWFile::append_(const char* data, size_t size) {
+        if (pos_ + size > size_) throw Error("PIGO: Writing beyond the end of the file");
+        while (size > 0) {
+            size_t fill = std::min(size, align_ - tail_used_);
+            memcpy(tail_ + tail_used_, data, fill);
+            tail_used_ += fill;
+            pos_ += fill;
+            data += fill;
+            size -= fill;
+            if (tail_used_ == align_) flush_tail_();
+        }
+    }
+
+    inline
+    void DirectWFile::parallel_write(char* v, size_t v_size) {
+        if (pos_ + v_size > size_) throw Error("PIGO: Writing beyond the end of the file");
+        ChecksumWriter* sums = (v_size > 0) ? sums_ : nullptr;
+        size_t sec = sums ? sums->begin_region_(v_size) : 0;
+        size_t done = 0;
+
+        // Complete any partial block, after which writes are aligned
+        if (tail_used_ > 0) {
+            size_t fill = std::min(v_size, align_ - tail_used_);
+            append_(v, fill);
+            if (sums) sums->add_region_part_(sec, 0, v, fill);
+            v += fill;
+            v_size -= fill;
+            done = fill;
+        }
+
+        size_t body = v_size - v_size % align_;
+        if (body > 0) {
+            size_t offset = pos_;
+            size_t chunk_size = chunk_;
+            size_t num_chunks = (body + chunk_size - 1) / chunk_size;
+            std::atomic<bool> failed { false };
+            detail::ParallelTeam_ team;
+            detail::LoopChunks_ chunks { 0, num_chunks, 1 };
+            team.run([&](size_t) {
+                char* buf = nullptr;
+                size_t buf_size = std::min(body, chunk_size);
+                if (posix_memalign((void**)&buf, align_, buf_size) != 0) {
+                    failed = true;
+                    return;
+                }
+
+                // The source is not aligned, so each chunk is staged in
+                // an aligned buffer before it is written
+                size_t chunk, chunk_end;
+                while (chunks.next(chunk, chunk_end)) {
+                    size_t start = chunk*chunk_size;
+                    size_t len = std::min(chunk_size, body - start);
+                    memcpy(buf, v + start, len);
+                    // Checksum the copy, which is now in cache
+                    if (sums) sums->add_region_part_(sec, done + start, buf, len);
+                    try {
+                        pwrite_(buf, len, offset + start);
+                        #ifdef __linux__
+                        if (!direct_)
+                            sync_file_range(fd_, offset + start, len, SYNC_FILE_RANGE_WRITE);
+                        #endif
+                    } catch (...) {
+                        failed = true;
+                    }
+                }
+                ::free(buf);
+            });
+            if (failed) throw Error("PIGO: Unable to write to file");
+            pos_ += body;
+            v += body;
+            v_size -= body;
+            done += body;
+        }
+
+        // Keep the remaining partial block
+        append_(v, v_size);
+        if (sums) {
+            sums->add_region_part_(sec, done, v, v_size);
+            sums->end_region_();
+        }
+    }
+
+    inline
+    void DirectWFile::close() {
+        if (fd_ < 0) return;
+        if (pos_ != size_) throw Error("PIGO: File closed before being entirely written");
+        if (tail_used_ > 0) flush_tail_();
+
+        // Remove the padding of the last block and make the data durable
+        if (ftruncate(fd_, size_) != 0) throw Error("PIGO: Unable to set the file size");
+        #ifdef __APPLE__
+        if (fsync(fd_) != 0) throw Error("PIGO: Unable to synchronize the file");
+        #else
+        if (fdatasync(fd_) != 0) throw Error("PIGO: Unable to synchronize the file");
+        #endif
+        #ifdef __linux__
+        if (!direct_)
+            posix_fadvise(fd_, 0, size_, POSIX_FADV_DONTNEED);
+        #endif
+        int fd = fd_;
+        fd_ = -1;
+        if (::close(fd) != 0) throw Error("PIGO: Unable to close the file");
+    }
+
     template<class T>
     inline
     T File::read() {
@@ -118,7 +368,31 @@ namespace pigo {
 
     inline
     void File::parallel_write(char* v, size_t v_size) {
-        ::pigo::parallel_write(fp_, v, v_size);
+        if (!sums_ || v_size == 0) {
+            ::pigo::parallel_write(fp_, v, v_size);
+            return;
+        }
+
+        // Copy the region by checksum block, so each block is checksummed
+        // while it is still in cache
+        size_t sec = sums_->begin_region_(v_size);
+        size_t block_size = sums_->block_size_;
+        size_t num_blocks = (v_size + block_size - 1) / block_size;
+        WFilePos wfp = (WFilePos)(fp_);
+        detail::ProgressTracker_* progress = detail::current_progress_();
+        std::atomic<bool> stop { false };
+        detail::ParallelTeam_ team;
+        team.for_each(0, num_blocks, [&](size_t block) {
+            if (stop) return;
+            size_t start = block*block_size;
+            size_t len = std::min(block_size, v_size - start);
+            memcpy(wfp + start, v + start, len);
+            sums_->add_region_part_(sec, start, wfp + start, len);
+            // Stop at a block boundary once cancelled
+            if (progress && progress->update(len, 0)) stop = true;
+        });
+        sums_->end_region_();
+        fp_ += v_size;
     }
 
     inline
@@ -215,14 +489,113 @@ namespace pigo {
 
         template<typename T, typename std::enable_if<!std::is_signed<T>::value, bool>::type = false>
         inline
-        T get_positive(T obj) {
-            return obj;
+        uint64_t get_positive(T obj) {
+            return (uint64_t)obj;
         }
         template<typename T, typename std::enable_if<std::is_signed<T>::value, bool>::type = true>
         inline
-        T get_positive(T obj) {
-            if (obj < 0) return -obj;
-            return obj;
+        uint64_t get_positive(T obj) {
+            // Negate in unsigned arithmetic, so the smallest value works
+            if (obj < 0) return 0 - (uint64_t)obj;
+            return (uint64_t)obj;
+        }
+
+        /** @brief Return the number of decimal digits in a value
+         *
+         * This estimates the digits from the bit length, using
+         * log10(2) ~= 1233/4096, and then corrects the estimate with
+         * a single comparison against a power of ten.
+         */
+        inline
+        size_t num_digits_(uint64_t v) {
+            static const uint64_t pow10[] = {
+                1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL,
+                1000000ULL, 10000000ULL, 100000000ULL, 1000000000ULL,
+                10000000000ULL, 100000000000ULL, 1000000000000ULL,
+                10000000000000ULL, 100000000000000ULL, 1000000000000000ULL,
+                10000000000000000ULL, 100000000000000000ULL,
+                1000000000000000000ULL, 10000000000000000000ULL
+            };
+            uint64_t nz = v | 1;
+            size_t bits = 64 - __builtin_clzll(nz);
+            size_t t = (bits*1233) >> 12;
+            return t + (nz >= pow10[t]);
+        }
+
+        /** @brief Return the two ASCII digits of every value below 100 */
+        inline
+        const char* digit_pairs_() {
+            static const char pairs[] =
+                "00010203040506070809"
+                "10111213141516171819"
+                "20212223242526272829"
+                "30313233343536373839"
+                "40414243444546474849"
+                "50515253545556575859"
+                "60616263646566676869"
+                "70717273747576777879"
+                "80818283848586878889"
+                "90919293949596979899";
+            return pairs;
+        }
+
+        /** @brief Write exactly 8 digits of a value below 10^8
+         *
+         * On little-endian systems all 8 digits are computed at once
+         * within a 64-bit word (SWAR): the value is split into two
+         * 4-digit halves, then each half into hundreds and then tens,
+         * using multiplications by reciprocals instead of divisions.
+         */
+        inline
+        void write_8_digits_(char* out, uint32_t v) {
+            #if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+            uint64_t merged = (uint64_t)(v / 10000) | ((uint64_t)(v % 10000) << 32);
+            uint64_t top = ((merged * 10486ULL) >> 20) & ((0x7FULL << 32) | 0x7FULL);
+            uint64_t bot = merged - 100ULL*top;
+            uint64_t hundreds = (bot << 16) + top;
+            uint64_t tens = (hundreds * 103ULL) >> 10;
+            tens &= (0xFULL << 48) | (0xFULL << 32) | (0xFULL << 16) | 0xFULL;
+            tens += (hundreds - 10ULL*tens) << 8;
+            tens += 0x3030303030303030ULL;
+            memcpy(out, &tens, sizeof(tens));
+            #else
+            const char* pairs = digit_pairs_();
+            for (int pos = 6; pos >= 0; pos -= 2) {
+                memcpy(out+pos, pairs + 2*(v % 100), 2);
+                v /= 100;
+            }
+            #endif
+        }
+
+        /** @brief Write the decimal digits of a value
+         *
+         * @param out the position to write at
+         * @param v the value to write
+         * @param digits the number of digits of v, from num_digits_
+         */
+        inline
+        void write_digits_(char* out, uint64_t v, size_t digits) {
+            char* pos = out + digits;
+            // Emit the low 8 digits at a time
+            while (v >= 100000000ULL) {
+                uint64_t q = v / 100000000ULL;
+                pos -= 8;
+                write_8_digits_(pos, (uint32_t)(v - q*100000000ULL));
+                v = q;
+            }
+            // Emit the remaining digits two at a time
+            const char* pairs = digit_pairs_();
+            while (v >= 100) {
+                uint64_t q = v / 100;
+                pos -= 2;
+                memcpy(pos, pairs + 2*(v - q*100), 2);
+                v = q;
+            }
+            if (v >= 10) {
+                pos -= 2;
+                memcpy(pos, pairs + 2*v, 2);
+            } else
+                *--pos = (char)('0' + v);
         }
     }
 
@@ -243,24 +616,7 @@ namespace pigo {
     inline
     size_t write_size(T obj) {
         // If it is signed, and negative, it will take an additional char
-        size_t res = detail::neg_size(obj);
-        do {
-            obj /= 10;
-            ++res;
-        } while (obj != 0);
-        return res;
-    }
-
-    template<typename T,
-        typename std::enable_if<!std::is_integral<T>::value, bool>::type,
-        typename std::enable_if<std::is_floating_point<T>::value, bool>::type
-        >
-    inline
-    size_t write_size(T obj) {
-        char buf[1024];
-        int sz = stbsp_to_chars(buf, (double)obj);
-        if (sz >= 1024) sz = 1023;
-        return (size_t)sz;
+        return detail::neg_size(obj) + detail::num_digits_(detail::get_positive(obj));
     }
 
     template<typename T,
@@ -280,27 +636,24 @@ namespace pigo {
     inline
     void write_ascii(FilePos &fp, T obj) {
         detail::write_neg_ascii(fp, obj);
-        obj = detail::get_positive(obj);
-
-        size_t num_size = write_size(obj);
-        size_t pos = num_size-1;
-        // Write out each digit
-        do {
-            *((char*)fp+pos--) = (obj%10)+'0';
-            obj /= 10;
-        } while (obj != 0);
+        uint64_t val = detail::get_positive(obj);
+
+        size_t num_size = detail::num_digits_(val);
+        detail::write_digits_((char*)fp, val, num_size);
         fp += num_size;
     }
 
-    template<typename T,
-        typename std::enable_if<!std::is_integral<T>::value, bool>::type,
-        typename std::enable_if<std::is_floating_point<T>::value, bool>::type
-        >
+    template<typename T>
     inline
-    void write_ascii(FilePos &fp, T obj) {
-        int sz = stbsp_to_chars((char*)fp, (double)obj);
-        if (sz >= 1024) sz = 1023;
-        fp += sz;
+    size_t max_write_size() {
+        // Integers use at most one more digit than digits10, and a sign
+        if (std::is_integral<T>::value)
+            return std::numeric_limits<T>::digits10 + 2;
+        // Floating point values use at most the shortest round-trip digits,
+        // a sign, a point, and a signed exponent (see fp.impl.hpp)
+        if (std::is_floating_point<T>::value)
+            return (sizeof(T) <= sizeof(float)) ? 15 : 24;
+        return 1024;
     }
 
     inline
@@ -339,49 +692,6 @@ namespace pigo {
         return res;
     }
 
-    template<typename T>
-    inline
-    T FileReader::read_fp() {
-        T res = 0.0;
-        while (d < end && !((*d >= '0' && *d <= '9') || *d == 'e' ||
-                    *d == 'E' || *d == '-' || *d == '+' || *d == '.')) ++d;
-        // Read the size
-        bool positive = true;
-        if (*d == '-') {
-            positive = false;
-            ++d;
-        } else if (*d == '+') ++d;
-
-        // Support a simple form of floating point integers
-        // Note: this is not the most accurate or fastest strategy
-        // (+-)AAA.BBB(eE)(+-)ZZ.YY
-        // Read the 'A' part
-        while (d < end && (*d >= '0' && *d <= '9')) {
-            res = res*10. + (T)(*d-'0');
-            ++d;
-        }
-        if (*d == '.') {
-            ++d;
-            T fraction = 0.;
-            size_t fraction_count = 0;
-            // Read the 'B' part
-            while (d < end && (*d >= '0' && *d <= '9')) {
-                fraction = fraction*10. + (T)(*d-'0');
-                ++d;
-                ++fraction_count;
-            }
-            res += fraction / std::pow(10., fraction_count);
-        }
-        if (*d == 'e' || *d == 'E') {
-            ++d;
-            T exp = read_fp<T>();
-            res *= std::pow(10., exp);
-        }
-
-        if (!positive) res *= -1;
-        return res;
-    }
-
     inline
     bool FileReader::at_end_of_line() {
         FilePos td = d;
@@ -398,8 +708,32 @@ namespace pigo {
         while (d < end && (*d >= '0' && *d <= '9')) ++d;
     }
 
+    namespace detail {
+        /** @brief Return the length of an infinity or NaN at a position
+         *
+         * The words inf, infinity and nan are matched in any case.
+         *
+         * @return the length of the word, or 0 if there is none
+         */
+        inline
+        size_t nonfinite_size_(const char* d, const char* end) {
+            if (d >= end || ((*d | 0x20) != 'i' && (*d | 0x20) != 'n')) return 0;
+            const char* words[] = { "infinity", "inf", "nan" };
+            for (const char* word : words) {
+                size_t len = strlen(word);
+                if ((size_t)(end - d) < len) continue;
+                size_t i = 0;
+                while (i < len && (d[i] | 0x20) == word[i]) ++i;
+                if (i == len) return len;
+            }
+            return 0;
+        }
+    }
+
     inline
     void FileReader::move_to_non_fp() {
+        if (d < end && (*d == '-' || *d == '+')) ++d;
+        d += detail::nonfinite_size_(d, end);
         while (d < end && ((*d >= '0' && *d <= '9') || *d == 'e' ||
                     *d == 'E' || *d == '-' || *d == '+' || *d == '.')) ++d;
     }
@@ -407,7 +741,8 @@ namespace pigo {
     inline
     void FileReader::move_to_fp() {
         while (d < end && !((*d >= '0' && *d <= '9') || *d == 'e' ||
-                    *d == 'E' || *d == '-' || *d == '+' || *d == '.')) ++d;
+                    *d == 'E' || *d == '-' || *d == '+' || *d == '.') &&
+                detail::nonfinite_size_(d, end) == 0) ++d;
     }
 
     inline
@@ -534,26 +869,11 @@ namespace pigo {
         // offsets
 
         // Get the number of threads
-        size_t num_threads = 1;
-        #ifdef _OPENMP
-        omp_set_dynamic(0);
-        #pragma omp parallel shared(num_threads)
-        {
-            #pragma omp single
-            {
-                num_threads = omp_get_num_threads();
-            }
-        }
-        #endif
+        detail::ParallelTeam_ team;
+        size_t num_threads = team.size();
 
         std::vector<size_t> c_offsets(num_threads);
-        #pragma omp parallel
-        {
-            #ifdef _OPENMP
-            size_t tid = omp_get_thread_num();
-            #else
-            size_t tid = 0;
-            #endif
+        team.run([&](size_t tid) {
 
             // Find our offsets in the file
             size_t tsize = size();
@@ -580,18 +900,13 @@ namespace pigo {
             }
 
             c_offsets[tid] = tid_c;
+        });
 
-            // Compute a prefix sum on the offsets
-            #pragma omp barrier
-            #pragma omp single
-            {
-                size_t sum_c = 0;
-                for (size_t tid = 0; tid < num_threads; ++tid) {
-                    sum_c += c_offsets[tid];
-                    c_offsets[tid] = sum_c;
-                }
-
-            }
+        // Compute a prefix sum on the offsets
+        size_t sum_c = 0;
+        for (size_t tid = 0; tid < num_threads; ++tid) {
+            sum_c += c_offsets[tid];
+            c_offsets[tid] = sum_c;
         }
 
         // Now, we can allocate the space appropriately
@@ -600,13 +915,7 @@ namespace pigo {
         auto& t_c = t.c();
 
         // Next, go back and populate everything
-        #pragma omp parallel
-        {
-            #ifdef _OPENMP
-            size_t tid = omp_get_thread_num();
-            #else
-            size_t tid = 0;
-            #endif
+        team.run([&](size_t tid) {
 
             // Find our offsets in the file
             size_t tsize = size();
@@ -635,7 +944,7 @@ namespace pigo {
                     ++tid_c;
                 }
             }
-        }
+        });
 
         return t;
     }
@@ -647,18 +956,40 @@ namespace pigo {
         return comp;
     }
 
+    namespace detail {
+        /** @brief Copy one thread's part of a region
+         *
+         * While progress is tracked, the copy is made in chunks, stopping
+         * at a chunk boundary once cancelled.
+         *
+         * @param to the destination
+         * @param from the source
+         * @param size the bytes to copy
+         * @param progress the tracker, or nullptr if there is none
+         */
+        inline
+        void copy_chunks_(char* to, const char* from, size_t size,
+                ProgressTracker_* progress) {
+            if (!progress) {
+                memcpy(to, from, size);
+                return;
+            }
+            for (size_t done = 0; done < size; ) {
+                size_t chunk = std::min(size - done, progress_bytes_chunk_);
+                memcpy(to + done, from + done, chunk);
+                done += chunk;
+                if (progress->update(chunk, 0)) return;
+            }
+        }
+    }
+
     inline
     void parallel_write(FilePos &fp, char* v, size_t v_size) {
         WFilePos wfp = (WFilePos)(fp);
-        #pragma omp parallel
-        {
-            #ifdef _OPENMP
-            int num_threads = omp_get_num_threads();
-            int thread_id = omp_get_thread_num();
-            #else
-            int num_threads = 1;
-            int thread_id = 0;
-            #endif
+        detail::ProgressTracker_* progress = detail::current_progress_();
+        detail::ParallelTeam_ team;
+        size_t num_threads = team.size();
+        team.run([&](size_t thread_id) {
 
             size_t my_data = v_size/num_threads;
             // Give the last thread the remaining data
@@ -667,26 +998,18 @@ namespace pigo {
 
             size_t start_pos = (thread_id*(v_size/num_threads));
 
-            // Memcpy the region
-            char* o_out = (char*)memcpy(wfp + start_pos,
-                    v + start_pos, my_data);
-            if (o_out != fp+start_pos)
-                throw Error("Unable to write");
-        }
+            // Memcpy the region, in chunks while tracking progress
+            detail::copy_chunks_(wfp + start_pos, v + start_pos, my_data, progress);
+        });
         fp += v_size;
     }
 
     inline
     void parallel_read(FilePos &fp, char* v, size_t v_size) {
-        #pragma omp parallel
-        {
-            #ifdef _OPENMP
-            int num_threads = omp_get_num_threads();
-            int thread_id = omp_get_thread_num();
-            #else
-            int num_threads = 1;
-            int thread_id = 0;
-            #endif
+        detail::ProgressTracker_* progress = detail::current_progress_();
+        detail::ParallelTeam_ team;
+        size_t num_threads = team.size();
+        team.run([&](size_t thread_id) {
 
             size_t my_data = v_size/num_threads;
             // Give the last thread the remaining data
@@ -695,15 +1018,712 @@ namespace pigo {
 
             size_t start_pos = (thread_id*(v_size/num_threads));
 
-            // Memcpy the region
-            char* o_in = (char*)memcpy(v + start_pos,
-                    fp + start_pos, my_data);
-            if (o_in != v+start_pos)
-                throw Error("Unable to read");
-        }
+            // Memcpy the region, in chunks while tracking progress
+            detail::copy_chunks_(v + start_pos, fp + start_pos, my_data, progress);
+        });
         fp += v_size;
     }
 
+    namespace detail {
+        /** @brief Save a binary file of known size with the given mode
+         *
+         * @tparam T the type being saved, which provides save(File&),
+         *         save(DirectWFile&) and save(ChecksumWriter&)
+         * @param obj the object to save
+         * @param fn the file name to save as
+         * @param size the exact size of the file, without checksums
+         * @param mode the SaveMode to use
+         * @param checksum the ChecksumMode to use
+         * @param name the name of the save's phase, such as coo.save
+         * @return the bytes saved and the time taken
+         */
+        template<class T>
+        inline
+        SaveStats save_file_(T& obj, std::string fn, size_t size, SaveMode mode,
+                ChecksumMode checksum, const char* name) {
+            auto start = std::chrono::steady_clock::now();
+            PhaseTimer_ phase { name };
+            ProgressTracker_ progress { name, size };
+            progress.throw_if_cancelled();
+            // Only the layout is recorded here; the regions are
+            // checksummed as they are written
+            ChecksumWriter sums;
+            bool checksummed = (checksum == CRC32C);
+            if (checksummed) {
+                obj.save(sums);
+                size += sums.trailer_size();
+            }
+            phase.add_bytes(size);
+            if (mode == DIRECT) {
+                PhaseTimer_ write_phase { name, "write" };
+                write_phase.add_bytes(size);
+                DirectWFile w {fn, size};
+                if (checksummed) w.checksum_regions(&sums);
+                obj.save(w);
+                if (checksummed && !progress.cancelled()) w.write(sums.trailer());
+                write_phase.stop();
+                PhaseTimer_ sync_phase { name, "sync" };
+                w.close();
+            } else {
+                PhaseTimer_ write_phase { name, "write" };
+                write_phase.add_bytes(size);
+                WFile w {fn, size};
+                if (checksummed) w.checksum_regions(&sums);
+                obj.save(w);
+                if (checksummed && !progress.cancelled()) w.write(sums.trailer());
+            }
+            // The copies stop early once cancelled, leaving a partial file
+            if (progress.cancelled()) {
+                std::remove(fn.c_str());
+                progress.throw_if_cancelled();
+            }
+            progress.finish();
+            std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+            return SaveStats { size, elapsed.count() };
+        }
+
+        /** @brief Return whether a label lies within [0, bound)
+         *
+         * Negative signed labels become large unsigned values, so a single
+         * comparison covers both ends of the range.
+         */
+        template<class L>
+        inline
+        bool in_range_(L val, L bound) {
+            typedef typename std::make_unsigned<L>::type UL;
+            return static_cast<UL>(val) < static_cast<UL>(bound);
+        }
+
+        /** @brief Find the first index that fails a check, in parallel
+         *
+         * Indices are checked in fixed-size chunks without branching, so
+         * the checks vectorize, and only a failing chunk is searched for
+         * its exact index.
+         *
+         * @param count the number of indices to check
+         * @param check returns whether the given index is valid
+         * @return the first invalid index, or count if all are valid
+         */
+        template<class Check>
+        inline
+        size_t first_invalid_(size_t count, Check check) {
+            const size_t chunk_size = 1<<12;
+            size_t num_chunks = (count + chunk_size - 1) / chunk_size;
+            ParallelTeam_ team;
+            size_t num_threads = team.size();
+            std::vector<size_t> firsts(num_threads, count);
+            team.run([&](size_t tid) {
+                size_t my_first = count;
+                // Each task's chunks are in order, so it can stop at its
+                // first failure
+                size_t chunk_start = (tid*num_chunks)/num_threads;
+                size_t chunk_end = ((tid+1)*num_chunks)/num_threads;
+                for (size_t chunk = chunk_start; chunk < chunk_end; ++chunk) {
+                    if (my_first != count) break;
+                    size_t start = chunk*chunk_size;
+                    size_t end = std::min(start + chunk_size, count);
+                    bool valid = true;
+                    for (size_t i = start; i < end; ++i)
+                        valid &= check(i);
+                    if (valid) continue;
+                    for (size_t i = start; i < end; ++i) {
+                        if (!check(i)) {
+                            my_first = i;
+                            break;
+                        }
+                    }
+                }
+                firsts[tid] = my_first;
+            });
+            size_t first = *std::min_element(firsts.begin(), firsts.end());
+            return first;
+        }
+
+        /** @brief Throw an Error describing an invalid index
+         *
+         * @param what the description of the problem
+         * @param idx the offending index
+         */
+        inline
+        void invalid_(const std::string& what, size_t idx) {
+            throw Error("PIGO: " + what + " at index " + std::to_string(idx));
+        }
+
+        /** @brief Create a new file of the given size for writing
+         *
+         * Files with a size of zero cannot be mapped, so they are only
+         * created and a nullptr is returned.
+         *
+         * @param fn the file name to create
+         * @param size the size of the new file
+         * @return a File opened for writing, or nullptr if it is empty
+         */
+        inline
+        std::shared_ptr<File> create_file_(std::string fn, size_t size) {
+            if (size == 0) {
+                FILE* empty_f = fopen(fn.c_str(), "w");
+                if (empty_f == NULL || fclose(empty_f) != 0)
+                    throw Error("PIGO: Unable to create empty file");
+                return nullptr;
+            }
+            return std::make_shared<File>(fn, WRITE, size);
+        }
+
+        /** @brief Holds formatted output in a list of large blocks
+         *
+         * Formatted values are appended without ever moving the already
+         * formatted output, so the buffer can grow without copies.
+         */
+        class FormatBuffer_ {
+            private:
+                /** The blocks holding the formatted output */
+                std::vector<std::vector<char>> blocks_;
+                /** The bytes used in each block */
+                std::vector<size_t> used_;
+                /** The total bytes used */
+                size_t size_;
+                /** The size of newly created blocks */
+                size_t block_size_;
+            public:
+                /** @brief Initialize an empty buffer
+                 *
+                 * @param block_size the size of each allocated block
+                 */
+                FormatBuffer_(size_t block_size=(1<<23)) :
+                    size_(0), block_size_(block_size) { }
+
+                /** @brief Return a position with room for max_size bytes */
+                char* reserve(size_t max_size) {
+                    if (blocks_.empty() || used_.back()+max_size > blocks_.back().size()) {
+                        blocks_.emplace_back(std::max(block_size_, max_size));
+                        used_.push_back(0);
+                    }
+                    return blocks_.back().data() + used_.back();
+                }
+
+                /** @brief Mark the next bytes as used */
+                void commit(size_t bytes) {
+                    used_.back() += bytes;
+                    size_ += bytes;
+                }
+
+                /** @brief Return the total bytes used */
+                size_t size() const { return size_; }
+
+                /** @brief Copy the formatted output to the given location */
+                void copy_to(char* dst) const {
+                    for (size_t block = 0; block < blocks_.size(); ++block) {
+                        memcpy(dst, blocks_[block].data(), used_[block]);
+                        dst += used_[block];
+                    }
+                }
+
+                /** @brief Remove all formatted output */
+                void clear() {
+                    blocks_.clear();
+                    used_.clear();
+                    size_ = 0;
+                }
+        };
+
+        /** @brief Format a range of entries into a FormatBuffer_ */
+        template<class Fmt>
+        inline
+        void format_range_(Fmt& fmt, size_t start, size_t end, FormatBuffer_& buf) {
+            size_t max_size = fmt.max_size();
+            for (size_t i = start; i < end; ++i) {
+                char* pos = buf.reserve(max_size);
+                FilePos fp = pos;
+                fmt.write(fp, i);
+                buf.commit(fp - pos);
+            }
+        }
+
+        /** @brief Compresses independent chunks for a streaming WriteMode
+         *
+         * Each chunk becomes a complete gzip member or zstd frame, so the
+         * compressed chunks can simply be concatenated in order.
+         */
+        class ChunkCompressor_ {
+            private:
+                /** The WriteMode, one of STREAM, GZIP or ZSTD */
+                WriteMode mode_;
+                #ifdef PIGO_HAVE_ZLIB
+                /** The reused deflate state */
+                z_stream zs_;
+                #endif
+                #ifdef PIGO_HAVE_ZSTD
+                /** The reused zstd compression context */
+                ZSTD_CCtx* zctx_;
+                #endif
+                /** Whether the compression state was initialized */
+                bool ready_;
+            public:
+                /** @brief Throw if the WriteMode cannot be streamed */
+                static void check_mode(WriteMode mode) {
+                    if (mode != STREAM && mode != GZIP && mode != ZSTD)
+                        throw Error("PIGO: The WriteMode cannot be streamed");
+                    #ifndef PIGO_HAVE_ZLIB
+                    if (mode == GZIP)
+                        throw Error("PIGO: compiled without zlib, unable to gzip (define PIGO_HAVE_ZLIB)");
+                    #endif
+                    #ifndef PIGO_HAVE_ZSTD
+                    if (mode == ZSTD)
+                        throw Error("PIGO: compiled without zstd, unable to compress (define PIGO_HAVE_ZSTD)");
+                    #endif
+                }
+
+                /** @brief Prepare to compress chunks with the given mode */
+                ChunkCompressor_(WriteMode mode) : mode_(mode), ready_(mode == STREAM) {
+                    #ifdef PIGO_HAVE_ZLIB
+                    if (mode_ == GZIP) {
+                        memset(&zs_, 0, sizeof(zs_));
+                        // A window of 15 bits, plus 16 for a gzip wrapper
+                        ready_ = deflateInit2(&zs_, Z_DEFAULT_COMPRESSION,
+                                Z_DEFLATED, 15+16, 8, Z_DEFAULT_STRATEGY) == Z_OK;
+                    }
+                    #endif
+                    #ifdef PIGO_HAVE_ZSTD
+                    zctx_ = nullptr;
+                    if (mode_ == ZSTD) {
+                        zctx_ = ZSTD_createCCtx();
+                        ready_ = (zctx_ != nullptr);
+                    }
+                    #endif
+                }
+
+                /** @brief Release the compression state */
+                ~ChunkCompressor_() {
+                    #ifdef PIGO_HAVE_ZLIB
+                    if (mode_ == GZIP && ready_) deflateEnd(&zs_);
+                    #endif
+                    #ifdef PIGO_HAVE_ZSTD
+                    ZSTD_freeCCtx(zctx_);
+                    #endif
+                }
+
+                /** @brief Return whether chunks will be compressed */
+                bool compressing() const { return mode_ != STREAM; }
+
+                /** @brief Compress a chunk
+                 *
+                 * @param in the chunk to compress
+                 * @param size the size of the chunk
+                 * @param[out] out the buffer holding the compressed chunk
+                 * @return the compressed size, or 0 on failure
+                 */
+                size_t compress(const char* in, size_t size, std::vector<char>& out) {
+                    if (!ready_) return 0;
+                    #ifdef PIGO_HAVE_ZLIB
+                    if (mode_ == GZIP) {
+                        if (deflateReset(&zs_) != Z_OK) return 0;
+                        out.resize(deflateBound(&zs_, size));
+                        zs_.next_in = (Bytef*)in;
+                        zs_.avail_in = size;
+                        zs_.next_out = (Bytef*)out.data();
+                        zs_.avail_out = out.size();
+                        if (deflate(&zs_, Z_FINISH) != Z_STREAM_END) return 0;
+                        return out.size() - zs_.avail_out;
+                    }
+                    #endif
+                    #ifdef PIGO_HAVE_ZSTD
+                    if (mode_ == ZSTD) {
+                        out.resize(ZSTD_compressBound(size));
+                        size_t res = ZSTD_compressCCtx(zctx_, out.data(), out.size(),
+                                in, size, ZSTD_CLEVEL_DEFAULT);
+                        if (ZSTD_isError(res)) return 0;
+                        return res;
+                    }
+                    #endif
+                    (void)in;
+                    (void)size;
+                    (void)out;
+                    return 0;
+                }
+        };
+
+        /** @brief Append a little-endian 32-bit value to a string */
+        inline
+        void append_le32_(std::string& s, uint32_t val) {
+            for (int byte = 0; byte < 4; ++byte)
+                s += (char)((val >> (8*byte)) & 0xFF);
+        }
+
+        /** @brief Return a zstd seek table for the given frames
+         *
+         * This follows the zstd seekable format: a skippable frame holding
+         * the compressed and decompressed size of every frame, which lets
+         * readers decompress from any frame onwards.
+         */
+        inline
+        std::string zstd_seek_table_(const std::vector<uint32_t>& c_sizes,
+                const std::vector<uint32_t>& d_sizes) {
+            std::string table;
+            append_le32_(table, 0x184D2A5E);
+            append_le32_(table, c_sizes.size()*8 + 9);
+            for (size_t frame = 0; frame < c_sizes.size(); ++frame) {
+                append_le32_(table, c_sizes[frame]);
+                append_le32_(table, d_sizes[frame]);
+            }
+            append_le32_(table, c_sizes.size());
+            // The descriptor: no per-frame checksums
+            table += (char)0;
+            append_le32_(table, 0x8F92EAB1);
+            return table;
+        }
+
+        /** @brief Write formatted entries to a stream in order
+         *
+         * Chunks of entries are formatted in parallel into per-thread
+         * buffers, and each buffer is written to the stream once all
+         * earlier chunks have been written. With GZIP or ZSTD, each thread
+         * also compresses its chunks before they are written.
+         *
+         * @param out the stream to write to
+         * @param count the number of entries to write
+         * @param fmt the formatter for the entries, see write_ascii_file_
+         * @param mode the WriteMode, one of STREAM, GZIP or ZSTD
+         * @param chunk_size the number of entries in each chunk
+         */
+        template<class Fmt>
+        inline
+        void write_ascii_stream_(WStream& out, size_t count, Fmt& fmt,
+                WriteMode mode=STREAM, size_t chunk_size=(1<<16)) {
+            ChunkCompressor_::check_mode(mode);
+            size_t num_chunks = (count + chunk_size - 1) / chunk_size;
+            // Compressed output always holds at least one, empty, chunk
+            if (mode != STREAM && num_chunks == 0) num_chunks = 1;
+            size_t max_size = fmt.max_size();
+
+            std::vector<uint32_t> c_sizes;
+            std::vector<uint32_t> d_sizes;
+            if (mode == ZSTD) {
+                c_sizes.resize(num_chunks);
+                d_sizes.resize(num_chunks);
+            }
+
+            std::atomic<bool> failed { false };
+            ProgressTracker_* progress = current_progress_();
+            ParallelTeam_ team;
+            // Chunks are formatted and compressed by whichever task claims
+            // them, and written in order
+            LoopChunks_ chunks { 0, num_chunks, 1 };
+            OrderedTurns_ turns;
+            team.run([&](size_t) {
+                std::vector<char> buf(std::min(count, chunk_size)*max_size);
+                std::vector<char> cbuf;
+                ChunkCompressor_ comp { mode };
+                size_t chunk, chunk_stop;
+                while (chunks.next(chunk, chunk_stop)) {
+                    // Once cancelled, the remaining chunks are skipped,
+                    // though they still take their turns
+                    if (progress && progress->cancelled()) {
+                        turns.wait(chunk);
+                        turns.done();
+                        continue;
+                    }
+                    size_t start = chunk*chunk_size;
+                    size_t end = std::min(start + chunk_size, count);
+                    FilePos fp = buf.data();
+                    for (size_t i = start; i < end; ++i)
+                        fmt.write(fp, i);
+                    size_t size = fp - buf.data();
+                    const char* chunk_out = buf.data();
+
+                    if (comp.compressing()) {
+                        size_t c_size = comp.compress(buf.data(), size, cbuf);
+                        if (c_size == 0)
+                            failed = true;
+                        if (mode == ZSTD) {
+                            c_sizes[chunk] = c_size;
+                            d_sizes[chunk] = size;
+                        }
+                        chunk_out = cbuf.data();
+                        size = c_size;
+                    }
+
+                    turns.wait(chunk);
+                    if (!failed) {
+                        try {
+                            out.write(chunk_out, size);
+                        } catch (...) {
+                            failed = true;
+                        }
+                    }
+                    turns.done();
+                    if (progress) progress->update(size, end-start);
+                }
+            });
+            if (failed) throw Error("PIGO: Unable to write to stream");
+            if (progress && progress->cancelled()) return;
+
+            if (mode == ZSTD)
+                out.write(zstd_seek_table_(c_sizes, d_sizes));
+        }
+
+        /** @brief Write formatted entries into a new ASCII file
+         *
+         * Fmt must provide size(i), returning the bytes needed for entry
+         * i, write(fp, i), writing it, and max_size(), an upper bound on
+         * the size of any entry.
+         *
+         * @param fn the file name to write
+         * @param count the number of entries to write
+         * @param fmt the formatter for the entries
+         * @param mode the WriteMode to use
+         * @param name the name of the write's phase, such as coo.write
+         */
+        template<class Fmt>
+        inline
+        void write_ascii_file_(std::string fn, size_t count, Fmt& fmt, WriteMode mode,
+                const char* name="write") {
+            PhaseTimer_ phase { name };
+            phase.add_items(count);
+            ProgressTracker_ progress { name, 0, count };
+            progress.throw_if_cancelled();
+            if (mode == STREAM || mode == GZIP || mode == ZSTD) {
+                ChunkCompressor_::check_mode(mode);
+                {
+                    WStream out { fn };
+                    write_ascii_stream_(out, count, fmt, mode);
+                    out.flush();
+                }
+                // Partial output is removed, unless it went to a pipe
+                if (progress.cancelled()) {
+                    if (fn != "-") std::remove(fn.c_str());
+                    progress.throw_if_cancelled();
+                }
+                progress.finish();
+                return;
+            }
+
+            // Get the number of threads
+            detail::ParallelTeam_ team;
+            size_t num_threads = team.size();
+
+            std::vector<size_t> pos_offsets(num_threads+1);
+            std::vector<FormatBuffer_> bufs;
+            if (mode == BUFFERED)
+                bufs.resize(num_threads);
+            std::shared_ptr<File> f;
+            // Both passes count the entries, and the file is only created
+            // if the first completed
+            progress.add_totals(0, count);
+            PhaseTimer_ size_phase { name, (mode == BUFFERED) ? "format" : "size", false };
+            PhaseTimer_ fill_phase { name, (mode == BUFFERED) ? "copy" : "fill", false };
+            size_phase.add_items(count);
+            fill_phase.add_items(count);
+            team.run([&](size_t tid) {
+                size_t start = (tid*count)/num_threads;
+                size_t end = ((tid+1)*count)/num_threads;
+                size_phase.thread_start();
+
+                // Either format everything once, or simulate writing
+                // and only compute the space taken
+                size_t my_size = 0;
+                for (size_t c_start = start; c_start < end; c_start += progress_chunk_) {
+                    size_t c_end = std::min(c_start + progress_chunk_, end);
+                    if (mode == BUFFERED)
+                        format_range_(fmt, c_start, c_end, bufs[tid]);
+                    else {
+                        for (size_t i = c_start; i < c_end; ++i)
+                            my_size += fmt.size(i);
+                    }
+                    if (progress.update(0, c_end - c_start)) break;
+                }
+                if (mode == BUFFERED)
+                    my_size = bufs[tid].size();
+
+                pos_offsets[tid+1] = my_size;
+                size_phase.thread_stop();
+            });
+
+            // Compute the total size and perform a prefix sum
+            pos_offsets[0] = 0;
+            for (size_t thread = 1; thread <= num_threads; ++thread)
+                pos_offsets[thread] = pos_offsets[thread-1] + pos_offsets[thread];
+            size_phase.add_bytes(pos_offsets[num_threads]);
+            size_phase.stop();
+
+            // Allocate the file
+            bool stop = progress.cancelled();
+            bool failed = false;
+            {
+                PhaseTimer_ create_phase { name, "create" };
+                create_phase.add_bytes(pos_offsets[num_threads]);
+                try {
+                    if (!stop) f = create_file_(fn, pos_offsets[num_threads]);
+                } catch (...) {
+                    failed = true;
+                }
+            }
+
+            if (!failed && !stop) team.run([&](size_t tid) {
+                size_t start = (tid*count)/num_threads;
+                size_t end = ((tid+1)*count)/num_threads;
+                size_t my_size = pos_offsets[tid+1] - pos_offsets[tid];
+                fill_phase.thread_start();
+                if (my_size > 0) {
+                    FilePos my_fp = f->fp()+pos_offsets[tid];
+                    if (mode == BUFFERED) {
+                        // Place the formatted output and release it
+                        bufs[tid].copy_to((WFilePos)my_fp);
+                        bufs[tid].clear();
+                        progress.update(my_size, end - start);
+                    } else {
+                        // Perform the second pass, actually writing out
+                        for (size_t c_start = start; c_start < end; c_start += progress_chunk_) {
+                            size_t c_end = std::min(c_start + progress_chunk_, end);
+                            FilePos c_fp = my_fp;
+                            for (size_t i = c_start; i < c_end; ++i)
+                                fmt.write(my_fp, i);
+                            if (progress.update(my_fp - c_fp, c_end - c_start)) break;
+                        }
+                    }
+                }
+                fill_phase.thread_stop();
+            });
+            fill_phase.add_bytes(pos_offsets[num_threads]);
+            fill_phase.stop();
+            phase.add_bytes(pos_offsets[num_threads]);
+            if (failed) throw Error("PIGO: Unable to create the output file");
+            if (progress.cancelled()) {
+                // Unmap the partial file before removing it
+                bool created = (bool)f;
+                f.reset();
+                if (created) std::remove(fn.c_str());
+                progress.throw_if_cancelled();
+            }
+            progress.finish();
+        }
+
+        template<class Fmt>
+        inline
+        void write_gz_shards_(const std::vector<std::string>& fns,
+                const std::string& header, const std::vector<size_t>& bounds,
+                Fmt& fmt) {
+            #ifdef PIGO_HAVE_ZLIB
+            // Each file is compressed independently by a single thread,
+            // formatting blocks of entries into a local buffer
+            const size_t block_size = 1<<22;
+            std::atomic<bool> failed { false };
+            ParallelTeam_ team;
+            team.for_each(0, fns.size(), 1, [&](size_t file) {
+                gzFile gz = gzopen(fns[file].c_str(), "wb");
+                if (gz == NULL) {
+                    failed = true;
+                    return;
+                }
+                gzbuffer(gz, block_size);
+                bool ok = (header.size() == 0) ||
+                    (gzwrite(gz, header.data(), header.size()) > 0);
+
+                std::vector<char> buf(block_size);
+                size_t used = 0;
+                for (size_t i = bounds[file]; ok && i < bounds[file+1]; ++i) {
+                    size_t i_size = fmt.size(i);
+                    if (used + i_size > buf.size()) {
+                        if (used > 0 && gzwrite(gz, buf.data(), used) <= 0)
+                            ok = false;
+                        used = 0;
+                        if (i_size > buf.size()) buf.resize(i_size);
+                    }
+                    FilePos fp = buf.data() + used;
+                    fmt.write(fp, i);
+                    used += i_size;
+                }
+                if (ok && used > 0 && gzwrite(gz, buf.data(), used) <= 0)
+                    ok = false;
+                if (gzclose(gz) != Z_OK) ok = false;
+                if (!ok)
+                    failed = true;
+            });
+            if (failed) throw Error("PIGO: Unable to write gzip files");
+            #else
+            (void)fns;
+            (void)header;
+            (void)bounds;
+            (void)fmt;
+            throw Error("PIGO: compiled without zlib, unable to gzip (define PIGO_HAVE_ZLIB)");
+            #endif
+        }
+
+        template<class Fmt>
+        inline
+        void write_shards_(const std::vector<std::string>& fns,
+                const std::string& header, const std::vector<size_t>& bounds,
+                Fmt& fmt, bool gzip) {
+            if (gzip) {
+                write_gz_shards_(fns, header, bounds, fmt);
+                return;
+            }
+
+            // Get the number of threads
+            detail::ParallelTeam_ team;
+            size_t num_threads = team.size();
+
+            // Writing occurs in two passes over pieces, with each file
+            // split into one piece per thread. This keeps all threads busy
+            // regardless of how many or how large the files are.
+            size_t num_files = fns.size();
+            size_t num_pieces = num_files*num_threads;
+            std::vector<size_t> piece_pos(num_pieces);
+
+            // First, compute the size of each piece
+            team.for_each(0, num_pieces, 1, [&](size_t piece) {
+                size_t file = piece / num_threads;
+                size_t file_piece = piece % num_threads;
+                size_t count = bounds[file+1]-bounds[file];
+                size_t start = bounds[file] + (file_piece*count)/num_threads;
+                size_t end = bounds[file] + ((file_piece+1)*count)/num_threads;
+
+                size_t my_size = 0;
+                for (size_t i = start; i < end; ++i)
+                    my_size += fmt.size(i);
+                piece_pos[piece] = my_size;
+            });
+
+            // Turn the sizes into positions inside of each file
+            std::vector<size_t> file_sizes(num_files);
+            for (size_t file = 0; file < num_files; ++file) {
+                size_t pos = header.size();
+                for (size_t piece = file*num_threads; piece < (file+1)*num_threads; ++piece) {
+                    size_t piece_size = piece_pos[piece];
+                    piece_pos[piece] = pos;
+                    pos += piece_size;
+                }
+                file_sizes[file] = pos;
+            }
+
+            // Create all of the files, writing their headers
+            std::vector<std::shared_ptr<File>> files(num_files);
+            std::atomic<bool> failed { false };
+            team.for_each(0, num_files, 1, [&](size_t file) {
+                try {
+                    files[file] = create_file_(fns[file], file_sizes[file]);
+                    if (files[file]) files[file]->write(header);
+                } catch (...) {
+                    failed = true;
+                }
+            });
+            if (failed) throw Error("PIGO: Unable to create the output files");
+
+            // Finally, write out every piece
+            team.for_each(0, num_pieces, 1, [&](size_t piece) {
+                size_t file = piece / num_threads;
+                size_t file_piece = piece % num_threads;
+                size_t count = bounds[file+1]-bounds[file];
+                size_t start = bounds[file] + (file_piece*count)/num_threads;
+                size_t end = bounds[file] + ((file_piece+1)*count)/num_threads;
+                if (start == end) return;
+
+                FilePos fp = files[file]->fp() + piece_pos[piece] - header.size();
+                for (size_t i = start; i < end; ++i)
+                    fmt.write(fp, i);
+            });
+        }
+    }
+
     namespace detail {
         template <bool wgt, class W, class O>
         struct weight_size_i_ {
@@ -0,0 +1,164 @@
+/**
+ * PIGO: a parallel graph and matrix I/O and preprocessing library
+ * Copyright (c) 2022 GT-TDALab
+ *
+ * This file contains the implementation of progress reporting and
+ * cooperative cancellation
+ */
+
+#include <chrono>
+
+namespace pigo {
+
+    namespace detail {
+
+        /** @brief Return the calling thread's innermost monitor */
+        inline
+        ProgressMonitor*& current_monitor_() {
+            thread_local ProgressMonitor* monitor = nullptr;
+            return monitor;
+        }
+
+        /** @brief Return the calling thread's current tracker slot */
+        inline
+        ProgressTracker_*& current_tracker_() {
+            thread_local ProgressTracker_* tracker = nullptr;
+            return tracker;
+        }
+
+        inline
+        ProgressTracker_* current_progress_() {
+            return current_tracker_();
+        }
+
+        /** @brief Return the seconds on a steady clock */
+        inline
+        double progress_now_() {
+            std::chrono::duration<double> since =
+                std::chrono::steady_clock::now().time_since_epoch();
+            return since.count();
+        }
+
+        inline
+        ProgressTracker_::ProgressTracker_(const char* operation, size_t total_bytes,
+                size_t total_items) :
+                monitor_(current_monitor_()), outer_(nullptr),
+                total_bytes_(total_bytes), total_items_(total_items),
+                start_(0.), next_(0.) {
+            if (!monitor_) return;
+            operation_ = operation;
+            size_t num_threads = context_threads_();
+            counts_ = std::vector<Counts_>(num_threads);
+            for (Counts_& c : counts_) {
+                c.bytes.store(0, std::memory_order_relaxed);
+                c.items.store(0, std::memory_order_relaxed);
+            }
+            start_ = progress_now_();
+            next_.store(start_ + monitor_->interval_);
+            outer_ = current_tracker_();
+            current_tracker_() = this;
+        }
+
+        inline
+        ProgressTracker_::~ProgressTracker_() {
+            if (monitor_) current_tracker_() = outer_;
+        }
+
+        inline
+        void ProgressTracker_::add_totals(size_t bytes, size_t items) {
+            total_bytes_.fetch_add(bytes, std::memory_order_relaxed);
+            total_items_.fetch_add(items, std::memory_order_relaxed);
+        }
+
+        inline
+        bool update_read_progress_(ProgressTracker_* progress, FilePos& last,
+                FilePos pos, size_t items) {
+            if (!progress) return false;
+            bool cancelled = progress->update(pos - last, items);
+            last = pos;
+            return cancelled;
+        }
+
+        inline
+        bool ProgressTracker_::update(size_t bytes, size_t items) {
+            if (!monitor_) return false;
+            size_t tid = task_id_();
+            // Only the owning task writes its counts
+            Counts_& c = counts_[tid % counts_.size()];
+            c.bytes.store(c.bytes.load(std::memory_order_relaxed) + bytes,
+                    std::memory_order_relaxed);
+            c.items.store(c.items.load(std::memory_order_relaxed) + items,
+                    std::memory_order_relaxed);
+
+            double now = progress_now_();
+            double next = next_.load(std::memory_order_relaxed);
+            if (now >= next && next_.compare_exchange_strong(next,
+                        now + monitor_->interval_))
+                report_(false);
+            return monitor_->cancelled();
+        }
+
+        inline
+        void ProgressTracker_::report_(bool done) {
+            if (!monitor_->callback_ || monitor_->cancelled()) return;
+            Progress p;
+            p.operation = operation_;
+            for (Counts_& c : counts_) {
+                p.bytes += c.bytes.load(std::memory_order_relaxed);
+                p.items += c.items.load(std::memory_order_relaxed);
+            }
+            p.total_bytes = total_bytes_.load(std::memory_order_relaxed);
+            p.total_items = total_items_.load(std::memory_order_relaxed);
+            if (done) {
+                // Parts that were not counted in chunks are complete too
+                if (p.total_bytes > 0) p.bytes = p.total_bytes;
+                if (p.total_items > 0) p.items = p.total_items;
+            }
+            p.seconds = progress_now_() - start_;
+            p.done = done;
+
+            std::lock_guard<std::mutex> lock { monitor_->mutex_ };
+            // Another task may have cancelled while this one was waiting
+            if (monitor_->cancelled()) return;
+            bool keep_going = false;
+            try {
+                keep_going = monitor_->callback_(p);
+            } catch (...) {
+                // Exceptions cannot leave a parallel region, so stop instead
+            }
+            if (!keep_going) monitor_->cancel();
+        }
+
+        inline
+        void ProgressTracker_::throw_if_cancelled() const {
+            if (cancelled())
+                throw Cancelled("PIGO: " + operation_ + " was cancelled");
+        }
+
+        inline
+        void ProgressTracker_::finish() {
+            if (monitor_) report_(true);
+        }
+
+    }
+
+    inline
+    double Progress::fraction() const {
+        if (total_bytes > 0) return (double)bytes / total_bytes;
+        if (total_items > 0) return (double)items / total_items;
+        return 0.;
+    }
+
+    inline
+    ProgressMonitor::ProgressMonitor(Callback callback, double interval) :
+            callback_(callback), interval_(interval), cancelled_(false),
+            outer_(detail::current_monitor_()) {
+        detail::current_monitor_() = this;
+    }
+
+    inline
+    ProgressMonitor::~ProgressMonitor() {
+        detail::current_monitor_() = outer_;
+    }
+
+}
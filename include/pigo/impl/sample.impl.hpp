@@ -0,0 +1,285 @@
+/**
+ * PIGO: a parallel graph and matrix I/O and preprocessing library
+ * Copyright (c) 2022 GT-TDALab
+ *
+ * This file contains the implementation of estimating file statistics
+ * from a sample of windows
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace pigo {
+
+    namespace detail {
+
+        /** The z-score of a two-sided 95% confidence interval */
+        constexpr double sample_z_ = 1.96;
+
+        /** @brief Holds what was found in one sampled window */
+        struct SampleWindow_ {
+            /** The number of bytes in the window */
+            size_t bytes = 0;
+            /** The number of lines starting in the window */
+            size_t lines = 0;
+            /** The entries of the window, in file order */
+            std::vector<std::pair<uint64_t, uint64_t>> entries;
+        };
+
+        /** @brief Parse the lines starting in [begin, end) of the data
+         *
+         * @param data the start of the sampled region
+         * @param size the size of the sampled region
+         * @param begin the offset of the window
+         * @param end one past the last offset of the window
+         * @param w the window to fill
+         */
+        inline
+        void sample_window_(FilePos data, size_t size, size_t begin,
+                size_t end, SampleWindow_& w) {
+            w.bytes = end - begin;
+            FilePos pos = data + begin;
+            FilePos data_end = data + size;
+            // Lines belong to the window their first character is in
+            if (begin > 0 && *(pos-1) != '\n') {
+                pos = (FilePos)memchr(pos, '\n', data_end - pos);
+                pos = (pos == nullptr) ? data_end : pos + 1;
+            }
+            while (pos < data + end) {
+                FilePos line_end = (FilePos)memchr(pos, '\n', data_end - pos);
+                if (line_end == nullptr) line_end = data_end;
+                ++w.lines;
+
+                FileReader r { pos, line_end };
+                r.skip_space_tab();
+                if (r.good() && *r.d >= '0' && *r.d <= '9') {
+                    uint64_t x = r.read_int<uint64_t>();
+                    if (!r.at_end_of_line()) {
+                        uint64_t y = r.read_int<uint64_t>();
+                        w.entries.emplace_back(x, y);
+                    }
+                }
+                pos = line_end + 1;
+            }
+        }
+
+        /** @brief Estimate a total from per-window counts with a ratio
+         *
+         * @param counts the count in each window
+         * @param bytes the bytes in each window
+         * @param total_bytes the size of the sampled region
+         * @param exact whether the windows covered the region
+         * @return the estimated total with its bounds
+         */
+        inline
+        Estimate ratio_estimate_(const std::vector<size_t>& counts,
+                const std::vector<size_t>& bytes, size_t total_bytes, bool exact) {
+            size_t k = counts.size();
+            double sum_c = 0., sum_b = 0.;
+            for (size_t i = 0; i < k; ++i) {
+                sum_c += counts[i];
+                sum_b += bytes[i];
+            }
+            if (exact) return Estimate { sum_c, sum_c, sum_c };
+            double ratio = (sum_b > 0) ? sum_c / sum_b : 0.;
+            double value = ratio * total_bytes;
+            if (k < 2) return Estimate { value, sum_c, value };
+
+            double ss = 0.;
+            for (size_t i = 0; i < k; ++i) {
+                double resid = counts[i] - ratio*bytes[i];
+                ss += resid*resid;
+            }
+            double mean_b = sum_b / k;
+            double fpc = 1. - sum_b / total_bytes;
+            if (fpc < 0.) fpc = 0.;
+            double se = std::sqrt(ss / (k-1) / k * fpc) / mean_b;
+            double half = sample_z_ * se * total_bytes;
+            return Estimate { value, std::max(value - half, sum_c), value + half };
+        }
+
+        /** @brief Estimate a proportion with the Wilson score interval
+         *
+         * @param hits the number of sampled items with the property
+         * @param n the number of sampled items
+         * @param exact whether the sample is the whole population
+         * @return the estimated proportion with its bounds
+         */
+        inline
+        Estimate proportion_estimate_(size_t hits, size_t n, bool exact) {
+            if (n == 0) return Estimate { 0., 0., 1. };
+            double p = (double)hits / n;
+            if (exact) return Estimate { p, p, p };
+            double z2 = sample_z_*sample_z_;
+            double denom = 1. + z2/n;
+            double center = (p + z2/(2*n)) / denom;
+            double half = sample_z_ / denom * std::sqrt(p*(1-p)/n + z2/(4.*n*n));
+            return Estimate { p, std::max(0., center - half), std::min(1., center + half) };
+        }
+
+        /** @brief Add a degree to a log2 histogram */
+        inline
+        void add_degree_(std::vector<size_t>& hist, double degree) {
+            size_t bucket = 0;
+            while (degree >= 2. && bucket < 63) {
+                degree /= 2.;
+                ++bucket;
+            }
+            if (hist.size() <= bucket) hist.resize(bucket+1, 0);
+            ++hist[bucket];
+        }
+
+    }
+
+    inline
+    SampleStats sample(std::string fn, size_t num_windows, size_t window_size,
+            uint64_t seed) {
+        if (num_windows == 0 || window_size == 0)
+            throw Error("PIGO: Sampling needs at least one non-empty window");
+
+        ROFile f { fn };
+        FileReader r = f.reader();
+        SampleStats stats;
+        stats.file_size = r.size();
+
+        // Matrix market headers are not entries, so sample after them
+        if (r.at_str("%%MatrixMarket")) {
+            r.skip_comments();
+            r.move_to_eol();
+            if (r.good()) ++r.d;
+        }
+        FilePos data = r.d;
+        size_t size = r.size();
+
+        // Sample one window from each stratum, or cover everything if the
+        // windows are at least as large as the file
+        stats.exact = (size <= num_windows*window_size);
+        if (stats.exact && size < num_windows) num_windows = (size > 0) ? size : 1;
+        std::vector<size_t> starts(num_windows), ends(num_windows);
+        std::mt19937_64 gen { seed };
+        for (size_t i = 0; i < num_windows; ++i) {
+            size_t stratum_start = size / num_windows * i;
+            size_t stratum_end = (i+1 == num_windows) ? size : size / num_windows * (i+1);
+            if (stats.exact) {
+                starts[i] = stratum_start;
+                ends[i] = stratum_end;
+            } else {
+                size_t slack = stratum_end - stratum_start - window_size;
+                starts[i] = stratum_start + gen() % (slack + 1);
+                ends[i] = starts[i] + window_size;
+            }
+        }
+
+        std::vector<detail::SampleWindow_> windows(num_windows);
+        detail::ParallelTeam_ team;
+        team.for_each(0, num_windows, 1, [&](size_t i) {
+            detail::sample_window_(data, size, starts[i], ends[i], windows[i]);
+        });
+
+        // Count what the windows found
+        std::vector<size_t> lines(num_windows), entries(num_windows), bytes(num_windows);
+        std::vector<std::pair<uint64_t, uint64_t>> all;
+        uint64_t max_label = 0;
+        size_t self_loops = 0;
+        size_t in_order = 0;
+        size_t adjacent = 0;
+        stats.bytes_sampled = 0;
+        stats.lines_sampled = 0;
+        for (size_t i = 0; i < num_windows; ++i) {
+            auto& w = windows[i];
+            lines[i] = w.lines;
+            entries[i] = w.entries.size();
+            bytes[i] = w.bytes;
+            stats.bytes_sampled += w.bytes;
+            stats.lines_sampled += w.lines;
+            for (size_t e = 0; e < w.entries.size(); ++e) {
+                auto& entry = w.entries[e];
+                max_label = std::max(max_label, std::max(entry.first, entry.second));
+                if (entry.first == entry.second) ++self_loops;
+                if (e > 0) {
+                    ++adjacent;
+                    if (w.entries[e-1].first <= entry.first) ++in_order;
+                }
+            }
+            all.insert(all.end(), w.entries.begin(), w.entries.end());
+        }
+        stats.windows = num_windows;
+        stats.entries_sampled = all.size();
+        size_t n = all.size();
+
+        stats.lines = detail::ratio_estimate_(lines, bytes, size, stats.exact);
+        stats.entries = detail::ratio_estimate_(entries, bytes, size, stats.exact);
+        stats.self_loop_rate = detail::proportion_estimate_(self_loops, n, stats.exact);
+
+        // For labels uniform in [0, N], the sampled maximum falls below
+        // N*0.05^(1/s) with probability 0.05 for s sampled labels
+        double observed_max = (double)max_label;
+        if (stats.exact || n == 0)
+            stats.max_label = Estimate { observed_max, observed_max, observed_max };
+        else {
+            double s = 2.*n;
+            stats.max_label = Estimate { observed_max*(1. + 1./s), observed_max,
+                observed_max / std::pow(0.05, 1./s) };
+        }
+
+        std::sort(all.begin(), all.end());
+        size_t dups = 0;
+        for (size_t e = 1; e < n; ++e)
+            if (all[e] == all[e-1]) ++dups;
+        stats.duplicate_rate = detail::proportion_estimate_(dups, n, stats.exact);
+
+        // Degrees are counted directly when rows are contiguous in the file,
+        // and otherwise extrapolated from the sampled fraction
+        stats.rows_grouped = (adjacent > 0 && in_order >= adjacent - adjacent/100);
+        double max_count = 0.;
+        bool truncated = false;
+        if (stats.exact || !stats.rows_grouped) {
+            double scale = stats.exact ? 1. : (double)size / stats.bytes_sampled;
+            for (size_t e = 0; e < n; ) {
+                size_t run = e;
+                while (run < n && all[run].first == all[e].first) ++run;
+                double count = (double)(run - e);
+                max_count = std::max(max_count, count);
+                detail::add_degree_(stats.degree_histogram, count*scale);
+                e = run;
+            }
+            double value = max_count*scale;
+            if (stats.exact)
+                stats.max_degree = Estimate { value, value, value };
+            else {
+                double half = detail::sample_z_ * std::sqrt(max_count);
+                stats.max_degree = Estimate { value, std::max(max_count, (max_count - half)*scale),
+                    (max_count + half)*scale };
+            }
+        } else {
+            // Runs cut by a window boundary only bound their degree
+            for (auto& w : windows) {
+                size_t wn = w.entries.size();
+                for (size_t e = 0; e < wn; ) {
+                    size_t run = e;
+                    while (run < wn && w.entries[run].first == w.entries[e].first) ++run;
+                    double count = (double)(run - e);
+                    bool cut = (e == 0 || run == wn);
+                    if (count > max_count) {
+                        max_count = count;
+                        truncated = cut;
+                    }
+                    if (!cut || (e == 0 && run == wn))
+                        detail::add_degree_(stats.degree_histogram, count);
+                    e = run;
+                }
+            }
+            stats.max_degree = Estimate { max_count, max_count,
+                truncated ? std::max(max_count, stats.entries.high) : max_count };
+        }
+
+        return stats;
+    }
+
+}
@@ -4,11 +4,10 @@
  * Copyright (c) 2023 Kasimir Gabert
  */
 
-#ifdef _OPENMP
-#include <omp.h>
-#endif
 #include <atomic>
 #include <vector>
+#include <algorithm>
+#include <limits>
 #include <type_traits>
 
 namespace pigo {
@@ -31,6 +30,10 @@ namespace pigo {
 
     template<class L, class O, class S, class W, class WS, bool wgt>
     void Tensor<L,O,S,W,WS,wgt>::read_(File& f, FileType ft) {
+        detail::PhaseTimer_ phase { "tensor.read" };
+        phase.add_bytes(f.size());
+        detail::ProgressTracker_ progress { "tensor.read", f.size() };
+        progress.throw_if_cancelled();
         FileType ft_used = ft;
         // If the file type is AUTO, then try to detect it
         if (ft_used == AUTO) {
@@ -45,12 +48,21 @@ namespace pigo {
         } else {
             throw NotYetImplemented("Unknown file format");
         }
+        // The parallel steps stop early once cancelled
+        if (progress.cancelled()) {
+            free();
+            progress.throw_if_cancelled();
+        }
+        progress.finish();
+        phase.add_items(m_);
     }
 
     template<class L, class O, class S, class W, class WS, bool wgt>
     void Tensor<L,O,S,W,WS,wgt>::allocate_() {
-        detail::allocate_mem_<S>(c_, order_*m_);
-        detail::allocate_mem_<WS,wgt>(w_, m_);
+        detail::check_alloc_(sizeof(L)*order_*m_ + detail::weight_size_<wgt, W, O>(m_),
+                "tensor");
+        detail::allocate_mem_<S>(c_, order_*m_, "tensor");
+        detail::allocate_mem_<WS,wgt>(w_, m_, "tensor");
     }
 
     namespace detail {
@@ -103,17 +115,8 @@ namespace pigo {
     template<class L, class O, class S, class W, class WS, bool wgt>
     void Tensor<L,O,S,W,WS,wgt>::read_el_(FileReader& r) {
         // Get the number of threads
-        size_t num_threads = 1;
-        #ifdef _OPENMP
-        omp_set_dynamic(0);
-        #pragma omp parallel shared(num_threads)
-        {
-            #pragma omp single
-            {
-                num_threads = omp_get_num_threads();
-            }
-        }
-        #endif
+        detail::ParallelTeam_ team;
+        size_t num_threads = team.size();
 
         // Find the order by reading the first line
         auto first_line = r;
@@ -129,23 +132,18 @@ namespace pigo {
 
         std::vector<size_t> nl_offsets(num_threads);
 
-        #pragma omp parallel
-        {
-            #ifdef _OPENMP
-            size_t tid = omp_get_thread_num();
-            #else
-            size_t tid = 0;
-            #endif
-
-            // Find our offsets in the file
+        // Both passes read the whole input
+        detail::ProgressTracker_* progress = detail::current_progress_();
+        if (progress) progress->add_totals(r.size(), 0);
+        // Each task reads its own part of the file, moved off of
+        // overlapping entries
+        auto task_reader = [&](size_t tid) {
             size_t size = r.size();
             size_t tid_start_i = (tid*size)/num_threads;
             size_t tid_end_i = ((tid+1)*size)/num_threads;
             FileReader rs = r + tid_start_i;
             FileReader re = r + tid_end_i;
 
-            // Now, move to the appropriate starting point to move off of
-            // overlapping entries
             re.move_to_eol();
             re.move_to_next_int();
             if (tid != 0) {
@@ -157,48 +155,72 @@ namespace pigo {
             // Set our file reader to end either at the full end or at
             // the thread id local end
             rs.smaller_end(re);
+            return rs;
+        };
 
-            // Pass 1
-            // Iterate through, counting the number of newlines
-            FileReader rs_p1 = rs;
+        // Pass 1
+        // Iterate through, counting the number of newlines
+        team.run([&](size_t tid) {
+            FileReader rs_p1 = task_reader(tid);
             size_t tid_nls = 0;
+            size_t since = 0;
+            FilePos last = rs_p1.d;
             while (rs_p1.good()) {
                 read_coord_entry_<true>(tid_nls, rs_p1);
+                if (++since == detail::progress_chunk_) {
+                    since = 0;
+                    if (detail::update_read_progress_(progress, last, rs_p1.d, 0)) break;
+                }
             }
+            detail::update_read_progress_(progress, last, rs_p1.d, 0);
 
             nl_offsets[tid] = tid_nls;
+        });
 
-            // Compute a prefix sum on the newline offsets
-            #pragma omp barrier
-            #pragma omp single
-            {
-                size_t sum_nl = 0;
-                for (size_t tid = 0; tid < num_threads; ++tid) {
-                    sum_nl += nl_offsets[tid];
-                    nl_offsets[tid] = sum_nl;
-                }
+        // Compute a prefix sum on the newline offsets
+        size_t sum_nl = 0;
+        for (size_t tid = 0; tid < num_threads; ++tid) {
+            sum_nl += nl_offsets[tid];
+            nl_offsets[tid] = sum_nl;
+        }
 
-                // Now, allocate the space appropriately
-                m_ = nl_offsets[num_threads-1];
-                allocate_();
-            }
-            #pragma omp barrier
+        // Counts are incomplete once cancelled, so nothing is allocated
+        // or parsed
+        m_ = 0;
+        if (progress && progress->cancelled()) return;
+
+        // Now, allocate the space appropriately
+        m_ = nl_offsets[num_threads-1];
+        try {
+            allocate_();
+        } catch (...) {
+            m_ = 0;
+            throw;
+        }
+        if (progress) progress->add_totals(0, m_);
 
-            // Pass 2
-            // Iterate through again, but now copying out the integers
-            FileReader rs_p2 = rs;
+        // Pass 2
+        // Iterate through again, but now copying out the integers
+        team.run([&](size_t tid) {
+            FileReader rs_p2 = task_reader(tid);
             size_t coord_pos = 0;
             if (tid > 0)
                 coord_pos = nl_offsets[tid-1];
 
+            size_t since = 0;
+            FilePos last = rs_p2.d;
             while (rs_p2.good()) {
                 read_coord_entry_<false>(coord_pos, rs_p2);
+                if (++since == detail::progress_chunk_) {
+                    if (detail::update_read_progress_(progress, last, rs_p2.d, since)) break;
+                    since = 0;
+                }
             }
-        }
+        });
     }
 
     template<class L, class O, class S, class W, class WS, bool wgt>
-    void Tensor<L,O,S,W,WS,wgt>::save(std::string fn) {
+    SaveStats Tensor<L,O,S,W,WS,wgt>::save(std::string fn, SaveMode mode, ChecksumMode checksum) {
         // Before creating the file, we need to find the size
         size_t out_size = 0;
         std::string cfh { tensor_file_header };
@@ -215,10 +237,14 @@ namespace pigo {
         size_t w_size = detail::weight_size_<wgt, W, O>(m_);
         out_size += w_size;
 
-        // Create the output file
-        WFile w {fn, out_size};
+        return detail::save_file_(*this, fn, out_size, mode, checksum, "tensor.save");
+    }
 
+    template<class L, class O, class S, class W, class WS, bool wgt>
+    template<class OutFile>
+    void Tensor<L,O,S,W,WS,wgt>::save_to_(OutFile& w) {
         // Output the PIGO Tensor file header
+        std::string cfh { tensor_file_header };
         w.write(cfh);
 
         // Output the template sizes
@@ -240,6 +266,7 @@ namespace pigo {
         size_t vc_size = sizeof(L)*order_*m_;
         w.parallel_write(vc, vc_size);
 
+        size_t w_size = detail::weight_size_<wgt, W, O>(m_);
         if (w_size > 0) {
             char* vw = detail::get_raw_data_<WS>(w_);
             w.parallel_write(vw, w_size);
@@ -248,6 +275,9 @@ namespace pigo {
 
     template<class L, class O, class S, class W, class WS, bool wgt>
     void Tensor<L,O,S,W,WS,wgt>::read_bin_(File& f) {
+        // Load any checksums, verifying the header and sizes
+        detail::ChecksumReader_ sums { f };
+
         // Read and confirm the header
         f.read(tensor_file_header);
 
@@ -274,131 +304,96 @@ namespace pigo {
         // Read out the vectors
         char* vc = detail::get_raw_data_<S>(c_);
         size_t vc_size = sizeof(L)*order_*m_;
-        f.parallel_read(vc, vc_size);
+        sums.parallel_read(f, vc, vc_size);
 
         size_t w_size = detail::weight_size_<wgt, W, O>(m_);
         if (w_size > 0) {
             char* vw = detail::get_raw_data_<WS>(w_);
-            f.parallel_read(vw, w_size);
+            sums.parallel_read(f, vw, w_size);
         }
     }
 
-    template<class L, class O, class S, class W, class WS, bool wgt>
-    void Tensor<L,O,S,W,WS,wgt>::write(std::string fn) {
-        // Writing occurs in two passes
-        // First, each thread will simulate writing and compute how the
-        // space taken
-        // After the first pass, the output file is allocated
-        // Second, each thread actually writes
-
-        // Get the number of threads
-        size_t num_threads = 1;
-        #ifdef _OPENMP
-        omp_set_dynamic(0);
-        #pragma omp parallel shared(num_threads)
-        {
-            #pragma omp single
-            {
-                num_threads = omp_get_num_threads();
-            }
-        }
-        #endif
-
-        std::vector<size_t> pos_offsets(num_threads+1);
-        std::shared_ptr<File> f;
-        #pragma omp parallel shared(f) shared(pos_offsets)
-        {
-            #ifdef _OPENMP
-            size_t tid = omp_get_thread_num();
-            #else
-            size_t tid = 0;
-            #endif
-            size_t my_size = 0;
-
-            #pragma omp for
-            for (O e = 0; e < m_; ++e) {
-                for (O idx = 0; idx < order_; ++idx) {
-                    auto x = detail::get_value_<S, L>(c_, e*order_+idx);
-                    my_size += write_size(x);
+    namespace detail {
+        /** @brief Formats Tensor entries as ASCII lines */
+        template<class L, class O, class S, bool wgt, class W, class WS>
+        struct tensor_line_fmt_ {
+            /** The order of the tensor */
+            O order;
+            /** The coordinates */
+            S& c;
+            /** The weights */
+            WS& w;
+
+            size_t size(size_t e) {
+                size_t res = 0;
+                for (O idx = 0; idx < order; ++idx) {
+                    res += write_size(get_value_<S, L>(c, e*order+idx));
                     // Account for the separating space or newline
-                    my_size += 1;
+                    res += 1;
                 }
-
-                if (detail::if_true_<wgt>()) {
+                if (if_true_<wgt>()) {
                     // Account for the separating space
-                    my_size += 1;
-
-                    auto w = detail::get_value_<WS, W>(w_, e);
-                    my_size += write_size(w);
+                    res += 1 + write_size(get_value_<WS, W>(w, e));
                 }
+                return res;
             }
 
-            pos_offsets[tid+1] = my_size;
-            #pragma omp barrier
-
-            #pragma omp single
-            {
-                // Compute the total size and perform a prefix sum
-                pos_offsets[0] = 0;
-                for (size_t thread = 1; thread <= num_threads; ++thread)
-                    pos_offsets[thread] = pos_offsets[thread-1] + pos_offsets[thread];
-
-                // Allocate the file
-                f = std::make_shared<File>(fn, WRITE, pos_offsets[num_threads]);
+            void write(FilePos& fp, size_t e) {
+                for (O idx = 0; idx < order; ++idx) {
+                    write_ascii(fp, get_value_<S, L>(c, e*order+idx));
+                    if (idx < order-1)
+                        pigo::write(fp, ' ');
+                }
+                if (if_true_<wgt>()) {
+                    pigo::write(fp, ' ');
+                    write_ascii(fp, get_value_<WS, W>(w, e));
+                }
+                pigo::write(fp, '\n');
             }
 
-            #pragma omp barrier
+            size_t max_size() {
+                size_t res = order*(max_write_size<L>() + 1);
+                if (if_true_<wgt>())
+                    res += max_write_size<W>() + 1;
+                return res;
+            }
+        };
+    }
 
-            FilePos my_fp = f->fp()+pos_offsets[tid];
+    template<class L, class O, class S, class W, class WS, bool wgt>
+    void Tensor<L,O,S,W,WS,wgt>::write(std::string fn, WriteMode mode) {
+        detail::tensor_line_fmt_<L,O,S,wgt,W,WS> fmt { order_, c_, w_ };
+        detail::write_ascii_file_(fn, m_, fmt, mode, "tensor.write");
+    }
 
-            // Perform the second pass, actually writing out to the file
-            #pragma omp for
-            for (O e = 0; e < m_; ++e) {
-                for (O idx = 0; idx < order_; ++idx) {
-                    auto x = detail::get_value_<S, L>(c_, e*order_+idx);
-                    write_ascii(my_fp, x);
-                    if (idx < order_-1)
-                        pigo::write(my_fp, ' ');
-                }
-                if (detail::if_true_<wgt>()) {
-                    pigo::write(my_fp, ' ');
-                    auto w = detail::get_value_<WS, W>(w_, e);
-                    write_ascii(my_fp, w);
-                }
-                pigo::write(my_fp, '\n');
-            }
-        }
+    template<class L, class O, class S, class W, class WS, bool wgt>
+    void Tensor<L,O,S,W,WS,wgt>::write(WStream& out, WriteMode mode) {
+        detail::tensor_line_fmt_<L,O,S,wgt,W,WS> fmt { order_, c_, w_ };
+        detail::PhaseTimer_ phase { "tensor.write" };
+        phase.add_items(m_);
+        detail::ProgressTracker_ progress { "tensor.write", 0, (size_t)m_ };
+        progress.throw_if_cancelled();
+        detail::write_ascii_stream_(out, m_, fmt, mode);
+        // What was written before cancelling stays in the stream
+        progress.throw_if_cancelled();
+        progress.finish();
     }
 
     template<class L, class O, class S, class W, class WS, bool wgt>
     std::vector<L> Tensor<L,O,S,W,WS,wgt>::max_labels() const {
         // Get the number of threads
-        size_t num_threads = 1;
-        #ifdef _OPENMP
-        omp_set_dynamic(0);
-        #pragma omp parallel shared(num_threads)
-        {
-            #pragma omp single
-            {
-                num_threads = omp_get_num_threads();
-            }
-        }
-        #endif
+        detail::ParallelTeam_ team;
+        size_t num_threads = team.size();
 
         std::vector<L*> maxes(num_threads);
-        #pragma omp parallel
-        {
-            #ifdef _OPENMP
-            size_t tid = omp_get_thread_num();
-            #else
-            size_t tid = 0;
-            #endif
+        team.run([&](size_t tid) {
             L* my_maxes = new L[order_];
             for (O idx = 0; idx < order_; ++idx) my_maxes[idx] = 0;
 
             const L* c = (const L*)detail::get_const_data_<S>(c_);
-            #pragma omp for
-            for (O e = 0; e < m_; ++e) {
+            O e_start = (tid*m_)/num_threads;
+            O e_end = ((tid+1)*m_)/num_threads;
+            for (O e = e_start; e < e_end; ++e) {
                 for (O idx = 0; idx < order_; ++idx) {
                     L val = c[e*order_+idx];
                     if (val > my_maxes[idx]) my_maxes[idx] = val;
@@ -406,7 +401,7 @@ namespace pigo {
             }
 
             maxes[tid] = my_maxes;
-        }
+        });
 
         std::vector<L> ret(order_);
         for (size_t tid = 0; tid < num_threads; ++tid) {
@@ -418,4 +413,32 @@ namespace pigo {
         return ret;
     }
 
+    template<class L, class O, class S, class W, class WS, bool wgt>
+    void Tensor<L,O,S,W,WS,wgt>::validate(bool sorted) const {
+        if (m_ > 0 && order_ == 0)
+            detail::invalid_("Tensor has entries without dimensions", 0);
+
+        const L* c = (const L*)detail::get_const_data_<S>(c_);
+        size_t order = order_;
+        size_t m = m_;
+        size_t num_coords = order*m;
+
+        typedef typename std::make_unsigned<L>::type UL;
+        const UL max_label = std::numeric_limits<L>::max();
+        size_t idx = detail::first_invalid_(num_coords, [&](size_t idx) {
+                return static_cast<UL>(c[idx]) <= max_label;
+            });
+        if (idx < num_coords)
+            detail::invalid_("Tensor coordinate is negative", idx / order);
+
+        if (sorted) {
+            size_t e = detail::first_invalid_(m, [&](size_t e) {
+                    return e == 0 || !std::lexicographical_compare(
+                            c + e*order, c + (e+1)*order,
+                            c + (e-1)*order, c + e*order);
+                });
+            if (e < m) detail::invalid_("Tensor entry is not sorted", e);
+        }
+    }
+
 }
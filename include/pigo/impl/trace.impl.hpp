@@ -0,0 +1,178 @@
+/**
+ * PIGO: a parallel graph and matrix I/O and preprocessing library
+ * Copyright (c) 2022 GT-TDALab
+ *
+ * This file contains the implementation of the timeline tracer
+ */
+
+#include <atomic>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace pigo {
+
+    namespace detail {
+
+        /** @brief One traced event */
+        struct TraceEvent_ {
+            std::string name;
+            double start;
+            double end;
+            size_t bytes;
+            size_t items;
+        };
+
+        /** @brief The events of one thread */
+        struct TraceBuffer_ {
+            size_t track;
+            /** Guards events, which waits are appended to once a step
+             *  has finished */
+            std::mutex mutex;
+            std::vector<TraceEvent_> events;
+        };
+
+        /** @brief The per-thread buffers and settings of the tracer */
+        struct TraceState_ {
+            std::atomic<bool> enabled { false };
+            /** Guards registering buffers, not appending to them */
+            std::mutex mutex;
+            std::vector<std::unique_ptr<TraceBuffer_>> buffers;
+        };
+
+        /** @brief Return the tracer state */
+        inline
+        TraceState_& trace_state_() {
+            static TraceState_ state;
+            return state;
+        }
+
+        /** @brief Return the calling thread's buffer, registering it once
+         *
+         * Buffers are owned by the tracer, so events outlive the threads
+         * that recorded them.
+         */
+        inline
+        TraceBuffer_& trace_buffer_() {
+            thread_local TraceBuffer_* buffer = nullptr;
+            if (buffer == nullptr) {
+                TraceState_& state = trace_state_();
+                std::lock_guard<std::mutex> lock { state.mutex };
+                state.buffers.emplace_back(new TraceBuffer_);
+                buffer = state.buffers.back().get();
+                buffer->track = state.buffers.size()-1;
+            }
+            return *buffer;
+        }
+
+        inline
+        void trace_event_(const std::string& name, double start, double end,
+                size_t bytes, size_t items) {
+            TraceEvent_ event { name, start, end, bytes, items };
+            TraceBuffer_& buffer = trace_buffer_();
+            std::lock_guard<std::mutex> lock { buffer.mutex };
+            buffer.events.push_back(std::move(event));
+        }
+
+        inline
+        TraceBuffer_* trace_track_() {
+            return &trace_buffer_();
+        }
+
+        inline
+        void trace_event_on_(TraceBuffer_* track, const std::string& name,
+                double start, double end) {
+            TraceEvent_ event { name, start, end, 0, 0 };
+            std::lock_guard<std::mutex> lock { track->mutex };
+            track->events.push_back(std::move(event));
+        }
+
+        /** @brief Write a string as a JSON string literal */
+        inline
+        void write_json_string_(std::ostream& out, const std::string& s) {
+            out << '"';
+            for (char c : s) {
+                if (c == '"' || c == '\\') out << '\\' << c;
+                else if ((unsigned char)c < 0x20) out << ' ';
+                else out << c;
+            }
+            out << '"';
+        }
+
+    }
+
+    inline
+    void enable_tracing(bool enabled) {
+        #ifdef PIGO_NO_INSTRUMENTATION
+        if (enabled)
+            throw Error("PIGO: compiled without instrumentation (PIGO_NO_INSTRUMENTATION is defined)");
+        #else
+        detail::trace_state_().enabled.store(enabled);
+        #endif
+    }
+
+    inline
+    bool tracing_enabled() {
+        #ifdef PIGO_NO_INSTRUMENTATION
+        return false;
+        #else
+        return detail::trace_state_().enabled.load(std::memory_order_relaxed);
+        #endif
+    }
+
+    inline
+    void clear_trace() {
+        detail::TraceState_& state = detail::trace_state_();
+        std::lock_guard<std::mutex> lock { state.mutex };
+        for (auto& buffer : state.buffers) {
+            std::lock_guard<std::mutex> buffer_lock { buffer->mutex };
+            buffer->events.clear();
+        }
+    }
+
+    inline
+    void write_trace(std::ostream& out) {
+        detail::TraceState_& state = detail::trace_state_();
+        std::lock_guard<std::mutex> lock { state.mutex };
+        std::ios::fmtflags flags = out.flags();
+        std::streamsize precision = out.precision();
+
+        // Times are in microseconds, and each buffer is a named track
+        out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+        out << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,"
+            "\"args\":{\"name\":\"pigo\"}}";
+        out << std::fixed << std::setprecision(3);
+        for (auto& buffer : state.buffers) {
+            std::lock_guard<std::mutex> buffer_lock { buffer->mutex };
+            if (buffer->events.empty()) continue;
+            out << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":"
+                << buffer->track << ",\"args\":{\"name\":\"thread " << buffer->track << "\"}}";
+            for (const detail::TraceEvent_& e : buffer->events) {
+                out << ",\n{\"name\":";
+                detail::write_json_string_(out, e.name);
+                out << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->track
+                    << ",\"ts\":" << e.start*1e6
+                    << ",\"dur\":" << (e.end-e.start)*1e6;
+                if (e.bytes != 0 || e.items != 0)
+                    out << ",\"args\":{\"bytes\":" << e.bytes
+                        << ",\"items\":" << e.items << "}";
+                out << "}";
+            }
+        }
+        out << "\n]}\n";
+
+        out.flags(flags);
+        out.precision(precision);
+    }
+
+    inline
+    void write_trace(std::string fn) {
+        std::ofstream out { fn };
+        if (!out) throw Error("PIGO: Unable to open trace file " + fn);
+        write_trace(out);
+        if (!out) throw Error("PIGO: Unable to write trace file " + fn);
+    }
+
+}
@@ -0,0 +1,210 @@
+/**
+ * PIGO: a parallel graph and matrix I/O and preprocessing library
+ * Copyright (c) 2022 GT-TDALab
+ *
+ * This file contains the per-phase performance instrumentation
+ */
+
+#ifndef PIGO_INSTRUMENT_HPP
+#define PIGO_INSTRUMENT_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace pigo {
+
+    /** @brief Hardware performance counts, summed over threads
+     *
+     * Counts are of user-space events only. Events the processor or
+     * kernel cannot count are left at zero.
+     */
+    struct PerfCounters {
+        /** Whether the counts were measured */
+        bool valid = false;
+        /** The CPU cycles */
+        uint64_t cycles = 0;
+        /** The instructions retired */
+        uint64_t instructions = 0;
+        /** The last-level cache misses */
+        uint64_t cache_misses = 0;
+        /** The data TLB read misses */
+        uint64_t tlb_misses = 0;
+        /** The mispredicted branches */
+        uint64_t branch_misses = 0;
+
+        /** @brief Return the instructions per cycle, or 0 without cycles */
+        double ipc() const;
+
+        /** @brief Add the counts of another measurement */
+        PerfCounters& operator+=(const PerfCounters& other);
+
+        /** @brief Return the counts from before to this measurement */
+        PerfCounters operator-(const PerfCounters& before) const;
+    };
+
+    /** @brief The measurements of one phase of a PIGO operation
+     *
+     * Readers, conversions, sorts and writers record a phase for the
+     * whole operation, named object.operation (for example csr.convert),
+     * and one for each of their steps, named object.operation.step (for
+     * example csr.convert.scatter).
+     */
+    struct Phase {
+        /** The name of the phase */
+        std::string name;
+        /** The start, in seconds since the first use of instrumentation */
+        double start = 0.;
+        /** The wall time in seconds */
+        double seconds = 0.;
+        /** The time each thread spent in the phase, indexed by thread,
+         *  or empty if the phase was not measured per thread */
+        std::vector<double> thread_seconds;
+        /** The bytes read or written */
+        size_t bytes = 0;
+        /** The edges, non-zeros, rows or lines processed */
+        size_t items = 0;
+        /** The bytes allocated */
+        size_t alloc_bytes = 0;
+        /** The most bytes PIGO held allocated while the phase ran,
+         *  counting all structures and temporaries */
+        size_t peak_bytes = 0;
+        /** The hardware counts of every thread in the phase, valid only
+         *  while perf counters are enabled */
+        PerfCounters counters;
+
+        /** @brief Return the slowest thread's time over the mean
+         *
+         * @return the load imbalance, or 1 without per-thread times
+         */
+        double imbalance() const;
+    };
+
+    /** @brief Enable or disable recording phases
+     *
+     * Instrumentation is disabled by default, costing one check per
+     * phase. Defining PIGO_NO_INSTRUMENTATION (the PIGO_WITH_INSTRUMENTATION
+     * CMake option) removes it entirely.
+     *
+     * @param enabled whether to record phases
+     */
+    void enable_instrumentation(bool enabled=true);
+
+    /** @brief Return whether phases are being recorded */
+    bool instrumentation_enabled();
+
+    /** @brief Return the phases recorded so far, in completion order */
+    std::vector<Phase> recorded_phases();
+
+    /** @brief Remove all recorded phases */
+    void clear_phases();
+
+    /** @brief Call a function as each phase completes
+     *
+     * The callback may be called from any thread, but never concurrently,
+     * and must not throw.
+     *
+     * @param callback the function to call, or nullptr to remove it
+     */
+    void set_phase_callback(std::function<void(const Phase&)> callback);
+
+    /** @brief Enable or disable counting hardware events in each phase
+     *
+     * Each thread opens its own group of counters with perf_event_open
+     * the first time it measures a phase. Counters are unavailable
+     * outside of Linux, without a PMU (as in many virtual machines and
+     * containers) or when perf_event_paranoid forbids them; phases are
+     * then recorded without counts.
+     *
+     * @param enabled whether to count events
+     * @return whether counters are enabled, false if unavailable
+     */
+    bool enable_perf_counters(bool enabled=true);
+
+    /** @brief Return whether hardware events are being counted */
+    bool perf_counters_enabled();
+
+    /** @brief Return the counts of all threads so far
+     *
+     * Every thread that has measured a phase is counted, whichever
+     * executor ran it, including threads that have since exited. Inside
+     * a parallel region or a task of a step, only the calling thread is
+     * counted. The difference of two readings gives the counts between
+     * them.
+     *
+     * @return the counts, not valid if counters are not enabled
+     */
+    PerfCounters read_perf_counters();
+
+    /** @brief Print phases as a table
+     *
+     * @param out the stream to print to
+     * @param phases the phases to print
+     */
+    void print_phases(std::ostream& out, const std::vector<Phase>& phases);
+
+    namespace detail {
+
+        /** @brief Measures one phase while instrumentation or tracing
+         *         is enabled
+         *
+         * The phase is recorded when the timer is stopped or destroyed.
+         * Threads inside a parallel region may mark their own start and
+         * stop; the phase then spans the earliest thread start to the
+         * latest thread stop, and per-thread times are kept. The counters
+         * must be added to outside of parallel regions.
+         */
+        class PhaseTimer_ {
+            private:
+                struct State_;
+                /** The phase being measured, or nullptr when disabled */
+                State_* state_;
+            public:
+                /** @brief Begin a phase named name, or name.step
+                 *
+                 * @param name the name of the phase
+                 * @param step the step within the named operation, if any
+                 * @param start_now whether to start timing now, or wait for
+                 *        start() or the threads to start
+                 */
+                PhaseTimer_(const char* name, const char* step=nullptr, bool start_now=true);
+
+                /** @brief Record the phase, if not yet stopped */
+                ~PhaseTimer_();
+
+                PhaseTimer_(const PhaseTimer_&) = delete;
+                PhaseTimer_& operator=(const PhaseTimer_&) = delete;
+
+                /** @brief Return whether the phase is being measured */
+                bool active() const { return state_ != nullptr; }
+
+                /** @brief Start timing the phase now */
+                void start();
+
+                /** @brief Mark the start of the calling thread's work */
+                void thread_start();
+
+                /** @brief Mark the end of the calling thread's work */
+                void thread_stop();
+
+                /** @brief Add to the bytes read or written */
+                void add_bytes(size_t bytes);
+
+                /** @brief Add to the items processed */
+                void add_items(size_t items);
+
+                /** @brief Add to the bytes allocated */
+                void add_alloc(size_t bytes);
+
+                /** @brief Stop timing and record the phase */
+                void stop();
+        };
+
+    }
+
+}
+
+#endif
@@ -133,26 +133,38 @@ namespace pigo {
                 auto coo_copy = coo;
                 coo_copy.transpose();
 
-                csc_ = CSC<
-                            Label,
-                            Ordinal,
-                            LabelStorage,
-                            OrdinalStorage,
-                            weighted,
-                            Weight,
-                            WeightStorage
-                        > { coo_copy };
+                // Conversions free what they built if cancelled, so only
+                // the copy and the first conversion remain to free
+                try {
+                    csc_ = CSC<
+                                Label,
+                                Ordinal,
+                                LabelStorage,
+                                OrdinalStorage,
+                                weighted,
+                                Weight,
+                                WeightStorage
+                            > { coo_copy };
+                } catch (...) {
+                    coo_copy.free();
+                    throw;
+                }
                 coo_copy.free();
 
-                csr_ = CSR<
-                            Label,
-                            Ordinal,
-                            LabelStorage,
-                            OrdinalStorage,
-                            weighted,
-                            Weight,
-                            WeightStorage
-                        > { coo };
+                try {
+                    csr_ = CSR<
+                                Label,
+                                Ordinal,
+                                LabelStorage,
+                                OrdinalStorage,
+                                weighted,
+                                Weight,
+                                WeightStorage
+                            > { coo };
+                } catch (...) {
+                    csc_.free();
+                    throw;
+                }
             }
 
         public:
@@ -191,7 +203,12 @@ namespace pigo {
                     false, false, false,
                     weighted, Weight, WeightStorage
                 > coo {filename};
-                from_coo_(coo);
+                try {
+                    from_coo_(coo);
+                } catch (...) {
+                    coo.free();
+                    throw;
+                }
                 coo.free();
             }
 
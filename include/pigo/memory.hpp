@@ -0,0 +1,152 @@
+/**
+ * PIGO: a parallel graph and matrix I/O and preprocessing library
+ * Copyright (c) 2022 GT-TDALab
+ *
+ * This file contains the accounting of the memory PIGO allocates
+ */
+
+#ifndef PIGO_MEMORY_HPP
+#define PIGO_MEMORY_HPP
+
+#include <cstddef>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace pigo {
+
+    /** @brief The bytes PIGO holds allocated */
+    struct MemoryUsage {
+        /** The bytes allocated now */
+        size_t current = 0;
+        /** The most bytes allocated at once since the last reset */
+        size_t peak = 0;
+        /** The number of allocations made since the last reset */
+        size_t allocations = 0;
+    };
+
+    /** @brief An allocation PIGO is about to make */
+    struct AllocationRequest {
+        /** The structure allocating: coo, csr, tensor or temporary */
+        std::string kind;
+        /** The bytes to be allocated */
+        size_t bytes = 0;
+        /** The usage of all kinds before the allocation */
+        MemoryUsage usage;
+    };
+
+    /** @brief Thrown when an allocation would exceed the memory limit or
+     *         was refused by the allocation callback */
+    class MemoryLimitExceeded : public Error {
+        public:
+            template<class T>
+            MemoryLimitExceeded(T t) : Error(t) { }
+    };
+
+    /** @brief Return the memory PIGO holds allocated, over all kinds
+     *
+     * The storage of COOs, CSRs (and so of graphs and matrices) and
+     * tensors is counted from allocation until it is freed, as are the
+     * temporaries of conversions and sorts. Storage in std::vector is
+     * counted until free() is called, and in std::shared_ptr until the
+     * last reference is dropped.
+     */
+    MemoryUsage memory_usage();
+
+    /** @brief Return the memory PIGO holds allocated for one kind
+     *
+     * @param kind the kind of structure: coo, csr, tensor or temporary
+     */
+    MemoryUsage memory_usage(const std::string& kind);
+
+    /** @brief Return the memory PIGO holds allocated for each kind used */
+    std::map<std::string, MemoryUsage> memory_usage_by_kind();
+
+    /** @brief Restart the peaks and allocation counts from now
+     *
+     * Each peak becomes the bytes currently allocated.
+     */
+    void reset_memory_peaks();
+
+    /** @brief Limit the bytes PIGO may hold allocated
+     *
+     * Allocations that would exceed the limit throw MemoryLimitExceeded
+     * before anything is allocated. Structures check the whole of their
+     * storage at once, so a refused structure is left empty.
+     *
+     * @param bytes the limit, or 0 for none
+     */
+    void set_memory_limit(size_t bytes);
+
+    /** @brief Return the memory limit, or 0 if there is none */
+    size_t memory_limit();
+
+    /** @brief Call a function before each structure or temporary is
+     *         allocated, refusing the allocation if it returns false
+     *
+     * The callback may be called from any thread, but never concurrently.
+     * It is called after the memory limit is checked.
+     *
+     * @param callback the function to call, or nullptr to remove it
+     */
+    void set_allocation_callback(std::function<bool(const AllocationRequest&)> callback);
+
+    /** @brief Print the usage of each kind and the total as a table
+     *
+     * @param out the stream to print to
+     */
+    void print_memory_usage(std::ostream& out);
+
+    namespace detail {
+
+        /** @brief Check that bytes of kind may be allocated
+         *
+         * This throws MemoryLimitExceeded if the allocation would exceed
+         * the limit or the callback refuses it. It must be called before
+         * the allocation, outside of parallel regions or with the
+         * exception captured.
+         *
+         * @param bytes the bytes about to be allocated
+         * @param kind the kind of structure allocating
+         */
+        void check_alloc_(size_t bytes, const char* kind);
+
+        /** @brief Track the highest usage while a phase runs
+         *
+         * @param peak set to the current usage, and raised with every
+         *        allocation until unwatched
+         */
+        void watch_memory_(size_t* peak);
+
+        /** @brief Stop raising a peak passed to watch_memory_ */
+        void unwatch_memory_(size_t* peak);
+
+        /** @brief A std::allocator that counts its memory as temporary */
+        template<class T>
+        struct TrackedAllocator_ {
+            typedef T value_type;
+
+            TrackedAllocator_() { }
+            template<class U>
+            TrackedAllocator_(const TrackedAllocator_<U>&) { }
+
+            T* allocate(size_t n);
+            void deallocate(T* p, size_t n);
+
+            template<class U>
+            bool operator==(const TrackedAllocator_<U>&) const { return true; }
+            template<class U>
+            bool operator!=(const TrackedAllocator_<U>&) const { return false; }
+        };
+
+        /** @brief A vector for temporaries, counted and limit-checked */
+        template<class T>
+        using TempVector_ = std::vector<T, TrackedAllocator_<T>>;
+
+    }
+
+}
+
+#endif
@@ -0,0 +1,214 @@
+/**
+ * PIGO: a parallel graph and matrix I/O and preprocessing library
+ * Copyright (c) 2022 GT-TDALab
+ *
+ * This file contains progress reporting and cooperative cancellation of
+ * long-running operations
+ */
+
+#ifndef PIGO_PROGRESS_HPP
+#define PIGO_PROGRESS_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace pigo {
+
+    /** @brief The progress of a running PIGO operation */
+    struct Progress {
+        /** The operation, such as coo.read, csr.convert or coo.write */
+        std::string operation;
+        /** The bytes read or written so far. Text readers pass over
+         *  their input twice, counting its bytes in each pass. */
+        size_t bytes = 0;
+        /** The bytes the operation reads or writes, or 0 if unknown */
+        size_t total_bytes = 0;
+        /** The edges, non-zeros or rows processed so far */
+        size_t items = 0;
+        /** The items the operation processes, or 0 if unknown */
+        size_t total_items = 0;
+        /** The seconds since the operation started */
+        double seconds = 0.;
+        /** Whether the operation has finished */
+        bool done = false;
+
+        /** @brief Return the completed fraction, from bytes if known,
+         *         otherwise from items, or 0 if neither total is known */
+        double fraction() const;
+    };
+
+    /** @brief Thrown by an operation that was cancelled
+     *
+     * Any structure the operation was building has been freed, and any
+     * file it was writing has been removed.
+     */
+    class Cancelled : public Error {
+        public:
+            template<class T>
+            Cancelled(T t) : Error(t) { }
+    };
+
+    namespace detail { class ProgressTracker_; }
+
+    /** @brief Reports progress of, and cancels, the operations of a thread
+     *
+     * While a monitor exists, the readers, conversions and writers run by
+     * the thread that created it report their progress to its callback,
+     * and stop at the next chunk boundary once it is cancelled, throwing
+     * Cancelled. Threads count their progress separately, and the counts
+     * are only summed to report.
+     *
+     * Monitors nest; the innermost one of a thread is used.
+     */
+    class ProgressMonitor {
+        public:
+            /** @brief Called with progress, returning false to cancel
+             *
+             * The callback may be called from any thread of the operation,
+             * but never concurrently, and must not throw.
+             */
+            typedef std::function<bool(const Progress&)> Callback;
+
+            /** @brief Monitor the calling thread's operations
+             *
+             * @param callback the function to report progress to, or
+             *        nullptr to only allow cancelling
+             * @param interval the minimum seconds between reports of an
+             *        operation, besides the final report
+             */
+            ProgressMonitor(Callback callback=nullptr, double interval=0.5);
+
+            /** @brief Stop monitoring, restoring any outer monitor */
+            ~ProgressMonitor();
+
+            ProgressMonitor(const ProgressMonitor&) = delete;
+            ProgressMonitor& operator=(const ProgressMonitor&) = delete;
+
+            /** @brief Cancel the running and any later operations
+             *
+             * This may be called from any thread, including from a signal
+             * handler's watcher or a scheduler.
+             */
+            void cancel() { cancelled_.store(true); }
+
+            /** @brief Return whether operations have been cancelled */
+            bool cancelled() const { return cancelled_.load(std::memory_order_relaxed); }
+
+        private:
+            friend class detail::ProgressTracker_;
+            Callback callback_;
+            double interval_;
+            std::atomic<bool> cancelled_;
+            /** Serializes the callback */
+            std::mutex mutex_;
+            /** The monitor this one replaced */
+            ProgressMonitor* outer_;
+    };
+
+    namespace detail {
+
+        /** @brief Tracks the progress of one operation for the calling
+         *         thread's ProgressMonitor
+         *
+         * The tracker is created outside of parallel regions, and becomes
+         * the thread's current tracker until destroyed, so helpers such as
+         * parallel_read add to the operation that called them. Threads
+         * call update at chunk boundaries and stop once it returns true;
+         * the operation then frees what it built and calls
+         * throw_if_cancelled outside of the parallel region, or finish
+         * once it completes.
+         */
+        class ProgressTracker_ {
+            private:
+                /** Each thread's counts, padded apart from the next thread's */
+                struct Counts_ {
+                    std::atomic<size_t> bytes;
+                    std::atomic<size_t> items;
+                    char pad[64];
+                };
+                ProgressMonitor* monitor_;
+                ProgressTracker_* outer_;
+                std::string operation_;
+                std::atomic<size_t> total_bytes_;
+                std::atomic<size_t> total_items_;
+                double start_;
+                /** The time of the next report */
+                std::atomic<double> next_;
+                std::vector<Counts_> counts_;
+
+                /** @brief Report the summed counts to the callback */
+                void report_(bool done);
+            public:
+                /** @brief Begin tracking an operation
+                 *
+                 * @param operation the name of the operation
+                 * @param total_bytes the bytes it reads or writes, if known
+                 * @param total_items the items it processes, if known
+                 */
+                ProgressTracker_(const char* operation, size_t total_bytes=0,
+                        size_t total_items=0);
+
+                /** @brief Stop tracking, restoring any outer tracker */
+                ~ProgressTracker_();
+
+                ProgressTracker_(const ProgressTracker_&) = delete;
+                ProgressTracker_& operator=(const ProgressTracker_&) = delete;
+
+                /** @brief Return whether a monitor is tracking progress */
+                bool active() const { return monitor_ != nullptr; }
+
+                /** @brief Add to the totals as more work becomes known
+                 *
+                 * @param bytes the bytes to add to the total
+                 * @param items the items to add to the total
+                 */
+                void add_totals(size_t bytes, size_t items);
+
+                /** @brief Add the calling thread's progress since its last
+                 *         update, reporting if due
+                 *
+                 * @param bytes the bytes read or written
+                 * @param items the items processed
+                 * @return whether the operation was cancelled
+                 */
+                bool update(size_t bytes, size_t items);
+
+                /** @brief Return whether the operation was cancelled */
+                bool cancelled() const { return monitor_ && monitor_->cancelled(); }
+
+                /** @brief Throw Cancelled if the operation was cancelled */
+                void throw_if_cancelled() const;
+
+                /** @brief Report that the operation completed */
+                void finish();
+        };
+
+        /** @brief Return the calling thread's current tracker, if any */
+        ProgressTracker_* current_progress_();
+
+        /** @brief Update a tracker at a chunk boundary of a text pass
+         *
+         * @param progress the tracker, or nullptr if there is none
+         * @param last the position of the previous update, moved to pos
+         * @param pos the current position
+         * @param items the entries read since the previous update
+         * @return whether the operation was cancelled
+         */
+        bool update_read_progress_(ProgressTracker_* progress, FilePos& last,
+                FilePos pos, size_t items);
+
+        /** @brief The entries parsed or converted between progress updates */
+        const size_t progress_chunk_ = 1<<16;
+
+        /** @brief The bytes copied between progress updates */
+        const size_t progress_bytes_chunk_ = 1<<24;
+
+    }
+
+}
+
+#endif
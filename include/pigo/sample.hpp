@@ -0,0 +1,84 @@
+/**
+ * PIGO: a parallel graph and matrix I/O and preprocessing library
+ * Copyright (c) 2022 GT-TDALab
+ *
+ * This file contains utilities to estimate the statistics of large text
+ * files from a sample, without reading the whole file
+ */
+
+#ifndef PIGO_SAMPLE_HPP
+#define PIGO_SAMPLE_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace pigo {
+
+    /** @brief An estimated value with its confidence bounds */
+    struct Estimate {
+        /** The estimated value */
+        double value;
+        /** The lower bound of the 95% confidence interval */
+        double low;
+        /** The upper bound of the 95% confidence interval */
+        double high;
+    };
+
+    /** @brief Holds the statistics estimated by sample */
+    struct SampleStats {
+        /** The size of the file in bytes */
+        size_t file_size;
+        /** The number of bytes read */
+        size_t bytes_sampled;
+        /** The number of windows read */
+        size_t windows;
+        /** The number of lines starting in the windows */
+        size_t lines_sampled;
+        /** The number of entries parsed in the windows */
+        size_t entries_sampled;
+        /** Whether the windows covered the whole file */
+        bool exact;
+
+        /** The number of lines, including comments */
+        Estimate lines;
+        /** The number of entries (non-comment lines with two labels) */
+        Estimate entries;
+        /** The largest label. The sampled maximum is the lower bound. */
+        Estimate max_label;
+        /** The fraction of entries that are self loops */
+        Estimate self_loop_rate;
+        /** The fraction of sampled entries repeating another sampled
+         *  entry. Duplicates split across windows are not seen, so this
+         *  is closer to a lower bound on the file's rate. */
+        Estimate duplicate_rate;
+        /** Whether the entries of each row are contiguous in the windows,
+         *  so degrees are counted instead of extrapolated */
+        bool rows_grouped;
+        /** The largest out-degree of the sampled rows */
+        Estimate max_degree;
+        /** A log2 histogram of the estimated out-degrees of the sampled
+         *  rows: entry i counts rows with degree in [2^i, 2^(i+1)) */
+        std::vector<size_t> degree_histogram;
+    };
+
+    /** @brief Estimate the statistics of an edge list or matrix market file
+     *
+     * This reads num_windows windows of window_size bytes at random,
+     * line-aligned positions in parallel, one in each equal stratum of the
+     * file, and extrapolates from the entries found in them. Lines
+     * starting with % or # are comments. The estimates come with 95%
+     * confidence bounds, and are exact when the windows cover the file.
+     *
+     * @param fn the file to sample
+     * @param num_windows the number of windows to read
+     * @param window_size the size of each window in bytes
+     * @param seed the seed of the random window positions
+     * @return the estimated statistics
+     */
+    SampleStats sample(std::string fn, size_t num_windows=64,
+            size_t window_size=(1<<16), uint64_t seed=0);
+
+}
+
+#endif
@@ -105,25 +105,31 @@ namespace pigo {
 
             /** @brief Copies values from the other tensor */
             void copy_(const Tensor& other) {
-                #pragma omp parallel for
-                for (Ordinal pos = 0; pos < order_*m_; ++pos) {
+                detail::ParallelTeam_ team;
+                team.for_each(0, order_*m_, [&](size_t pos) {
                     Label val = detail::get_value_<
                                 Storage,
                                 Label
                             >((Storage&)(other.c_), pos);
                     detail::set_value_(c_, pos, val);
-                }
+                });
                 if (detail::if_true_<weighted>()) {
-                    #pragma omp parallel for
-                    for (Ordinal pos = 0; pos < m_; ++pos) {
+                    team.for_each(0, m_, [&](size_t pos) {
                         Weight w_val = detail::get_value_<
                                     WeightStorage,
                                     Weight
                                 >((WeightStorage&)(other.w_), pos);
                         detail::set_value_(w_, pos, w_val);
-                    }
+                    });
                 }
             }
+
+            /** @brief Write the binary save to an open file
+             *
+             * @tparam OutFile the type of file, File, DirectWFile or ChecksumWriter
+             * @param w the open file to write to
+             */
+            template<class OutFile> void save_to_(OutFile& w);
         public:
             /** @brief Initialize a Tensor from a file
              *
@@ -183,11 +189,73 @@ namespace pigo {
             /** @brief Compute and return the maximum label in each dimension */
             std::vector<Label> max_labels() const;
 
-            /** @brief Saves the Tensor to a binary PIGO file */
-            void save(std::string fn);
+            /** @brief Check the structure of the Tensor
+             *
+             * In one parallel sweep, this checks that there is at least
+             * one dimension and that no coordinate is negative. An Error
+             * naming the first offending index is thrown if any check
+             * fails.
+             *
+             * @param sorted whether to also check that the entries are
+             *        sorted by their coordinates
+             */
+            void validate(bool sorted=false) const;
+
+            /** @brief Saves the Tensor to a binary PIGO file
+             *
+             * @param fn the filename to save as
+             * @param mode the SaveMode to use. DIRECT bypasses the page
+             *        cache and synchronizes the file before returning.
+             * @param checksum the ChecksumMode to use. CRC32C appends
+             *        checksums that are verified when loading.
+             * @return the bytes saved and the time taken
+             */
+            SaveStats save(std::string fn, SaveMode mode=MAPPED,
+                    ChecksumMode checksum=NO_CHECKSUM);
+
+            /** @brief Save the loaded Tensor as a PIGO binary file
+             *
+             * This saves the current Tensor to an open file
+             *
+             * @param w the File to save to
+             */
+            void save(File& w) { save_to_(w); }
 
-            /** @brief Write the Tensor out to an ASCII file */
-            void write(std::string fn);
+            /** @brief Save the loaded Tensor as a PIGO binary file
+             *
+             * This saves the current Tensor to an open DirectWFile
+             *
+             * @param w the DirectWFile to save to
+             */
+            void save(DirectWFile& w) { save_to_(w); }
+
+            /** @brief Checksum the binary sections of the Tensor
+             *
+             * @param w the ChecksumWriter to save to
+             */
+            void save(ChecksumWriter& w) { save_to_(w); }
+
+            /** @brief Write the Tensor out to an ASCII file
+             *
+             * @param fn the filename to write
+             * @param mode the WriteMode to use. BUFFERED formats each
+             *        value only once but holds the output in memory.
+             *        STREAM never sizes the output, and with fn "-"
+             *        writes to standard output. GZIP and ZSTD stream
+             *        compressed output.
+             */
+            void write(std::string fn, WriteMode mode=TWO_PASS);
+
+            /** @brief Write the Tensor out in ASCII to a stream
+             *
+             * Lines are formatted in parallel chunks and written in
+             * order, so the stream may be a pipe or standard output.
+             *
+             * @param out the stream to write to
+             * @param mode the WriteMode, one of STREAM, GZIP or ZSTD.
+             *        GZIP and ZSTD compress the chunks in parallel.
+             */
+            void write(WStream& out, WriteMode mode=STREAM);
 
             /** @brief Free consumed memory */
             void free() {
@@ -0,0 +1,90 @@
+/**
+ * PIGO: a parallel graph and matrix I/O and preprocessing library
+ * Copyright (c) 2022 GT-TDALab
+ *
+ * This file contains the timeline tracer of parallel phases
+ */
+
+#ifndef PIGO_TRACE_HPP
+#define PIGO_TRACE_HPP
+
+#include <cstddef>
+#include <iostream>
+#include <string>
+
+namespace pigo {
+
+    /** @brief Enable or disable tracing the threads of each phase
+     *
+     * While enabled, every thread records when it begins and ends its
+     * part of each phase, and how long it waits for the other threads
+     * between the steps of a phase. Events are kept in per-thread buffers until written with
+     * write_trace. Tracing is independent of enable_instrumentation, and
+     * is also removed by PIGO_NO_INSTRUMENTATION.
+     *
+     * @param enabled whether to trace phases
+     */
+    void enable_tracing(bool enabled=true);
+
+    /** @brief Return whether phases are being traced */
+    bool tracing_enabled();
+
+    /** @brief Remove all traced events
+     *
+     * This must not run concurrently with a traced operation.
+     */
+    void clear_trace();
+
+    /** @brief Write the traced events as Chrome trace JSON
+     *
+     * The output can be opened in Perfetto or chrome://tracing, with one
+     * track per thread. This must not run concurrently with a traced
+     * operation.
+     *
+     * @param out the stream to write to
+     */
+    void write_trace(std::ostream& out);
+
+    /** @brief Write the traced events as Chrome trace JSON to a file
+     *
+     * @param fn the file name to write
+     */
+    void write_trace(std::string fn);
+
+    namespace detail {
+
+        /** @brief Record an event on the calling thread's track
+         *
+         * @param name the name of the event
+         * @param start the start, in seconds since the instrumentation epoch
+         * @param end the end, in seconds since the instrumentation epoch
+         * @param bytes the bytes read or written, if known
+         * @param items the items processed, if known
+         */
+        void trace_event_(const std::string& name, double start, double end,
+                size_t bytes=0, size_t items=0);
+
+        /** @brief The events of one thread */
+        struct TraceBuffer_;
+
+        /** @brief Return the calling thread's buffer */
+        TraceBuffer_* trace_track_();
+
+        /** @brief Record an event on another thread's track
+         *
+         * This is used to record how long each task of a step waited for
+         * the step to finish, once it has.
+         *
+         * @param track the buffer of the thread that waited
+         * @param name the name of the event
+         * @param start the start, in seconds since the instrumentation epoch
+         * @param end the end, in seconds since the instrumentation epoch
+         */
+        void trace_event_on_(TraceBuffer_* track, const std::string& name,
+                double start, double end);
+
+    }
+
+}
+
+#endif
@@ -0,0 +1,227 @@
+/**
+ * PIGO: a parallel graph and matrix I/O and preprocessing library
+ * Copyright (c) 2022 GT-TDALab
+ *
+ * This file contains tests for asynchronous loading and saving
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "tests.hpp"
+#include "pigo.hpp"
+
+using namespace std;
+using namespace pigo;
+
+int loads(string fn) {
+    COO<> c = generate_gnm(1000, 50000, 1);
+    c.write(fn);
+    CSR<> expected { fn };
+    expected.sort();
+
+    // With the default executor
+    Async<COO<>> one = load_async<COO<>>(fn);
+    EQ(one.valid(), true);
+    COO<>& r = one.get();
+    EQ(one.ready(), true);
+    EQ(same_coo(c, r), true);
+    EQ(one.progress().done, true);
+    r.free();
+
+    // Several loads share a pool of two workers
+    ExecutionContext ctx;
+    ctx.executor = make_shared<ThreadPool>(2);
+    ExecutionScope scope { ctx };
+    vector<Async<CSR<>>> handles;
+    for (size_t i = 0; i < 4; ++i)
+        handles.push_back(load_async<CSR<>>(fn, EDGE_LIST));
+    for (Async<CSR<>>& h : handles) {
+        h.wait();
+        EQ(h.ready(), true);
+        h.get().sort();
+        EQ(same_csr(h.get(), expected), true);
+        h.get().free();
+    }
+
+    c.free();
+    expected.free();
+    remove(fn.c_str());
+    return 0;
+}
+
+int saves(string fn) {
+    COO<> c = generate_gnm(1000, 50000, 2);
+    Async<SaveStats> saving = save_async(c, fn);
+    SaveStats stats = saving.get();
+    NOPRINT_NEQ(stats.bytes, 0);
+
+    Async<COO<>> loading = load_async<COO<>>(fn);
+    EQ(same_coo(c, loading.get()), true);
+    loading.get().free();
+
+    c.free();
+    remove(fn.c_str());
+    return 0;
+}
+
+int cancel(string fn) {
+    COO<> c = generate_gnm(1000, 50000, 3);
+    c.write(fn);
+
+    // Keep the only worker busy, so the load cannot start before it is
+    // cancelled
+    shared_ptr<ThreadPool> workers = make_shared<ThreadPool>(1);
+    atomic<bool> started { false };
+    atomic<bool> release { false };
+    workers->submit([&]() {
+        started = true;
+        while (!release) this_thread::yield();
+    });
+    while (!started) this_thread::yield();
+    ExecutionContext ctx;
+    ctx.executor = workers;
+    ExecutionScope scope { ctx };
+    Async<COO<>> loading = load_async<COO<>>(fn);
+    EQ(loading.wait_for(chrono::milliseconds(10)), false);
+    loading.cancel();
+    release = true;
+
+    bool thrown = false;
+    try {
+        loading.get();
+    } catch (Cancelled&) {
+        thrown = true;
+    }
+    EQ(thrown, true);
+
+    // Cancelling a finished operation has no effect
+    Async<COO<>> done = load_async<COO<>>(fn);
+    done.wait();
+    done.cancel();
+    EQ(same_coo(c, done.get()), true);
+    done.get().free();
+
+    c.free();
+    remove(fn.c_str());
+    return 0;
+}
+
+/** @brief Return the number of threads of the process, or 0 if unknown */
+size_t process_threads() {
+    ifstream status { "/proc/self/status" };
+    string key;
+    while (status >> key) {
+        if (key == "Threads:") {
+            size_t threads = 0;
+            status >> threads;
+            return threads;
+        }
+    }
+    return 0;
+}
+
+int bounded(string fn) {
+    COO<> c = generate_gnm(100000, 2000000, 4);
+    c.write(fn);
+    c.free();
+
+    // Start the shared workers with one load, then count the threads
+    // while several loads run at once
+    Async<COO<>> first = load_async<COO<>>(fn);
+    first.get().free();
+    size_t before = process_threads();
+    if (before == 0) return 0;
+    vector<Async<COO<>>> handles;
+    for (size_t i = 0; i < 8; ++i)
+        handles.push_back(load_async<COO<>>(fn));
+    size_t most = before;
+    for (Async<COO<>>& h : handles) {
+        while (!h.wait_for(chrono::milliseconds(1)))
+            most = max(most, process_threads());
+    }
+    for (Async<COO<>>& h : handles) {
+        EQ(h.get().m(), 2000000);
+        h.get().free();
+    }
+    EQ(most, before);
+
+    remove(fn.c_str());
+    return 0;
+}
+
+int unclaimed(string fn) {
+    COO<> c = generate_gnm(1000, 50000, 5);
+    c.write(fn);
+    c.free();
+    size_t before = memory_usage("coo").current;
+
+    // A result no handle got is freed with the operation
+    {
+        Async<COO<>> loading = load_async<COO<>>(fn);
+        loading.wait();
+    }
+    for (size_t wait = 0; wait < 5000 && memory_usage("coo").current != before; ++wait)
+        this_thread::sleep_for(chrono::milliseconds(1));
+    EQ(memory_usage("coo").current, before);
+
+    // One that was got belongs to the caller, and a CSR copied out of
+    // the handle keeps its storage
+    size_t csr_before = memory_usage("csr").current;
+    CSR<> kept;
+    {
+        Async<CSR<>> got = load_async<CSR<>>(fn);
+        kept = got.get();
+    }
+    EQ(kept.m(), 50000);
+    NOPRINT_NEQ(memory_usage("csr").current, csr_before);
+    kept.free();
+    EQ(memory_usage("csr").current, csr_before);
+
+    remove(fn.c_str());
+    return 0;
+}
+
+int errors() {
+    Async<COO<>> loading = load_async<COO<>>("/nonexistent/pigo.el");
+    bool thrown = false;
+    try {
+        loading.get();
+    } catch (Error&) {
+        thrown = true;
+    }
+    EQ(thrown, true);
+    EQ(loading.ready(), true);
+
+    // The operation may outlive the caller's references to its pool
+    {
+        ExecutionContext ctx;
+        ctx.executor = make_shared<ThreadPool>(1);
+        ExecutionScope scope { ctx };
+        loading = load_async<COO<>>("/nonexistent/pigo.el");
+    }
+    loading.wait();
+    EQ(loading.ready(), true);
+
+    EQ(Async<COO<>>().valid(), false);
+    return 0;
+}
+
+int main() {
+    int pass = 0;
+
+    TEST(loads, ".test.async.loads.el");
+    TEST(saves, ".test.async.saves.bin");
+    TEST(cancel, ".test.async.cancel.el");
+    TEST(bounded, ".test.async.bounded.el");
+    TEST(unclaimed, ".test.async.unclaimed.el");
+    TEST(errors);
+
+    return pass;
+}
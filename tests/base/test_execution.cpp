@@ -0,0 +1,291 @@
+/**
+ * PIGO: a parallel graph and matrix I/O and preprocessing library
+ * Copyright (c) 2022 GT-TDALab
+ *
+ * This file contains tests for the execution context
+ */
+
+#include <atomic>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "tests.hpp"
+#include "pigo.hpp"
+
+using namespace std;
+using namespace pigo;
+
+/** @brief Load fn into a sorted CSR and its deduplicated copy, and check
+ *         them against the expected ones */
+bool load_matches(string fn, COO<>& c, CSR<>& expected, CSR<>& expected_dedup) {
+    COO<> r { fn };
+    CSR<> csr { r };
+    csr.sort();
+    CSR<> dedup = csr.new_csr_without_dups();
+    bool good = same_coo(c, r) && same_csr(csr, expected) && same_csr(dedup, expected_dedup);
+    r.free();
+    csr.free();
+    dedup.free();
+    return good;
+}
+
+int scopes() {
+    EQ(execution_context().threads, 0);
+    {
+        ExecutionContext ctx;
+        ctx.threads = 2;
+        ExecutionScope scope { ctx };
+        EQ(execution_context().threads, 2);
+        {
+            ExecutionContext inner;
+            inner.threads = 1;
+            inner.nested = NESTED_PARALLEL;
+            ExecutionScope inner_scope { inner };
+            EQ(execution_context().threads, 1);
+            EQ(execution_context().nested, NESTED_PARALLEL);
+        }
+        EQ(execution_context().threads, 2);
+
+        // Other threads keep their own context
+        size_t other = 1;
+        thread t { [&other]() { other = execution_context().threads; } };
+        t.join();
+        EQ(other, 0);
+    }
+    EQ(execution_context().threads, 0);
+    return 0;
+}
+
+int threads(string fn) {
+    COO<> c = generate_gnm(1000, 50000, 1);
+    c.write(fn);
+
+    #ifdef _OPENMP
+    // Dynamic adjustment is left as the caller set it
+    omp_set_dynamic(1);
+    #endif
+    for (size_t t = 1; t <= 3; ++t) {
+        ExecutionContext ctx;
+        ctx.threads = t;
+        ExecutionScope scope { ctx };
+
+        clear_phases();
+        enable_instrumentation();
+        COO<> r { fn };
+        enable_instrumentation(false);
+        if (!same_coo(c, r)) return 1;
+        r.free();
+
+        #if defined(_OPENMP) && !defined(PIGO_NO_INSTRUMENTATION)
+        size_t used = 0;
+        for (const Phase& p : recorded_phases())
+            if (p.name == "coo.read.parse") used = p.thread_seconds.size();
+        EQ(used, t);
+        #endif
+    }
+    #ifdef _OPENMP
+    EQ(omp_get_dynamic(), 1);
+    omp_set_dynamic(0);
+    #endif
+
+    c.free();
+    remove(fn.c_str());
+    return 0;
+}
+
+int nested(string fn) {
+    COO<> c = generate_gnm(1000, 50000, 2);
+    c.write(fn);
+
+    // Each thread of an outer region loads the file on its own
+    const int outer = 2;
+    vector<int> ok(outer, 0);
+    #pragma omp parallel num_threads(outer)
+    {
+        #ifdef _OPENMP
+        int tid = omp_get_thread_num();
+        #else
+        int tid = 0;
+        #endif
+        COO<> r { fn };
+        CSR<> csr { r };
+        ok[tid] = same_coo(c, r) && csr.m() == c.m();
+        r.free();
+        csr.free();
+    }
+    #ifdef _OPENMP
+    for (int tid = 0; tid < outer; ++tid)
+        EQ(ok[tid], 1);
+    #else
+    EQ(ok[0], 1);
+    #endif
+
+    c.free();
+    remove(fn.c_str());
+    return 0;
+}
+
+int concurrent(string fn) {
+    COO<> c = generate_gnm(1000, 50000, 3);
+    c.write(fn);
+    CSR<> expected { c };
+
+    // Two loads run side by side, each on its own CPU. A CPU that is not
+    // available leaves its threads unbound.
+    const size_t loads = 2;
+    vector<int> ok(loads, 0);
+    vector<thread> workers;
+    for (size_t i = 0; i < loads; ++i) {
+        workers.emplace_back([&, i]() {
+            ExecutionContext ctx;
+            ctx.threads = 2;
+            ctx.cpus = { (int)i };
+            ExecutionScope scope { ctx };
+            COO<> r { fn };
+            CSR<> csr { r };
+            csr.sort();
+            bool good = same_coo(c, r) && csr.m() == expected.m();
+            for (size_t v = 0; good && v <= expected.n(); ++v)
+                good = csr.offsets()[v] == expected.offsets()[v];
+            ok[i] = good;
+            r.free();
+            csr.free();
+        });
+    }
+    for (thread& t : workers) t.join();
+    for (size_t i = 0; i < loads; ++i)
+        EQ(ok[i], 1);
+
+    c.free();
+    expected.free();
+    remove(fn.c_str());
+    return 0;
+}
+
+int pool(string fn) {
+    COO<> c = generate_gnm(1000, 50000, 4);
+    c.write(fn);
+    CSR<> expected { c };
+    expected.sort();
+    CSR<> expected_dedup = expected.new_csr_without_dups();
+
+    // Steps have more tasks than the pool has workers, and the waiting
+    // thread runs tasks too
+    shared_ptr<ThreadPool> workers = make_shared<ThreadPool>(2);
+    EQ(workers->concurrency(), 2);
+    ExecutionContext ctx;
+    ctx.threads = 5;
+    ctx.executor = workers;
+    {
+        ExecutionScope scope { ctx };
+        EQ(load_matches(fn, c, expected, expected_dedup), true);
+    }
+
+    // Loads submitted to the pool split their steps across its workers
+    ctx.nested = NESTED_PARALLEL;
+    const size_t loads = 3;
+    vector<int> ok(loads, 0);
+    atomic<size_t> finished { 0 };
+    for (size_t i = 0; i < loads; ++i) {
+        workers->submit([&, i]() {
+            ExecutionScope scope { ctx };
+            ok[i] = load_matches(fn, c, expected, expected_dedup);
+            ++finished;
+        });
+    }
+    while (finished < loads) this_thread::yield();
+    for (size_t i = 0; i < loads; ++i)
+        EQ(ok[i], 1);
+
+    c.free();
+    expected.free();
+    expected_dedup.free();
+    remove(fn.c_str());
+    return 0;
+}
+
+int external(string fn) {
+    COO<> c = generate_gnm(1000, 50000, 5);
+    c.write(fn);
+    CSR<> expected { c };
+    expected.sort();
+    CSR<> expected_dedup = expected.new_csr_without_dups();
+
+    // A stand-in for an external scheduler, running each job on a thread
+    mutex jobs_mutex;
+    vector<thread> jobs;
+    ExecutionContext ctx;
+    ctx.executor = make_shared<ExternalExecutor>([&](function<void()> job) {
+        lock_guard<mutex> lock { jobs_mutex };
+        jobs.emplace_back(job);
+    }, 3);
+    {
+        ExecutionScope scope { ctx };
+        EQ(execution_context().executor->concurrency(), 3);
+        EQ(load_matches(fn, c, expected, expected_dedup), true);
+    }
+    NOPRINT_NEQ(jobs.size(), 0);
+    for (thread& t : jobs) t.join();
+
+    // A scheduler that refuses jobs leaves the waiting thread to run all
+    // of the tasks
+    ctx.executor = make_shared<ExternalExecutor>([](function<void()>) {
+        throw Error("busy");
+    }, 4);
+    {
+        ExecutionScope scope { ctx };
+        EQ(load_matches(fn, c, expected, expected_dedup), true);
+    }
+
+    c.free();
+    expected.free();
+    expected_dedup.free();
+    remove(fn.c_str());
+    return 0;
+}
+
+int errors() {
+    vector<shared_ptr<Executor>> executors {
+        make_shared<OpenMPExecutor>(),
+        make_shared<ThreadPool>(2),
+        make_shared<ExternalExecutor>([](function<void()> job) { thread(job).detach(); }, 2)
+    };
+    for (shared_ptr<Executor>& executor : executors) {
+        // Every task runs once, and the first exception is rethrown after
+        // all of them completed
+        const size_t count = 6;
+        vector<atomic<int>> runs(count);
+        for (atomic<int>& r : runs) r = 0;
+        bool thrown = false;
+        try {
+            executor->run(count, [&](size_t i) {
+                ++runs[i];
+                if (i % 2 == 1) throw Error("task failed");
+            });
+        } catch (Error&) {
+            thrown = true;
+        }
+        EQ(thrown, true);
+        for (size_t i = 0; i < count; ++i)
+            EQ(runs[i], 1);
+    }
+    return 0;
+}
+
+int main() {
+    int pass = 0;
+
+    TEST(scopes);
+    TEST(threads, ".test.execution.threads.el");
+    TEST(nested, ".test.execution.nested.el");
+    TEST(concurrent, ".test.execution.concurrent.el");
+    TEST(pool, ".test.execution.pool.el");
+    TEST(external, ".test.execution.external.el");
+    TEST(errors);
+
+    return pass;
+}
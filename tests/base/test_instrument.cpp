@@ -0,0 +1,168 @@
+/**
+ * PIGO: a parallel graph and matrix I/O and preprocessing library
+ * Copyright (c) 2022 GT-TDALab
+ *
+ * This file contains tests for the per-phase performance instrumentation
+ */
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "tests.hpp"
+#include "pigo.hpp"
+
+using namespace std;
+using namespace pigo;
+
+const Phase* find_phase(const vector<Phase>& phases, const string& name) {
+    for (const Phase& p : phases)
+        if (p.name == name) return &p;
+    return nullptr;
+}
+
+int disabled() {
+    clear_phases();
+    enable_instrumentation(false);
+    EQ(instrumentation_enabled(), false);
+    COO<> c = generate_gnm(100, 1000, 1);
+    CSR<> csr { c };
+    csr.sort();
+    EQ(recorded_phases().size(), 0);
+    c.free();
+    csr.free();
+    return 0;
+}
+
+int read_phases(string fn) {
+    COO<> c = generate_gnm(1000, 20000, 2);
+    c.write(fn);
+    c.free();
+
+    clear_phases();
+    enable_instrumentation();
+    COO<> r { fn };
+    enable_instrumentation(false);
+    remove(fn.c_str());
+
+    vector<Phase> phases = recorded_phases();
+    const Phase* read = find_phase(phases, "coo.read");
+    const Phase* count = find_phase(phases, "coo.read.count");
+    const Phase* alloc = find_phase(phases, "coo.read.allocate");
+    const Phase* parse = find_phase(phases, "coo.read.parse");
+    NOPRINT_NEQ(read, nullptr);
+    NOPRINT_NEQ(count, nullptr);
+    NOPRINT_NEQ(alloc, nullptr);
+    NOPRINT_NEQ(parse, nullptr);
+
+    // The whole read is recorded after its steps and covers them
+    EQ(phases.back().name, "coo.read");
+    EQ(read->items, 20000);
+    EQ(read->alloc_bytes, alloc->alloc_bytes);
+    NOPRINT_NEQ(read->bytes, 0);
+    if (parse->start < read->start) return 1;
+    if (parse->start + parse->seconds > read->start + read->seconds + 1e-6) return 1;
+
+    EQ(parse->items, 20000);
+    EQ(alloc->alloc_bytes, 2*20000*sizeof(uint32_t));
+    NOPRINT_NEQ(parse->thread_seconds.size(), 0);
+    if (parse->imbalance() < 1. - 1e-9) return 1;
+    EQ(read->thread_seconds.size(), 0);
+    FEQ(read->imbalance(), 1.);
+
+    r.free();
+    return 0;
+}
+
+int callback() {
+    clear_phases();
+    vector<string> names;
+    set_phase_callback([&names](const Phase& p) { names.push_back(p.name); });
+    enable_instrumentation();
+    COO<> c = generate_gnm(100, 1000, 3);
+    CSR<> csr { c };
+    csr.sort();
+    enable_instrumentation(false);
+    set_phase_callback(nullptr);
+
+    vector<Phase> phases = recorded_phases();
+    EQ(names.size(), phases.size());
+    for (size_t i = 0; i < names.size(); ++i)
+        EQ(names[i], phases[i].name);
+    NOPRINT_NEQ(find_phase(phases, "csr.convert.scatter"), nullptr);
+    const Phase* convert = find_phase(phases, "csr.convert");
+    NOPRINT_NEQ(convert, nullptr);
+    EQ(convert->items, 1000);
+    NOPRINT_NEQ(convert->alloc_bytes, 0);
+    const Phase* sort = find_phase(phases, "csr.sort");
+    NOPRINT_NEQ(sort, nullptr);
+    NOPRINT_NEQ(sort->thread_seconds.size(), 0);
+
+    c.free();
+    csr.free();
+    clear_phases();
+    return 0;
+}
+
+int counters() {
+    PerfCounters a, b;
+    a.valid = true;
+    a.cycles = 100;
+    a.instructions = 250;
+    b.valid = true;
+    b.cycles = 40;
+    b.instructions = 50;
+    PerfCounters d = a - b;
+    EQ(d.valid, true);
+    EQ(d.cycles, 60);
+    FEQ(d.ipc(), 200./60);
+    EQ((b - a).cycles, 0);
+    d += a;
+    EQ(d.instructions, 450);
+    FEQ(PerfCounters().ipc(), 0.);
+
+    // Counters are used if available, and otherwise leave phases uncounted
+    clear_phases();
+    bool available = enable_perf_counters();
+    EQ(perf_counters_enabled(), available);
+    enable_instrumentation();
+    COO<> c = generate_gnm(1000, 20000, 4);
+    CSR<> csr { c };
+    enable_instrumentation(false);
+    enable_perf_counters(false);
+    EQ(perf_counters_enabled(), false);
+
+    vector<Phase> phases = recorded_phases();
+    const Phase* scatter = find_phase(phases, "csr.convert.scatter");
+    const Phase* convert = find_phase(phases, "csr.convert");
+    NOPRINT_NEQ(scatter, nullptr);
+    NOPRINT_NEQ(convert, nullptr);
+    EQ(scatter->counters.valid, available);
+    EQ(convert->counters.valid, available);
+    if (available) {
+        NOPRINT_NEQ(scatter->counters.instructions, 0);
+        if (convert->counters.instructions < scatter->counters.instructions) return 1;
+    }
+
+    c.free();
+    csr.free();
+    clear_phases();
+    return 0;
+}
+
+int main() {
+    int pass = 0;
+
+    #ifdef PIGO_NO_INSTRUMENTATION
+    // Only the disabled behavior is compiled in
+    TEST(disabled);
+    return pass;
+    #endif
+
+    TEST(disabled);
+    TEST(read_phases, ".test.instrument.el");
+    TEST(callback);
+    TEST(counters);
+
+    return pass;
+}
@@ -0,0 +1,165 @@
+/**
+ * PIGO: a parallel graph and matrix I/O and preprocessing library
+ * Copyright (c) 2022 GT-TDALab
+ *
+ * This file contains tests for the memory accounting
+ */
+
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "tests.hpp"
+#include "pigo.hpp"
+
+using namespace std;
+using namespace pigo;
+
+/** @brief Return the threads a conversion uses */
+size_t max_threads() {
+    #ifdef _OPENMP
+    return omp_get_max_threads();
+    #else
+    return 1;
+    #endif
+}
+
+int structures() {
+    size_t coo_before = memory_usage("coo").current;
+    size_t csr_before = memory_usage("csr").current;
+    size_t temp_before = memory_usage("temporary").current;
+
+    COO<> c = generate_gnm(1000, 20000, 1);
+    EQ(memory_usage("coo").current - coo_before, 2*20000*sizeof(uint32_t));
+
+    reset_memory_peaks();
+    CSR<> csr { c };
+    EQ(memory_usage("csr").current - csr_before,
+            20000*sizeof(uint32_t) + 1001*sizeof(uint32_t));
+    // The conversion's degree counts are freed once it completes
+    EQ(memory_usage("temporary").current, temp_before);
+    EQ(memory_usage("temporary").peak >= temp_before + 2*1000*sizeof(uint32_t), true);
+    EQ(memory_usage().peak, memory_usage().current + 2*1000*sizeof(uint32_t) +
+            max_threads()*sizeof(uint32_t));
+
+    c.free();
+    csr.free();
+    EQ(memory_usage("coo").current, coo_before);
+    EQ(memory_usage("csr").current, csr_before);
+    return 0;
+}
+
+int storage() {
+    size_t before = memory_usage().current;
+    {
+        // Shared storage is counted until the last reference is dropped
+        typedef COO<uint32_t, uint32_t, shared_ptr<uint32_t>> SCOO;
+        SCOO c = generate_gnm<uint32_t, uint32_t, shared_ptr<uint32_t>>(100, 1000, 2);
+        EQ(memory_usage().current - before, 2*1000*sizeof(uint32_t));
+        SCOO copy = c;
+        EQ(memory_usage().current - before, 4*1000*sizeof(uint32_t));
+        c.free();
+    }
+    EQ(memory_usage().current, before);
+
+    // Vector storage is counted until free()
+    COO<uint32_t, uint32_t, vector<uint32_t>> v =
+        generate_gnm<uint32_t, uint32_t, vector<uint32_t>>(100, 1000, 3);
+    EQ(memory_usage().current - before, 2*1000*sizeof(uint32_t));
+    v.free();
+    EQ(memory_usage().current, before);
+    return 0;
+}
+
+int limits(string fn) {
+    COO<> c = generate_gnm(1000, 20000, 4);
+    c.write(fn);
+    size_t before = memory_usage().current;
+
+    // The CSR would exceed the limit, so nothing is allocated
+    set_memory_limit(before + 1000);
+    EQ(memory_limit(), before + 1000);
+    bool thrown = false;
+    try {
+        CSR<> csr { c };
+        csr.free();
+    } catch (MemoryLimitExceeded&) {
+        thrown = true;
+    }
+    EQ(thrown, true);
+    EQ(memory_usage().current, before);
+
+    // Readers refuse inside their parallel steps
+    thrown = false;
+    try {
+        COO<> r { fn };
+        r.free();
+    } catch (MemoryLimitExceeded&) {
+        thrown = true;
+    }
+    EQ(thrown, true);
+    EQ(memory_usage().current, before);
+    set_memory_limit(0);
+
+    // The callback sees each request and may refuse it
+    vector<string> kinds;
+    set_allocation_callback([&](const AllocationRequest& req) {
+        kinds.push_back(req.kind);
+        return req.kind != "temporary";
+    });
+    thrown = false;
+    try {
+        CSR<> csr { c };
+        csr.free();
+    } catch (MemoryLimitExceeded&) {
+        thrown = true;
+    }
+    set_allocation_callback(nullptr);
+    EQ(thrown, true);
+    EQ(kinds.size(), 2);
+    EQ(kinds[0], "csr");
+    EQ(memory_usage().current, before);
+
+    // Without limits, everything loads
+    CSR<> csr { fn };
+    EQ(csr.m(), 20000);
+    csr.free();
+    c.free();
+    remove(fn.c_str());
+    return 0;
+}
+
+int phases() {
+    COO<> c = generate_gnm(1000, 20000, 5);
+    size_t before = memory_usage().current;
+
+    clear_phases();
+    enable_instrumentation();
+    CSR<> csr { c };
+    enable_instrumentation(false);
+
+    // The conversion's peak includes its input, output and temporaries
+    size_t peak = 0;
+    for (const Phase& p : recorded_phases())
+        if (p.name == "csr.convert") peak = p.peak_bytes;
+    EQ(peak, before + 21001*sizeof(uint32_t) + 2*1000*sizeof(uint32_t) +
+            max_threads()*sizeof(uint32_t));
+
+    c.free();
+    csr.free();
+    return 0;
+}
+
+int main() {
+    int pass = 0;
+
+    TEST(structures);
+    TEST(storage);
+    TEST(limits, ".test.memory.el");
+    #ifndef PIGO_NO_INSTRUMENTATION
+    TEST(phases);
+    #endif
+
+    return pass;
+}
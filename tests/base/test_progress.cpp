@@ -0,0 +1,206 @@
+/**
+ * PIGO: a parallel graph and matrix I/O and preprocessing library
+ * Copyright (c) 2022 GT-TDALab
+ *
+ * This file contains tests for progress reporting and cancellation
+ */
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "tests.hpp"
+#include "pigo.hpp"
+
+using namespace std;
+using namespace pigo;
+
+bool exists(const string& fn) {
+    FILE* f = fopen(fn.c_str(), "r");
+    if (!f) return false;
+    fclose(f);
+    return true;
+}
+
+size_t file_size(const string& fn) {
+    ROFile f { fn };
+    return f.size();
+}
+
+int reports(string fn) {
+    COO<> c = generate_gnm(1000, 200000, 1);
+    c.write(fn);
+    c.free();
+    size_t size = file_size(fn);
+
+    vector<Progress> seen;
+    {
+        ProgressMonitor monitor { [&](const Progress& p) {
+            seen.push_back(p);
+            return true;
+        }, 0. };
+        COO<> r { fn };
+        CSR<> csr { r };
+        EQ(monitor.cancelled(), false);
+        r.free();
+        csr.free();
+    }
+    remove(fn.c_str());
+
+    // Each operation ends with a single done report
+    NOPRINT_NEQ(seen.size(), 0);
+    size_t done = 0;
+    for (const Progress& p : seen) if (p.done) ++done;
+    EQ(done, 2);
+
+    const Progress* read = nullptr;
+    const Progress* convert = nullptr;
+    for (const Progress& p : seen) {
+        if (!p.done) continue;
+        if (p.operation == "coo.read") read = &p;
+        if (p.operation == "csr.convert") convert = &p;
+    }
+    NOPRINT_NEQ(read, nullptr);
+    NOPRINT_NEQ(convert, nullptr);
+    // Text is read twice, first counting and then parsing
+    EQ(read->total_bytes, 2*size);
+    EQ(read->bytes, 2*size);
+    EQ(read->items, 200000);
+    FEQ(read->fraction(), 1.);
+    // Degrees are counted, then endpoints are scattered
+    EQ(convert->items, 400000);
+
+    // Progress never exceeds the totals
+    for (const Progress& p : seen) {
+        if (p.total_bytes > 0 && p.bytes > p.total_bytes) return 1;
+        if (p.total_items > 0 && p.items > p.total_items) return 1;
+    }
+    return 0;
+}
+
+int cancel_read(string fn) {
+    COO<> c = generate_gnm(1000, 200000, 2);
+    c.write(fn);
+    c.free();
+
+    // Returning false from the callback cancels
+    size_t calls = 0;
+    bool thrown = false;
+    {
+        ProgressMonitor monitor { [&](const Progress&) {
+            ++calls;
+            return false;
+        }, 0. };
+        try {
+            COO<> r { fn };
+            r.free();
+        } catch (Cancelled&) {
+            thrown = true;
+        }
+        EQ(monitor.cancelled(), true);
+    }
+    EQ(thrown, true);
+    EQ(calls, 1);
+
+    // Cancelling before starting stops at once
+    thrown = false;
+    {
+        ProgressMonitor monitor;
+        monitor.cancel();
+        try {
+            CSR<> r { fn };
+            r.free();
+        } catch (Cancelled&) {
+            thrown = true;
+        }
+    }
+    EQ(thrown, true);
+
+    // Without a monitor, nothing is cancelled
+    COO<> r { fn };
+    EQ(r.m(), 200000);
+    r.free();
+    remove(fn.c_str());
+    return 0;
+}
+
+int cancel_convert() {
+    COO<> c = generate_gnm(1000, 200000, 3);
+    bool thrown = false;
+    {
+        ProgressMonitor monitor { [](const Progress&) { return false; }, 0. };
+        try {
+            CSR<> csr { c };
+            csr.free();
+        } catch (Cancelled&) {
+            thrown = true;
+        }
+    }
+    EQ(thrown, true);
+    // The input is untouched
+    EQ(c.m(), 200000);
+    c.free();
+    return 0;
+}
+
+int cancel_write(string fn, WriteMode mode) {
+    COO<> c = generate_gnm(1000, 200000, 4);
+    bool thrown = false;
+    {
+        ProgressMonitor monitor { [](const Progress&) { return false; }, 0. };
+        try {
+            c.write(fn, mode);
+        } catch (Cancelled&) {
+            thrown = true;
+        }
+    }
+    EQ(thrown, true);
+    // The partial file is removed
+    EQ(exists(fn), false);
+    c.free();
+    return 0;
+}
+
+int cancel_save(string fn) {
+    COO<> c = generate_gnm(1000, 200000, 5);
+    bool thrown = false;
+    {
+        ProgressMonitor monitor;
+        monitor.cancel();
+        try {
+            c.save(fn);
+        } catch (Cancelled&) {
+            thrown = true;
+        }
+    }
+    EQ(thrown, true);
+    EQ(exists(fn), false);
+
+    // Saving reports the bytes written
+    size_t saved = 0;
+    {
+        ProgressMonitor monitor { [&](const Progress& p) {
+            if (p.done) saved = p.bytes;
+            return true;
+        }, 0. };
+        c.save(fn);
+    }
+    EQ(saved, file_size(fn));
+    remove(fn.c_str());
+    c.free();
+    return 0;
+}
+
+int main() {
+    int pass = 0;
+
+    TEST(reports, ".test.progress.el");
+    TEST(cancel_read, ".test.progress.cancel.el");
+    TEST(cancel_convert);
+    TEST(cancel_write, ".test.progress.two_pass.el", TWO_PASS);
+    TEST(cancel_write, ".test.progress.buffered.el", BUFFERED);
+    TEST(cancel_write, ".test.progress.stream.el", STREAM);
+    TEST(cancel_save, ".test.progress.bin");
+
+    return pass;
+}
@@ -0,0 +1,117 @@
+/**
+ * PIGO: a parallel graph and matrix I/O and preprocessing library
+ * Copyright (c) 2022 GT-TDALab
+ *
+ * This file contains tests for the timeline tracer
+ */
+
+#include <cstdio>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include "tests.hpp"
+#include "pigo.hpp"
+
+using namespace std;
+using namespace pigo;
+
+size_t count_of(const string& s, const string& sub) {
+    size_t count = 0;
+    for (size_t pos = s.find(sub); pos != string::npos; pos = s.find(sub, pos+1))
+        ++count;
+    return count;
+}
+
+string trace_json() {
+    ostringstream out;
+    write_trace(out);
+    return out.str();
+}
+
+int disabled() {
+    clear_trace();
+    EQ(tracing_enabled(), false);
+    COO<> c = generate_gnm(100, 1000, 1);
+    CSR<> csr { c };
+    EQ(count_of(trace_json(), "\"ph\":\"X\""), 0);
+    c.free();
+    csr.free();
+    return 0;
+}
+
+int read_trace(string fn) {
+    COO<> c = generate_gnm(1000, 20000, 2);
+    c.write(fn);
+    c.free();
+
+    clear_trace();
+    clear_phases();
+    enable_tracing();
+    COO<> r { fn };
+    CSR<> csr { r };
+    enable_tracing(false);
+    remove(fn.c_str());
+
+    // Tracing does not record phases
+    EQ(recorded_phases().size(), 0);
+
+    string json = trace_json();
+    EQ(json.compare(0, 17, "{\"displayTimeUnit"), 0);
+    EQ(json.substr(json.size()-4), "\n]}\n");
+    // Each thread traces its part of the parallel steps and barriers
+    NOPRINT_NEQ(count_of(json, "\"name\":\"coo.read.parse\""), 0);
+    NOPRINT_NEQ(count_of(json, "\"name\":\"coo.read.wait\""), 0);
+    NOPRINT_NEQ(count_of(json, "\"name\":\"csr.convert.scatter\""), 0);
+    NOPRINT_NEQ(count_of(json, "\"name\":\"csr.convert.wait\""), 0);
+    EQ(count_of(json, "\"name\":\"coo.read\""), 1);
+    EQ(count_of(json, "\"items\":20000"), 2);
+    EQ(count_of(json, "\"name\":\"coo.read.parse\""),
+            count_of(json, "\"name\":\"csr.convert.scatter\""));
+
+    r.free();
+    csr.free();
+    return 0;
+}
+
+int threads() {
+    // Threads outside of OpenMP get their own tracks
+    clear_trace();
+    enable_tracing();
+    thread t { []() {
+        COO<> c = generate_gnm(100, 1000, 3);
+        CSR<> csr { c };
+        c.free();
+        csr.free();
+    } };
+    t.join();
+    COO<> c = generate_gnm(100, 1000, 3);
+    CSR<> csr { c };
+    enable_tracing(false);
+
+    string json = trace_json();
+    NOPRINT_NEQ(count_of(json, "\"name\":\"thread_name\""), 1);
+    EQ(count_of(json, "\"name\":\"csr.convert\""), 2);
+
+    clear_trace();
+    EQ(count_of(trace_json(), "\"ph\":\"X\""), 0);
+    c.free();
+    csr.free();
+    return 0;
+}
+
+int main() {
+    int pass = 0;
+
+    #ifdef PIGO_NO_INSTRUMENTATION
+    // Only the disabled behavior is compiled in
+    TEST(disabled);
+    return pass;
+    #endif
+
+    TEST(disabled);
+    TEST(read_trace, ".test.trace.el");
+    TEST(threads);
+
+    return pass;
+}
@@ -0,0 +1,200 @@
+/**
+ * PIGO: a parallel graph and matrix I/O and preprocessing library
+ * Copyright (c) 2021 GT-TDALab
+ *
+ * This file contains tests for writing ASCII values
+ */
+
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <string>
+
+#include "tests.hpp"
+#include "pigo.hpp"
+
+using namespace std;
+using namespace pigo;
+
+template<class T>
+string ascii(T val) {
+    char buf[64];
+    FilePos fp = buf;
+    write_ascii(fp, val);
+    return string(buf, fp-buf);
+}
+
+template<class T>
+int check_int(T val) {
+    string exp = to_string(val);
+    EQ(ascii(val), exp);
+    EQ(write_size(val), exp.size());
+    if (exp.size() > max_write_size<T>()) return 1;
+    return 0;
+}
+
+int integers() {
+    // Check around every power of ten
+    uint64_t pow = 1;
+    for (int digits = 1; digits <= 20; ++digits) {
+        if (check_int(pow) != 0) return 1;
+        if (check_int(pow-1) != 0) return 1;
+        if (check_int(pow+1) != 0) return 1;
+        if (check_int((int64_t)pow) != 0) return 1;
+        if (check_int(-(int64_t)pow) != 0) return 1;
+        if (digits < 20) pow *= 10;
+    }
+
+    // Check a spread of values with all digit lengths
+    uint64_t val = 1;
+    for (int step = 0; step < 100000; ++step) {
+        val = val*6364136223846793005ULL + 1442695040888963407ULL;
+        uint64_t shifted = val >> (step % 64);
+        if (check_int(shifted) != 0) return 1;
+        if (check_int((int32_t)shifted) != 0) return 1;
+        if (check_int((uint16_t)shifted) != 0) return 1;
+    }
+    return 0;
+}
+
+int integer_limits() {
+    if (check_int(numeric_limits<uint64_t>::max()) != 0) return 1;
+    if (check_int(numeric_limits<int64_t>::max()) != 0) return 1;
+    if (check_int(numeric_limits<int64_t>::min()) != 0) return 1;
+    if (check_int(numeric_limits<int32_t>::min()) != 0) return 1;
+    if (check_int(numeric_limits<uint8_t>::max()) != 0) return 1;
+    if (check_int(numeric_limits<int8_t>::min()) != 0) return 1;
+    if (check_int(0) != 0) return 1;
+    return 0;
+}
+
+template<class T>
+T parse(string str) {
+    if (sizeof(T) <= sizeof(float)) return (T)strtof(str.c_str(), nullptr);
+    return (T)strtod(str.c_str(), nullptr);
+}
+
+template<class T>
+T read_back(string str) {
+    FileReader r { str.c_str(), str.c_str()+str.size() };
+    return r.read_fp<T>();
+}
+
+template<class T>
+int check_fp(T val) {
+    string str = ascii(val);
+    EQ(write_size(val), str.size());
+    if (str.size() > max_write_size<T>()) return 1;
+
+    // The value must come back bit for bit
+    T back = parse<T>(str);
+    if (memcmp(&back, &val, sizeof(T)) != 0) return 1;
+    T read = read_back<T>(str);
+    if (memcmp(&read, &val, sizeof(T)) != 0) return 1;
+
+    // Rounding to at least two fewer digits must not round trip
+    string digits;
+    for (char c : str.substr(0, str.find('e')))
+        if (c >= '0' && c <= '9') digits += c;
+    digits.erase(0, digits.find_first_not_of('0'));
+    digits.erase(digits.find_last_not_of('0')+1);
+    for (int prec = 1; prec < (int)digits.size()-1; ++prec) {
+        char buf[512];
+        snprintf(buf, 512, "%.*g", prec, (double)val);
+        if (parse<T>(buf) == val) return 1;
+    }
+    return 0;
+}
+
+int floating_point() {
+    EQ(ascii(0.1), "0.1");
+    EQ(ascii(0.3f), "0.3");
+    EQ(ascii(5.), "5");
+    EQ(ascii(-2.5), "-2.5");
+    EQ(ascii(100.), "100");
+    EQ(ascii(1000.), "1e3");
+    EQ(ascii(0.001), "1e-3");
+    EQ(ascii(0.0125), "0.0125");
+    EQ(ascii(1e100), "1e100");
+    EQ(ascii(5e-324), "5e-324");
+    EQ(ascii(0.), "0");
+    EQ(ascii(-0.), "-0");
+    EQ(ascii(numeric_limits<double>::infinity()), "inf");
+    EQ(ascii(-numeric_limits<double>::infinity()), "-inf");
+    EQ(ascii(numeric_limits<double>::quiet_NaN()), "nan");
+    if (check_fp(numeric_limits<double>::infinity()) != 0) return 1;
+    if (check_fp(-numeric_limits<double>::infinity()) != 0) return 1;
+    if (check_fp(numeric_limits<float>::infinity()) != 0) return 1;
+    if (check_fp(-numeric_limits<float>::infinity()) != 0) return 1;
+    EQ(isnan(read_back<double>(ascii(numeric_limits<double>::quiet_NaN()))), true);
+    EQ(isnan(read_back<float>(ascii(numeric_limits<float>::quiet_NaN()))), true);
+
+    // Check every power of two
+    for (int exp = -1074; exp < 1024; ++exp)
+        if (check_fp(ldexp(1., exp)) != 0) return 1;
+    for (int exp = -149; exp < 128; ++exp)
+        if (check_fp(ldexpf(1.f, exp)) != 0) return 1;
+
+    // Check a spread of bit patterns and of typical weights
+    uint64_t bits = 1;
+    for (int step = 0; step < 100000; ++step) {
+        bits = bits*6364136223846793005ULL + 1442695040888963407ULL;
+        double d;
+        memcpy(&d, &bits, sizeof(d));
+        if (isfinite(d) && check_fp(d) != 0) return 1;
+        float f;
+        uint32_t fbits = (uint32_t)(bits >> 32);
+        memcpy(&f, &fbits, sizeof(f));
+        if (isfinite(f) && check_fp(f) != 0) return 1;
+        if (check_fp((double)(bits % 1000000) / 1000.) != 0) return 1;
+        if (check_fp((float)(bits % 1000000) / 100.f) != 0) return 1;
+    }
+    return 0;
+}
+
+int read_fp() {
+    FEQ(read_back<double>("1.5"), 1.5);
+    FEQ(read_back<double>("-2.25e2"), -225.);
+    FEQ(read_back<double>("+.5E-1"), 0.05);
+    FEQ(read_back<double>("  12"), 12.);
+    FEQ(read_back<float>("3.25"), 3.25f);
+    EQ(read_back<double>("1e400"), HUGE_VAL);
+    EQ(read_back<double>("1e-400"), 0.);
+
+    // Infinity and NaN are read in any case, and end at the word
+    EQ(read_back<double>("Inf"), HUGE_VAL);
+    EQ(read_back<double>(" -Infinity"), -HUGE_VAL);
+    EQ(read_back<float>("INF"), numeric_limits<float>::infinity());
+    EQ(isnan(read_back<double>("NaN")), true);
+    {
+        string line = "inf\n2.5 nan -inf";
+        FileReader r { line.c_str(), line.c_str()+line.size() };
+        EQ(r.read_fp<double>(), HUGE_VAL);
+        FEQ(r.read_fp<double>(), 2.5);
+        EQ(isnan(r.read_fp<double>()), true);
+        EQ(r.read_fp<double>(), -HUGE_VAL);
+    }
+
+    // Values with up to 19 significant digits round correctly
+    EQ(read_back<double>("9007199254740993"), 9007199254740992.);
+    EQ(read_back<double>("9007199254740995"), 9007199254740996.);
+    EQ(read_back<double>("2.2250738585072011e-308"), 2.2250738585072011e-308);
+    EQ(read_back<double>("4.9406564584124654e-324"), 5e-324);
+    EQ(read_back<double>("1.7976931348623157e308"), 1.7976931348623157e308);
+    EQ(read_back<float>("16777217"), 16777216.f);
+    EQ(read_back<float>("1.000000178813934"), 1.0000001f);
+    return 0;
+}
+
+int main() {
+    int pass = 0;
+
+    TEST(integers);
+    TEST(integer_limits);
+    TEST(floating_point);
+    TEST(read_fp);
+
+    return pass;
+}
@@ -8,6 +8,9 @@
 #include "tests.hpp"
 #include "pigo.hpp"
 
+#include <cstdio>
+#include <cstring>
+
 using namespace std;
 using namespace pigo;
 
@@ -76,6 +79,146 @@ int fail_diff_bin(string dir_path) {
     return 0;
 }
 
+int same_file(string fn_a, string fn_b) {
+    ROFile a { fn_a };
+    ROFile b { fn_b };
+    EQ(a.size(), b.size());
+    EQ(memcmp(a.fp(), b.fp(), a.size()), 0);
+    return 0;
+}
+
+int direct_bin(string dir_path) {
+    // A small file only fills part of one block
+    COO<uint8_t, uint8_t> c { dir_path + "/clean.el", EDGE_LIST };
+    SaveStats mapped = c.save(".test.write_bin.pigo");
+    SaveStats direct = c.save(".test.write_bin.direct.pigo", DIRECT);
+    EQ(direct.bytes, mapped.bytes);
+    if (same_file(".test.write_bin.pigo", ".test.write_bin.direct.pigo") != 0) return 1;
+    c.free();
+
+    // A larger file spans several parallel chunks, with unaligned arrays
+    {
+        FILE* el = fopen(".test.write_bin.el", "w");
+        if (el == NULL) return 1;
+        for (size_t e = 0; e < 1500000; ++e)
+            fprintf(el, "%zu %zu %zu\n", e, e*7+3, e % 13);
+        fclose(el);
+    }
+    WCOO<uint64_t, uint64_t, uint64_t*, uint16_t> big { ".test.write_bin.el" };
+    mapped = big.save(".test.write_bin.pigo");
+    direct = big.save(".test.write_bin.direct.pigo", DIRECT);
+    EQ(direct.bytes, mapped.bytes);
+    if (direct.bandwidth() <= 0) return 1;
+    if (same_file(".test.write_bin.pigo", ".test.write_bin.direct.pigo") != 0) return 1;
+
+    WCOO<uint64_t, uint64_t, uint64_t*, uint16_t> reread { ".test.write_bin.direct.pigo" };
+    EQ(reread.m(), big.m());
+    EQ(reread.w()[1234567], big.w()[1234567]);
+    reread.free();
+    big.free();
+
+    return 0;
+}
+
+int flip_byte(string fn, size_t offset) {
+    FILE* f = fopen(fn.c_str(), "r+b");
+    if (f == NULL) return 1;
+    fseek(f, offset, SEEK_SET);
+    int c = fgetc(f);
+    fseek(f, offset, SEEK_SET);
+    fputc(c ^ 0x10, f);
+    fclose(f);
+    return 0;
+}
+
+int checksum_bin(string dir_path) {
+    (void)dir_path;
+    // The standard CRC32C check value
+    EQ(detail::crc32c_("123456789", 9), 0xE3069283);
+    EQ(detail::crc32c_("56789", 5, detail::crc32c_("1234", 4)), 0xE3069283);
+    EQ(detail::crc32c_combine_(detail::crc32c_("1234", 4), detail::crc32c_("56789", 5), 5),
+            0xE3069283);
+
+    {
+        FILE* el = fopen(".test.write_bin.el", "w");
+        if (el == NULL) return 1;
+        for (size_t e = 0; e < 1500000; ++e)
+            fprintf(el, "%zu %zu %zu\n", e, e*7+3, e % 13);
+        fclose(el);
+    }
+    WCOO<uint64_t, uint64_t, uint64_t*, uint16_t> big { ".test.write_bin.el" };
+    SaveStats plain = big.save(".test.write_bin.pigo");
+    SaveStats mapped = big.save(".test.write_bin.crc.pigo", MAPPED, CRC32C);
+    SaveStats direct = big.save(".test.write_bin.direct.pigo", DIRECT, CRC32C);
+    if (mapped.bytes <= plain.bytes) return 1;
+    EQ(direct.bytes, mapped.bytes);
+    if (same_file(".test.write_bin.crc.pigo", ".test.write_bin.direct.pigo") != 0) return 1;
+
+    // The data is unchanged ahead of the trailer
+    {
+        ROFile a { ".test.write_bin.pigo" };
+        ROFile b { ".test.write_bin.crc.pigo" };
+        EQ(memcmp(a.fp(), b.fp(), a.size()), 0);
+    }
+
+    WCOO<uint64_t, uint64_t, uint64_t*, uint16_t> reread { ".test.write_bin.crc.pigo" };
+    EQ(reread.m(), big.m());
+    EQ(reread.x()[1234567], big.x()[1234567]);
+    EQ(reread.w()[1234567], big.w()[1234567]);
+    reread.free();
+
+    // Corrupting the data, the sizes, or the trailer is detected
+    size_t offsets[] = { plain.bytes/2, 20, mapped.bytes - 30 };
+    for (size_t offset : offsets) {
+        if (flip_byte(".test.write_bin.direct.pigo", offset) != 0) return 1;
+        bool threw = false;
+        try {
+            WCOO<uint64_t, uint64_t, uint64_t*, uint16_t> bad { ".test.write_bin.direct.pigo" };
+            bad.free();
+        } catch (Error&) { threw = true; }
+        EQ(threw, true);
+        if (flip_byte(".test.write_bin.direct.pigo", offset) != 0) return 1;
+    }
+
+    big.free();
+    return 0;
+}
+
+int convert_bin(string dir_path) {
+    // Small windows split the file mid-line many times over
+    COO<>::convert(dir_path + "/with-comments.el", ".test.write_bin.conv.pigo", 7);
+    COO<> small { dir_path + "/with-comments.el" };
+    small.save(".test.write_bin.pigo");
+    small.free();
+    if (same_file(".test.write_bin.pigo", ".test.write_bin.conv.pigo") != 0) return 1;
+
+    {
+        FILE* el = fopen(".test.write_bin.el", "w");
+        if (el == NULL) return 1;
+        fprintf(el, "# a comment\n");
+        for (size_t e = 0; e < 300000; ++e)
+            fprintf(el, "%zu %zu %zu\n", e % 1000, (e*7+3) % 5000, e % 13);
+        fclose(el);
+    }
+    typedef COO<uint32_t, uint64_t, uint32_t*, false, false, false, true, uint16_t, uint16_t*> WC;
+    SaveStats conv = WC::convert(".test.write_bin.el", ".test.write_bin.conv.pigo", 1<<16);
+    WC big { ".test.write_bin.el" };
+    SaveStats saved = big.save(".test.write_bin.pigo");
+    big.free();
+    EQ(conv.bytes, saved.bytes);
+    if (same_file(".test.write_bin.pigo", ".test.write_bin.conv.pigo") != 0) return 1;
+
+    // Symmetrizing and dropping self loops happen while streaming too
+    typedef COO<uint32_t, uint64_t, uint32_t*, true, false, true> SC;
+    SC::convert(".test.write_bin.el", ".test.write_bin.conv.pigo", 1<<16);
+    SC sym { ".test.write_bin.el" };
+    sym.save(".test.write_bin.pigo");
+    sym.free();
+    if (same_file(".test.write_bin.pigo", ".test.write_bin.conv.pigo") != 0) return 1;
+
+    return 0;
+}
+
 int main(int argc, char **argv) {
     int pass = 0;
 
@@ -89,6 +232,9 @@ int main(int argc, char **argv) {
     TEST(write_bin, dir_path);
     TEST(read_bin, dir_path);
     TEST(fail_diff_bin, dir_path);
+    TEST(direct_bin, dir_path);
+    TEST(checksum_bin, dir_path);
+    TEST(convert_bin, dir_path);
 
     return pass;
 }
@@ -0,0 +1,146 @@
+/**
+ * PIGO: a parallel graph and matrix I/O and preprocessing library
+ * Copyright (c) 2021 GT-TDALab
+ *
+ * This file contains tests for exporting COOs as bulk-load CSV files
+ */
+
+#include "tests.hpp"
+#include "pigo.hpp"
+
+#include <fstream>
+#include <sstream>
+#include <string>
+
+using namespace std;
+using namespace pigo;
+
+string read_file(string fn) {
+    ifstream f { fn };
+    stringstream ss;
+    ss << f.rdbuf();
+    return ss.str();
+}
+
+int split_write(string dir_path) {
+    COO<> c { dir_path + "/clean.el" };
+
+    c.split_cvs_write(".tmp.test_coo_csv", 3, true);
+
+    EQ(read_file(".tmp.test_coo_csv.0.csv"),
+            "~id,~from,~to,~label\ne0,v0,v1,con\ne1,v1,v2,con\ne2,v2,v3,con\n");
+    EQ(read_file(".tmp.test_coo_csv.1.csv"),
+            "~id,~from,~to,~label\ne3,v3,v4,con\ne4,v4,v5,con\ne5,v5,v0,con\n");
+    EQ(read_file(".tmp.test_coo_csv.2.csv"),
+            "~id,~from,~to,~label\ne6,v2,v9,con\n");
+
+    // There should be no additional file
+    ifstream missing { ".tmp.test_coo_csv.3.csv" };
+    EQ(missing.good(), false);
+
+    c.free();
+    return 0;
+}
+
+int export_vertices(string dir_path) {
+    COO<> c { dir_path + "/clean.el" };
+
+    CSVExportOptions opts;
+    opts.entries_per_file = 4;
+    opts.edge_label = "link";
+    opts.vertices = true;
+    opts.vertex_label = "node";
+    opts.vertex_id_prefix = "n";
+    c.csv_export(".tmp.test_coo_csv_v", opts);
+
+    EQ(read_file(".tmp.test_coo_csv_v.0.csv"),
+            "~from,~to,~label\nn0,n1,link\nn1,n2,link\nn2,n3,link\nn3,n4,link\n");
+    EQ(read_file(".tmp.test_coo_csv_v.1.csv"),
+            "~from,~to,~label\nn4,n5,link\nn5,n0,link\nn2,n9,link\n");
+
+    // Only the used labels are written, 6-8 are not used
+    EQ(read_file(".tmp.test_coo_csv_v.vertices.0.csv"),
+            "~id,~label\nn0,node\nn1,node\nn2,node\nn3,node\n");
+    EQ(read_file(".tmp.test_coo_csv_v.vertices.1.csv"),
+            "~id,~label\nn4,node\nn5,node\nn9,node\n");
+
+    c.free();
+    return 0;
+}
+
+int export_weights(string dir_path) {
+    WCOO<uint32_t, uint32_t, uint32_t*, int> c { dir_path + "/intweight.mtx" };
+
+    CSVExportOptions opts;
+    opts.weight_property = "w";
+    c.csv_export(".tmp.test_coo_csv_w", opts);
+
+    string res = read_file(".tmp.test_coo_csv_w.0.csv");
+    string header = "~from,~to,~label,w:Int\n";
+    EQ(res.substr(0, header.size()), header);
+
+    // Ensure each line has the weight at the end
+    istringstream lines { res.substr(header.size()) };
+    string line;
+    uint32_t e = 0;
+    while (getline(lines, line)) {
+        string exp = "v" + to_string(c.x()[e]) + ",v" + to_string(c.y()[e]) +
+            ",con," + to_string(c.w()[e]);
+        EQ(line, exp);
+        ++e;
+    }
+    EQ(e, c.m());
+
+    c.free();
+    return 0;
+}
+
+#ifdef PIGO_HAVE_ZLIB
+#include <zlib.h>
+
+int export_gzip(string dir_path) {
+    COO<> c { dir_path + "/clean.el" };
+
+    CSVExportOptions opts;
+    opts.entries_per_file = 5;
+    opts.vertices = true;
+    opts.gzip = true;
+    c.csv_export(".tmp.test_coo_csv_gz", opts);
+
+    gzFile gz = gzopen(".tmp.test_coo_csv_gz.1.csv.gz", "rb");
+    NOPRINT_NEQ(gz, (gzFile)NULL);
+    char buf[1024];
+    int len = gzread(gz, buf, sizeof(buf));
+    gzclose(gz);
+    EQ(string(buf, len), "~from,~to,~label\nv5,v0,con\nv2,v9,con\n");
+
+    gz = gzopen(".tmp.test_coo_csv_gz.vertices.1.csv.gz", "rb");
+    NOPRINT_NEQ(gz, (gzFile)NULL);
+    len = gzread(gz, buf, sizeof(buf));
+    gzclose(gz);
+    EQ(string(buf, len), "~id,~label\nv5,vertex\nv9,vertex\n");
+
+    c.free();
+    return 0;
+}
+#endif
+
+int main(int argc, char **argv) {
+    int pass = 0;
+
+    if (argc != 2) {
+        cerr << "Usage: " << argv[0] << " test-source-path" << endl;
+        return 1;
+    }
+
+    string dir_path = string(argv[1]) + "/data";
+
+    TEST(split_write, dir_path);
+    TEST(export_vertices, dir_path);
+    TEST(export_weights, dir_path);
+    #ifdef PIGO_HAVE_ZLIB
+    TEST(export_gzip, dir_path);
+    #endif
+
+    return pass;
+}
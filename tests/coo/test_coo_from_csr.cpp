@@ -33,6 +33,8 @@ int sym() {
 
     EQ(sym_coo.n(), 6);
     EQ(sym_coo.m(), 10);
+    EQ(sym_coo.nrows(), 6);
+    EQ(sym_coo.ncols(), 6);
 
     auto& xn = sym_coo.x(); auto& yn = sym_coo.y();
     i = 0;
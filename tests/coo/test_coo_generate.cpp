@@ -0,0 +1,182 @@
+/**
+ * PIGO: a parallel graph and matrix I/O and preprocessing library
+ * Copyright (c) 2022 GT-TDALab
+ *
+ * This file contains tests for the synthetic graph generators
+ */
+
+#include "tests.hpp"
+#include "pigo.hpp"
+
+#include <set>
+#include <utility>
+#include <vector>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+using namespace std;
+using namespace pigo;
+
+void set_threads(int threads) {
+    #ifdef _OPENMP
+    omp_set_num_threads(threads);
+    #else
+    (void)threads;
+    #endif
+}
+
+template<class C>
+set<pair<uint32_t, uint32_t>> edges(C& c) {
+    set<pair<uint32_t, uint32_t>> es;
+    for (uint32_t e = 0; e < c.m(); ++e)
+        es.insert(make_pair(c.x()[e], c.y()[e]));
+    return es;
+}
+
+int rmat() {
+    set_threads(1);
+    COO<> c = generate_rmat(10, 8, 42);
+    EQ(c.n(), 1024);
+    EQ(c.nrows(), 1024);
+    EQ(c.m(), 8*1024);
+    vector<uint32_t> degs(c.n(), 0);
+    for (uint32_t e = 0; e < c.m(); ++e) {
+        if (c.x()[e] >= c.n() || c.y()[e] >= c.n()) return 1;
+        ++degs[c.x()[e]];
+    }
+    // The degrees are skewed
+    uint32_t max_deg = 0;
+    for (auto d : degs) max_deg = max(max_deg, d);
+    NOPRINT_NEQ(max_deg < 64, true);
+
+    // The result does not depend on the thread count
+    set_threads(3);
+    COO<> again = generate_rmat(10, 8, 42);
+    for (uint32_t e = 0; e < c.m(); ++e) {
+        EQ(again.x()[e], c.x()[e]);
+        EQ(again.y()[e], c.y()[e]);
+    }
+    COO<> other = generate_rmat(10, 8, 43);
+    NOPRINT_NEQ(edges(other) == edges(c), true);
+
+    // Permuting relabels vertices without merging any
+    detail::LabelPermutation_ perm { 10, 42 };
+    set<uint64_t> labels;
+    for (uint64_t v = 0; v < 1024; ++v)
+        labels.insert(perm(v));
+    EQ(labels.size(), 1024);
+    EQ(*labels.rbegin(), 1023);
+
+    c.free();
+    again.free();
+    other.free();
+    return 0;
+}
+
+int gnm() {
+    COO<uint64_t> c = generate_gnm<uint64_t>(500, 4000, 3);
+    EQ(c.n(), 500);
+    EQ(c.m(), 4000);
+    for (uint64_t e = 0; e < c.m(); ++e) {
+        NOPRINT_NEQ(c.x()[e], c.y()[e]);
+        if (c.x()[e] >= 500 || c.y()[e] >= 500) return 1;
+    }
+    c.free();
+    return 0;
+}
+
+int gnp() {
+    const uint32_t n = 2000;
+    const double p = 0.01;
+    COO<> c = generate_gnp(n, p, 5);
+    EQ(c.n(), n);
+    // The edge count is within 5 standard deviations of its mean
+    double mean = p * n * (n-1);
+    double sd = sqrt(mean * (1-p));
+    if (c.m() < mean - 5*sd || c.m() > mean + 5*sd) {
+        cerr << c.m() << " edges, expected about " << mean << endl;
+        return 1;
+    }
+    for (uint32_t e = 0; e < c.m(); ++e) {
+        NOPRINT_NEQ(c.x()[e], c.y()[e]);
+        if (e > 0 && make_pair(c.x()[e-1], c.y()[e-1]) >= make_pair(c.x()[e], c.y()[e]))
+            return 1;
+    }
+    c.free();
+
+    // p = 1 is the complete graph
+    COO<> full = generate_gnp(20, 1.);
+    EQ(full.m(), 20*19);
+    EQ(edges(full).size(), 20*19);
+    full.free();
+
+    COO<> empty = generate_gnp(20, 0.);
+    EQ(empty.m(), 0);
+    return 0;
+}
+
+int ba() {
+    const uint32_t n = 5000, k = 4;
+    COO<> c = generate_ba(n, k, 9);
+    EQ(c.m(), (n-1)*k);
+    vector<uint32_t> degs(n, 0);
+    for (uint32_t e = 0; e < c.m(); ++e) {
+        EQ(c.x()[e], e / k + 1);
+        if (c.y()[e] >= c.x()[e]) return 1;
+        ++degs[c.x()[e]];
+        ++degs[c.y()[e]];
+    }
+    // Preferential attachment concentrates edges on early vertices
+    uint32_t max_deg = 0;
+    for (auto d : degs) max_deg = max(max_deg, d);
+    NOPRINT_NEQ(max_deg < 10*k, true);
+    c.free();
+    return 0;
+}
+
+int grid() {
+    COO<> g2 = generate_grid(3, 4);
+    EQ(g2.n(), 12);
+    EQ(g2.m(), 2*(2*4 + 3*3));
+    auto es = edges(g2);
+    EQ(es.size(), g2.m());
+    for (auto e : es)
+        EQ(es.count(make_pair(e.second, e.first)), 1);
+    EQ(es.count(make_pair(4u, 1u)), 1);
+    EQ(es.count(make_pair(4u, 7u)), 1);
+    EQ(es.count(make_pair(2u, 3u)), 0);
+    g2.free();
+
+    COO<> g3 = generate_grid(2, 3, 4);
+    EQ(g3.n(), 24);
+    EQ(g3.m(), 2*(1*3*4 + 2*2*4 + 2*3*3));
+    for (uint32_t e = 1; e < g3.m(); ++e)
+        if (make_pair(g3.x()[e-1], g3.y()[e-1]) >= make_pair(g3.x()[e], g3.y()[e]))
+            return 1;
+    g3.free();
+    return 0;
+}
+
+int weighted() {
+    COO<uint32_t, uint32_t, vector<uint32_t>, false, false, false, true, double,
+        vector<double>> c = generate_rmat<uint32_t, uint32_t, vector<uint32_t>,
+        true, double, vector<double>>(6, 4);
+    EQ(c.m(), 256);
+    for (auto w : c.w())
+        FEQ(w, 1.);
+    return 0;
+}
+
+int main() {
+    int pass = 0;
+
+    TEST(rmat);
+    TEST(gnm);
+    TEST(gnp);
+    TEST(ba);
+    TEST(grid);
+    TEST(weighted);
+
+    return pass;
+}
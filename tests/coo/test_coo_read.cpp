@@ -134,6 +134,29 @@ int read_from_csr_graph(string dir_path) {
     return 0;
 }
 
+int validate(string dir_path) {
+    COO<uint32_t, uint32_t, vector<uint32_t> >
+        c { dir_path + "/clean.el", EDGE_LIST };
+    c.validate();
+
+    // The last edge comes after a larger row
+    try {
+        c.validate(true);
+        EQ(1, 0);
+    } catch (Error& e) {
+        EQ(string(e.what()), "PIGO: COO entry is not sorted at index 6");
+    }
+
+    c.x()[3] = c.nrows();
+    try {
+        c.validate();
+        EQ(1, 0);
+    } catch (Error& e) {
+        EQ(string(e.what()), "PIGO: COO entry is outside of the matrix at index 3");
+    }
+    return 0;
+}
+
 int main(int argc, char **argv) {
     int pass = 0;
 
@@ -150,6 +173,7 @@ int main(int argc, char **argv) {
     TEST(read_dirty_clean, dir_path);
     TEST(read_from_csr_bin, dir_path);
     TEST(read_from_csr_graph, dir_path);
+    TEST(validate, dir_path);
 
     return pass;
 }
@@ -0,0 +1,124 @@
+/**
+ * PIGO: a parallel graph and matrix I/O and preprocessing library
+ * Copyright (c) 2022 GT-TDALab
+ *
+ * This file contains tests for estimating statistics from samples
+ */
+
+#include "tests.hpp"
+#include "pigo.hpp"
+
+#include <fstream>
+#include <random>
+#include <vector>
+
+using namespace std;
+using namespace pigo;
+
+int within(const Estimate& e, double val) {
+    if (e.low > val || e.high < val) {
+        cerr << val << " is not in [" << e.low << ", " << e.high << "]" << endl;
+        return 1;
+    }
+    return 0;
+}
+
+int exact(string dir_path) {
+    // Small files are covered completely, giving exact statistics
+    SampleStats s = sample(dir_path + "/selfloop.el");
+    EQ(s.exact, true);
+
+    COO<> coo { dir_path + "/selfloop.el" };
+    EQ(s.entries.value, coo.m());
+    EQ(s.entries.low, coo.m());
+    EQ(s.entries.high, coo.m());
+    EQ(s.max_label.value, coo.n()-1);
+
+    size_t self_loops = 0;
+    for (size_t e = 0; e < coo.m(); ++e)
+        if (coo.x()[e] == coo.y()[e]) ++self_loops;
+    FEQ(s.self_loop_rate.value, (double)self_loops / coo.m());
+    coo.free();
+
+    // Matrix market headers are not entries
+    SampleStats mm = sample(dir_path + "/sparse.mtx");
+    COO<> mm_coo { dir_path + "/sparse.mtx" };
+    EQ(mm.entries.value, mm_coo.m());
+    mm_coo.free();
+
+    return 0;
+}
+
+int estimate() {
+    // Write a shuffled edge list with known statistics
+    const size_t m = 400000;
+    const uint32_t n = 100000;
+    mt19937 gen { 7 };
+    uniform_int_distribution<uint32_t> label { 0, n-1 };
+    size_t self_loops = 0;
+    uint32_t max_label = 0;
+    {
+        ofstream out { ".test.sample.el" };
+        out << "# a comment line\n";
+        for (size_t e = 0; e < m; ++e) {
+            uint32_t x = label(gen);
+            uint32_t y = (e % 20 == 0) ? x : label(gen);
+            if (x == y) ++self_loops;
+            max_label = max(max_label, max(x, y));
+            out << x << " " << y << "\n";
+        }
+    }
+
+    SampleStats s = sample(".test.sample.el", 32, 1<<14, 1);
+    EQ(s.exact, false);
+    EQ(s.windows, 32);
+    EQ(s.rows_grouped, false);
+    EQ(s.bytes_sampled, 32*(1<<14));
+    if (within(s.lines, m+1)) return 1;
+    if (within(s.entries, m)) return 1;
+    if (within(s.max_label, max_label)) return 1;
+    if (within(s.self_loop_rate, (double)self_loops / m)) return 1;
+    NOPRINT_NEQ(s.degree_histogram.size(), 0);
+
+    // The same seed samples the same windows
+    SampleStats again = sample(".test.sample.el", 32, 1<<14, 1);
+    EQ(again.entries.value, s.entries.value);
+    EQ(again.lines_sampled, s.lines_sampled);
+
+    return 0;
+}
+
+int grouped() {
+    // Rows written contiguously have their degrees counted
+    {
+        ofstream out { ".test.sample.el" };
+        for (uint32_t v = 0; v < 20000; ++v)
+            for (uint32_t d = 0; d < 1 + v % 8; ++d)
+                out << v << " " << d << "\n";
+    }
+    SampleStats s = sample(".test.sample.el", 16, 1<<12);
+    EQ(s.exact, false);
+    EQ(s.rows_grouped, true);
+    EQ(s.max_degree.value, 8);
+    EQ(s.degree_histogram.size(), 4);
+    FEQ(s.duplicate_rate.value, 0.);
+
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    int pass = 0;
+
+    if (argc != 2) {
+        cerr << "Usage: " << argv[0] << " test-source-path" << endl;
+        return 1;
+    }
+
+    string dir_path = string(argv[1]) + "/data";
+
+    TEST(exact, dir_path);
+    TEST(estimate);
+    TEST(grouped);
+
+    return pass;
+}
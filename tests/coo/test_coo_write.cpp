@@ -8,9 +8,23 @@
 #include "tests.hpp"
 #include "pigo.hpp"
 
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <limits>
 #include <memory>
+#include <string>
 #include <vector>
 
+#include <unistd.h>
+
+#ifdef PIGO_HAVE_ZLIB
+#include <zlib.h>
+#endif
+#ifdef PIGO_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
 using namespace std;
 using namespace pigo;
 
@@ -63,6 +77,34 @@ int weights(string dir_path) {
     return 0;
 }
 
+int nonfinite_weights() {
+    WCOO<uint32_t, uint32_t, uint32_t*, double> coo { 3, 3, 3, 4 };
+    double ws[] = { numeric_limits<double>::infinity(), 2.5, 1000.,
+        -numeric_limits<double>::infinity() };
+    for (uint32_t e = 0; e < 4; ++e) {
+        coo.x()[e] = e % 3;
+        coo.y()[e] = (e+1) % 3;
+        coo.w()[e] = ws[e];
+    }
+    coo.w()[3] = numeric_limits<double>::quiet_NaN();
+    ws[3] = coo.w()[3];
+
+    // Infinity and NaN must not swallow the following edges
+    coo.write(".tmp.test_coo_write.out");
+    WCOO<uint32_t, uint32_t, uint32_t*, double> coo_r { ".tmp.test_coo_write.out", EDGE_LIST };
+    EQ(coo_r.m(), 4);
+    for (uint32_t e = 0; e < 4; ++e) {
+        EQ(coo_r.x()[e], coo.x()[e]);
+        EQ(coo_r.y()[e], coo.y()[e]);
+        if (e < 3) EQ(coo_r.w()[e], ws[e]);
+    }
+    EQ(isnan(coo_r.w()[3]), true);
+
+    coo_r.free();
+    coo.free();
+    return 0;
+}
+
 int neg_weight(string dir_path) {
     WCOOPtr<int, size_t, int> coo { dir_path + "/intweight.mtx" };
 
@@ -87,6 +129,123 @@ int neg_weight(string dir_path) {
     return 0;
 }
 
+int buffered(string dir_path) {
+    WCOOPtr<int, size_t, int> coo { dir_path + "/intweight.mtx" };
+
+    // Both write modes must produce the same file
+    coo.write(".tmp.test_coo_write.out");
+    coo.write(".tmp.test_coo_write.buf.out", BUFFERED);
+
+    File f { ".tmp.test_coo_write.out", READ };
+    File f_buf { ".tmp.test_coo_write.buf.out", READ };
+    EQ(f_buf.size(), f.size());
+    EQ(memcmp(f.fp(), f_buf.fp(), f.size()), 0);
+
+    coo.free();
+    return 0;
+}
+
+int streamed(string dir_path) {
+    // Use enough edges to span several streamed chunks
+    {
+        FILE* el = fopen(".tmp.test_coo_write.el", "w");
+        if (el == NULL) return 1;
+        for (size_t e = 0; e < 300000; ++e)
+            fprintf(el, "%zu %zu %f\n", e % 1237, e, e / 8.);
+        fclose(el);
+    }
+    WCOOPtr<uint32_t, size_t, double> big { ".tmp.test_coo_write.el" };
+    big.write(".tmp.test_coo_write.out");
+    big.write(".tmp.test_coo_write.stream.out", STREAM);
+    {
+        File f { ".tmp.test_coo_write.out", READ };
+        File f_stream { ".tmp.test_coo_write.stream.out", READ };
+        EQ(f_stream.size(), f.size());
+        EQ(memcmp(f.fp(), f_stream.fp(), f.size()), 0);
+    }
+    big.free();
+
+    // Stream through a pipe, with a tiny buffer forcing many writes
+    WCOOPtr<int, size_t, int> coo { dir_path + "/intweight.mtx" };
+    coo.write(".tmp.test_coo_write.out");
+    int fds[2];
+    EQ(pipe(fds), 0);
+    {
+        WStream out { fds[1], 7 };
+        coo.write(out);
+        out.flush();
+        EQ(out.size(), 33);
+    }
+    close(fds[1]);
+    string piped;
+    char buf[256];
+    ssize_t got;
+    while ((got = read(fds[0], buf, sizeof(buf))) > 0)
+        piped.append(buf, got);
+    close(fds[0]);
+
+    File f { ".tmp.test_coo_write.out", READ };
+    EQ(piped.size(), f.size());
+    EQ(memcmp(f.fp(), piped.data(), f.size()), 0);
+
+    coo.free();
+    return 0;
+}
+
+int compressed(string dir_path) {
+    (void)dir_path;
+    // Use enough edges to span several compressed chunks
+    {
+        FILE* el = fopen(".tmp.test_coo_write.el", "w");
+        if (el == NULL) return 1;
+        for (size_t e = 0; e < 300000; ++e)
+            fprintf(el, "%zu %zu %zu\n", e % 1237, e, e*7);
+        fclose(el);
+    }
+    WCOOPtr<uint32_t, size_t, size_t> big { ".tmp.test_coo_write.el" };
+    big.write(".tmp.test_coo_write.out");
+    File f { ".tmp.test_coo_write.out", READ };
+    string expected { (const char*)f.fp(), f.size() };
+
+    #ifdef PIGO_HAVE_ZLIB
+    {
+        big.write(".tmp.test_coo_write.out.gz", GZIP);
+        gzFile gz = gzopen(".tmp.test_coo_write.out.gz", "rb");
+        NOPRINT_NEQ(gz, nullptr);
+        string unzipped;
+        char buf[1<<16];
+        int got;
+        while ((got = gzread(gz, buf, sizeof(buf))) > 0)
+            unzipped.append(buf, got);
+        gzclose(gz);
+        EQ(unzipped.size(), expected.size());
+        EQ(unzipped == expected, true);
+    }
+    #else
+    bool threw = false;
+    try {
+        big.write(".tmp.test_coo_write.out.gz", GZIP);
+    } catch (Error&) { threw = true; }
+    EQ(threw, true);
+    #endif
+
+    #ifdef PIGO_HAVE_ZSTD
+    {
+        big.write(".tmp.test_coo_write.out.zst", ZSTD);
+        ROFile zf { ".tmp.test_coo_write.out.zst" };
+        unsigned long long size = ZSTD_findDecompressedSize(zf.fp(), zf.size());
+        EQ(size, expected.size());
+        string unzipped(size, '\0');
+        size_t got = ZSTD_decompress(&unzipped[0], size, zf.fp(), zf.size());
+        EQ(got, size);
+        EQ(unzipped == expected, true);
+    }
+    #endif
+
+    big.free();
+    return 0;
+}
+
 int main(int argc, char **argv) {
     int pass = 0;
 
@@ -100,7 +259,11 @@ int main(int argc, char **argv) {
     TEST(use_shared_ptr, dir_path);
     TEST(use_def, dir_path);
     TEST(weights, dir_path);
+    TEST(nonfinite_weights);
     TEST(neg_weight, dir_path)
+    TEST(buffered, dir_path);
+    TEST(streamed, dir_path);
+    TEST(compressed, dir_path);
 
     return pass;
 }
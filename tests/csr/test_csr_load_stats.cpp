@@ -0,0 +1,118 @@
+/**
+ * PIGO: a parallel graph and matrix I/O and preprocessing library
+ * Copyright (c) 2022 GT-TDALab
+ *
+ * This file contains tests for gathering statistics while loading CSRs
+ */
+
+#include "tests.hpp"
+#include "pigo.hpp"
+
+#include <vector>
+
+using namespace std;
+using namespace pigo;
+
+/** Compare LoadStats against a sequential sweep over the CSR */
+template<class CSRT>
+int check_sweep(CSRT& csr, const LoadStats& s) {
+    auto offsets = csr.offsets();
+    auto endpoints = csr.endpoints();
+    size_t max_deg = 0, max_row = 0, empty = 0, self_loops = 0;
+    vector<size_t> hist;
+    for (size_t v = 0; v < csr.n(); ++v) {
+        size_t deg = offsets[v+1] - offsets[v];
+        if (deg == 0) ++empty;
+        if (deg > max_deg) {
+            max_deg = deg;
+            max_row = v;
+        }
+        if (deg > 0) {
+            size_t bucket = 0;
+            while ((deg >> (bucket+1)) != 0) ++bucket;
+            if (hist.size() <= bucket) hist.resize(bucket+1, 0);
+            ++hist[bucket];
+        }
+        for (size_t e = offsets[v]; e < (size_t)offsets[v+1]; ++e)
+            if ((size_t)endpoints[e] == v) ++self_loops;
+    }
+    EQ(s.rows, csr.n());
+    EQ(s.entries, offsets[csr.n()]);
+    EQ(s.max_degree, max_deg);
+    EQ(s.max_degree_row, max_row);
+    EQ(s.empty_rows, empty);
+    EQ(s.self_loops, self_loops);
+    EQ(s.degree_histogram.size(), hist.size());
+    for (size_t b = 0; b < hist.size(); ++b)
+        EQ(s.degree_histogram[b], hist[b]);
+    return 0;
+}
+
+int from_el(string dir_path) {
+    LoadStats s;
+    CSR<> csr { dir_path + "/dupedge.el", AUTO, &s };
+
+    EQ(s.rows, 9);
+    EQ(s.entries, 11);
+    EQ(s.max_degree, 3);
+    EQ(s.max_degree_row, 2);
+    EQ(s.empty_rows, 3);
+    EQ(s.self_loops, 1);
+    EQ(s.duplicates, 0);
+    EQ(s.degree_histogram.size(), 2);
+    EQ(s.degree_histogram[0], 3);
+    EQ(s.degree_histogram[1], 3);
+    FEQ(s.avg_degree(), 11./9);
+
+    // Removing duplicates reports the new CSR
+    LoadStats dedup_s;
+    CSR<> dedup = csr.new_csr_without_dups(&dedup_s);
+    EQ(dedup_s.entries, 10);
+    EQ(dedup_s.duplicates, 1);
+    EQ(dedup_s.self_loops, 1);
+    EQ(dedup_s.max_degree_row, 2);
+    if (check_sweep(dedup, dedup_s)) return 1;
+
+    dedup.free();
+    csr.free();
+    return 0;
+}
+
+int all_formats(string dir_path) {
+    LoadStats s;
+    CSR<> csr { dir_path + "/gnp_100_2.el", AUTO, &s };
+    if (check_sweep(csr, s)) return 1;
+
+    // Binary loads sweep the loaded CSR
+    csr.save(".test.load_stats.pigo");
+    LoadStats bin_s;
+    CSR<> bin { ".test.load_stats.pigo", AUTO, &bin_s };
+    if (check_sweep(bin, bin_s)) return 1;
+    bin.free();
+    csr.free();
+
+    for (string fn : { "/triangle.graph", "/base1.graph", "/tiny.graph" }) {
+        LoadStats graph_s;
+        CSR<> graph { dir_path + fn, AUTO, &graph_s };
+        if (check_sweep(graph, graph_s)) return 1;
+        graph.free();
+    }
+
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    int pass = 0;
+
+    if (argc != 2) {
+        cerr << "Usage: " << argv[0] << " test-source-path" << endl;
+        return 1;
+    }
+
+    string dir_path = string(argv[1]) + "/data";
+
+    TEST(from_el, dir_path);
+    TEST(all_formats, dir_path);
+
+    return pass;
+}
@@ -0,0 +1,126 @@
+/**
+ * PIGO: a parallel graph and matrix I/O and preprocessing library
+ * Copyright (c) 2021 GT-TDALab
+ *
+ * This contains tests for validating the structure of CSRs and DiGraphs
+ */
+
+#include "tests.hpp"
+#include "pigo.hpp"
+
+#include <cstring>
+#include <vector>
+
+using namespace std;
+using namespace pigo;
+
+template<class T>
+int fails_at(T& obj, bool sorted, string idx) {
+    try {
+        obj.validate(sorted);
+    } catch (Error& e) {
+        string what { e.what() };
+        string expect { "at index " + idx };
+        EQ(what.substr(what.size()-expect.size()), expect);
+        return 0;
+    }
+    EQ(1, 0);
+    return 1;
+}
+
+int first_invalid(string dir_path) {
+    (void)dir_path;
+    // Failures in later chunks and threads must not hide earlier ones
+    size_t first = detail::first_invalid_(1000000, [](size_t i) {
+            return i != 777777 && i != 900000 && i != 999999;
+        });
+    EQ(first, 777777);
+    first = detail::first_invalid_(1000000, [](size_t) { return true; });
+    EQ(first, 1000000);
+    first = detail::first_invalid_(0, [](size_t) { return false; });
+    EQ(first, 0);
+    return 0;
+}
+
+int validate_csr(string dir_path) {
+    CSR<int, int, vector<int>, vector<int>> orig { dir_path + "/base1.graph" };
+    orig.validate();
+    // Row zero is empty in one-based files
+    if (fails_at(orig, true, "1") != 0) return 1;
+    orig.sort();
+    orig.validate(true);
+
+    auto& offsets = orig.offsets();
+
+    CSR<int, int, vector<int>, vector<int>> bad = orig;
+    bad.offsets()[3] = offsets[4] + 1;
+    if (fails_at(bad, false, "3") != 0) return 1;
+
+    bad = orig;
+    bad.offsets()[orig.n()] = orig.m() + 1;
+    if (fails_at(bad, false, to_string(orig.n())) != 0) return 1;
+
+    bad = orig;
+    bad.endpoints()[7] = orig.ncols();
+    if (fails_at(bad, false, "7") != 0) return 1;
+
+    bad = orig;
+    bad.endpoints()[5] = -1;
+    bad.endpoints()[9] = -3;
+    if (fails_at(bad, false, "5") != 0) return 1;
+    return 0;
+}
+
+int validate_empty(string dir_path) {
+    // Default and freed CSRs have no offsets to check
+    CSR<> empty;
+    bool thrown = false;
+    try {
+        empty.validate();
+    } catch (Error&) {
+        thrown = true;
+    }
+    EQ(thrown, true);
+
+    CSR<> freed { dir_path + "/base1.graph" };
+    freed.validate();
+    freed.free();
+    thrown = false;
+    try {
+        freed.validate();
+    } catch (Error&) {
+        thrown = true;
+    }
+    EQ(thrown, true);
+    return 0;
+}
+
+int validate_digraph(string dir_path) {
+    DiGraph<> g { dir_path + "/gnp_100_2.el" };
+    g.validate();
+    g.out().endpoints()[100] = g.n();
+    try {
+        g.validate();
+        EQ(1, 0);
+    } catch (Error&) { }
+    g.free();
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    int pass = 0;
+
+    if (argc != 2) {
+        cerr << "Usage: " << argv[0] << " test-source-path" << endl;
+        return 1;
+    }
+
+    string dir_path = string(argv[1]) + "/data";
+
+    TEST(first_invalid, dir_path);
+    TEST(validate_csr, dir_path);
+    TEST(validate_empty, dir_path);
+    TEST(validate_digraph, dir_path);
+
+    return pass;
+}
@@ -8,6 +8,7 @@
 #include "tests.hpp"
 #include "pigo.hpp"
 
+#include <cstring>
 #include <memory>
 #include <vector>
 
@@ -55,6 +56,33 @@ int write_bin(string dir_path) {
     return 0;
 }
 
+int direct_bin(string dir_path) {
+    DiGraph<> g { dir_path + "/gnp_100_2.el" };
+
+    SaveStats mapped = g.save(".test.dig_bin.pigo");
+    SaveStats direct = g.save(".test.dig_bin.direct.pigo", DIRECT);
+    EQ(direct.bytes, mapped.bytes);
+
+    // Both save modes must produce the same file
+    ROFile f { ".test.dig_bin.pigo" };
+    ROFile f_direct { ".test.dig_bin.direct.pigo" };
+    EQ(f_direct.size(), f.size());
+    EQ(f.size(), mapped.bytes);
+    EQ(memcmp(f.fp(), f_direct.fp(), f.size()), 0);
+
+    // Checksummed files read back the same DiGraph
+    g.save(".test.dig_bin.crc.pigo", DIRECT, CRC32C);
+    DiGraph<> read { ".test.dig_bin.crc.pigo" };
+    EQ(read.n(), g.n());
+    EQ(read.m(), g.m());
+    for (size_t e = 0; e < read.m(); ++e)
+        EQ(read.out().endpoints()[e], g.out().endpoints()[e]);
+    read.free();
+
+    g.free();
+    return 0;
+}
+
 int main(int argc, char **argv) {
     int pass = 0;
 
@@ -66,6 +94,7 @@ int main(int argc, char **argv) {
     string dir_path = string(argv[1]) + "/data";
 
     TEST(write_bin, dir_path);
+    TEST(direct_bin, dir_path);
 
     return pass;
 }
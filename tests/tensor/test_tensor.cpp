@@ -55,6 +55,20 @@ int write_tensor(string dir_path) {
     return 0;
 }
 
+int write_tensor_buffered(string dir_path) {
+    Tensor<int,int,vector<int>> r { dir_path + "/test.tns" };
+    r.write(".test.out.ascii");
+    r.write(".test.out.buf.ascii", BUFFERED);
+
+    File f { ".test.out.ascii", READ };
+    File f_buf { ".test.out.buf.ascii", READ };
+    EQ(f_buf.size(), f.size());
+    EQ(string(f.fp(), f.size()), string(f_buf.fp(), f_buf.size()));
+
+    r.free();
+    return 0;
+}
+
 int write_bin(string dir_path) {
     Tensor<int,int,vector<int>> r { dir_path + "/test.tns" };
     r.save(".test.out.bin");
@@ -130,6 +144,32 @@ int order_one_no_weight(string dir_path) {
     return 0;
 }
 
+int validate(string dir_path) {
+    Tensor<int,int,vector<int>,double,vector<double>> t { dir_path + "/test.tns" };
+    t.validate(true);
+
+    auto& c = t.c();
+    c[4] = 3;
+    try {
+        t.validate(true);
+        EQ(1, 0);
+    } catch (Error& e) {
+        EQ(string(e.what()), "PIGO: Tensor entry is not sorted at index 2");
+    }
+    t.validate();
+
+    c[13] = -1;
+    try {
+        t.validate();
+        EQ(1, 0);
+    } catch (Error& e) {
+        EQ(string(e.what()), "PIGO: Tensor coordinate is negative at index 3");
+    }
+
+    t.free();
+    return 0;
+}
+
 int main(int argc, char **argv) {
     int pass = 0;
 
@@ -142,10 +182,12 @@ int main(int argc, char **argv) {
 
     TEST(read_tensor, dir_path);
     TEST(write_tensor, dir_path);
+    TEST(write_tensor_buffered, dir_path);
     TEST(write_bin, dir_path);
     TEST(no_weight, dir_path);
     TEST(max_labs, dir_path);
     TEST(order_one_no_weight, dir_path);
+    TEST(validate, dir_path);
 
     return pass;
 }
@@ -7,6 +7,7 @@
 
 #include <cstdlib>
 #include <cmath>
+#include <cstddef>
 #include <iostream>
 
 /**
@@ -67,3 +68,23 @@
     } while(0);
 
 #define COMMA ,
+
+/** @brief Return whether two COOs hold the same entries, in order */
+template<class COOA, class COOB>
+bool same_coo(COOA& a, COOB& b) {
+    if (a.m() != b.m() || a.n() != b.n()) return false;
+    for (size_t e = 0; e < a.m(); ++e)
+        if (a.x()[e] != b.x()[e] || a.y()[e] != b.y()[e]) return false;
+    return true;
+}
+
+/** @brief Return whether two CSRs hold the same rows, in order */
+template<class CSRA, class CSRB>
+bool same_csr(CSRA& a, CSRB& b) {
+    if (a.m() != b.m() || a.n() != b.n()) return false;
+    for (size_t v = 0; v <= a.n(); ++v)
+        if (a.offsets()[v] != b.offsets()[v]) return false;
+    for (size_t e = 0; e < a.m(); ++e)
+        if (a.endpoints()[e] != b.endpoints()[e]) return false;
+    return true;
+}
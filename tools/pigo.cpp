@@ -0,0 +1,677 @@
+/**
+ * PIGO: a parallel graph and matrix I/O and preprocessing library
+ * Copyright (c) 2022 GT-TDALab
+ *
+ * This is the pigo command-line tool, which converts between the formats
+ * PIGO supports and inspects and validates graph and matrix files
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <future>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "pigo.hpp"
+
+using namespace std;
+using namespace pigo;
+
+/** The output formats of convert */
+enum OutFormat { OUT_EL, OUT_COO, OUT_CSR, OUT_DIGRAPH };
+
+/** The weight types the tool supports */
+enum WeightType { W_NONE, W_INT, W_FLOAT };
+
+/** The options shared by all subcommands */
+struct Options {
+    /** The label and ordinal width in bits, or 0 to detect it */
+    int width = 0;
+    /** The weight type */
+    WeightType weights = W_NONE;
+    /** The output format of convert */
+    OutFormat to = OUT_CSR;
+    /** Whether to symmetrize */
+    bool symmetrize = false;
+    /** Whether to remove duplicate entries */
+    bool dedup = false;
+    /** Whether to sort each row, or check sortedness in validate */
+    bool sort = false;
+    /** The SaveMode for binary outputs */
+    SaveMode save_mode = MAPPED;
+    /** The ChecksumMode for binary outputs */
+    ChecksumMode checksum = NO_CHECKSUM;
+    /** The number of windows read by sample */
+    size_t windows = 64;
+    /** The size of each window read by sample */
+    size_t window_size = 1<<16;
+    /** The R-MAT scale of generate */
+    unsigned scale = 16;
+    /** The R-MAT edges per vertex of generate */
+    uint64_t edge_factor = 16;
+    /** The number of vertices of generate */
+    uint64_t n = 1<<16;
+    /** The number of edges of generate gnm */
+    uint64_t m = 1<<20;
+    /** The edge probability of generate gnp */
+    double p = 1e-4;
+    /** The edges added per vertex of generate ba */
+    uint64_t k = 8;
+    /** The grid dimensions of generate */
+    vector<uint64_t> dims { 256, 256 };
+    /** The random seed of generate */
+    uint64_t seed = 1;
+    /** Whether to print the timing of each phase */
+    bool timings = false;
+    /** The Chrome trace file to write, if any */
+    string trace;
+    /** The file arguments */
+    vector<string> files;
+};
+
+static void usage() {
+    cerr <<
+        "Usage: pigo <command> [options] files...\n"
+        "\n"
+        "Commands:\n"
+        "  convert [options] IN OUT [IN OUT ...]\n"
+        "      Convert each IN to OUT. Reading the next input overlaps\n"
+        "      with writing the current output.\n"
+        "  generate rmat|gnm|gnp|ba|grid [options] OUT\n"
+        "      Generate a synthetic graph and write it like convert.\n"
+        "  info [options] FILE...\n"
+        "      Print the sizes, degree statistics and flags of each file.\n"
+        "  sample [options] FILE...\n"
+        "      Estimate the statistics of large edge lists from random\n"
+        "      windows, without loading them.\n"
+        "  validate [options] FILE...\n"
+        "      Check the structure of each file, exiting with 1 on errors.\n"
+        "\n"
+        "Options:\n"
+        "  --width 32|64           label and ordinal width (default: read\n"
+        "                          from binary inputs, otherwise 32)\n"
+        "  --weights none|int|float\n"
+        "                          the weight type (default: none)\n"
+        "  --to el|coo|csr|digraph the output format of convert (default: csr)\n"
+        "  --symmetrize            add the reverse of every edge\n"
+        "  --dedup                 remove duplicate edges\n"
+        "  --sort                  sort every row; with validate, require it\n"
+        "  --direct                save binaries with DIRECT writes\n"
+        "  --checksum              save binaries with CRC32C checksums\n"
+        "  --windows N             windows read by sample (default: 64)\n"
+        "  --window-size N         bytes per sample window (default: 65536)\n"
+        "  --scale S               rmat: 2^S vertices (default: 16)\n"
+        "  --edge-factor F         rmat: F edges per vertex (default: 16)\n"
+        "  --n N                   gnm, gnp, ba: vertices (default: 65536)\n"
+        "  --m M                   gnm: edges (default: 1048576)\n"
+        "  --p P                   gnp: edge probability (default: 0.0001)\n"
+        "  --k K                   ba: edges per new vertex (default: 8)\n"
+        "  --dims X[xY[xZ]]        grid: dimensions (default: 256x256)\n"
+        "  --seed S                the random seed of generate (default: 1)\n"
+        "  --timings               print the time of each phase to stderr\n"
+        "  --trace FILE            write a Chrome trace of every thread's\n"
+        "                          phases and waits to FILE\n"
+        "\n"
+        "Edge list outputs ending in .gz or .zst are compressed, and an\n"
+        "output of - writes an edge list to standard output.\n";
+}
+
+static bool ends_with(const string& s, const string& suffix) {
+    return s.size() >= suffix.size() &&
+        s.compare(s.size()-suffix.size(), suffix.size(), suffix) == 0;
+}
+
+static const char* format_name(FileType ft) {
+    switch (ft) {
+        case MATRIX_MARKET: return "matrix market";
+        case EDGE_LIST: return "edge list";
+        case PIGO_COO_BIN: return "PIGO COO binary";
+        case PIGO_CSR_BIN: return "PIGO CSR binary";
+        case PIGO_DIGRAPH_BIN: return "PIGO DiGraph binary";
+        case PIGO_TENSOR_BIN: return "PIGO Tensor binary";
+        case GRAPH: return "graph";
+        default: return "unknown";
+    }
+}
+
+/** @brief Return the label width of a binary file, or 0 for text */
+static int binary_width(const string& fn) {
+    ROFile f { fn };
+    FileType ft = f.guess_file_type();
+    size_t header = 0;
+    if (ft == PIGO_COO_BIN)
+        header = strlen(COO<>::coo_file_header);
+    else if (ft == PIGO_CSR_BIN)
+        header = strlen(CSR<>::csr_file_header);
+    else if (ft == PIGO_DIGRAPH_BIN)
+        header = strlen(DiGraph<>::digraph_file_header) + strlen(CSR<>::csr_file_header);
+    else
+        return 0;
+    if (f.size() < header + 2) throw Error("Truncated binary file " + fn);
+    uint8_t l_size = f.fp()[header];
+    uint8_t o_size = f.fp()[header+1];
+    if (l_size != o_size || (l_size != 4 && l_size != 8))
+        throw Error("Unsupported label and ordinal sizes in " + fn);
+    return l_size*8;
+}
+
+/** @brief Return the width to use for the given file */
+static int resolve_width(const Options& opts, const string& fn) {
+    if (opts.width != 0) return opts.width;
+    int width = 0;
+    try {
+        width = binary_width(fn);
+    } catch (Error&) {
+        // Unreadable files are reported when they are loaded
+    }
+    return (width == 0) ? 32 : width;
+}
+
+/** @brief Prints timing for each stage of the tool */
+static void report(const string& what, const string& fn, double seconds) {
+    cerr << fixed << setprecision(2) << seconds << " sec " << what << " " << fn << endl;
+}
+
+/** @brief The types used for a given width and weight type */
+template<class L, bool wgt, class W>
+struct Types {
+    typedef COO<L, L, L*, false, false, false, wgt, W, W*> coo_t;
+    typedef COO<L, L, L*, true, false, false, wgt, W, W*> sym_coo_t;
+    typedef CSR<L, L, L*, L*, wgt, W, W*> csr_t;
+    typedef DiGraph<L, L, L*, L*, wgt, W, W*> digraph_t;
+};
+
+/** @brief An input loaded and prepared for writing */
+template<class L, bool wgt, class W>
+struct Loaded {
+    typedef Types<L, wgt, W> T;
+    /** The loaded entries, when no CSR was needed */
+    unique_ptr<typename T::coo_t> coo;
+    /** The CSR, when sorting, deduplicating, or saving a CSR */
+    typename T::csr_t csr;
+    /** Whether csr holds the data instead of coo */
+    bool have_csr = false;
+
+    ~Loaded() {
+        if (have_csr) csr.free();
+        else if (coo) coo->free();
+    }
+};
+
+/** @brief Read the entries of a file into a COO of the given type
+ *
+ * DiGraph binaries are not read by COOs directly, so their out-edges are
+ * converted, symmetrizing them as well for symmetric COOs.
+ */
+template<class COOT, class DiGraphT>
+static unique_ptr<COOT> read_coo(const string& fn) {
+    ROFile f { fn };
+    FileType ft = f.guess_file_type();
+    if (ft != PIGO_DIGRAPH_BIN) return unique_ptr<COOT> { new COOT { f, ft } };
+    DiGraphT g { f, ft };
+    unique_ptr<COOT> coo { new COOT { g.out() } };
+    g.free();
+    return coo;
+}
+
+/** @brief Deduplicate or sort a loaded CSR */
+template<class L, bool wgt, class W>
+static void finish(const Options& opts, Loaded<L, wgt, W>& in) {
+    if (opts.dedup) {
+        typename Types<L, wgt, W>::csr_t dedup = in.csr.new_csr_without_dups();
+        in.csr.free();
+        in.csr = dedup;
+    } else if (opts.sort)
+        in.csr.sort();
+}
+
+/** @brief The first pipeline stage: load and prepare one input */
+template<class L, bool wgt, class W>
+static shared_ptr<Loaded<L, wgt, W>> load(const Options& opts, const string& fn) {
+    typedef Types<L, wgt, W> T;
+    double start = omp_get_wtime();
+    shared_ptr<Loaded<L, wgt, W>> in = make_shared<Loaded<L, wgt, W>>();
+    if (opts.symmetrize) {
+        // Symmetric COOs are only needed while building the CSR
+        auto sym = read_coo<typename T::sym_coo_t, typename T::digraph_t>(fn);
+        in->csr = typename T::csr_t { *sym };
+        sym->free();
+        in->have_csr = true;
+    } else if (opts.sort || opts.dedup || opts.to == OUT_CSR) {
+        auto coo = read_coo<typename T::coo_t, typename T::digraph_t>(fn);
+        in->csr = typename T::csr_t { *coo };
+        coo->free();
+        in->have_csr = true;
+    } else
+        in->coo = read_coo<typename T::coo_t, typename T::digraph_t>(fn);
+
+    finish(opts, *in);
+    report("loaded", fn, omp_get_wtime() - start);
+    return in;
+}
+
+/** @brief The second pipeline stage: write one prepared input */
+template<class L, bool wgt, class W>
+static void store(const Options& opts, Loaded<L, wgt, W>& in, const string& fn) {
+    typedef Types<L, wgt, W> T;
+    double start = omp_get_wtime();
+    if (opts.to == OUT_CSR) {
+        in.csr.save(fn, opts.save_mode, opts.checksum);
+        report("saved", fn, omp_get_wtime() - start);
+        return;
+    }
+
+    // The other formats are written from a COO
+    if (in.have_csr) {
+        in.coo.reset(new typename T::coo_t { in.csr });
+        in.csr.free();
+        in.have_csr = false;
+    }
+    if (opts.to == OUT_EL) {
+        WriteMode mode = TWO_PASS;
+        if (fn == "-") mode = STREAM;
+        else if (ends_with(fn, ".gz")) mode = GZIP;
+        else if (ends_with(fn, ".zst")) mode = ZSTD;
+        in.coo->write(fn, mode);
+    } else if (opts.to == OUT_COO) {
+        in.coo->save(fn, opts.save_mode, opts.checksum);
+    } else {
+        typename T::digraph_t g { *in.coo };
+        g.save(fn, opts.save_mode, opts.checksum);
+        g.free();
+    }
+    report("saved", fn, omp_get_wtime() - start);
+}
+
+/** @brief Convert the input and output pairs [first, last) of the files */
+template<class L, bool wgt, class W>
+static int convert(const Options& opts, size_t first, size_t last) {
+    typedef shared_ptr<Loaded<L, wgt, W>> LoadedPtr;
+    const vector<string>& files = opts.files;
+    int ret = 0;
+
+    // Load the next input in the background while writing the current one
+    future<LoadedPtr> next = async(launch::async, load<L, wgt, W>, cref(opts), cref(files[2*first]));
+    for (size_t job = first; job < last; ++job) {
+        LoadedPtr cur;
+        try {
+            cur = next.get();
+        } catch (exception& e) {
+            cerr << "Error loading " << files[2*job] << ": " << e.what() << endl;
+            ret = 1;
+        }
+        if (job+1 < last)
+            next = async(launch::async, load<L, wgt, W>, cref(opts), cref(files[2*job+2]));
+        if (!cur) continue;
+        try {
+            store<L, wgt, W>(opts, *cur, files[2*job+1]);
+        } catch (exception& e) {
+            cerr << "Error writing " << files[2*job+1] << ": " << e.what() << endl;
+            ret = 1;
+        }
+    }
+    return ret;
+}
+
+/** @brief Generate a graph and write it */
+template<class L, bool wgt, class W>
+static int generate(const Options& opts) {
+    typedef Types<L, wgt, W> T;
+    typedef typename T::coo_t C;
+    const string& kind = opts.files[0];
+    double start = omp_get_wtime();
+    Loaded<L, wgt, W> in;
+    if (kind == "rmat")
+        in.coo.reset(new C(generate_rmat<L, L, L*, wgt, W, W*>(opts.scale,
+                        opts.edge_factor, opts.seed)));
+    else if (kind == "gnm")
+        in.coo.reset(new C(generate_gnm<L, L, L*, wgt, W, W*>(opts.n, opts.m, opts.seed)));
+    else if (kind == "gnp")
+        in.coo.reset(new C(generate_gnp<L, L, L*, wgt, W, W*>(opts.n, opts.p, opts.seed)));
+    else if (kind == "ba")
+        in.coo.reset(new C(generate_ba<L, L, L*, wgt, W, W*>(opts.n, opts.k, opts.seed)));
+    else if (kind == "grid") {
+        vector<uint64_t> d = opts.dims;
+        d.resize(3, 1);
+        in.coo.reset(new C(generate_grid<L, L, L*, wgt, W, W*>(d[0], d[1], d[2])));
+    } else
+        throw Error("Unknown generator " + kind);
+    report("generated", kind, omp_get_wtime() - start);
+
+    // Prepare the entries as if they were loaded
+    start = omp_get_wtime();
+    if (opts.symmetrize || opts.sort || opts.dedup || opts.to == OUT_CSR) {
+        in.csr = typename T::csr_t { *in.coo };
+        in.coo->free();
+        in.coo.reset();
+        in.have_csr = true;
+    }
+    if (opts.symmetrize) {
+        typename T::sym_coo_t sym { in.csr };
+        in.csr.free();
+        in.csr = typename T::csr_t { sym };
+        sym.free();
+    }
+    finish(opts, in);
+    report("prepared", kind, omp_get_wtime() - start);
+
+    store(opts, in, opts.files[1]);
+    return 0;
+}
+
+/** @brief Print the sizes, degree statistics and flags of a CSR */
+template<class CSRT>
+static void print_csr(const string& name, CSRT& csr) {
+    auto offsets = csr.offsets();
+    auto endpoints = csr.endpoints();
+    size_t n = csr.n();
+    size_t min_deg = (n > 0) ? SIZE_MAX : 0;
+    size_t max_deg = 0;
+    size_t empty = 0;
+    size_t self_loops = 0;
+    size_t unsorted = 0;
+    #pragma omp parallel for reduction(min : min_deg) reduction(max : max_deg) \
+            reduction(+ : empty, self_loops, unsorted) schedule(dynamic, 10240)
+    for (size_t v = 0; v < n; ++v) {
+        size_t deg = offsets[v+1] - offsets[v];
+        min_deg = std::min(min_deg, deg);
+        max_deg = std::max(max_deg, deg);
+        if (deg == 0) ++empty;
+        for (size_t e = offsets[v]; e < (size_t)offsets[v+1]; ++e) {
+            if ((size_t)endpoints[e] == v) ++self_loops;
+            if (e > (size_t)offsets[v] && endpoints[e-1] > endpoints[e]) ++unsorted;
+        }
+    }
+    double avg_deg = (n > 0) ? (double)csr.m() / n : 0.;
+    cout << "  " << name << "n: " << csr.n() << "\n";
+    cout << "  " << name << "m: " << csr.m() << "\n";
+    cout << "  " << name << "rows x cols: " << csr.nrows() << " x " << csr.ncols() << "\n";
+    cout << "  " << name << "degree min/avg/max: " << min_deg << " / "
+        << fixed << setprecision(2) << avg_deg << " / " << max_deg << "\n";
+    cout << "  " << name << "empty rows: " << empty << "\n";
+    cout << "  " << name << "self loops: " << self_loops << "\n";
+    cout << "  " << name << "sorted: " << (unsorted == 0 ? "yes" : "no") << "\n";
+}
+
+template<class L, bool wgt, class W>
+static int info_one(const string& fn) {
+    typedef Types<L, wgt, W> T;
+    ROFile f { fn };
+    FileType ft = f.guess_file_type();
+    cout << fn << "\n";
+    cout << "  format: " << format_name(ft) << "\n";
+    cout << "  label width: " << sizeof(L)*8 << "\n";
+    cout << "  weighted: " << (wgt ? "yes" : "no") << "\n";
+    if (ft == PIGO_DIGRAPH_BIN) {
+        typename T::digraph_t g { f, ft };
+        print_csr("out ", g.out());
+        print_csr("in ", g.in());
+        g.free();
+    } else {
+        typename T::csr_t csr { f, ft };
+        print_csr("", csr);
+        csr.free();
+    }
+    return 0;
+}
+
+template<class L, bool wgt, class W>
+static int validate_one(const Options& opts, const string& fn) {
+    typedef Types<L, wgt, W> T;
+    ROFile f { fn };
+    FileType ft = f.guess_file_type();
+    if (ft == PIGO_DIGRAPH_BIN) {
+        typename T::digraph_t g { f, ft };
+        try {
+            g.validate(opts.sort);
+        } catch (...) {
+            g.free();
+            throw;
+        }
+        g.free();
+    } else if (ft == PIGO_COO_BIN) {
+        typename T::coo_t coo { f, ft };
+        try {
+            coo.validate(opts.sort);
+        } catch (...) {
+            coo.free();
+            throw;
+        }
+        coo.free();
+    } else {
+        typename T::csr_t csr { f, ft };
+        try {
+            csr.validate(opts.sort);
+        } catch (...) {
+            csr.free();
+            throw;
+        }
+        csr.free();
+    }
+    return 0;
+}
+
+static void print_estimate(const string& name, const Estimate& e) {
+    cout << "  " << name << ": " << e.value << " [" << e.low << ", " << e.high << "]\n";
+}
+
+/** @brief Print the statistics estimated from a sample */
+static void print_sample(const string& fn, const SampleStats& s) {
+    cout << fn << "\n";
+    cout << fixed << setprecision(0);
+    cout << "  sampled: " << s.bytes_sampled << " of " << s.file_size << " bytes in "
+        << s.windows << " windows" << (s.exact ? " (exact)" : "") << "\n";
+    print_estimate("lines", s.lines);
+    print_estimate("entries", s.entries);
+    print_estimate("max label", s.max_label);
+    print_estimate("max degree", s.max_degree);
+    cout << setprecision(4);
+    print_estimate("self loop rate", s.self_loop_rate);
+    print_estimate("duplicate rate", s.duplicate_rate);
+    cout << "  rows grouped: " << (s.rows_grouped ? "yes" : "no") << "\n";
+    cout << "  degree histogram:";
+    for (size_t b = 0; b < s.degree_histogram.size(); ++b)
+        cout << " [" << (1ull << b) << "]=" << s.degree_histogram[b];
+    cout << endl;
+}
+
+/** @brief Run a command for one file with the given types */
+template<class L, bool wgt, class W>
+static int run_typed(const string& cmd, const Options& opts, const string& fn) {
+    if (cmd == "info") return info_one<L, wgt, W>(fn);
+    validate_one<L, wgt, W>(opts, fn);
+    cout << fn << ": ok" << endl;
+    return 0;
+}
+
+/** @brief Dispatch a function template on the width and weight type */
+#define PIGO_DISPATCH(width, weights, FN, ...)                             \
+    ((width) == 64 ?                                                        \
+        ((weights) == W_INT ? FN<uint64_t, true, int64_t>(__VA_ARGS__) :    \
+         (weights) == W_FLOAT ? FN<uint64_t, true, double>(__VA_ARGS__) :   \
+         FN<uint64_t, false, float>(__VA_ARGS__)) :                         \
+        ((weights) == W_INT ? FN<uint32_t, true, int64_t>(__VA_ARGS__) :    \
+         (weights) == W_FLOAT ? FN<uint32_t, true, double>(__VA_ARGS__) :   \
+         FN<uint32_t, false, float>(__VA_ARGS__)))
+
+static bool parse_options(int argc, char** argv, Options& opts) {
+    for (int arg = 2; arg < argc; ++arg) {
+        string a { argv[arg] };
+        auto value = [&]() -> string {
+            if (arg+1 >= argc) throw Error("Missing value for " + a);
+            return argv[++arg];
+        };
+        if (a == "--width") {
+            string v = value();
+            if (v == "32") opts.width = 32;
+            else if (v == "64") opts.width = 64;
+            else throw Error("Unsupported width " + v);
+        } else if (a == "--weights") {
+            string v = value();
+            if (v == "none") opts.weights = W_NONE;
+            else if (v == "int") opts.weights = W_INT;
+            else if (v == "float") opts.weights = W_FLOAT;
+            else throw Error("Unsupported weight type " + v);
+        } else if (a == "--to") {
+            string v = value();
+            if (v == "el") opts.to = OUT_EL;
+            else if (v == "coo") opts.to = OUT_COO;
+            else if (v == "csr") opts.to = OUT_CSR;
+            else if (v == "digraph") opts.to = OUT_DIGRAPH;
+            else throw Error("Unsupported output format " + v);
+        } else if (a == "--symmetrize") opts.symmetrize = true;
+        else if (a == "--dedup") opts.dedup = true;
+        else if (a == "--sort") opts.sort = true;
+        else if (a == "--direct") opts.save_mode = DIRECT;
+        else if (a == "--checksum") opts.checksum = CRC32C;
+        else if (a == "--windows") opts.windows = stoull(value());
+        else if (a == "--window-size") opts.window_size = stoull(value());
+        else if (a == "--scale") opts.scale = stoul(value());
+        else if (a == "--edge-factor") opts.edge_factor = stoull(value());
+        else if (a == "--n") opts.n = stoull(value());
+        else if (a == "--m") opts.m = stoull(value());
+        else if (a == "--p") opts.p = stod(value());
+        else if (a == "--k") opts.k = stoull(value());
+        else if (a == "--seed") opts.seed = stoull(value());
+        else if (a == "--timings") opts.timings = true;
+        else if (a == "--trace") opts.trace = value();
+        else if (a == "--dims") {
+            string v = value();
+            opts.dims.clear();
+            size_t pos = 0;
+            while (pos <= v.size() && opts.dims.size() < 4) {
+                size_t x = v.find('x', pos);
+                if (x == string::npos) x = v.size();
+                opts.dims.push_back(stoull(v.substr(pos, x-pos)));
+                pos = x+1;
+            }
+            if (opts.dims.size() > 3) throw Error("Grids have at most 3 dimensions");
+        }
+        else if (a == "-h" || a == "--help") return false;
+        else if (a.size() > 2 && a.compare(0, 2, "--") == 0)
+            throw Error("Unknown option " + a);
+        else opts.files.push_back(a);
+    }
+    return true;
+}
+
+/** Prints the recorded phases and writes the trace when the command
+ *  finishes */
+struct TimingReport {
+    bool timings;
+    string trace;
+    ~TimingReport() {
+        if (timings) print_phases(cerr, recorded_phases());
+        if (trace.empty()) return;
+        try {
+            write_trace(trace);
+        } catch (exception& e) {
+            cerr << "pigo: " << e.what() << endl;
+        }
+    }
+};
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        usage();
+        return 1;
+    }
+    string cmd { argv[1] };
+    if (cmd == "-h" || cmd == "--help" || cmd == "help") {
+        usage();
+        return 0;
+    }
+
+    Options opts;
+    try {
+        if (!parse_options(argc, argv, opts)) {
+            usage();
+            return 0;
+        }
+        if (opts.timings) enable_instrumentation();
+        if (!opts.trace.empty()) enable_tracing();
+    } catch (exception& e) {
+        cerr << "pigo: " << e.what() << endl;
+        return 1;
+    }
+    TimingReport timing_report { opts.timings, opts.trace };
+
+    if (cmd == "convert") {
+        if (opts.files.empty() || opts.files.size() % 2 != 0) {
+            cerr << "pigo: convert takes pairs of input and output files" << endl;
+            return 1;
+        }
+        try {
+            // Each run of inputs with the same width shares a pipeline
+            size_t num_jobs = opts.files.size() / 2;
+            vector<int> widths;
+            for (size_t job = 0; job < num_jobs; ++job)
+                widths.push_back(resolve_width(opts, opts.files[2*job]));
+            int ret = 0;
+            for (size_t first = 0, last; first < num_jobs; first = last) {
+                last = first + 1;
+                while (last < num_jobs && widths[last] == widths[first]) ++last;
+                ret |= PIGO_DISPATCH(widths[first], opts.weights, convert, opts, first, last);
+            }
+            return ret;
+        } catch (exception& e) {
+            cerr << "pigo: " << e.what() << endl;
+            return 1;
+        }
+    }
+
+    if (cmd == "generate") {
+        if (opts.files.size() != 2) {
+            cerr << "pigo: generate takes a generator and an output file" << endl;
+            return 1;
+        }
+        try {
+            int width = (opts.width == 0) ? 32 : opts.width;
+            return PIGO_DISPATCH(width, opts.weights, generate, opts);
+        } catch (exception& e) {
+            cerr << "pigo: " << e.what() << endl;
+            return 1;
+        }
+    }
+
+    if ((cmd == "sample" || cmd == "info" || cmd == "validate") && opts.files.empty()) {
+        cerr << "pigo: " << cmd << " takes at least one file" << endl;
+        return 1;
+    }
+
+    if (cmd == "sample") {
+        int ret = 0;
+        for (const string& fn : opts.files) {
+            try {
+                print_sample(fn, sample(fn, opts.windows, opts.window_size));
+            } catch (exception& e) {
+                cout << fn << ": " << e.what() << endl;
+                ret = 1;
+            }
+        }
+        return ret;
+    }
+
+    if (cmd == "info" || cmd == "validate") {
+        int ret = 0;
+        for (const string& fn : opts.files) {
+            try {
+                int width = resolve_width(opts, fn);
+                ret |= PIGO_DISPATCH(width, opts.weights, run_typed, cmd, opts, fn);
+            } catch (exception& e) {
+                cout << fn << ": " << e.what() << endl;
+                ret = 1;
+            }
+        }
+        return ret;
+    }
+
+    cerr << "pigo: unknown command " << cmd << endl;
+    usage();
+    return 1;
+}